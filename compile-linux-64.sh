@@ -20,6 +20,7 @@
 echo 'Starting compilation script...'
 
 profile='src/GPUTweak.pro'
+backendsprofile='src/backends/backends.pro'
 exefile='GPUTweak'
 compiledir='linux-compile-64'
 distdir='GPUTweak'
@@ -38,9 +39,19 @@ qmake ../"$profile" -spec linux-g++-64 "CONFIG+=release"
 echo 'Running make...'
 make
 
+echo 'Compiling backend plugins...'
+# Plugins end up in the backends directory, next to the executable
+mkdir backends
+cd backends
+qmake ../../"$backendsprofile" -spec linux-g++-64 "CONFIG+=release"
+make
+cd ..
+
 echo 'Copying files...'
 cd ..
 cp $compiledir/$exefile $distdir/$exefile
+mkdir $distdir/backends
+cp $compiledir/backends/*.so $distdir/backends/
 cp README.md  $distdir/README.md
 cp LICENSE  $distdir/LICENSE
 
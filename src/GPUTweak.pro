@@ -4,31 +4,94 @@
 #
 #-------------------------------------------------
 
-QT       += core gui
+QT       += core gui concurrent network
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
 TARGET = GPUTweak
 TEMPLATE = app
 
+# The backend plugins (see backends/backends.pro) use the GPU classes of the executable
+QMAKE_LFLAGS += -rdynamic
+
+# Trace spans (see gputrace.h), enabled with: qmake CONFIG+=tracing
+tracing: DEFINES += GPUTWEAK_TRACING
+
 
 SOURCES += main.cpp\
     mainwindow.cpp \
     gpuinfowindow.cpp \
-    gpunvidia.cpp \
-    nvidiasettingsadapter.cpp \
     gputweakwindow.cpp \
-    gpustatswindow.cpp
+    gpustatswindow.cpp \
+    gpuhistory.cpp \
+    gpusimulated.cpp \
+    gpudashboardwindow.cpp \
+    benchmarks.cpp \
+    gpu.cpp \
+    gpupoller.cpp \
+    gpuregistry.cpp \
+    gpuburstcapture.cpp \
+    gpuburstwindow.cpp \
+    cli.cpp \
+    gpubackends.cpp \
+    gpufancontroller.cpp \
+    gpufancurveeditor.cpp \
+    gpuprofile.cpp \
+    gpuworkloadwatcher.cpp \
+    gpueventlog.cpp \
+    gputhrottledetector.cpp \
+    gpupciemonitor.cpp \
+    gpusketch.cpp \
+    gpuquantiles.cpp \
+    gpudiagnostics.cpp \
+    gpudiagnosticswindow.cpp \
+    gputrace.cpp \
+    gpunetwork.cpp \
+    gpuagent.cpp \
+    gpucollector.cpp \
+    gpuremote.cpp \
+    gpuremotelink.cpp \
+    gpuenergymeter.cpp \
+    gpujobmarkers.cpp
 
 HEADERS  += mainwindow.h \
     gpuinfowindow.h \
-    gpunvidia.h \
     gpu.h \
-    nvidiasettingsadapter.h \
     gputweakwindow.h \
-    gpustatswindow.h
+    gpustatswindow.h \
+    gpuhistory.h \
+    gpusimulated.h \
+    gpudashboardwindow.h \
+    benchmarks.h \
+    gpupoller.h \
+    gpuregistry.h \
+    gpuburstcapture.h \
+    gpuburstwindow.h \
+    cli.h \
+    gpubackend.h \
+    gpubackends.h \
+    gpufancontroller.h \
+    gpufancurveeditor.h \
+    gpuprofile.h \
+    gpuworkloadwatcher.h \
+    gpueventlog.h \
+    gputhrottledetector.h \
+    gpupciemonitor.h \
+    gpusketch.h \
+    gpuquantiles.h \
+    gpudiagnostics.h \
+    gpudiagnosticswindow.h \
+    gputrace.h \
+    gpunetwork.h \
+    gpuagent.h \
+    gpucollector.h \
+    gpuremote.h \
+    gpuremotelink.h \
+    gpuenergymeter.h \
+    gpujobmarkers.h
 
 FORMS    += mainwindow.ui \
     gpuinfowindow.ui \
     gputweakwindow.ui \
-    gpustatswindow.ui
+    gpustatswindow.ui \
+    gpuburstwindow.ui
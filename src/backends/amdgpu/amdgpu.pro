@@ -0,0 +1,31 @@
+#-------------------------------------------------
+#
+# amdgpu backend plugin of GPUTweak
+#
+#-------------------------------------------------
+
+QT       += core
+
+TARGET = gputweak-amdgpu
+TEMPLATE = lib
+CONFIG += plugin
+
+# Plugins are gathered next to each other, GPUTweak looks for them in its "backends" directory
+DESTDIR = $$OUT_PWD/..
+
+# Shared interfaces of the application, their symbols are exported by the executable
+INCLUDEPATH += ../..
+
+# Trace spans, like the executable
+tracing: DEFINES += GPUTWEAK_TRACING
+
+SOURCES += amdgpubackend.cpp \
+    gpuamd.cpp \
+    amdgpuadapter.cpp
+
+HEADERS += amdgpubackend.h \
+    gpuamd.h \
+    amdgpuadapter.h \
+    ../../gpubackend.h
+
+OTHER_FILES += amdgpu.json
@@ -0,0 +1,310 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "amdgpuadapter.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QRegularExpression>
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "gpuamd.h"
+
+/**
+ * Root of the sysfs tree, can be replaced trough this environment variable to use a fake tree
+ */
+const char *SYSFS_ROOT_ENV = "GPUTWEAK_SYSFS_ROOT";
+const QString SYSFS_ROOT = "/sys";
+/**
+ * PCI vendor id of AMD
+ */
+const QString AMD_VENDOR_ID = "0x1002";
+/**
+ * Max size of a value read from sysfs, the dpm level lists are the longest
+ */
+const int READ_BUFFER_SIZE = 1024;
+
+/**
+ * Device directory of the cards listed by the last enumerate(), by bus id, only used from the GUI thread
+ */
+static QHash<QString, QPair<int, QString> > enumeratedCards;
+
+/**
+ * Gives the root of the sysfs tree
+ * @return Path without trailing slash
+ */
+QString AmdgpuAdapter::sysfsRoot()
+{
+    QString root = QString::fromLocal8Bit(qgetenv(SYSFS_ROOT_ENV));
+
+    return root.isEmpty() ? SYSFS_ROOT : root;
+}
+
+/**
+ * Reads a whole file, only used for constants
+ * @param path Path of the file
+ * @return Trimmed content, empty if it cannot be read
+ */
+QString AmdgpuAdapter::readFile(QString path)
+{
+    QFile file(path);
+    if(!file.open(QIODevice::ReadOnly)) {
+        return QString();
+    }
+
+    return QString(file.readAll()).trimmed();
+}
+
+/**
+ * Opens a file kept open to be read many times
+ * @param path     Path of the file
+ * @param writable Opens it for writing too, falls back to read-only if not allowed
+ * @return File descriptor, -1 if it cannot be opened
+ */
+int AmdgpuAdapter::openFile(QString path, bool writable)
+{
+    QByteArray localPath = QFile::encodeName(path);
+
+    int fd = -1;
+
+    if(writable) {
+        fd = ::open(localPath.constData(), O_RDWR | O_CLOEXEC);
+    }
+
+    if(fd < 0) {
+        fd = ::open(localPath.constData(), O_RDONLY | O_CLOEXEC);
+    }
+
+    return fd;
+}
+
+/**
+ * Reads a file descriptor from the start
+ * sysfs regenerates the value on every read at offset 0, so no seek nor reopen is needed
+ * @param fd File descriptor
+ * @return Content, empty on error
+ */
+QByteArray AmdgpuAdapter::readFd(int fd)
+{
+    if(fd < 0) {
+        return QByteArray();
+    }
+
+    char buffer[READ_BUFFER_SIZE];
+    ssize_t length = ::pread(fd, buffer, sizeof(buffer), 0);
+
+    if(length <= 0) {
+        return QByteArray();
+    }
+
+    return QByteArray(buffer, static_cast<int>(length));
+}
+
+/**
+ * Reads an integer from a file descriptor without allocating
+ * @param fd File descriptor
+ * @return Value, 0 on error
+ */
+int AmdgpuAdapter::readIntFd(int fd)
+{
+    if(fd < 0) {
+        return 0;
+    }
+
+    char buffer[32];
+    ssize_t length = ::pread(fd, buffer, sizeof(buffer) - 1, 0);
+
+    if(length <= 0) {
+        return 0;
+    }
+
+    buffer[length] = '\0';
+
+    return static_cast<int>(strtoll(buffer, 0, 10));
+}
+
+/**
+ * Writes a value to a file descriptor
+ * @param fd    File descriptor opened for writing
+ * @param value Value
+ * @return True on success
+ */
+bool AmdgpuAdapter::writeFd(int fd, QByteArray value)
+{
+    if(fd < 0) {
+        return false;
+    }
+
+    return ::pwrite(fd, value.constData(), value.size(), 0) == value.size();
+}
+
+/**
+ * Closes a file descriptor opened by openFile
+ * @param fd File descriptor
+ */
+void AmdgpuAdapter::closeFd(int fd)
+{
+    if(fd >= 0) {
+        ::close(fd);
+    }
+}
+
+/**
+ * Parses a dpm level list to get the active level
+ * @param levels Content like "0: 300Mhz\n1: 1000Mhz *\n"
+ * @return Value of the level marked with a star, 0 if none
+ */
+int AmdgpuAdapter::getActiveLevelValue(QByteArray levels)
+{
+    int star = levels.indexOf('*');
+    if(star < 0) {
+        return 0;
+    }
+
+    int lineStart = levels.lastIndexOf('\n', star) + 1;
+    int valueStart = levels.indexOf(':', lineStart) + 1;
+    if(valueStart <= 0 || valueStart > star) {
+        return 0;
+    }
+
+    // toInt() fails on the unit, so stop at the first non-digit
+    int value = 0;
+    for(int i = valueStart; i < star; i++) {
+        char c = levels.at(i);
+
+        if(c >= '0' && c <= '9') {
+            value = value * 10 + (c - '0');
+        } else if(value > 0) {
+            break;
+        }
+    }
+
+    return value;
+}
+
+/**
+ * Lists the AMD cards of the drm class
+ * @return Device directory of each card, by card number
+ */
+static QMap<int, QString> listCards()
+{
+    QDir drm(AmdgpuAdapter::sysfsRoot() + "/class/drm");
+
+    QRegularExpression cardName("^card(?<id>\\d+)$");
+
+    QMap<int, QString> list;
+
+    foreach(QString entry, drm.entryList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name)) {
+        QRegularExpressionMatch match = cardName.match(entry);
+        if(!match.hasMatch()) {
+            // Connectors like card0-DP-1
+            continue;
+        }
+
+        QString devicePath = drm.filePath(entry + "/device");
+
+        if(AmdgpuAdapter::readFile(devicePath + "/vendor") != AMD_VENDOR_ID) {
+            continue;
+        }
+
+        list.insert(match.captured("id").toInt(), devicePath);
+    }
+
+    return list;
+}
+
+/**
+ * Get a list of all GPUs detected by this adapter
+ * @return List of GPUs
+ */
+QList<GPU*> AmdgpuAdapter::getGPUs()
+{
+    QList<GPU*> list;
+
+    QMapIterator<int, QString> i(listCards());
+    while(i.hasNext()) {
+        i.next();
+        list.append(new GPUAmd(i.key(), i.value()));
+    }
+
+    return list;
+}
+
+/**
+ * Lists the cards from the directory entries of sysfs, nothing is opened but the vendor files
+ * @return Identifier of each card by bus id
+ */
+QMap<QString, QString> AmdgpuAdapter::enumerate()
+{
+    enumeratedCards.clear();
+
+    QMap<QString, QString> list;
+
+    QMapIterator<int, QString> i(listCards());
+    while(i.hasNext()) {
+        i.next();
+
+        QString busId = AmdgpuAdapter::getBusId(i.value());
+
+        enumeratedCards.insert(busId, qMakePair(i.key(), i.value()));
+        list.insert(busId, QString("card%1").arg(i.key()));
+    }
+
+    return list;
+}
+
+/**
+ * Creates a card listed by the last enumerate()
+ * @param busId
+ * @return GPU, 0 if it was not listed
+ */
+GPU *AmdgpuAdapter::createGPU(QString busId)
+{
+    if(!enumeratedCards.contains(busId)) {
+        return 0;
+    }
+
+    QPair<int, QString> card = enumeratedCards.value(busId);
+
+    return new GPUAmd(card.first, card.second);
+}
+
+/**
+ * Gives the bus id of a card from its device directory
+ * The directory is a link to the PCI address, ex: 0000:03:00.0
+ * @param devicePath
+ * @return Bus id like PCI:3:0:0, or the address if it cannot be parsed
+ */
+QString AmdgpuAdapter::getBusId(QString devicePath)
+{
+    QString address = QFileInfo(QFileInfo(devicePath).canonicalFilePath()).fileName();
+    QRegularExpressionMatch match = QRegularExpression("(?<bus>[0-9a-f]+):(?<device>[0-9a-f]+)\\.(?<func>[0-9a-f]+)$").match(address);
+
+    if(!match.hasMatch()) {
+        return address;
+    }
+
+    return QString("PCI:%1:%2:%3")
+            .arg(match.captured("bus").toInt(0, 16))
+            .arg(match.captured("device").toInt(0, 16))
+            .arg(match.captured("func").toInt(0, 16));
+}
@@ -0,0 +1,50 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef AMDGPUADAPTER_H
+#define AMDGPUADAPTER_H
+
+#include <QString>
+#include <QList>
+#include <QMap>
+
+#include "gpu.h"
+
+/**
+ * This namespace holds global functions used to access AMD cards trough the sysfs interface of the amdgpu kernel driver
+ */
+namespace AmdgpuAdapter
+{
+    QString sysfsRoot();
+
+    QString readFile(QString path);
+
+    int openFile(QString path, bool writable = false);
+    QByteArray readFd(int fd);
+    int readIntFd(int fd);
+    bool writeFd(int fd, QByteArray value);
+    void closeFd(int fd);
+
+    int getActiveLevelValue(QByteArray levels);
+    QString getBusId(QString devicePath);
+
+    QList<GPU*>            getGPUs();
+    QMap<QString, QString> enumerate();
+    GPU                   *createGPU(QString busId);
+}
+
+#endif // AMDGPUADAPTER_H
@@ -0,0 +1,56 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "amdgpubackend.h"
+
+#include <QDir>
+
+#include "amdgpuadapter.h"
+
+QString AmdgpuBackend::getName()
+{
+    return "amdgpu";
+}
+
+/**
+ * The drm class must exist, the cards themselves are filtered by getGPUs()
+ * @return True if usable
+ */
+bool AmdgpuBackend::probe()
+{
+    return QDir(AmdgpuAdapter::sysfsRoot() + "/class/drm").exists();
+}
+
+QList<GPU*> AmdgpuBackend::getGPUs()
+{
+    return AmdgpuAdapter::getGPUs();
+}
+
+QMap<QString, QString> AmdgpuBackend::enumerate()
+{
+    return AmdgpuAdapter::enumerate();
+}
+
+GPU *AmdgpuBackend::createGPU(QString busId)
+{
+    return AmdgpuAdapter::createGPU(busId);
+}
+
+QList<GPUBackend::ExtraField> AmdgpuBackend::getExtraFields()
+{
+    return QList<ExtraField>();
+}
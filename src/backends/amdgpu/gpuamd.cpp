@@ -0,0 +1,398 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "gpuamd.h"
+
+#include <QDir>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "amdgpuadapter.h"
+#include "gputrace.h"
+
+/**
+ * Max value of the pwm files
+ */
+const int PWM_MAX = 255;
+/**
+ * Values of pwm1_enable
+ */
+const QByteArray PWM_MODE_MANUAL = "1";
+const QByteArray PWM_MODE_AUTO   = "2";
+/**
+ * Constant for the number of bytes in a MB
+ */
+const qint64 BYTES_IN_A_MB = 1024 * 1024;
+/**
+ * hwmon temperatures are given in millidegrees
+ */
+const int MILLIDEGREES_IN_A_DEGREE = 1000;
+/**
+ * hwmon powers are given in microwatts
+ */
+const double MICROWATTS_IN_A_WATT = 1000000.0;
+
+GPUAmd::GPUAmd(int ID, QString DevicePath) : GPU()
+{
+    this->id         = ID;
+    this->devicePath = DevicePath;
+
+    this->fetchConstants();
+
+    QString hwmonPath = this->findHwmonPath();
+
+    this->tempFd      = AmdgpuAdapter::openFile(hwmonPath + "/temp1_input");
+    this->pwmFd       = AmdgpuAdapter::openFile(hwmonPath + "/pwm1", true);
+    this->pwmEnableFd = AmdgpuAdapter::openFile(hwmonPath + "/pwm1_enable", true);
+    this->sclkFd      = AmdgpuAdapter::openFile(this->devicePath + "/pp_dpm_sclk");
+    this->mclkFd      = AmdgpuAdapter::openFile(this->devicePath + "/pp_dpm_mclk");
+    this->busyFd      = AmdgpuAdapter::openFile(this->devicePath + "/gpu_busy_percent");
+    this->vramUsedFd  = AmdgpuAdapter::openFile(this->devicePath + "/mem_info_vram_used");
+    this->powerCapFd  = AmdgpuAdapter::openFile(hwmonPath + "/power1_cap", true);
+
+    // Older kernels only have the average over the last second, newer ones the instant value too
+    this->powerFd = AmdgpuAdapter::openFile(hwmonPath + "/power1_average");
+    if(this->powerFd < 0) {
+        this->powerFd = AmdgpuAdapter::openFile(hwmonPath + "/power1_input");
+    }
+
+    // Writing needs root, openFile falls back to read-only otherwise
+    this->fanWritable = this->pwmFd >= 0 && (fcntl(this->pwmFd, F_GETFL) & O_ACCMODE) == O_RDWR
+            && this->pwmEnableFd >= 0 && (fcntl(this->pwmEnableFd, F_GETFL) & O_ACCMODE) == O_RDWR;
+
+    // power1_cap_default only exists since Linux 5.12, the cap is then restored to the max
+    this->powerLimitMin     = AmdgpuAdapter::readFile(hwmonPath + "/power1_cap_min").toLongLong() / MICROWATTS_IN_A_WATT;
+    this->powerLimitMax     = AmdgpuAdapter::readFile(hwmonPath + "/power1_cap_max").toLongLong() / MICROWATTS_IN_A_WATT;
+    QString powerCapDefault = AmdgpuAdapter::readFile(hwmonPath + "/power1_cap_default");
+    this->powerLimitDefault = powerCapDefault.isEmpty() ? this->powerLimitMax : powerCapDefault.toLongLong() / MICROWATTS_IN_A_WATT;
+    this->powerLimitWritable = this->powerCapFd >= 0 && (fcntl(this->powerCapFd, F_GETFL) & O_ACCMODE) == O_RDWR
+            && this->powerLimitMin < this->powerLimitMax;
+
+    // Variables are only fetched when someone asks for them
+    this->coreTemp        = 0;
+    this->fanSpeed        = 0;
+    this->coreClock       = 0;
+    this->memoryClock     = 0;
+    this->coreUse         = 0;
+    this->memoryUse       = 0;
+    this->fanControlState = false;
+    this->powerDraw       = 0;
+    this->powerLimit      = 0;
+
+    this->readPcieLink();
+}
+
+GPUAmd::~GPUAmd()
+{
+    AmdgpuAdapter::closeFd(this->tempFd);
+    AmdgpuAdapter::closeFd(this->pwmFd);
+    AmdgpuAdapter::closeFd(this->pwmEnableFd);
+    AmdgpuAdapter::closeFd(this->sclkFd);
+    AmdgpuAdapter::closeFd(this->mclkFd);
+    AmdgpuAdapter::closeFd(this->busyFd);
+    AmdgpuAdapter::closeFd(this->vramUsedFd);
+    AmdgpuAdapter::closeFd(this->powerFd);
+    AmdgpuAdapter::closeFd(this->powerCapFd);
+}
+
+/**
+ * Finds the hwmon directory of the card
+ * @return Path, empty if there is none
+ */
+QString GPUAmd::findHwmonPath()
+{
+    QDir hwmon(this->devicePath + "/hwmon");
+
+    QStringList entries = hwmon.entryList(QStringList() << "hwmon*", QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name);
+    if(entries.isEmpty()) {
+        return QString();
+    }
+
+    return hwmon.filePath(entries.first());
+}
+
+void GPUAmd::fetchConstants()
+{
+    GPUTWEAK_TRACE_SCOPE("GPUAmd::fetchConstants");
+
+    QString deviceId = AmdgpuAdapter::readFile(this->devicePath + "/device");
+    QString productName = AmdgpuAdapter::readFile(this->devicePath + "/product_name");
+    this->name = productName.isEmpty() ? QString("AMD Radeon (%1)").arg(deviceId) : productName;
+
+    QString root = AmdgpuAdapter::sysfsRoot();
+    this->driverVersion = AmdgpuAdapter::readFile(root + "/module/amdgpu/version");
+    if(this->driverVersion.isEmpty()) {
+        // In-tree driver, the version is the one of the kernel
+        this->driverVersion = QString("amdgpu %1").arg(AmdgpuAdapter::readFile("/proc/sys/kernel/osrelease"));
+    }
+
+    this->busId = AmdgpuAdapter::getBusId(this->devicePath);
+
+    this->pcieMaxLinkWidth = AmdgpuAdapter::readFile(this->devicePath + "/max_link_width").toInt();
+
+    // ex: "8.0 GT/s PCIe"
+    this->pcieGen = GPU::pcieGenFromSpeed(AmdgpuAdapter::readFile(this->devicePath + "/max_link_speed").section(' ', 0, 0).toDouble());
+
+    this->totalMemoryBytes = AmdgpuAdapter::readFile(this->devicePath + "/mem_info_vram_total").toLongLong();
+    this->totalMemory      = static_cast<int>(this->totalMemoryBytes / BYTES_IN_A_MB);
+}
+
+void GPUAmd::fetchVariables(Metrics metrics)
+{
+    GPUTWEAK_TRACE_SCOPE("GPUAmd::fetchVariables");
+
+    if(metrics & CoreTemp) {
+        this->coreTemp    = AmdgpuAdapter::readIntFd(this->tempFd) / MILLIDEGREES_IN_A_DEGREE;
+    }
+
+    if(metrics & Clocks) {
+        this->coreClock   = AmdgpuAdapter::getActiveLevelValue(AmdgpuAdapter::readFd(this->sclkFd));
+        this->memoryClock = AmdgpuAdapter::getActiveLevelValue(AmdgpuAdapter::readFd(this->mclkFd));
+    }
+
+    if(metrics & Utilization) {
+        this->coreUse     = AmdgpuAdapter::readIntFd(this->busyFd);
+
+        if(this->totalMemoryBytes > 0) {
+            // Too big for readIntFd on cards with more than 2 GB
+            qint64 used = AmdgpuAdapter::readFd(this->vramUsedFd).trimmed().toLongLong();
+            this->memoryUse = static_cast<int>(used * 100 / this->totalMemoryBytes);
+        }
+    }
+
+    if(metrics & FanSpeed) {
+        this->fanSpeed    = (AmdgpuAdapter::readIntFd(this->pwmFd) * 100 + PWM_MAX / 2) / PWM_MAX;
+    }
+
+    if(metrics & FanControlState) {
+        this->fanControlState = AmdgpuAdapter::readIntFd(this->pwmEnableFd) == PWM_MODE_MANUAL.toInt();
+    }
+
+    if(metrics & PcieLink) {
+        this->readPcieLink();
+    }
+
+    if(metrics & Power) {
+        this->powerDraw  = AmdgpuAdapter::readIntFd(this->powerFd) / MICROWATTS_IN_A_WATT;
+        this->powerLimit = AmdgpuAdapter::readIntFd(this->powerCapFd) / MICROWATTS_IN_A_WATT;
+    }
+
+    this->updatedMetrics = metrics;
+
+    emit updated();
+}
+
+/**
+ * Reads the state of the PCI-E link
+ * It is fetched rarely, so the files are not kept open
+ */
+void GPUAmd::readPcieLink()
+{
+    this->pcieLinkWidth = AmdgpuAdapter::readFile(this->devicePath + "/current_link_width").toInt();
+    this->pcieLinkGen   = GPU::pcieGenFromSpeed(AmdgpuAdapter::readFile(this->devicePath + "/current_link_speed").section(' ', 0, 0).toDouble());
+}
+
+QString GPUAmd::getIdentifier()
+{
+    return QString("card%1").arg(this->id);
+}
+
+QString GPUAmd::getName()
+{
+    return this->name;
+}
+
+QString GPUAmd::getDriverVersion()
+{
+    return this->driverVersion;
+}
+
+QString GPUAmd::getBusType()
+{
+    return QString("PCI-E x%1 Gen%2 @ x%3")
+            .arg(this->pcieMaxLinkWidth)
+            .arg(this->pcieGen)
+            .arg(this->pcieLinkWidth);
+}
+
+QString GPUAmd::getBusId()
+{
+    return this->busId;
+}
+
+int GPUAmd::getTotalMemory()
+{
+    return this->totalMemory;
+}
+
+int GPUAmd::getCurrentCoreTemp()
+{
+    return this->coreTemp;
+}
+
+int GPUAmd::getCurrentFanSpeed()
+{
+    return this->fanSpeed;
+}
+
+int GPUAmd::getCurrentCoreClock()
+{
+    return this->coreClock;
+}
+
+int GPUAmd::getCurrentMemoryClock()
+{
+    return this->memoryClock;
+}
+
+int GPUAmd::getCurrentCoreUse()
+{
+    return this->coreUse;
+}
+
+int GPUAmd::getCurrentMemoryUse()
+{
+    return this->memoryUse;
+}
+
+bool GPUAmd::isFanControlAvailable()
+{
+    return this->fanWritable;
+}
+
+bool GPUAmd::isFanControlEnabled()
+{
+    return this->fanControlState;
+}
+
+bool GPUAmd::isCoreClockControlAvailable()
+{
+    return false;
+}
+
+bool GPUAmd::isCoreClockControlEnabled()
+{
+    return false;
+}
+
+bool GPUAmd::isMemoryClockControlAvailable()
+{
+    return false;
+}
+
+bool GPUAmd::isMemoryClockControlEnabled()
+{
+    return false;
+}
+
+int GPUAmd::getPcieMaxLinkWidth()
+{
+    return this->pcieMaxLinkWidth;
+}
+
+int GPUAmd::getPcieMaxLinkGen()
+{
+    return this->pcieGen;
+}
+
+int GPUAmd::getPcieLinkWidth()
+{
+    return this->pcieLinkWidth;
+}
+
+int GPUAmd::getPcieLinkGen()
+{
+    return this->pcieLinkGen;
+}
+
+bool GPUAmd::isPowerDrawAvailable()
+{
+    return this->powerFd >= 0;
+}
+
+double GPUAmd::getCurrentPowerDraw()
+{
+    return this->powerDraw;
+}
+
+double GPUAmd::getPowerLimit()
+{
+    return this->powerLimit;
+}
+
+bool GPUAmd::isPowerLimitControlAvailable()
+{
+    return this->powerLimitWritable;
+}
+
+double GPUAmd::getPowerLimitMin()
+{
+    return this->powerLimitMin;
+}
+
+double GPUAmd::getPowerLimitDefault()
+{
+    return this->powerLimitDefault;
+}
+
+double GPUAmd::getPowerLimitMax()
+{
+    return this->powerLimitMax;
+}
+
+/**
+ * Writes power1_cap and reads it back
+ * @param watts
+ * @return True if the limit is applied
+ */
+bool GPUAmd::setPowerLimit(double watts)
+{
+    if(!this->powerLimitWritable) {
+        return false;
+    }
+
+    bool ok = AmdgpuAdapter::writeFd(this->powerCapFd, QByteArray::number(qRound64(watts * MICROWATTS_IN_A_WATT)));
+
+    this->fetchVariables(Power);
+
+    return ok && qAbs(this->powerLimit - watts) < 1;
+}
+
+void GPUAmd::setFanControlEnabled(bool enabled)
+{
+    if(!this->fanWritable) {
+        // Read-only files, the fan stays under the control of the driver
+        return;
+    }
+
+    AmdgpuAdapter::writeFd(this->pwmEnableFd, enabled ? PWM_MODE_MANUAL : PWM_MODE_AUTO);
+
+    this->fetchVariables(FanControlState | FanSpeed);
+}
+
+void GPUAmd::setFanSpeed(int speed)
+{
+    if(!this->isFanControlEnabled()) {
+        // The driver would switch back to automatic mode anyway
+        return;
+    }
+
+    AmdgpuAdapter::writeFd(this->pwmFd, QByteArray::number(qBound(0, speed, 100) * PWM_MAX / 100));
+
+    this->fetchVariables(FanSpeed);
+}
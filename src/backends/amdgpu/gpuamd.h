@@ -0,0 +1,124 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GPUAMD_H
+#define GPUAMD_H
+
+#include <QString>
+
+#include "gpu.h"
+
+/**
+ * AMD Card using the amdgpu kernel driver
+ * Data is read from sysfs and hwmon trough file descriptors kept open, so a sample costs a few syscalls and no process
+ */
+class GPUAmd : public GPU
+{
+public:
+    GPUAmd(int id, QString devicePath);
+    ~GPUAmd();
+
+    void    fetchConstants();
+    void    fetchVariables(Metrics metrics = AllMetrics);
+
+    QString getIdentifier();
+    QString getName();
+    QString getDriverVersion();
+    QString getBusType();
+    QString getBusId();
+    int     getTotalMemory();
+
+    int     getCurrentCoreTemp();
+    int     getCurrentFanSpeed();
+    int     getCurrentCoreClock();
+    int     getCurrentMemoryClock();
+    int     getCurrentCoreUse();
+    int     getCurrentMemoryUse();
+
+    bool    isFanControlAvailable();
+    bool    isFanControlEnabled();
+    bool    isCoreClockControlAvailable();
+    bool    isCoreClockControlEnabled();
+    bool    isMemoryClockControlAvailable();
+    bool    isMemoryClockControlEnabled();
+
+    int     getPcieMaxLinkWidth();
+    int     getPcieMaxLinkGen();
+    int     getPcieLinkWidth();
+    int     getPcieLinkGen();
+
+    bool    isPowerDrawAvailable();
+    double  getCurrentPowerDraw();
+    double  getPowerLimit();
+
+    bool    isPowerLimitControlAvailable();
+    double  getPowerLimitMin();
+    double  getPowerLimitDefault();
+    double  getPowerLimitMax();
+
+    void    setFanControlEnabled(bool enabled);
+    void    setFanSpeed(int speed);
+    bool    setPowerLimit(double watts);
+
+private:
+    QString findHwmonPath();
+    void    readPcieLink();
+
+    // Constants
+    int     id;         // drm card number
+    QString devicePath; // ex: /sys/class/drm/card0/device
+
+    // Constants, read from sysfs
+    QString name;
+    QString driverVersion;
+    QString busId;             // ex: PCI:3:0:0
+    int     pcieMaxLinkWidth;  // ex: 16
+    int     pcieGen;           // ex: 3
+    int     totalMemory;       // MB
+    qint64  totalMemoryBytes;
+    double  powerLimitMin;     // W
+    double  powerLimitDefault; // W
+    double  powerLimitMax;     // W
+
+    // Cached file descriptors, -1 if not available
+    int     tempFd;            // hwmon temp1_input, m°C
+    int     pwmFd;             // hwmon pwm1, 0-255
+    int     pwmEnableFd;       // hwmon pwm1_enable, 1 manual, 2 auto
+    int     sclkFd;            // pp_dpm_sclk
+    int     mclkFd;            // pp_dpm_mclk
+    int     busyFd;            // gpu_busy_percent
+    int     vramUsedFd;        // mem_info_vram_used, bytes
+    int     powerFd;           // hwmon power1_average or power1_input, µW
+    int     powerCapFd;        // hwmon power1_cap, µW
+    bool    fanWritable;
+    bool    powerLimitWritable;
+
+    // Variables
+    int     coreTemp;          // °C
+    int     fanSpeed;          // %
+    int     coreClock;         // MHz
+    int     memoryClock;       // MHz
+    int     coreUse;           // %
+    int     memoryUse;         // % of the VRAM in use
+    bool    fanControlState;
+    int     pcieLinkWidth;     // ex: 16, narrower in low power states
+    int     pcieLinkGen;       // ex: 3, lower in low power states
+    double  powerDraw;         // W
+    double  powerLimit;        // W
+};
+
+#endif // GPUAMD_H
@@ -0,0 +1,11 @@
+#-------------------------------------------------
+#
+# Backend plugins of GPUTweak, built separately from the application
+#
+#-------------------------------------------------
+
+TEMPLATE = subdirs
+
+SUBDIRS += nvidiasettings \
+    nvidiasmi \
+    amdgpu
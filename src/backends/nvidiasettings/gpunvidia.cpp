@@ -0,0 +1,757 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "gpunvidia.h"
+
+#include <QRegularExpression>
+#include <QThread>
+
+#include "nvidiasettingsadapter.h"
+#include "gputrace.h"
+
+using NvidiaAttributes::DESCRIPTORS;
+
+/**
+ * Attributes of the fans and thermal sensors, read for each of them
+ */
+const QString FAN_SPEED_ATTRIBUTE      = "GPUCurrentFanSpeed";
+const QString SENSOR_READING_ATTRIBUTE = "ThermalSensorReading";
+
+/**
+ * @param ID       nvidia id of the GPU
+ * @param Name     Card name
+ * @param topology Fans and thermal sensors of the card, see NvidiaSettingsAdapter::queryTopology()
+ */
+GPUNvidia::GPUNvidia(int ID, QString Name, NvidiaTopology topology) : GPU()
+{
+    this->id             = ID;
+    this->name           = Name;
+    this->fans           = topology.fans;
+    this->thermalSensors = topology.thermalSensors;
+
+    // Variables are only fetched when someone asks for them
+    for(int i=0; i < NvidiaAttributes::AttributeCount; i++) {
+        this->values[i] = 0;
+    }
+    this->values[NvidiaAttributes::CurrentPerfLevel] = -1;
+    this->values[NvidiaAttributes::PowerMizerMode]   = PowerMizerAuto;
+    this->currentFanSpeed                            = 0;
+
+    for(int i=0; i < this->fans.size(); i++) {
+        this->fanSpeeds.append(0);
+    }
+
+    for(int i=0; i < this->thermalSensors.size(); i++) {
+        this->thermalSensorTemps.append(0);
+    }
+
+    this->fetchConstants();
+}
+
+GPUNvidia::~GPUNvidia()
+{
+    // no-op
+}
+
+/**
+ * Reads all the constants with one process, then the clock offsets and the PCI-E link
+ */
+void GPUNvidia::fetchConstants()
+{
+    GPUTWEAK_TRACE_SCOPE("GPUNvidia::fetchConstants");
+
+    this->perfLevel      = 0;
+    this->perfLevelCount = 0;
+    this->prepareTargets();
+
+    this->fetchAttributes(this->prepareFetch(NvidiaAttributes::Constant, 0));
+
+    // ex: "perf=0, nvclock=324, nvclockmin=324, ...; perf=1, ..."
+    QRegularExpressionMatchIterator i = QRegularExpression("perf=(?<level>\\d+)").globalMatch(this->stringValues[NvidiaAttributes::PerfModes]);
+    while(i.hasNext()) {
+        this->perfLevel      = qMax(this->perfLevel, i.next().captured("level").toInt());
+        this->perfLevelCount = this->perfLevel + 1;
+    }
+
+    // The offsets are indexed by the highest performance level
+    this->prepareTargets();
+
+    int min, max;
+    this->powerMizerAvailable = NvidiaSettingsAdapter::queryAttributeRange(this->targets[NvidiaAttributes::PowerMizerMode], min, max);
+
+    // The fans can only be driven with Coolbits 4 in the xorg conf, nvidia-settings reports the state read-only otherwise
+    this->fanControlAvailable = !this->fans.isEmpty()
+            && NvidiaSettingsAdapter::isAttributeWritable(this->targets[NvidiaAttributes::FanControlState]);
+
+    this->fetchClockOffsetRanges();
+    this->fetchAttributes(this->preparedFetch(ClockOffsets | PcieLink));
+}
+
+/**
+ * Builds the full name of every attribute, so refreshes do not format them again
+ */
+void GPUNvidia::prepareTargets()
+{
+    for(int i=0; i < NvidiaAttributes::AttributeCount; i++) {
+        this->targets[i] = QString("[gpu:%1]/%2").arg(this->id).arg(DESCRIPTORS[i].name);
+
+        if(DESCRIPTORS[i].perfLevel) {
+            this->targets[i] += QString("[%1]").arg(this->perfLevel);
+        }
+    }
+
+    this->preparedFetches.clear();
+}
+
+/**
+ * Attributes a card does not have are left out, they would fail the whole process
+ * @param descriptor
+ * @return True if the attribute is read
+ */
+bool GPUNvidia::isQueried(const NvidiaAttributes::Descriptor &descriptor)
+{
+    switch(descriptor.requirement) {
+    case NvidiaAttributes::PerfLevels:
+        return this->perfLevelCount > 0;
+    case NvidiaAttributes::PowerMizer:
+        return this->powerMizerAvailable;
+    case NvidiaAttributes::CoreClockControl:
+        return this->coreClockControlAvailable;
+    case NvidiaAttributes::MemoryClockControl:
+        return this->memoryClockControlAvailable;
+    default:
+        return true;
+    }
+}
+
+/**
+ * Builds the process reading the attributes of a refresh class
+ * List values of the same attribute share one line of the output
+ * @param refresh Constants or variables
+ * @param metrics Metrics of the variables, ignored for the constants
+ * @return Fetch to give to fetchAttributes()
+ */
+GPUNvidia::PreparedFetch GPUNvidia::prepareFetch(NvidiaAttributes::Refresh refresh, Metrics metrics)
+{
+    PreparedFetch fetch;
+    fetch.arguments.append("-t");
+    fetch.fanLine    = -1;
+    fetch.sensorLine = -1;
+    fetch.lineCount  = 0;
+
+    QHash<QString, int> lineOfTarget;
+
+    for(int i=0; i < NvidiaAttributes::AttributeCount; i++) {
+        const NvidiaAttributes::Descriptor &descriptor = DESCRIPTORS[i];
+
+        if(descriptor.refresh != refresh || (refresh == NvidiaAttributes::Variable && !(metrics & descriptor.metrics))
+                || !this->isQueried(descriptor) || this->refusedAttributes.contains(i)) {
+            continue;
+        }
+
+        if(!lineOfTarget.contains(this->targets[i])) {
+            lineOfTarget.insert(this->targets[i], fetch.lineCount++);
+            fetch.arguments << "-q" << this->targets[i];
+        }
+
+        fetch.attributes.append(i);
+        fetch.lines.append(lineOfTarget.value(this->targets[i]));
+    }
+
+    if(refresh == NvidiaAttributes::Variable && (metrics & FanSpeed) && this->refusedFans.size() < this->fans.size()) {
+        fetch.fanLine = fetch.lineCount;
+        for(int i=0; i < this->fans.size(); i++) {
+            if(this->refusedFans.contains(i)) {
+                continue;
+            }
+
+            fetch.arguments << "-q" << QString("[fan:%1]/%2").arg(this->fans.at(i)).arg(FAN_SPEED_ATTRIBUTE);
+            fetch.fans.append(i);
+            fetch.lineCount++;
+        }
+    }
+
+    if(refresh == NvidiaAttributes::Variable && (metrics & CoreTemp) && this->refusedSensors.size() < this->thermalSensors.size()) {
+        fetch.sensorLine = fetch.lineCount;
+        for(int i=0; i < this->thermalSensors.size(); i++) {
+            if(this->refusedSensors.contains(i)) {
+                continue;
+            }
+
+            fetch.arguments << "-q" << QString("[thermalsensor:%1]/%2").arg(this->thermalSensors.at(i)).arg(SENSOR_READING_ATTRIBUTE);
+            fetch.sensors.append(i);
+            fetch.lineCount++;
+        }
+    }
+
+    return fetch;
+}
+
+/**
+ * Fetch of the variables of some metrics, built the first time they are asked for
+ * @param metrics
+ * @return Fetch to give to fetchAttributes()
+ */
+const GPUNvidia::PreparedFetch &GPUNvidia::preparedFetch(Metrics metrics)
+{
+    QHash<int, PreparedFetch>::const_iterator fetch = this->preparedFetches.constFind(metrics);
+
+    if(fetch == this->preparedFetches.constEnd()) {
+        fetch = this->preparedFetches.insert(metrics, this->prepareFetch(NvidiaAttributes::Variable, metrics));
+    }
+
+    return fetch.value();
+}
+
+/**
+ * Arguments of the nvidia-settings process refreshing some metrics
+ * @param metrics
+ * @return Arguments, shared with the ones used by fetchVariables()
+ */
+QStringList GPUNvidia::getFetchArguments(Metrics metrics)
+{
+    return this->preparedFetch(metrics).arguments;
+}
+
+/**
+ * Runs a prepared fetch and stores the values
+ * When the driver refuses one of the attributes, they are read again one by one
+ * so the others are still updated, and the refused ones, fans and sensors included,
+ * are left out of the next fetches so a single process is enough again
+ * @param fetch
+ */
+void GPUNvidia::fetchAttributes(const PreparedFetch &fetch)
+{
+    if(fetch.lineCount == 0) {
+        return;
+    }
+
+    QStringList lines = NvidiaSettingsAdapter::queryArguments(fetch.arguments, fetch.lineCount);
+    QSet<int> refusedLines;
+
+    if(lines.isEmpty()) {
+        for(int i=0; i < fetch.lineCount; i++) {
+            // Arguments are "-t" then "-q" and the target of each line
+            lines.append(NvidiaSettingsAdapter::queryAtrribute(fetch.arguments.at(2 + i * 2)));
+
+            if(lines.last().isEmpty()) {
+                refusedLines.insert(i);
+            }
+        }
+
+        // Nothing answered at all, the driver is not reachable rather than refusing some attributes
+        if(refusedLines.size() == fetch.lineCount) {
+            refusedLines.clear();
+        }
+    }
+
+    for(int i=0; i < fetch.attributes.size(); i++) {
+        if(refusedLines.contains(fetch.lines.at(i))) {
+            this->refusedAttributes.insert(fetch.attributes.at(i));
+        } else {
+            this->storeValue(fetch.attributes.at(i), lines.at(fetch.lines.at(i)));
+        }
+    }
+
+    if(fetch.fanLine >= 0) {
+        int total = 0;
+        int count = 0;
+        for(int i=0; i < fetch.fans.size(); i++) {
+            int fan = fetch.fans.at(i);
+
+            if(refusedLines.contains(fetch.fanLine + i)) {
+                this->refusedFans.insert(fan);
+                continue;
+            }
+
+            this->fanSpeeds[fan] = lines.at(fetch.fanLine + i).toInt();
+            total += this->fanSpeeds.at(fan);
+            count++;
+        }
+
+        // The average of the fans still answering
+        if(count > 0) {
+            this->currentFanSpeed = qRound(static_cast<double>(total) / count);
+        }
+    }
+
+    if(fetch.sensorLine >= 0) {
+        for(int i=0; i < fetch.sensors.size(); i++) {
+            int sensor = fetch.sensors.at(i);
+
+            if(refusedLines.contains(fetch.sensorLine + i)) {
+                this->refusedSensors.insert(sensor);
+            } else {
+                this->thermalSensorTemps[sensor] = lines.at(fetch.sensorLine + i).toInt();
+            }
+        }
+    }
+
+    // Built again without the refused attributes, the fetch given may be one of them
+    if(!refusedLines.isEmpty()) {
+        this->preparedFetches.clear();
+    }
+}
+
+/**
+ * Parses a line of the output according to the type of the attribute
+ * Lines are trimmed here, whether they come from one process or from one per attribute
+ * @param attribute NvidiaAttributes::Attribute
+ * @param line Line of the terse output
+ */
+void GPUNvidia::storeValue(int attribute, const QString &line)
+{
+    const NvidiaAttributes::Descriptor &descriptor = DESCRIPTORS[attribute];
+    QString value = line.trimmed();
+
+    switch(descriptor.type) {
+    case NvidiaAttributes::Integer:
+        this->values[attribute] = value.toInt();
+        break;
+    case NvidiaAttributes::ListValue:
+        this->values[attribute] = NvidiaSettingsAdapter::getValueFromAttributesList(value, QLatin1String(descriptor.listKey));
+        break;
+    case NvidiaAttributes::String:
+        this->stringValues[attribute] = value;
+        break;
+    }
+}
+
+/**
+ * Fetches the valid ranges of the clock offsets
+ * Offsets are only available when enabled with Coolbits in the xorg conf
+ */
+void GPUNvidia::fetchClockOffsetRanges()
+{
+    this->coreClockControlAvailable   = NvidiaSettingsAdapter::queryAttributeRange(this->targets[NvidiaAttributes::CoreClockOffset], this->coreClockOffsetMin, this->coreClockOffsetMax);
+    this->memoryClockControlAvailable = NvidiaSettingsAdapter::queryAttributeRange(this->targets[NvidiaAttributes::MemoryClockOffset], this->memoryClockOffsetMin, this->memoryClockOffsetMax);
+
+    if(!this->coreClockControlAvailable) {
+        this->coreClockOffsetMin = 0;
+        this->coreClockOffsetMax = 0;
+        this->values[NvidiaAttributes::CoreClockOffset] = 0;
+    }
+
+    if(!this->memoryClockControlAvailable) {
+        this->memoryClockOffsetMin = 0;
+        this->memoryClockOffsetMax = 0;
+        this->values[NvidiaAttributes::MemoryClockOffset] = 0;
+    }
+
+    // The offsets are only read when available
+    this->preparedFetches.clear();
+}
+
+/**
+ * Writes a clock offset and reads it back
+ * The previous offset is written again if the driver refused the new one or
+ * did not apply it, so the card is never left in an unknown state
+ * While batching, the offset is only queued
+ * @param attribute NvidiaAttributes::CoreClockOffset or MemoryClockOffset
+ * @param offset New offset in MHz
+ * @param previous Offset in MHz to restore on failure
+ * @return True if the new offset is applied
+ */
+bool GPUNvidia::applyClockOffset(int attribute, int offset, int previous)
+{
+    QString fullAttribute = this->targets[attribute];
+
+    if(NvidiaSettingsAdapter::isBatching()) {
+        // Checked by whoever commits the batch
+        NvidiaSettingsAdapter::setAttribute(fullAttribute, offset);
+        this->values[attribute] = offset;
+        return true;
+    }
+
+    bool ok = NvidiaSettingsAdapter::setAttribute(fullAttribute, offset)
+            && NvidiaSettingsAdapter::queryAtrribute(fullAttribute).toInt() == offset;
+
+    if(!ok) {
+        NvidiaSettingsAdapter::setAttribute(fullAttribute, previous);
+    }
+
+    this->fetchClockOffsetRanges();
+    this->fetchVariables(ClockOffsets | Clocks);
+
+    return ok;
+}
+
+/**
+ * Reads the variables of the metrics, with the fans and sensors, in one process
+ * @param metrics
+ */
+void GPUNvidia::fetchVariables(Metrics metrics)
+{
+    GPUTWEAK_TRACE_SCOPE("GPUNvidia::fetchVariables");
+
+    this->fetchAttributes(this->preparedFetch(metrics));
+    this->lastFetch.start();
+
+    this->updatedMetrics = metrics;
+
+    // Time spent in the subscribers
+    GPUTWEAK_TRACE_SCOPE("GPUNvidia::updated");
+    emit updated();
+}
+
+/**
+ * The values are read from the query cache, shared by all the GPUs and windows, until they expire
+ * @return Milliseconds, 0 when the cache is disabled
+ */
+int GPUNvidia::getRefreshPeriod()
+{
+    return NvidiaSettingsAdapter::getCacheTtl();
+}
+
+/**
+ * Blocks until the values read by the last fetch have expired from the query cache
+ * @param msecs Timeout
+ * @return False if they would still be cached after the timeout
+ */
+bool GPUNvidia::waitForNewValues(int msecs)
+{
+    if(!this->lastFetch.isValid()) {
+        return true;
+    }
+
+    qint64 remaining = NvidiaSettingsAdapter::getCacheTtl() - this->lastFetch.elapsed();
+
+    if(remaining <= 0) {
+        return true;
+    }
+
+    if(remaining > msecs) {
+        return false;
+    }
+
+    QThread::msleep(static_cast<unsigned long>(remaining));
+
+    return true;
+}
+
+QString GPUNvidia::getIdentifier()
+{
+    return QString("gpu:%1").arg(this->id);
+}
+
+QString GPUNvidia::getName()
+{
+    return this->name;
+}
+
+QString GPUNvidia::getDriverVersion()
+{
+    return this->stringValues[NvidiaAttributes::DriverVersion];
+}
+
+QString GPUNvidia::getBusType()
+{
+    return QString("PCI-E x%1 Gen%2 @ x%3")
+            .arg(this->values[NvidiaAttributes::PcieMaxLinkWidth])
+            .arg(this->values[NvidiaAttributes::PcieMaxGen])
+            .arg(this->values[NvidiaAttributes::PcieLinkWidth]);
+}
+
+int GPUNvidia::getPcieMaxLinkWidth()
+{
+    return this->values[NvidiaAttributes::PcieMaxLinkWidth];
+}
+
+int GPUNvidia::getPcieMaxLinkGen()
+{
+    return this->values[NvidiaAttributes::PcieMaxGen];
+}
+
+int GPUNvidia::getPcieLinkWidth()
+{
+    return this->values[NvidiaAttributes::PcieLinkWidth];
+}
+
+int GPUNvidia::getPcieLinkGen()
+{
+    // ex: 8000 for 8 GT/s
+    return GPU::pcieGenFromSpeed(this->values[NvidiaAttributes::PcieLinkSpeed] / 1000.0);
+}
+
+QString GPUNvidia::getBusId()
+{
+    return QString("PCI:%1:%2:%3")
+            .arg(this->values[NvidiaAttributes::PciBus])
+            .arg(this->values[NvidiaAttributes::PciDevice])
+            .arg(this->values[NvidiaAttributes::PciFunc]);
+}
+
+int GPUNvidia::getTotalMemory()
+{
+    return this->values[NvidiaAttributes::TotalMemory];
+}
+
+int GPUNvidia::getCudaCores()
+{
+    return this->values[NvidiaAttributes::CudaCores];
+}
+
+/**
+ * Values of the attributes labelled in NvidiaAttributes::DESCRIPTORS
+ * @param key Name of the attribute, see NvidiaSettingsBackend::getExtraFields()
+ * @return Value with its unit
+ */
+QString GPUNvidia::getExtraValue(QString key)
+{
+    for(int i=0; i < NvidiaAttributes::AttributeCount; i++) {
+        const NvidiaAttributes::Descriptor &descriptor = DESCRIPTORS[i];
+
+        if(!descriptor.label || key != QLatin1String(descriptor.name)) {
+            continue;
+        }
+
+        QString value = descriptor.type == NvidiaAttributes::String ? this->stringValues[i] : QString::number(this->values[i]);
+
+        return value + QString::fromUtf8(descriptor.unit);
+    }
+
+    return GPU::getExtraValue(key);
+}
+
+int GPUNvidia::getCurrentCoreTemp()
+{
+    return this->values[NvidiaAttributes::CoreTemp];
+}
+
+int GPUNvidia::getCurrentFanSpeed()
+{
+    return this->currentFanSpeed;
+}
+
+int GPUNvidia::getCurrentCoreClock()
+{
+    return this->values[NvidiaAttributes::CoreClock];
+}
+
+int GPUNvidia::getCurrentMemoryClock()
+{
+    return this->values[NvidiaAttributes::MemoryClock];
+}
+
+int GPUNvidia::getCurrentCoreUse()
+{
+    return this->values[NvidiaAttributes::CoreUse];
+}
+
+int GPUNvidia::getCurrentMemoryUse()
+{
+    return this->values[NvidiaAttributes::MemoryUse];
+}
+
+int GPUNvidia::getFanCount()
+{
+    return this->fans.size();
+}
+
+int GPUNvidia::getCurrentFanSpeedAt(int index)
+{
+    return this->fanSpeeds.value(index);
+}
+
+int GPUNvidia::getThermalSensorCount()
+{
+    return this->thermalSensors.size();
+}
+
+int GPUNvidia::getThermalSensorTempAt(int index)
+{
+    return this->thermalSensorTemps.value(index);
+}
+
+bool GPUNvidia::isFanControlAvailable()
+{
+    return this->fanControlAvailable;
+}
+
+bool GPUNvidia::isFanControlEnabled()
+{
+    return this->values[NvidiaAttributes::FanControlState] == 1;
+}
+
+bool GPUNvidia::isCoreClockControlAvailable()
+{
+    return this->coreClockControlAvailable;
+}
+
+bool GPUNvidia::isCoreClockControlEnabled()
+{
+    return this->values[NvidiaAttributes::CoreClockOffset] != 0;
+}
+
+bool GPUNvidia::isMemoryClockControlAvailable()
+{
+    return this->memoryClockControlAvailable;
+}
+
+bool GPUNvidia::isMemoryClockControlEnabled()
+{
+    return this->values[NvidiaAttributes::MemoryClockOffset] != 0;
+}
+
+int GPUNvidia::getPerfLevelCount()
+{
+    return this->perfLevelCount;
+}
+
+int GPUNvidia::getCurrentPerfLevel()
+{
+    return this->values[NvidiaAttributes::CurrentPerfLevel];
+}
+
+bool GPUNvidia::isPowerMizerAvailable()
+{
+    return this->powerMizerAvailable;
+}
+
+GPU::PowerMizerMode GPUNvidia::getPowerMizerMode()
+{
+    return static_cast<PowerMizerMode>(this->values[NvidiaAttributes::PowerMizerMode]);
+}
+
+int GPUNvidia::getCoreClockOffset()
+{
+    return this->values[NvidiaAttributes::CoreClockOffset];
+}
+
+int GPUNvidia::getCoreClockOffsetMin()
+{
+    return this->coreClockOffsetMin;
+}
+
+int GPUNvidia::getCoreClockOffsetMax()
+{
+    return this->coreClockOffsetMax;
+}
+
+int GPUNvidia::getMemoryClockOffset()
+{
+    return this->values[NvidiaAttributes::MemoryClockOffset];
+}
+
+int GPUNvidia::getMemoryClockOffsetMin()
+{
+    return this->memoryClockOffsetMin;
+}
+
+int GPUNvidia::getMemoryClockOffsetMax()
+{
+    return this->memoryClockOffsetMax;
+}
+
+void GPUNvidia::setFanControlEnabled(bool enabled)
+{
+    NvidiaSettingsAdapter::setAttribute(this->targets[NvidiaAttributes::FanControlState], static_cast<int>(enabled));
+
+    if(NvidiaSettingsAdapter::isBatching()) {
+        this->values[NvidiaAttributes::FanControlState] = enabled;
+        return;
+    }
+
+    this->fetchVariables(FanControlState | FanSpeed);
+}
+
+void GPUNvidia::setFanSpeed(int speed)
+{
+    if(!this->isFanControlEnabled()) {
+        // Setting fan speed when not in manual mode would trigger an error
+        return;
+    }
+
+    // All the fans of the card are set with one process
+    bool batching = NvidiaSettingsAdapter::isBatching();
+    if(!batching) {
+        NvidiaSettingsAdapter::beginBatch();
+    }
+
+    foreach(int fan, this->fans) {
+        NvidiaSettingsAdapter::setAttribute(QString("[fan:%1]/%2").arg(fan).arg(FAN_SPEED_ATTRIBUTE), speed);
+    }
+
+    if(batching) {
+        this->currentFanSpeed = speed;
+        for(int i=0; i < this->fanSpeeds.size(); i++) {
+            this->fanSpeeds[i] = speed;
+        }
+        return;
+    }
+
+    NvidiaSettingsAdapter::commitBatch();
+
+    this->fetchVariables(FanSpeed);
+}
+
+/**
+ * Sets the speed of one fan of the card
+ * @param index Index of the fan, below getFanCount()
+ * @param speed Speed in %
+ */
+void GPUNvidia::setFanSpeedAt(int index, int speed)
+{
+    if(!this->isFanControlEnabled() || index < 0 || index >= this->fans.size()) {
+        return;
+    }
+
+    NvidiaSettingsAdapter::setAttribute(QString("[fan:%1]/%2").arg(this->fans.at(index)).arg(FAN_SPEED_ATTRIBUTE), speed);
+
+    if(NvidiaSettingsAdapter::isBatching()) {
+        this->fanSpeeds[index] = speed;
+        return;
+    }
+
+    this->fetchVariables(FanSpeed);
+}
+
+bool GPUNvidia::setCoreClockOffset(int offset)
+{
+    if(!this->isCoreClockControlAvailable() || offset < this->coreClockOffsetMin || offset > this->coreClockOffsetMax) {
+        return false;
+    }
+
+    return this->applyClockOffset(NvidiaAttributes::CoreClockOffset, offset, this->values[NvidiaAttributes::CoreClockOffset]);
+}
+
+bool GPUNvidia::setMemoryClockOffset(int offset)
+{
+    if(!this->isMemoryClockControlAvailable() || offset < this->memoryClockOffsetMin || offset > this->memoryClockOffsetMax) {
+        return false;
+    }
+
+    return this->applyClockOffset(NvidiaAttributes::MemoryClockOffset, offset, this->values[NvidiaAttributes::MemoryClockOffset]);
+}
+
+bool GPUNvidia::setPowerMizerMode(PowerMizerMode mode)
+{
+    if(!this->isPowerMizerAvailable()) {
+        return false;
+    }
+
+    bool ok = NvidiaSettingsAdapter::setAttribute(this->targets[NvidiaAttributes::PowerMizerMode], static_cast<int>(mode));
+
+    if(NvidiaSettingsAdapter::isBatching()) {
+        this->values[NvidiaAttributes::PowerMizerMode] = mode;
+        return true;
+    }
+
+    this->fetchVariables(PerfLevel);
+
+    return ok && this->values[NvidiaAttributes::PowerMizerMode] == mode;
+}
@@ -0,0 +1,167 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GPUNVIDIA_H
+#define GPUNVIDIA_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include "gpu.h"
+#include "nvidiaattributes.h"
+#include "nvidiasettingsadapter.h"
+
+/**
+ * NVIDIA Card using the nvidia proprietary driver
+ * Data is accessed trough the nvidia-settings command-line utility
+ */
+class GPUNvidia : public GPU
+{
+public:
+    GPUNvidia(int id, QString name, NvidiaTopology topology);
+    ~GPUNvidia();
+
+    void    fetchConstants();
+    void    fetchVariables(Metrics metrics = AllMetrics);
+
+    int     getRefreshPeriod();
+    bool    waitForNewValues(int msecs);
+
+    QString getIdentifier();
+    QString getName();
+    QString getDriverVersion();
+    QString getBusType();
+    QString getBusId();
+    int     getTotalMemory();
+    int     getCudaCores();
+
+    QString getExtraValue(QString key);
+
+    int     getCurrentCoreTemp();
+    int     getCurrentFanSpeed();
+    int     getCurrentCoreClock();
+    int     getCurrentMemoryClock();
+    int     getCurrentCoreUse();
+    int     getCurrentMemoryUse();
+
+    int     getFanCount();
+    int     getCurrentFanSpeedAt(int index);
+    int     getThermalSensorCount();
+    int     getThermalSensorTempAt(int index);
+
+    bool    isFanControlAvailable();
+    bool    isFanControlEnabled();
+    bool    isCoreClockControlAvailable();
+    bool    isCoreClockControlEnabled();
+    bool    isMemoryClockControlAvailable();
+    bool    isMemoryClockControlEnabled();
+
+    int     getCoreClockOffset();
+    int     getCoreClockOffsetMin();
+    int     getCoreClockOffsetMax();
+    int     getMemoryClockOffset();
+    int     getMemoryClockOffsetMin();
+    int     getMemoryClockOffsetMax();
+
+    int     getPerfLevelCount();
+    int     getCurrentPerfLevel();
+
+    bool           isPowerMizerAvailable();
+    PowerMizerMode getPowerMizerMode();
+
+    int     getPcieMaxLinkWidth();
+    int     getPcieMaxLinkGen();
+    int     getPcieLinkWidth();
+    int     getPcieLinkGen();
+
+    void    setFanControlEnabled(bool enabled);
+    void    setFanSpeed(int speed);
+    void    setFanSpeedAt(int index, int speed);
+    bool    setCoreClockOffset(int offset);
+    bool    setMemoryClockOffset(int offset);
+    bool    setPowerMizerMode(PowerMizerMode mode);
+
+    QStringList getFetchArguments(Metrics metrics);
+
+private:
+    /**
+     * One nvidia-settings process reading attributes of the GPU, its fans and its sensors
+     */
+    struct PreparedFetch {
+        QStringList  arguments;  // ex: -t -q [gpu:0]/GPUCoreTemp -q [fan:0]/GPUCurrentFanSpeed
+        QVector<int> attributes; // NvidiaAttributes::Attribute of each parsed value
+        QVector<int> lines;      // line of the output holding each of them
+        int          fanLine;    // first line of the fan speeds, -1 if not read
+        QVector<int> fans;       // index in GPUNvidia::fans of each line from fanLine
+        int          sensorLine; // first line of the thermal sensors, -1 if not read
+        QVector<int> sensors;    // index in GPUNvidia::thermalSensors of each line from sensorLine
+        int          lineCount;
+    };
+
+    void    prepareTargets();
+    bool    isQueried(const NvidiaAttributes::Descriptor &descriptor);
+    PreparedFetch        prepareFetch(NvidiaAttributes::Refresh refresh, Metrics metrics);
+    const PreparedFetch &preparedFetch(Metrics metrics);
+    void    fetchAttributes(const PreparedFetch &fetch);
+    void    storeValue(int attribute, const QString &line);
+    void    fetchClockOffsetRanges();
+    bool    applyClockOffset(int attribute, int offset, int previous);
+
+    // Constants
+    int     id;   // nvidia id of the gpu (0-based)
+    QString name; // card name, comes from the cards list
+    QList<int> fans;           // ids of the [fan:N] targets cooling the card
+    QList<int> thermalSensors; // ids of the [thermalsensor:N] targets of the card
+
+    // Queries, built once
+    QString targets[NvidiaAttributes::AttributeCount]; // ex: [gpu:0]/GPUGraphicsClockOffset[3]
+    QHash<int, PreparedFetch> preparedFetches;         // by metrics, see fetchVariables()
+    QSet<int> refusedAttributes;                       // refused by the driver, no longer queried
+    QSet<int> refusedFans;                             // indexes in fans, same
+    QSet<int> refusedSensors;                          // indexes in thermalSensors, same
+
+    // Values of the attributes, see NvidiaAttributes::DESCRIPTORS
+    int     values[NvidiaAttributes::AttributeCount];
+    QString stringValues[NvidiaAttributes::AttributeCount]; // of the String attributes
+
+    // Derived from the constants
+    int     perfLevel;               // highest performance level, the one the offsets apply to
+    int     perfLevelCount;          // 0 if GPUPerfModes is not reported
+    bool    powerMizerAvailable;
+    bool    fanControlAvailable;     // fans found and GPUFanControlState writable
+
+    // Clock offset ranges, fetched at start and after an offset is set
+    bool    coreClockControlAvailable;
+    int     coreClockOffsetMin;      // MHz
+    int     coreClockOffsetMax;      // MHz
+    bool    memoryClockControlAvailable;
+    int     memoryClockOffsetMin;    // MHz, of the memory transfer rate
+    int     memoryClockOffsetMax;    // MHz
+
+    // Variables of the fans and sensors
+    int     currentFanSpeed;         // %, average of the fans
+    QList<int> fanSpeeds;            // %, in the order of fans
+    QList<int> thermalSensorTemps;   // °C, in the order of thermalSensors
+    QElapsedTimer lastFetch;         // since the end of the last fetchVariables()
+};
+
+#endif // GPUNVIDIA_H
@@ -0,0 +1,132 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef NVIDIAATTRIBUTES_H
+#define NVIDIAATTRIBUTES_H
+
+#include "gpu.h"
+
+/**
+ * Description of the nvidia-settings attributes read for a GPU
+ * The queries, the parsing and the extra rows of the info window are all generated from DESCRIPTORS
+ */
+namespace NvidiaAttributes
+{
+    /**
+     * Values read for a GPU, in the order of DESCRIPTORS
+     */
+    enum Attribute {
+        DriverVersion,
+        PcieMaxLinkWidth,
+        PcieMaxGen,
+        PciBus,
+        PciDevice,
+        PciFunc,
+        TotalMemory,
+        CudaCores,
+        PerfModes,
+        CoreTemp,
+        CoreClock,
+        MemoryClock,
+        CoreUse,
+        MemoryUse,
+        FanControlState,
+        CurrentPerfLevel,
+        PowerMizerMode,
+        CoreClockOffset,
+        MemoryClockOffset,
+        PcieLinkWidth,
+        PcieLinkSpeed,
+        AttributeCount
+    };
+
+    /**
+     * How the output of the attribute is parsed
+     */
+    enum Type {
+        Integer,
+        String,
+        ListValue // one value of a "key=value, key=value" list
+    };
+
+    enum Refresh {
+        Constant, // read once when the GPU is created
+        Variable  // read by GPUNvidia::fetchVariables() for its metrics
+    };
+
+    /**
+     * Condition for a variable to be queried, attributes missing from a card would fail the whole batch
+     */
+    enum Requirement {
+        Always,
+        PerfLevels,
+        PowerMizer,
+        CoreClockControl,
+        MemoryClockControl
+    };
+
+    struct Descriptor {
+        Attribute   attribute;
+        const char *name;        // name of the nvidia-settings attribute
+        Type        type;
+        const char *listKey;     // key of a ListValue, ex: nvclock
+        const char *unit;        // appended to the displayed value
+        Refresh     refresh;
+        int         metrics;     // GPU::Metric refreshing a variable
+        Requirement requirement;
+        bool        perfLevel;   // indexed by the highest performance level, ex: GPUGraphicsClockOffset[3]
+        const char *label;       // extra row of the info window, 0 for the values it already shows
+    };
+
+    constexpr Descriptor DESCRIPTORS[] = {
+        {DriverVersion,     "NvidiaDriverVersion",         String,    0,          "",      Constant, 0,                    Always,             false, 0},
+        {PcieMaxLinkWidth,  "PCIEMaxLinkWidth",            Integer,   0,          "",      Constant, 0,                    Always,             false, 0},
+        {PcieMaxGen,        "PCIEGen",                     Integer,   0,          "",      Constant, 0,                    Always,             false, 0},
+        {PciBus,            "PCIBus",                      Integer,   0,          "",      Constant, 0,                    Always,             false, 0},
+        {PciDevice,         "PCIDevice",                   Integer,   0,          "",      Constant, 0,                    Always,             false, 0},
+        {PciFunc,           "PCIFunc",                     Integer,   0,          "",      Constant, 0,                    Always,             false, 0},
+        {TotalMemory,       "TotalDedicatedGPUMemory",     Integer,   0,          " MB",   Constant, 0,                    Always,             false, 0},
+        {CudaCores,         "CUDACores",                   Integer,   0,          "",      Constant, 0,                    Always,             false, "Cuda Cores"},
+        {PerfModes,         "GPUPerfModes",                String,    0,          "",      Constant, 0,                    Always,             false, 0},
+        {CoreTemp,          "GPUCoreTemp",                 Integer,   0,          " °C",   Variable, GPU::CoreTemp,        Always,             false, 0},
+        {CoreClock,         "GPUCurrentClockFreqsString",  ListValue, "nvclock",  " MHz",  Variable, GPU::Clocks,          Always,             false, 0},
+        {MemoryClock,       "GPUCurrentClockFreqsString",  ListValue, "memclock", " MHz",  Variable, GPU::Clocks,          Always,             false, 0},
+        {CoreUse,           "GPUUtilization",              ListValue, "graphics", " %",    Variable, GPU::Utilization,     Always,             false, 0},
+        {MemoryUse,         "GPUUtilization",              ListValue, "memory",   " %",    Variable, GPU::Utilization,     Always,             false, 0},
+        {FanControlState,   "GPUFanControlState",          Integer,   0,          "",      Variable, GPU::FanControlState, Always,             false, 0},
+        {CurrentPerfLevel,  "GPUCurrentPerfLevel",         Integer,   0,          "",      Variable, GPU::PerfLevel,       PerfLevels,         false, 0},
+        {PowerMizerMode,    "GPUPowerMizerMode",           Integer,   0,          "",      Variable, GPU::PerfLevel,       PowerMizer,         false, 0},
+        {CoreClockOffset,   "GPUGraphicsClockOffset",      Integer,   0,          " MHz",  Variable, GPU::ClockOffsets,    CoreClockControl,   true,  0},
+        {MemoryClockOffset, "GPUMemoryTransferRateOffset", Integer,   0,          " MHz",  Variable, GPU::ClockOffsets,    MemoryClockControl, true,  0},
+        {PcieLinkWidth,     "PCIECurrentLinkWidth",        Integer,   0,          "",      Variable, GPU::PcieLink,        Always,             false, 0},
+        {PcieLinkSpeed,     "PCIECurrentLinkSpeed",        Integer,   0,          " MT/s", Variable, GPU::PcieLink,        Always,             false, 0}
+    };
+
+    /**
+     * @param i First index to check
+     * @return True if every descriptor from i is at the index of its attribute
+     */
+    constexpr bool isOrdered(int i = 0)
+    {
+        return i == AttributeCount || (DESCRIPTORS[i].attribute == i && isOrdered(i + 1));
+    }
+
+    static_assert(sizeof(DESCRIPTORS) / sizeof(Descriptor) == AttributeCount, "One descriptor is needed for each attribute");
+    static_assert(isOrdered(), "Descriptors must be in the order of the attributes");
+}
+
+#endif // NVIDIAATTRIBUTES_H
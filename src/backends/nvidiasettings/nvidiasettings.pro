@@ -0,0 +1,32 @@
+#-------------------------------------------------
+#
+# nvidia-settings backend plugin of GPUTweak
+#
+#-------------------------------------------------
+
+QT       += core
+
+TARGET = gputweak-nvidiasettings
+TEMPLATE = lib
+CONFIG += plugin
+
+# Plugins are gathered next to each other, GPUTweak looks for them in its "backends" directory
+DESTDIR = $$OUT_PWD/..
+
+# Shared interfaces of the application, their symbols are exported by the executable
+INCLUDEPATH += ../..
+
+# Trace spans, like the executable
+tracing: DEFINES += GPUTWEAK_TRACING
+
+SOURCES += nvidiasettingsbackend.cpp \
+    gpunvidia.cpp \
+    nvidiasettingsadapter.cpp
+
+HEADERS += nvidiasettingsbackend.h \
+    gpunvidia.h \
+    nvidiaattributes.h \
+    nvidiasettingsadapter.h \
+    ../../gpubackend.h
+
+OTHER_FILES += nvidiasettings.json
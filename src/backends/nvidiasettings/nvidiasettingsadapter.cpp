@@ -0,0 +1,807 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "nvidiasettingsadapter.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QProcess>
+#include <QRegularExpression>
+#include <QWaitCondition>
+
+#include <algorithm>
+
+#include "gpunvidia.h"
+#include "gpudiagnostics.h"
+#include "gputrace.h"
+
+/**
+ * nvidia-settings command line utility path
+ */
+const QString NVIDIA_SETTINGS_CMD = "nvidia-settings";
+/**
+ * Environment variable overriding the nvidia-settings path, used to run against a fake tool
+ */
+const char *NVIDIA_SETTINGS_CMD_ENV = "GPUTWEAK_NVIDIA_SETTINGS";
+/**
+ * Line of a GPU in the output of "-q gpus", ex: "[0] host:0[gpu:0] (GeForce GTX 1080)"
+ */
+const QString GPU_LINE_PATTERN = "\\[gpu:(?<id>\\d+)\\] +\\((?<name>[A-Za-z0-9 ]+)\\)";
+/**
+ * Line of an attribute queried for all the GPUs, ex: "Attribute 'PCIBus' (host:0[gpu:0]): 1."
+ */
+const QString ATTRIBUTE_LINE_PATTERN = "Attribute '(?<attribute>\\w+)' \\([^)]*\\[gpu:(?<id>\\d+)\\]\\): (?<value>-?\\d+)\\.";
+/**
+ * Target in the verbose list of the GPUs, fans and thermal sensors, ex: "    [0] host:0[fan:1] (Fan 1)"
+ * Targets connected to the one listed above them are indented deeper
+ */
+const QString TARGET_LINE_PATTERN = "^(?<indent> *)\\[\\d+\\] +\\S*\\[(?<type>gpu|fan|thermalsensor):(?<id>\\d+)\\]";
+/**
+ * Age after which a queried value is read again from the driver, see setCacheTtl()
+ */
+const int DEFAULT_CACHE_TTL_MSECS = 250;
+
+namespace
+{
+    struct CachedValue {
+        QString value;
+        qint64  time; // msecs of QueryCache::clock when the query started
+    };
+
+    struct Flight {
+        QStringList arguments;
+        qint64      start;
+    };
+
+    /**
+     * Values recently read, by target, ex: [gpu:0]/GPUCoreTemp
+     * Shared by all the threads, a query asked for while the same one runs waits for its result
+     */
+    struct QueryCache {
+        QueryCache();
+
+        QMutex                      mutex;
+        QWaitCondition              finished; // woken when a query in flight ends
+        QElapsedTimer               clock;
+        int                         ttlMsecs;
+        QHash<QString, CachedValue> values;
+        QHash<QString, qint64>      writes;   // time of the last assignment of each target
+        QList<Flight>               inFlight; // queries running
+    };
+
+    QueryCache::QueryCache()
+    {
+        this->clock.start();
+        this->ttlMsecs = DEFAULT_CACHE_TTL_MSECS;
+    }
+}
+
+Q_GLOBAL_STATIC(QueryCache, queryCache)
+
+/**
+ * Assignments waiting for commitBatch(), only used from the GUI thread
+ */
+static bool        batching = false;
+static QStringList pendingAssignments;
+
+/**
+ * GPUs listed by the last enumerate(), by bus id, only used from the GUI thread
+ */
+struct EnumeratedGPU {
+    int     id;
+    QString name;
+};
+static QHash<QString, EnumeratedGPU> enumeratedGPUs;
+
+/**
+ * Records a query in the diagnostics, split by target
+ * @param attribute Attribute with its target, ex: [gpu:0]/GPUCoreTemp
+ * @param timer     Started before the query
+ * @param ok        False if the query failed
+ */
+static void recordQuery(QString attribute, const QElapsedTimer &timer, bool ok)
+{
+    QString target = "host";
+    int targetEnd = attribute.indexOf("]/");
+
+    if(attribute.startsWith("[") && targetEnd > 0) {
+        target    = attribute.mid(1, targetEnd - 1);
+        attribute = attribute.mid(targetEnd + 2);
+    }
+
+    GPUDiagnostics::recordQuery(target, attribute, timer.nsecsElapsed(), ok);
+}
+
+/**
+ * Waits for a started nvidia-settings process
+ * @param process Started process
+ * @param ok Set to true if the command exited normally with a zero status and reported no error
+ * @return String containing all the standard output
+ */
+static QString finishProcess(QProcess &process, bool *ok)
+{
+    {
+        GPUTWEAK_TRACE_SCOPE("wait nvidia-settings");
+        process.waitForFinished(-1);
+    }
+
+    // nvidia-settings exits with 0 even when an assignment is refused, it is only reported on the standard error
+    if(ok) {
+        *ok = process.exitStatus() == QProcess::NormalExit && process.exitCode() == 0
+                && !process.readAllStandardError().contains("ERROR");
+    }
+
+    return QString(process.readAllStandardOutput());
+}
+
+/**
+ * Values of all the queried targets, if they are recent enough
+ * The cache mutex must be locked
+ * @param cache
+ * @param arguments Terse queries, "-t" then "-q" and a target for each value
+ * @param oldest Time of the oldest values accepted
+ * @param values Set to the values in the order of the targets
+ * @return False if one of them is missing or too old
+ */
+static bool cachedValues(QueryCache *cache, const QStringList &arguments, qint64 oldest, QStringList &values)
+{
+    for(int i=2; i < arguments.size(); i += 2) {
+        QHash<QString, CachedValue>::const_iterator cached = cache->values.constFind(arguments.at(i));
+
+        if(cached == cache->values.constEnd() || cached.value().time < oldest) {
+            return false;
+        }
+
+        values.append(cached.value().value);
+    }
+
+    return true;
+}
+
+/**
+ * Finds a running query
+ * The cache mutex must be locked
+ * @param cache
+ * @param arguments
+ * @return Index in QueryCache::inFlight, -1 if not running
+ */
+static int findFlight(QueryCache *cache, const QStringList &arguments)
+{
+    for(int i=0; i < cache->inFlight.size(); i++) {
+        if(cache->inFlight.at(i).arguments == arguments) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * Values of the queried targets, from the cache or from one nvidia-settings process
+ * A query already running in another thread is waited for instead of being run again
+ * @param arguments Terse queries, "-t" then "-q" and a target for each value
+ * @param count Number of values
+ * @param label Name of the query in the diagnostics
+ * @return Value of each target in the same order, empty if one of them failed
+ */
+static QStringList cachedQuery(const QStringList &arguments, int count, const QString &label)
+{
+    QueryCache *cache = queryCache();
+    QMutexLocker locker(&cache->mutex);
+
+    // Values younger than the TTL, none with 0
+    bool   coalesced = false;
+    qint64 oldest    = cache->clock.elapsed() - cache->ttlMsecs + 1;
+
+    forever {
+        QStringList values;
+        if(cachedValues(cache, arguments, oldest, values)) {
+            // A query waited for is counted once, as coalesced
+            if(!coalesced) {
+                GPUDiagnostics::count(GPUDiagnostics::DriverQueryCacheHits);
+            }
+            return values;
+        }
+
+        int flight = findFlight(cache, arguments);
+        if(flight < 0) {
+            break;
+        }
+
+        if(!coalesced) {
+            GPUDiagnostics::count(GPUDiagnostics::DriverQueriesCoalesced);
+            coalesced = true;
+        }
+
+        // Whatever the age limit, the values of the query waited for are taken
+        oldest = qMin(oldest, cache->inFlight.at(flight).start);
+
+        // They are not stored if it failed or a target was written meanwhile, the query is then run again
+        cache->finished.wait(&cache->mutex);
+    }
+
+    Flight flight;
+    flight.arguments = arguments;
+    flight.start     = cache->clock.elapsed();
+    cache->inFlight.append(flight);
+
+    locker.unlock();
+
+    QElapsedTimer timer;
+    timer.start();
+
+    bool ok;
+    QStringList values = NvidiaSettingsAdapter::cmdLineProcess(arguments, &ok).split('\n', QString::SkipEmptyParts);
+
+    // A failed query prints nothing on the standard output, the values would be shifted
+    ok = ok && values.size() == count;
+
+    recordQuery(label, timer, ok);
+
+    locker.relock();
+
+    cache->inFlight.removeAt(findFlight(cache, arguments));
+
+    if(ok) {
+        for(int i=0; i < count; i++) {
+            const QString &target = arguments.at(2 + i * 2);
+
+            // Read before an assignment that ended while it ran
+            if(cache->writes.value(target, -1) >= flight.start) {
+                continue;
+            }
+
+            CachedValue cached;
+            cached.value = values.at(i);
+            cached.time  = flight.start;
+            cache->values.insert(target, cached);
+        }
+    }
+
+    cache->finished.wakeAll();
+
+    return ok ? values : QStringList();
+}
+
+/**
+ * Drops the cached value of an assigned attribute
+ * Queries that started before are not cached either
+ * @param attribute Name of the attribute, with its target
+ */
+static void invalidate(const QString &attribute)
+{
+    QueryCache *cache = queryCache();
+    QMutexLocker locker(&cache->mutex);
+
+    cache->values.remove(attribute);
+    cache->writes.insert(attribute, cache->clock.elapsed());
+}
+
+/**
+ * Path of the nvidia-settings utility
+ * @return Command
+ */
+QString NvidiaSettingsAdapter::command()
+{
+    QString cmd = QString::fromLocal8Bit(qgetenv(NVIDIA_SETTINGS_CMD_ENV));
+
+    return cmd.isEmpty() ? NVIDIA_SETTINGS_CMD : cmd;
+}
+
+/**
+ * Execute the given shell command and return the output
+ * @param command Command to run
+ * @param ok Set to true if the command exited normally with a zero status and reported no error
+ * @return String containing all the standard output
+ */
+QString NvidiaSettingsAdapter::cmdLineProcess(QString command, bool *ok)
+{
+    GPUTWEAK_TRACE_SCOPE("NvidiaSettingsAdapter::cmdLineProcess");
+
+    GPUDiagnostics::count(GPUDiagnostics::ProcessSpawns);
+
+    QProcess process;
+
+    {
+        GPUTWEAK_TRACE_SCOPE("spawn nvidia-settings");
+        process.start(command);
+        process.waitForStarted(-1);
+    }
+
+    return finishProcess(process, ok);
+}
+
+/**
+ * Runs nvidia-settings with the given arguments and return the output
+ * The arguments are passed as they are, nothing is joined or split again
+ * @param arguments Arguments of the tool
+ * @param ok Set to true if the command exited normally with a zero status and reported no error
+ * @return String containing all the standard output
+ */
+QString NvidiaSettingsAdapter::cmdLineProcess(const QStringList &arguments, bool *ok)
+{
+    GPUTWEAK_TRACE_SCOPE("NvidiaSettingsAdapter::cmdLineProcess");
+
+    GPUDiagnostics::count(GPUDiagnostics::ProcessSpawns);
+
+    QProcess process;
+
+    {
+        GPUTWEAK_TRACE_SCOPE("spawn nvidia-settings");
+        process.start(NvidiaSettingsAdapter::command(), arguments);
+        process.waitForStarted(-1);
+    }
+
+    return finishProcess(process, ok);
+}
+
+/**
+ * Queries the driver for a string attribute
+ * @param attribute Name of the attribute
+ * @return Value of the attribute
+ */
+QString NvidiaSettingsAdapter::queryAtrribute(QString attribute)
+{
+    // -q for data query, -t for value only
+    return cachedQuery(QStringList() << "-t" << "-q" << attribute, 1, attribute).value(0);
+}
+
+/**
+ * Queries several attributes with a single nvidia-settings process
+ * @param attributes Names of the attributes, with their targets
+ * @return Value of each attribute in the same order, empty if one of them failed
+ */
+QStringList NvidiaSettingsAdapter::queryAttributes(QStringList attributes)
+{
+    QStringList arguments("-t");
+    foreach(QString attribute, attributes) {
+        arguments << "-q" << attribute;
+    }
+
+    return NvidiaSettingsAdapter::queryArguments(arguments, attributes.size());
+}
+
+/**
+ * Queries several attributes with arguments built beforehand, see GPUNvidia::prepareFetch()
+ * @param arguments Terse (-t) queries, ex: -t -q [gpu:0]/GPUCoreTemp -q [fan:0]/GPUCurrentFanSpeed
+ * @param count Number of values asked for
+ * @return Value of each attribute in the same order, empty if one of them failed
+ */
+QStringList NvidiaSettingsAdapter::queryArguments(const QStringList &arguments, int count)
+{
+    return cachedQuery(arguments, count, QString("batch query %1").arg(count));
+}
+
+/**
+ * Sets how long a queried value is reused
+ * Queries for the same values running at the same time are shared even with 0
+ * @param msecs Age in ms, 0 to always ask the driver
+ */
+void NvidiaSettingsAdapter::setCacheTtl(int msecs)
+{
+    QueryCache *cache = queryCache();
+    QMutexLocker locker(&cache->mutex);
+
+    cache->ttlMsecs = msecs;
+}
+
+int NvidiaSettingsAdapter::getCacheTtl()
+{
+    QueryCache *cache = queryCache();
+    QMutexLocker locker(&cache->mutex);
+
+    return cache->ttlMsecs;
+}
+
+/**
+ * Forgets all the queried values, ex: when the cards changed
+ */
+void NvidiaSettingsAdapter::clearCache()
+{
+    QueryCache *cache = queryCache();
+    QMutexLocker locker(&cache->mutex);
+
+    cache->values.clear();
+}
+
+/**
+ * Queries the driver for the valid values of an integer attribute
+ * They are only given by the full (non-terse) output, ex:
+ * "The valid values for 'GPUGraphicsClockOffset' are in the range -200 - 1200 (inclusive)."
+ * @param attribute Name of the attribute
+ * @param min Set to the minimum value
+ * @param max Set to the maximum value
+ * @return False if the attribute is not available or read-only
+ */
+bool NvidiaSettingsAdapter::queryAttributeRange(QString attribute, int &min, int &max)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    bool ok;
+    QString out = NvidiaSettingsAdapter::cmdLineProcess(QString("%1 -q %2").arg(NvidiaSettingsAdapter::command()).arg(attribute), &ok);
+
+    recordQuery(attribute + " range", timer, ok);
+
+    QRegularExpression rangeLine("are in the range (?<min>-?\\d+) - (?<max>-?\\d+)");
+
+    QRegularExpressionMatch match = rangeLine.match(out);
+    if(!match.hasMatch() || out.contains("read-only")) {
+        return false;
+    }
+
+    min = match.captured("min").toInt();
+    max = match.captured("max").toInt();
+
+    return min < max;
+}
+
+/**
+ * Queries the driver for the permissions of an attribute, given by the full (non-terse) output
+ * Unlike queryAttributeRange, it works with the attributes whose valid values are not a range, ex: booleans
+ * @param attribute Name of the attribute
+ * @return False if the attribute is not available or read-only
+ */
+bool NvidiaSettingsAdapter::isAttributeWritable(QString attribute)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    bool ok;
+    QString out = NvidiaSettingsAdapter::cmdLineProcess(QString("%1 -q %2").arg(NvidiaSettingsAdapter::command()).arg(attribute), &ok);
+
+    recordQuery(attribute + " permissions", timer, ok);
+
+    return ok && out.contains("Attribute '") && !out.contains("read-only");
+}
+
+/**
+ * Lists the fans and thermal sensors of every GPU with a single nvidia-settings process
+ * @return Topology of each GPU by id
+ */
+QMap<int, NvidiaTopology> NvidiaSettingsAdapter::queryTopology()
+{
+    GPUTWEAK_TRACE_SCOPE("NvidiaSettingsAdapter::queryTopology");
+
+    QElapsedTimer timer;
+    timer.start();
+
+    bool ok;
+    QString out = NvidiaSettingsAdapter::cmdLineProcess(QString("%1 --verbose -q gpus -q fans -q thermalsensors").arg(NvidiaSettingsAdapter::command()), &ok);
+
+    recordQuery("topology", timer, ok);
+
+    QMap<int, NvidiaTopology> topologies;
+
+    QRegularExpressionMatchIterator i = QRegularExpression(GPU_LINE_PATTERN).globalMatch(out);
+    while(i.hasNext()) {
+        int id = i.next().captured("id").toInt();
+        topologies.insert(id, NvidiaSettingsAdapter::parseTopology(out, id));
+    }
+
+    return topologies;
+}
+
+/**
+ * Finds the fans and thermal sensors of a GPU in the verbose target lists
+ * The connections can be listed under the GPU or under the fan or sensor, both are read
+ * Drivers that list no connection get the old assumption that fan N cools GPU N
+ * @param out Output of queryTopology()
+ * @param gpu Id of the GPU
+ * @return Topology of the GPU
+ */
+NvidiaTopology NvidiaSettingsAdapter::parseTopology(QString out, int gpu)
+{
+    QRegularExpression targetLine(TARGET_LINE_PATTERN);
+
+    NvidiaTopology topology;
+
+    // Listed target the following deeper lines are connected to
+    QString sectionType;
+    int     sectionId     = -1;
+    int     sectionIndent = -1;
+    bool    connections   = false;
+
+    foreach(QString line, out.split("\n")) {
+        QRegularExpressionMatch match = targetLine.match(line);
+        if(!match.hasMatch()) {
+            continue;
+        }
+
+        QString type   = match.captured("type");
+        int     id     = match.captured("id").toInt();
+        int     indent = match.captured("indent").length();
+
+        if(sectionIndent < 0 || indent <= sectionIndent) {
+            sectionType   = type;
+            sectionId     = id;
+            sectionIndent = indent;
+            continue;
+        }
+
+        connections = true;
+
+        // Connection of the section to this target, in either direction
+        if(sectionType == "gpu" && sectionId == gpu) {
+            if(type == "fan" && !topology.fans.contains(id)) {
+                topology.fans.append(id);
+            } else if(type == "thermalsensor" && !topology.thermalSensors.contains(id)) {
+                topology.thermalSensors.append(id);
+            }
+        } else if(type == "gpu" && id == gpu) {
+            if(sectionType == "fan" && !topology.fans.contains(sectionId)) {
+                topology.fans.append(sectionId);
+            } else if(sectionType == "thermalsensor" && !topology.thermalSensors.contains(sectionId)) {
+                topology.thermalSensors.append(sectionId);
+            }
+        }
+    }
+
+    if(!connections) {
+        topology.fans.append(gpu);
+    }
+
+    std::sort(topology.fans.begin(), topology.fans.end());
+    std::sort(topology.thermalSensors.begin(), topology.thermalSensors.end());
+
+    return topology;
+}
+
+/**
+ * Get a list of all GPUs detected by this adapter
+ * @return List of GPUs
+ */
+QList<GPU*> NvidiaSettingsAdapter::getGPUs()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    bool ok;
+    QString out = NvidiaSettingsAdapter::cmdLineProcess(QString("%1 -q gpus").arg(NvidiaSettingsAdapter::command()), &ok);
+
+    recordQuery("gpus", timer, ok);
+
+    // TODO: something special if the command fail ?
+
+    QRegularExpression gpuLine(GPU_LINE_PATTERN);
+
+    QRegularExpressionMatchIterator i = gpuLine.globalMatch(out);
+
+    QList<GPU*> list;
+
+    if(!i.hasNext()) {
+        return list;
+    }
+
+    QMap<int, NvidiaTopology> topologies = NvidiaSettingsAdapter::queryTopology();
+
+    NvidiaSettingsAdapter::clearCache();
+
+    while (i.hasNext()) {
+        QRegularExpressionMatch match = i.next();
+        int id = match.captured("id").toInt();
+        list.append(new GPUNvidia(id, match.captured("name"), topologies.value(id)));
+    }
+
+    return list;
+}
+
+/**
+ * Lists the GPUs and their bus ids with a single nvidia-settings process
+ * @return Identifier of each GPU by bus id, empty if the tool failed
+ */
+QMap<QString, QString> NvidiaSettingsAdapter::enumerate()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    bool ok;
+    QString out = NvidiaSettingsAdapter::cmdLineProcess(QString("%1 -q gpus -q PCIBus -q PCIDevice -q PCIFunc").arg(NvidiaSettingsAdapter::command()), &ok);
+
+    recordQuery("enumerate", timer, ok);
+
+    QHash<int, QString> names;
+
+    QRegularExpressionMatchIterator i = QRegularExpression(GPU_LINE_PATTERN).globalMatch(out);
+    while(i.hasNext()) {
+        QRegularExpressionMatch match = i.next();
+        names.insert(match.captured("id").toInt(), match.captured("name"));
+    }
+
+    // PCIBus, PCIDevice and PCIFunc of each GPU
+    QHash<int, QHash<QString, int> > addresses;
+
+    i = QRegularExpression(ATTRIBUTE_LINE_PATTERN).globalMatch(out);
+    while(i.hasNext()) {
+        QRegularExpressionMatch match = i.next();
+        addresses[match.captured("id").toInt()].insert(match.captured("attribute"), match.captured("value").toInt());
+    }
+
+    enumeratedGPUs.clear();
+
+    QMap<QString, QString> list;
+
+    QHashIterator<int, QString> gpu(names);
+    while(gpu.hasNext()) {
+        gpu.next();
+
+        QHash<QString, int> address = addresses.value(gpu.key());
+        if(!address.contains("PCIBus") || !address.contains("PCIDevice") || !address.contains("PCIFunc")) {
+            continue;
+        }
+
+        // Same format as GPUNvidia::getBusId()
+        QString busId = QString("PCI:%1:%2:%3")
+                .arg(address.value("PCIBus"))
+                .arg(address.value("PCIDevice"))
+                .arg(address.value("PCIFunc"));
+
+        EnumeratedGPU enumerated;
+        enumerated.id   = gpu.key();
+        enumerated.name = gpu.value();
+        enumeratedGPUs.insert(busId, enumerated);
+
+        list.insert(busId, QString("gpu:%1").arg(gpu.key()));
+    }
+
+    return list;
+}
+
+/**
+ * Creates a GPU listed by the last enumerate()
+ * @param busId
+ * @return GPU, 0 if it was not listed
+ */
+GPU *NvidiaSettingsAdapter::createGPU(QString busId)
+{
+    if(!enumeratedGPUs.contains(busId)) {
+        return 0;
+    }
+
+    EnumeratedGPU enumerated = enumeratedGPUs.value(busId);
+
+    // Ids may have moved to another card
+    NvidiaSettingsAdapter::clearCache();
+
+    // Cards are rarely added, the topology is only asked for then
+    return new GPUNvidia(enumerated.id, enumerated.name, NvidiaSettingsAdapter::queryTopology().value(enumerated.id));
+}
+
+/**
+ * Parses an integer attribute list from the nvidia-settings utility to get a given attribute
+ * @param list String containing the chained values
+ * @param key Key of the requested value
+ * @return Value corresponding to the key or 0 if not found
+ */
+int NvidiaSettingsAdapter::getValueFromAttributesList(const QString &list, QLatin1String key)
+{
+    GPUTWEAK_TRACE_SCOPE("NvidiaSettingsAdapter::getValueFromAttributesList");
+
+    // Scanned in place, this runs for every list value of every refresh
+    int from = 0;
+    while((from = list.indexOf(key, from)) >= 0) {
+        int start = from + key.size();
+        bool keyStart = from == 0 || list.at(from - 1) == ' ' || list.at(from - 1) == ',';
+        from = start;
+
+        // ex: "nvclock" must not match "nvclockmin="
+        if(!keyStart || start >= list.size() || list.at(start) != '=') {
+            continue;
+        }
+
+        int end = start + 1;
+        while(end < list.size() && list.at(end).isDigit()) {
+            end++;
+        }
+
+        return list.midRef(start + 1, end - start - 1).toInt();
+    }
+
+    return 0;
+}
+
+/**
+ * Sets an attribute trough the nvidia-settings utility
+ * While batching, the assignment is only queued and always succeeds
+ * @param attribute Name of the attribute
+ * @param value String value to set
+ * @return False if the tool failed or reported an error
+ */
+bool NvidiaSettingsAdapter::setAttribute(QString attribute, QString value)
+{
+    if(batching) {
+        pendingAssignments.append(QString("%1=%2").arg(attribute).arg(value));
+        return true;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    bool ok;
+    NvidiaSettingsAdapter::cmdLineProcess(QString("%1 -a \"%2=%3\"").arg(NvidiaSettingsAdapter::command()).arg(attribute).arg(value), &ok);
+
+    recordQuery(attribute + " assign", timer, ok);
+
+    invalidate(attribute);
+
+    return ok;
+}
+
+/**
+ * Sets an attribute trough the nvidia-settings utility
+ * @param attribute Name of the attribute
+ * @param value Integer value to set
+ * @return False if the tool failed or reported an error
+ */
+bool NvidiaSettingsAdapter::setAttribute(QString attribute, int value)
+{
+    // Converts the number to string and use the base implementation
+    return NvidiaSettingsAdapter::setAttribute(attribute, QString::number(value));
+}
+
+/**
+ * Starts queuing the assignments so they are all sent in a single invocation
+ */
+void NvidiaSettingsAdapter::beginBatch()
+{
+    batching = true;
+    pendingAssignments.clear();
+}
+
+bool NvidiaSettingsAdapter::isBatching()
+{
+    return batching;
+}
+
+/**
+ * Sends all the queued assignments with one nvidia-settings process
+ * @return False if the tool failed or reported an error for one of them
+ */
+bool NvidiaSettingsAdapter::commitBatch()
+{
+    GPUTWEAK_TRACE_SCOPE("NvidiaSettingsAdapter::commitBatch");
+
+    batching = false;
+
+    if(pendingAssignments.isEmpty()) {
+        return true;
+    }
+
+    QStringList arguments;
+    QStringList attributes;
+    foreach(QString assignment, pendingAssignments) {
+        arguments << "-a" << assignment;
+        attributes.append(assignment.section('=', 0, 0));
+    }
+    pendingAssignments.clear();
+
+    QElapsedTimer timer;
+    timer.start();
+
+    bool ok;
+    NvidiaSettingsAdapter::cmdLineProcess(arguments, &ok);
+
+    recordQuery("batch assign", timer, ok);
+
+    foreach(QString attribute, attributes) {
+        invalidate(attribute);
+    }
+
+    return ok;
+}
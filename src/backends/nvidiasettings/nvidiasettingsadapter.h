@@ -0,0 +1,75 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef NVIDIASETTINGSADAPTER
+#define NVIDIASETTINGSADAPTER
+
+#include <QList>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+
+#include "gpu.h"
+
+/**
+ * Fans and thermal sensors of a GPU, as nvidia-settings targets
+ * A card can have several of each, and their ids do not follow the ones of the GPUs
+ */
+struct NvidiaTopology {
+    QList<int> fans;           // ids of the [fan:N] targets
+    QList<int> thermalSensors; // ids of the [thermalsensor:N] targets
+};
+
+/**
+ * This namespace holds global functions used to access the NVIDIA driver data trough the nvidia-settings linux tool
+ */
+namespace NvidiaSettingsAdapter
+{
+    QString command();
+
+    QString cmdLineProcess(QString command, bool *ok = 0);
+    QString cmdLineProcess(const QStringList &arguments, bool *ok = 0);
+
+    QString     queryAtrribute(QString attribute);
+    QStringList queryAttributes(QStringList attributes);
+    QStringList queryArguments(const QStringList &arguments, int count);
+    bool    queryAttributeRange(QString attribute, int &min, int &max);
+    bool    isAttributeWritable(QString attribute);
+
+    void setCacheTtl(int msecs);
+    int  getCacheTtl();
+    void clearCache();
+
+    bool setAttribute(QString attribute, QString value);
+    bool setAttribute(QString attribute, int value);
+
+    void beginBatch();
+    bool isBatching();
+    bool commitBatch();
+
+    int getValueFromAttributesList(const QString &list, QLatin1String key);
+
+    QMap<int, NvidiaTopology> queryTopology();
+    NvidiaTopology            parseTopology(QString out, int gpu);
+
+    QList<GPU*>            getGPUs();
+    QMap<QString, QString> enumerate();
+    GPU                   *createGPU(QString busId);
+}
+
+#endif // NVIDIASETTINGSADAPTER
+
@@ -0,0 +1,102 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "nvidiasettingsbackend.h"
+
+#include <QFileInfo>
+#include <QStandardPaths>
+
+#include "nvidiaattributes.h"
+#include "nvidiasettingsadapter.h"
+
+QString NvidiaSettingsBackend::getName()
+{
+    return "nvidia-settings";
+}
+
+/**
+ * nvidia-settings must be installed and needs an X server
+ * A tool given by path (ex: a fake one) is trusted to work without X
+ * @return True if usable
+ */
+bool NvidiaSettingsBackend::probe()
+{
+    QString command = NvidiaSettingsAdapter::command();
+
+    if(QFileInfo(command).isAbsolute()) {
+        return QFileInfo(command).isExecutable();
+    }
+
+    return !qgetenv("DISPLAY").isEmpty() && !QStandardPaths::findExecutable(command).isEmpty();
+}
+
+QList<GPU*> NvidiaSettingsBackend::getGPUs()
+{
+    return NvidiaSettingsAdapter::getGPUs();
+}
+
+/**
+ * A single nvidia-settings process lists the GPUs with their PCI address
+ * @return
+ */
+QMap<QString, QString> NvidiaSettingsBackend::enumerate()
+{
+    return NvidiaSettingsAdapter::enumerate();
+}
+
+GPU *NvidiaSettingsBackend::createGPU(QString busId)
+{
+    return NvidiaSettingsAdapter::createGPU(busId);
+}
+
+/**
+ * Rows of the attributes labelled in NvidiaAttributes::DESCRIPTORS
+ * @return
+ */
+QList<GPUBackend::ExtraField> NvidiaSettingsBackend::getExtraFields()
+{
+    QList<ExtraField> fields;
+
+    for(int i=0; i < NvidiaAttributes::AttributeCount; i++) {
+        const NvidiaAttributes::Descriptor &descriptor = NvidiaAttributes::DESCRIPTORS[i];
+
+        if(!descriptor.label) {
+            continue;
+        }
+
+        ExtraField field;
+        field.key   = descriptor.name;
+        field.label = descriptor.label;
+        fields.append(field);
+    }
+
+    return fields;
+}
+
+void NvidiaSettingsBackend::beginBatch()
+{
+    NvidiaSettingsAdapter::beginBatch();
+}
+
+/**
+ * All the assignments are given to one nvidia-settings process
+ * @return
+ */
+bool NvidiaSettingsBackend::commitBatch()
+{
+    return NvidiaSettingsAdapter::commitBatch();
+}
@@ -0,0 +1,356 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "gpunvidiasmi.h"
+
+#include "nvidiasmiadapter.h"
+#include "gputrace.h"
+
+/**
+ * Time to wait for the first row when the stream has just been started
+ */
+const int FIRST_ROW_TIMEOUT_MSECS = 2000;
+
+/**
+ * Builds a GPU from a row of the detection query
+ * @param constants index, name, driver_version, pci.bus_id, memory.total, pcie.link.gen.max, pcie.link.width.max, pcie.link.width.current,
+ *                  power.draw, power.limit, power.min_limit, power.max_limit, power.default_limit
+ */
+GPUNvidiaSmi::GPUNvidiaSmi(QStringList constants) : GPU()
+{
+    this->id                   = constants.at(0).toInt();
+    this->name                 = constants.at(1);
+    this->driverVersion        = constants.at(2);
+    this->busId                = NvidiaSmiAdapter::parseBusId(constants.at(3));
+    this->totalMemory          = NvidiaSmiAdapter::parseInt(constants.at(4));
+    this->pcieGen              = NvidiaSmiAdapter::parseInt(constants.at(5));
+    this->pcieMaxLinkWidth     = NvidiaSmiAdapter::parseInt(constants.at(6));
+    this->pcieCurrentLinkWidth = NvidiaSmiAdapter::parseInt(constants.at(7));
+    this->pcieCurrentGen       = this->pcieGen;
+    // "[N/A]" on the cards without a power sensor
+    this->powerDraw            = constants.at(8).toDouble(&this->powerAvailable);
+    this->powerLimit           = constants.at(9).toDouble();
+    // "[N/A]" on the cards where power management is not supported
+    bool minOk, maxOk;
+    this->powerLimitMin        = constants.at(10).toDouble(&minOk);
+    this->powerLimitMax        = constants.at(11).toDouble(&maxOk);
+    this->powerLimitDefault    = constants.at(12).toDouble();
+    this->powerLimitAvailable  = minOk && maxOk && this->powerLimitMin < this->powerLimitMax;
+    this->powerLimitChanged    = false;
+
+    this->hasValues   = false;
+    this->fetchedRow  = 0;
+    this->coreTemp    = 0;
+    this->fanSpeed    = 0;
+    this->coreClock   = 0;
+    this->memoryClock = 0;
+    this->coreUse     = 0;
+    this->memoryUse   = 0;
+
+    NvidiaSmiStream::instance()->registerGPU(this->id, this);
+}
+
+GPUNvidiaSmi::~GPUNvidiaSmi()
+{
+    NvidiaSmiStream::instance()->unregisterGPU(this->id, this);
+}
+
+void GPUNvidiaSmi::fetchConstants()
+{
+    // Constants are given to the constructor by the detection query
+}
+
+/**
+ * Reports the last streamed values, no process is spawned
+ * @param metrics
+ */
+void GPUNvidiaSmi::fetchVariables(Metrics metrics)
+{
+    GPUTWEAK_TRACE_SCOPE("GPUNvidiaSmi::fetchVariables");
+
+    NvidiaSmiStream *stream = NvidiaSmiStream::instance();
+
+    stream->demand();
+
+    if(!this->hasValues) {
+        stream->waitForRow(this->id, FIRST_ROW_TIMEOUT_MSECS);
+    }
+
+    this->fetchedRow = stream->getRowCount(this->id);
+
+    // The stream may still be on a row older than the last write
+    if(this->powerLimitChanged && (metrics & Power)) {
+        this->fetchPowerLimit();
+    }
+
+    this->updatedMetrics = metrics;
+
+    emit updated();
+}
+
+/**
+ * The values only change when the stream gives a new row
+ * @return Milliseconds
+ */
+int GPUNvidiaSmi::getRefreshPeriod()
+{
+    return NvidiaSmiStream::instance()->getPeriod();
+}
+
+/**
+ * Blocks until the stream gives a row of this GPU newer than the one of the last fetch
+ * @param msecs Timeout
+ * @return False if nothing came in time
+ */
+bool GPUNvidiaSmi::waitForNewValues(int msecs)
+{
+    NvidiaSmiStream *stream = NvidiaSmiStream::instance();
+
+    stream->demand();
+
+    if(stream->getRowCount(this->id) > this->fetchedRow) {
+        return true;
+    }
+
+    return stream->waitForRow(this->id, msecs);
+}
+
+/**
+ * Stores a row received from the stream
+ * @param values Values in the order of StreamColumn
+ */
+void GPUNvidiaSmi::setStreamValues(const QStringList &values)
+{
+    this->coreTemp    = NvidiaSmiAdapter::parseInt(values.at(StreamCoreTemp));
+    this->fanSpeed    = NvidiaSmiAdapter::parseInt(values.at(StreamFanSpeed));
+    this->coreClock   = NvidiaSmiAdapter::parseInt(values.at(StreamCoreClock));
+    this->memoryClock = NvidiaSmiAdapter::parseInt(values.at(StreamMemoryClock));
+    this->coreUse     = NvidiaSmiAdapter::parseInt(values.at(StreamCoreUse));
+    this->memoryUse   = NvidiaSmiAdapter::parseInt(values.at(StreamMemoryUse));
+
+    this->pcieCurrentGen       = NvidiaSmiAdapter::parseInt(values.at(StreamPcieLinkGen));
+    this->pcieCurrentLinkWidth = NvidiaSmiAdapter::parseInt(values.at(StreamPcieLinkWidth));
+
+    if(this->powerAvailable) {
+        this->powerDraw  = values.at(StreamPowerDraw).toDouble();
+        this->powerLimit = values.at(StreamPowerLimit).toDouble();
+    }
+
+    this->hasValues = true;
+}
+
+QString GPUNvidiaSmi::getIdentifier()
+{
+    return QString("gpu:%1").arg(this->id);
+}
+
+QString GPUNvidiaSmi::getName()
+{
+    return this->name;
+}
+
+QString GPUNvidiaSmi::getDriverVersion()
+{
+    return this->driverVersion;
+}
+
+QString GPUNvidiaSmi::getBusType()
+{
+    return QString("PCI-E x%1 Gen%2 @ x%3")
+            .arg(this->pcieMaxLinkWidth)
+            .arg(this->pcieGen)
+            .arg(this->pcieCurrentLinkWidth);
+}
+
+int GPUNvidiaSmi::getPcieMaxLinkWidth()
+{
+    return this->pcieMaxLinkWidth;
+}
+
+int GPUNvidiaSmi::getPcieMaxLinkGen()
+{
+    return this->pcieGen;
+}
+
+int GPUNvidiaSmi::getPcieLinkWidth()
+{
+    return this->pcieCurrentLinkWidth;
+}
+
+int GPUNvidiaSmi::getPcieLinkGen()
+{
+    return this->pcieCurrentGen;
+}
+
+bool GPUNvidiaSmi::isPowerDrawAvailable()
+{
+    return this->powerAvailable;
+}
+
+double GPUNvidiaSmi::getCurrentPowerDraw()
+{
+    return this->powerDraw;
+}
+
+double GPUNvidiaSmi::getPowerLimit()
+{
+    return this->powerLimit;
+}
+
+bool GPUNvidiaSmi::isPowerLimitControlAvailable()
+{
+    return this->powerLimitAvailable;
+}
+
+double GPUNvidiaSmi::getPowerLimitMin()
+{
+    return this->powerLimitMin;
+}
+
+double GPUNvidiaSmi::getPowerLimitDefault()
+{
+    return this->powerLimitDefault;
+}
+
+double GPUNvidiaSmi::getPowerLimitMax()
+{
+    return this->powerLimitMax;
+}
+
+/**
+ * Sets the power limit and reads it back, needs root
+ * @param watts
+ * @return True if the limit is applied
+ */
+bool GPUNvidiaSmi::setPowerLimit(double watts)
+{
+    if(!this->powerLimitAvailable) {
+        return false;
+    }
+
+    bool ok = NvidiaSmiAdapter::setPowerLimit(this->id, watts);
+
+    this->powerLimitChanged = true;
+
+    if(NvidiaSmiAdapter::isBatching()) {
+        this->powerLimit = watts;
+        return true;
+    }
+
+    this->fetchPowerLimit();
+
+    return ok && qAbs(this->powerLimit - watts) < 1;
+}
+
+/**
+ * Reads the power limit with a query of its own, bypassing the stream
+ */
+void GPUNvidiaSmi::fetchPowerLimit()
+{
+    QString out = NvidiaSmiAdapter::query("index,power.limit");
+
+    foreach(QString line, out.split("\n", QString::SkipEmptyParts)) {
+        QStringList values = NvidiaSmiAdapter::parseRow(line);
+
+        if(values.size() < 2 || values.at(0).toInt() != this->id) {
+            continue;
+        }
+
+        this->powerLimit        = values.at(1).toDouble();
+        this->powerLimitChanged = false;
+    }
+}
+
+QString GPUNvidiaSmi::getBusId()
+{
+    return this->busId;
+}
+
+int GPUNvidiaSmi::getTotalMemory()
+{
+    return this->totalMemory;
+}
+
+int GPUNvidiaSmi::getCurrentCoreTemp()
+{
+    return this->coreTemp;
+}
+
+int GPUNvidiaSmi::getCurrentFanSpeed()
+{
+    return this->fanSpeed;
+}
+
+int GPUNvidiaSmi::getCurrentCoreClock()
+{
+    return this->coreClock;
+}
+
+int GPUNvidiaSmi::getCurrentMemoryClock()
+{
+    return this->memoryClock;
+}
+
+int GPUNvidiaSmi::getCurrentCoreUse()
+{
+    return this->coreUse;
+}
+
+int GPUNvidiaSmi::getCurrentMemoryUse()
+{
+    return this->memoryUse;
+}
+
+bool GPUNvidiaSmi::isFanControlAvailable()
+{
+    return false; // nvidia-smi cannot set the fans
+}
+
+bool GPUNvidiaSmi::isFanControlEnabled()
+{
+    return false;
+}
+
+bool GPUNvidiaSmi::isCoreClockControlAvailable()
+{
+    return false;
+}
+
+bool GPUNvidiaSmi::isCoreClockControlEnabled()
+{
+    return false;
+}
+
+bool GPUNvidiaSmi::isMemoryClockControlAvailable()
+{
+    return false;
+}
+
+bool GPUNvidiaSmi::isMemoryClockControlEnabled()
+{
+    return false;
+}
+
+void GPUNvidiaSmi::setFanControlEnabled(bool enabled)
+{
+    Q_UNUSED(enabled);
+}
+
+void GPUNvidiaSmi::setFanSpeed(int speed)
+{
+    Q_UNUSED(speed);
+}
@@ -0,0 +1,135 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GPUNVIDIASMI_H
+#define GPUNVIDIASMI_H
+
+#include <QString>
+#include <QStringList>
+
+#include "gpu.h"
+
+/**
+ * NVIDIA Card using the nvidia proprietary driver
+ * Data is accessed trough a single nvidia-smi process streaming the values of all the cards,
+ * which also works on servers without X
+ */
+class GPUNvidiaSmi : public GPU
+{
+public:
+    /**
+     * Columns of a streamed row
+     */
+    enum StreamColumn {
+        StreamIndex,
+        StreamCoreTemp,
+        StreamFanSpeed,
+        StreamCoreClock,
+        StreamMemoryClock,
+        StreamCoreUse,
+        StreamMemoryUse,
+        StreamPcieLinkGen,
+        StreamPcieLinkWidth,
+        StreamPowerDraw,
+        StreamPowerLimit,
+        StreamColumnCount
+    };
+
+    GPUNvidiaSmi(QStringList constants);
+    ~GPUNvidiaSmi();
+
+    void    fetchConstants();
+    void    fetchVariables(Metrics metrics = AllMetrics);
+
+    int     getRefreshPeriod();
+    bool    waitForNewValues(int msecs);
+
+    void    setStreamValues(const QStringList &values);
+
+    QString getIdentifier();
+    QString getName();
+    QString getDriverVersion();
+    QString getBusType();
+    QString getBusId();
+    int     getTotalMemory();
+
+    int     getCurrentCoreTemp();
+    int     getCurrentFanSpeed();
+    int     getCurrentCoreClock();
+    int     getCurrentMemoryClock();
+    int     getCurrentCoreUse();
+    int     getCurrentMemoryUse();
+
+    bool    isFanControlAvailable();
+    bool    isFanControlEnabled();
+    bool    isCoreClockControlAvailable();
+    bool    isCoreClockControlEnabled();
+    bool    isMemoryClockControlAvailable();
+    bool    isMemoryClockControlEnabled();
+
+    int     getPcieMaxLinkWidth();
+    int     getPcieMaxLinkGen();
+    int     getPcieLinkWidth();
+    int     getPcieLinkGen();
+
+    bool    isPowerDrawAvailable();
+    double  getCurrentPowerDraw();
+    double  getPowerLimit();
+
+    bool    isPowerLimitControlAvailable();
+    double  getPowerLimitMin();
+    double  getPowerLimitDefault();
+    double  getPowerLimitMax();
+
+    void    setFanControlEnabled(bool enabled);
+    void    setFanSpeed(int speed);
+    bool    setPowerLimit(double watts);
+
+private:
+    void    fetchPowerLimit();
+
+    // Constants, from the detection query
+    int     id;                   // nvidia-smi index of the gpu (0-based)
+    QString name;                 // ex: Tesla V100-SXM2-16GB
+    QString driverVersion;        // ex: 418.67
+    QString busId;                // ex: PCI:1:0:0
+    int     totalMemory;          // MB
+    int     pcieGen;              // ex: 3
+    int     pcieMaxLinkWidth;     // ex: 16
+    bool    powerLimitAvailable;
+    double  powerLimitMin;        // W
+    double  powerLimitDefault;    // W
+    double  powerLimitMax;        // W
+
+    // Variables, from the stream
+    bool    hasValues;
+    qint64  fetchedRow;           // row count of the stream at the last fetch
+    int     coreTemp;             // °C
+    int     fanSpeed;             // %
+    int     coreClock;            // MHz
+    int     memoryClock;          // MHz
+    int     coreUse;              // %
+    int     memoryUse;            // %
+    int     pcieCurrentGen;       // ex: 1 when idle
+    int     pcieCurrentLinkWidth; // ex: 16
+    bool    powerAvailable;
+    double  powerDraw;            // W
+    double  powerLimit;           // W
+    bool    powerLimitChanged;    // written since the last read back
+};
+
+#endif // GPUNVIDIASMI_H
@@ -0,0 +1,31 @@
+#-------------------------------------------------
+#
+# nvidia-smi backend plugin of GPUTweak
+#
+#-------------------------------------------------
+
+QT       += core
+
+TARGET = gputweak-nvidiasmi
+TEMPLATE = lib
+CONFIG += plugin
+
+# Plugins are gathered next to each other, GPUTweak looks for them in its "backends" directory
+DESTDIR = $$OUT_PWD/..
+
+# Shared interfaces of the application, their symbols are exported by the executable
+INCLUDEPATH += ../..
+
+# Trace spans, like the executable
+tracing: DEFINES += GPUTWEAK_TRACING
+
+SOURCES += nvidiasmibackend.cpp \
+    gpunvidiasmi.cpp \
+    nvidiasmiadapter.cpp
+
+HEADERS += nvidiasmibackend.h \
+    gpunvidiasmi.h \
+    nvidiasmiadapter.h \
+    ../../gpubackend.h
+
+OTHER_FILES += nvidiasmi.json
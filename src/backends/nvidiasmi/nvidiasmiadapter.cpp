@@ -0,0 +1,482 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "nvidiasmiadapter.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QRegularExpression>
+
+#include "gpunvidiasmi.h"
+#include "gpudiagnostics.h"
+#include "gputrace.h"
+
+/**
+ * nvidia-smi command line utility path, can be replaced trough this environment variable
+ */
+const char *NVIDIA_SMI_CMD_ENV = "GPUTWEAK_NVIDIA_SMI";
+const QString NVIDIA_SMI_CMD = "nvidia-smi";
+/**
+ * Fields queried once when the GPUs are detected
+ */
+const QString CONSTANT_FIELDS = "index,name,driver_version,pci.bus_id,memory.total,pcie.link.gen.max,pcie.link.width.max,pcie.link.width.current,power.draw,power.limit,power.min_limit,power.max_limit,power.default_limit";
+/**
+ * Fields streamed by the loop mode, must stay in sync with GPUNvidiaSmi::StreamColumn
+ */
+const QString STREAM_FIELDS = "index,temperature.gpu,fan.speed,clocks.gr,clocks.mem,utilization.gpu,utilization.memory,pcie.link.gen.current,pcie.link.width.current,power.draw,power.limit";
+/**
+ * Period of the loop mode
+ */
+const int STREAM_PERIOD_MSECS = 500;
+/**
+ * The stream is stopped when no value was asked for during this time
+ */
+const int STREAM_IDLE_MSECS = 10000;
+
+/**
+ * Detection rows of the GPUs listed by the last enumerate(), by bus id, only used from the GUI thread
+ */
+static QHash<QString, QStringList> enumeratedRows;
+
+/**
+ * Power limits waiting for commitBatch(), indexes of the GPUs by limit, only used from the GUI thread
+ * nvidia-smi sets the same limit to all the GPUs given to -i, so each distinct limit costs one process
+ */
+static bool                    batching = false;
+static QMap<QString, QStringList> pendingPowerLimits;
+
+/**
+ * Gives the command used to run nvidia-smi
+ * @return Command
+ */
+QString NvidiaSmiAdapter::command()
+{
+    QString cmd = QString::fromLocal8Bit(qgetenv(NVIDIA_SMI_CMD_ENV));
+
+    return cmd.isEmpty() ? NVIDIA_SMI_CMD : cmd;
+}
+
+/**
+ * Queries the given fields of all GPUs once
+ * @param fields Comma-separated list of fields
+ * @return CSV output, one GPU per line
+ */
+QString NvidiaSmiAdapter::query(QString fields)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    GPUDiagnostics::count(GPUDiagnostics::ProcessSpawns);
+
+    QProcess process;
+    process.start(NvidiaSmiAdapter::command(), QStringList()
+                  << QString("--query-gpu=%1").arg(fields)
+                  << "--format=csv,noheader,nounits");
+    process.waitForFinished(-1);
+
+    bool ok = process.exitStatus() == QProcess::NormalExit && process.exitCode() == 0;
+    GPUDiagnostics::recordQuery("all", fields, timer.nsecsElapsed(), ok);
+
+    return QString(process.readAllStandardOutput());
+}
+
+/**
+ * Runs nvidia-smi to change a setting
+ * @param arguments Arguments of the command
+ * @param target    Target reported to the diagnostics, ex: gpu:0
+ * @param attribute Attribute reported to the diagnostics
+ * @return False if the tool failed, ex: without root
+ */
+bool NvidiaSmiAdapter::run(QStringList arguments, QString target, QString attribute)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    GPUDiagnostics::count(GPUDiagnostics::ProcessSpawns);
+
+    QProcess process;
+    process.start(NvidiaSmiAdapter::command(), arguments);
+    process.waitForFinished(-1);
+
+    bool ok = process.exitStatus() == QProcess::NormalExit && process.exitCode() == 0;
+    GPUDiagnostics::recordQuery(target, attribute, timer.nsecsElapsed(), ok);
+
+    return ok;
+}
+
+/**
+ * Sets the power limit of a GPU
+ * While batching, the limit is only queued and always succeeds
+ * @param index nvidia-smi index of the GPU
+ * @param watts Limit in W
+ * @return False if the tool failed
+ */
+bool NvidiaSmiAdapter::setPowerLimit(int index, double watts)
+{
+    QString limit = QString::number(watts, 'f', 2);
+
+    if(batching) {
+        pendingPowerLimits[limit].append(QString::number(index));
+        return true;
+    }
+
+    return NvidiaSmiAdapter::run(QStringList() << "-i" << QString::number(index) << "-pl" << limit,
+                                 QString("gpu:%1").arg(index), "power.limit assign");
+}
+
+/**
+ * Starts queuing the power limits so the GPUs sharing a limit are set by a single invocation
+ */
+void NvidiaSmiAdapter::beginBatch()
+{
+    batching = true;
+    pendingPowerLimits.clear();
+}
+
+bool NvidiaSmiAdapter::isBatching()
+{
+    return batching;
+}
+
+/**
+ * Sends the queued power limits, one nvidia-smi process per distinct limit
+ * @return False if the tool failed for one of them
+ */
+bool NvidiaSmiAdapter::commitBatch()
+{
+    GPUTWEAK_TRACE_SCOPE("NvidiaSmiAdapter::commitBatch");
+
+    batching = false;
+
+    bool ok = true;
+
+    QMapIterator<QString, QStringList> it(pendingPowerLimits);
+    while(it.hasNext()) {
+        it.next();
+
+        ok = NvidiaSmiAdapter::run(QStringList() << "-i" << it.value().join(",") << "-pl" << it.key(),
+                                   "all", "batch power.limit assign") && ok;
+    }
+
+    pendingPowerLimits.clear();
+
+    return ok;
+}
+
+/**
+ * Splits a CSV line of nvidia-smi
+ * Values never contain commas so there is no need for quote handling
+ * @param line Line without the new line character
+ * @return Trimmed values
+ */
+QStringList NvidiaSmiAdapter::parseRow(QString line)
+{
+    QStringList values = line.split(",");
+
+    for(int i=0; i < values.size(); i++) {
+        values[i] = values.at(i).trimmed();
+    }
+
+    return values;
+}
+
+/**
+ * Parses an integer value of nvidia-smi
+ * @param value Value like "45", "1506.25" or "[N/A]"
+ * @return Value, 0 if not available
+ */
+int NvidiaSmiAdapter::parseInt(QString value)
+{
+    bool ok;
+    double number = value.toDouble(&ok);
+
+    return ok ? qRound(number) : 0;
+}
+
+/**
+ * Converts the bus id of nvidia-smi to the format of nvidia-settings
+ * @param busId Bus id like "00000000:01:00.0"
+ * @return Bus id like "PCI:1:0:0"
+ */
+QString NvidiaSmiAdapter::parseBusId(QString busId)
+{
+    QRegularExpression regExp("(?<bus>[0-9A-Fa-f]+):(?<device>[0-9A-Fa-f]+)\\.(?<func>[0-9A-Fa-f]+)$");
+
+    QRegularExpressionMatch match = regExp.match(busId);
+    if(!match.hasMatch()) {
+        return busId;
+    }
+
+    return QString("PCI:%1:%2:%3")
+            .arg(match.captured("bus").toInt(0, 16))
+            .arg(match.captured("device").toInt(0, 16))
+            .arg(match.captured("func").toInt(0, 16));
+}
+
+/**
+ * Get a list of all GPUs detected by this adapter
+ * @return List of GPUs
+ */
+QList<GPU*> NvidiaSmiAdapter::getGPUs()
+{
+    QString out = NvidiaSmiAdapter::query(CONSTANT_FIELDS);
+
+    QList<GPU*> list;
+
+    foreach(QString line, out.split("\n", QString::SkipEmptyParts)) {
+        QStringList values = NvidiaSmiAdapter::parseRow(line);
+
+        if(values.size() < 13) {
+            // Probably an error message
+            continue;
+        }
+
+        list.append(new GPUNvidiaSmi(values));
+    }
+
+    return list;
+}
+
+/**
+ * Lists the GPUs with the detection query, keeping the rows for createGPU()
+ * @return Identifier of each GPU by bus id, empty if the tool failed
+ */
+QMap<QString, QString> NvidiaSmiAdapter::enumerate()
+{
+    QString out = NvidiaSmiAdapter::query(CONSTANT_FIELDS);
+
+    enumeratedRows.clear();
+
+    QMap<QString, QString> list;
+
+    foreach(QString line, out.split("\n", QString::SkipEmptyParts)) {
+        QStringList values = NvidiaSmiAdapter::parseRow(line);
+
+        if(values.size() < 13) {
+            continue;
+        }
+
+        QString busId = NvidiaSmiAdapter::parseBusId(values.at(3));
+
+        enumeratedRows.insert(busId, values);
+        list.insert(busId, QString("gpu:%1").arg(values.at(0).toInt()));
+    }
+
+    return list;
+}
+
+/**
+ * Creates a GPU listed by the last enumerate(), no process is spawned
+ * @param busId
+ * @return GPU, 0 if it was not listed
+ */
+GPU *NvidiaSmiAdapter::createGPU(QString busId)
+{
+    if(!enumeratedRows.contains(busId)) {
+        return 0;
+    }
+
+    return new GPUNvidiaSmi(enumeratedRows.value(busId));
+}
+
+NvidiaSmiStream::NvidiaSmiStream(QObject *parent) :
+    QObject(parent),
+    process(this),
+    idleTimer(this)
+{
+    this->idleTimer.setSingleShot(true);
+    this->idleTimer.setInterval(STREAM_IDLE_MSECS);
+
+    connect(&this->process, SIGNAL(readyReadStandardOutput()), this, SLOT(readOutput()));
+    connect(&this->idleTimer, SIGNAL(timeout()), this, SLOT(stop()));
+}
+
+/**
+ * Gives the stream shared by all the GPUs, it lives as long as the application
+ * The GPUs can be created outside of the GUI thread, but the stream always lives in it
+ * @return Stream
+ */
+NvidiaSmiStream *NvidiaSmiStream::instance()
+{
+    static NvidiaSmiStream *stream = 0;
+
+    if(!stream) {
+        stream = new NvidiaSmiStream();
+        stream->moveToThread(QCoreApplication::instance()->thread());
+
+        connect(QCoreApplication::instance(), SIGNAL(aboutToQuit()), stream, SLOT(stop()));
+    }
+
+    return stream;
+}
+
+/**
+ * Registers the GPU receiving the rows of an index
+ * @param index nvidia-smi index
+ * @param gpu
+ */
+void NvidiaSmiStream::registerGPU(int index, GPUNvidiaSmi *gpu)
+{
+    this->gpus.insert(index, gpu);
+}
+
+/**
+ * Stops dispatching the rows of an index
+ * The index may already belong to a newer GPU after a re-enumeration
+ * @param index nvidia-smi index
+ * @param gpu   GPU that registered
+ */
+void NvidiaSmiStream::unregisterGPU(int index, GPUNvidiaSmi *gpu)
+{
+    if(this->gpus.value(index) == gpu) {
+        this->gpus.remove(index);
+    }
+}
+
+/**
+ * Tells the stream that values are needed, starting the process if it is not running
+ */
+void NvidiaSmiStream::demand()
+{
+    this->idleTimer.start();
+
+    if(this->process.state() != QProcess::NotRunning) {
+        return;
+    }
+
+    this->buffer.clear();
+
+    GPUDiagnostics::count(GPUDiagnostics::ProcessSpawns);
+
+    this->process.start(NvidiaSmiAdapter::command(), QStringList()
+                        << QString("--query-gpu=%1").arg(STREAM_FIELDS)
+                        << "--format=csv,noheader,nounits"
+                        << "-lms" << QString::number(STREAM_PERIOD_MSECS));
+}
+
+/**
+ * Blocks until a new row of an index has been parsed, the rows of the other indexes do not count
+ * @param index nvidia-smi index
+ * @param msecs Timeout
+ * @return False if nothing came in time
+ */
+bool NvidiaSmiStream::waitForRow(int index, int msecs)
+{
+    qint64 before = this->rowCounts.value(index);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    while(this->rowCounts.value(index) == before) {
+        int remaining = qMax(0, msecs - static_cast<int>(timer.elapsed()));
+
+        if(!this->process.waitForReadyRead(remaining)) {
+            return false;
+        }
+
+        this->readOutput();
+    }
+
+    return true;
+}
+
+/**
+ * Number of rows dispatched to an index since the start of the application
+ * @param index nvidia-smi index
+ * @return Count
+ */
+qint64 NvidiaSmiStream::getRowCount(int index)
+{
+    return this->rowCounts.value(index);
+}
+
+/**
+ * Period at which the stream gives a row of each GPU
+ * @return Milliseconds
+ */
+int NvidiaSmiStream::getPeriod()
+{
+    return STREAM_PERIOD_MSECS;
+}
+
+/**
+ * Parses the output received from the process
+ */
+void NvidiaSmiStream::readOutput()
+{
+    this->parseOutput(this->process.readAllStandardOutput());
+}
+
+/**
+ * Parses all the complete lines received so far, the last incomplete one is kept for later
+ * A row can be split anywhere by the pipe, even inside a value
+ * @param output Output received since the last call
+ */
+void NvidiaSmiStream::parseOutput(const QByteArray &output)
+{
+    this->buffer.append(output);
+
+    int start = 0;
+    int end;
+
+    while((end = this->buffer.indexOf('\n', start)) >= 0) {
+        this->parseLine(this->buffer.mid(start, end - start));
+        start = end + 1;
+    }
+
+    this->buffer.remove(0, start);
+}
+
+/**
+ * Dispatches a row to its GPU
+ * @param line Line without the new line character
+ */
+void NvidiaSmiStream::parseLine(const QByteArray &line)
+{
+    QStringList values = NvidiaSmiAdapter::parseRow(QString::fromUtf8(line));
+
+    if(values.size() < GPUNvidiaSmi::StreamColumnCount) {
+        return;
+    }
+
+    bool ok;
+    int index = values.at(GPUNvidiaSmi::StreamIndex).toInt(&ok);
+
+    if(!ok || !this->gpus.contains(index)) {
+        return;
+    }
+
+    this->gpus.value(index)->setStreamValues(values);
+
+    this->rowCounts[index]++;
+}
+
+/**
+ * Stops the process when nobody needs the values anymore, demand() starts it again
+ */
+void NvidiaSmiStream::stop()
+{
+    if(this->process.state() == QProcess::NotRunning) {
+        return;
+    }
+
+    this->process.terminate();
+    if(!this->process.waitForFinished(1000)) {
+        this->process.kill();
+        this->process.waitForFinished(1000);
+    }
+}
@@ -0,0 +1,100 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef NVIDIASMIADAPTER_H
+#define NVIDIASMIADAPTER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QProcess>
+#include <QTimer>
+#include <QHash>
+#include <QMap>
+
+#include "gpu.h"
+
+class GPUNvidiaSmi;
+
+/**
+ * This namespace holds global functions used to access the NVIDIA driver data trough the nvidia-smi tool
+ * Unlike nvidia-settings, nvidia-smi does not need a running X server
+ */
+namespace NvidiaSmiAdapter
+{
+    QString command();
+
+    QString query(QString fields);
+    bool    run(QStringList arguments, QString target, QString attribute);
+
+    bool setPowerLimit(int index, double watts);
+    void beginBatch();
+    bool isBatching();
+    bool commitBatch();
+
+    QStringList parseRow(QString line);
+    int parseInt(QString value);
+    QString parseBusId(QString busId);
+
+    QList<GPU*>            getGPUs();
+    QMap<QString, QString> enumerate();
+    GPU                   *createGPU(QString busId);
+}
+
+/**
+ * Long-lived nvidia-smi process streaming the variables of all the GPUs in its loop mode
+ * Rows are parsed as they arrive and dispatched to the GPUs, the process is stopped when nobody asks for values anymore
+ */
+class NvidiaSmiStream : public QObject
+{
+    Q_OBJECT
+
+public:
+    static NvidiaSmiStream *instance();
+
+    void registerGPU(int index, GPUNvidiaSmi *gpu);
+    void unregisterGPU(int index, GPUNvidiaSmi *gpu);
+
+    void demand();
+    bool waitForRow(int index, int msecs);
+
+    qint64 getRowCount(int index);
+    int    getPeriod();
+
+    void parseOutput(const QByteArray &output);
+
+public slots:
+    void stop();
+
+private:
+    explicit NvidiaSmiStream(QObject *parent = 0);
+
+    void parseLine(const QByteArray &line);
+
+    QHash<int, GPUNvidiaSmi*> gpus;
+
+    QProcess   process;
+    QByteArray buffer; // output received but not yet parsed, always an incomplete line
+    QTimer     idleTimer;
+
+    QHash<int, qint64> rowCounts; // rows dispatched, by index
+
+private slots:
+    void readOutput();
+};
+
+#endif // NVIDIASMIADAPTER_H
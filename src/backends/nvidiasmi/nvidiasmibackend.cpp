@@ -0,0 +1,77 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "nvidiasmibackend.h"
+
+#include <QFileInfo>
+#include <QStandardPaths>
+
+#include "nvidiasmiadapter.h"
+
+QString NvidiaSmiBackend::getName()
+{
+    return "nvidia-smi";
+}
+
+/**
+ * nvidia-smi, or its replacement, must be installed
+ * @return True if usable
+ */
+bool NvidiaSmiBackend::probe()
+{
+    QString command = NvidiaSmiAdapter::command();
+
+    if(QFileInfo(command).isAbsolute()) {
+        return QFileInfo(command).isExecutable();
+    }
+
+    return !QStandardPaths::findExecutable(command).isEmpty();
+}
+
+QList<GPU*> NvidiaSmiBackend::getGPUs()
+{
+    return NvidiaSmiAdapter::getGPUs();
+}
+
+QMap<QString, QString> NvidiaSmiBackend::enumerate()
+{
+    return NvidiaSmiAdapter::enumerate();
+}
+
+GPU *NvidiaSmiBackend::createGPU(QString busId)
+{
+    return NvidiaSmiAdapter::createGPU(busId);
+}
+
+QList<GPUBackend::ExtraField> NvidiaSmiBackend::getExtraFields()
+{
+    return QList<ExtraField>();
+}
+
+void NvidiaSmiBackend::beginBatch()
+{
+    NvidiaSmiAdapter::beginBatch();
+}
+
+/**
+ * The GPUs given the same power limit share one nvidia-smi process
+ * @return
+ */
+bool NvidiaSmiBackend::commitBatch()
+{
+    return NvidiaSmiAdapter::commitBatch();
+}
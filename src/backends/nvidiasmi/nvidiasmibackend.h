@@ -0,0 +1,45 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef NVIDIASMIBACKEND_H
+#define NVIDIASMIBACKEND_H
+
+#include <QObject>
+
+#include "gpubackend.h"
+
+/**
+ * Plugin giving access to the GPUs trough nvidia-smi
+ */
+class NvidiaSmiBackend : public QObject, public GPUBackend
+{
+    Q_OBJECT
+    Q_PLUGIN_METADATA(IID GPUBackend_iid FILE "nvidiasmi.json")
+    Q_INTERFACES(GPUBackend)
+
+public:
+    QString getName();
+    bool probe();
+    QList<GPU*> getGPUs();
+    QMap<QString, QString> enumerate();
+    GPU *createGPU(QString busId);
+    QList<ExtraField> getExtraFields();
+    void beginBatch();
+    bool commitBatch();
+};
+
+#endif // NVIDIASMIBACKEND_H
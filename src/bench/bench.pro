@@ -0,0 +1,59 @@
+#-------------------------------------------------
+#
+# Benchmarks of GPUTweak, built separately from the application
+# Run with -csv or -xml for a machine-readable output, see README
+#
+#-------------------------------------------------
+
+QT       += core gui widgets concurrent testlib
+
+TARGET = gputweak-bench
+TEMPLATE = app
+CONFIG += console testcase
+CONFIG -= app_bundle
+
+# The fake nvidia-settings put on the PATH by the benchmarks
+DEFINES += GPUTWEAK_TOOLS_DIR=\\\"$$PWD/../tools\\\"
+
+# Trace spans, like the executable
+tracing: DEFINES += GPUTWEAK_TRACING
+
+INCLUDEPATH += .. \
+    ../backends/nvidiasettings
+
+SOURCES += benchgputweak.cpp \
+    ../gpu.cpp \
+    ../gpuhistory.cpp \
+    ../gpuquantiles.cpp \
+    ../gpusketch.cpp \
+    ../gpudiagnostics.cpp \
+    ../gputrace.cpp \
+    ../gpusimulated.cpp \
+    ../gpupoller.cpp \
+    ../gpueventlog.cpp \
+    ../gpupciemonitor.cpp \
+    ../gpuburstcapture.cpp \
+    ../gpuburstwindow.cpp \
+    ../gpustatswindow.cpp \
+    ../backends/nvidiasettings/gpunvidia.cpp \
+    ../backends/nvidiasettings/nvidiasettingsadapter.cpp
+
+HEADERS += ../gpu.h \
+    ../gpuhistory.h \
+    ../gpuquantiles.h \
+    ../gpusketch.h \
+    ../gpudiagnostics.h \
+    ../gputrace.h \
+    ../gpusimulated.h \
+    ../gpupoller.h \
+    ../gpueventlog.h \
+    ../gpupciemonitor.h \
+    ../gpuburstcapture.h \
+    ../gpuburstwindow.h \
+    ../gpustatswindow.h \
+    ../backends/nvidiasettings/gpunvidia.h \
+    ../backends/nvidiasettings/nvidiaattributes.h \
+    ../backends/nvidiasettings/nvidiasettingsadapter.h
+
+FORMS += ../gpustatswindow.ui \
+    ../gpuburstwindow.ui
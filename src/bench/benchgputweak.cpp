@@ -0,0 +1,583 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <QtTest>
+#include <QGraphicsScene>
+#include <QTemporaryDir>
+#include <QtConcurrentRun>
+
+#include <cstdlib>
+
+#include "gpudiagnostics.h"
+#include "gpunvidia.h"
+#include "nvidiaattributes.h"
+#include "nvidiasettingsadapter.h"
+#include "gpusimulated.h"
+#include "gpustatswindow.h"
+
+/**
+ * Number of seconds of values drawn by the graphs, like the stats window
+ */
+const int GRAPH_TIME_LENGTH_SECS = 60;
+/**
+ * Size of the graphs drawn
+ */
+const int GRAPH_WIDTH  = 470;
+const int GRAPH_HEIGHT = 100;
+
+/**
+ * Refreshes over which the allocations are averaged
+ */
+const int ALLOCATION_TICKS = 100;
+/**
+ * Threads asking for the same values at once
+ */
+const int COALESCED_QUERIES = 8;
+
+#ifdef __GLIBC__
+/**
+ * Heap allocations of the whole process, Qt containers and strings included
+ * glibc lets the executable replace malloc and still reach its own
+ */
+static QAtomicInt allocations;
+
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t count, size_t size);
+extern "C" void *__libc_realloc(void *pointer, size_t size);
+
+extern "C" void *malloc(size_t size)
+{
+    allocations.fetchAndAddRelaxed(1);
+    return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t count, size_t size)
+{
+    allocations.fetchAndAddRelaxed(1);
+    return __libc_calloc(count, size);
+}
+
+extern "C" void *realloc(void *pointer, size_t size)
+{
+    allocations.fetchAndAddRelaxed(1);
+    return __libc_realloc(pointer, size);
+}
+#endif
+
+/**
+ * Gives access to the drawing functions of the stats window
+ */
+class BenchStatsWindow : public GPUStatsWindow
+{
+public:
+    BenchStatsWindow(GPUHistory *history, GPUEventLog *eventLog, GPUPoller *poller) :
+        GPUStatsWindow(history, eventLog, poller)
+    {
+    }
+
+    using GPUStatsWindow::updateGraph;
+    using GPUStatsWindow::updateGraphScene;
+};
+
+/**
+ * Benchmarks of the acquisition, parsing and rendering paths
+ * nvidia-settings is replaced by src/tools/fake-nvidia-settings, found through the PATH
+ * like the real one, so the process costs are measured but not the driver ones
+ */
+class BenchGPUTweak : public QObject
+{
+    Q_OBJECT
+
+private:
+    QList<GPUHistory::HistoryValue> makeValues(int count);
+
+    QTemporaryDir dir;
+
+private slots:
+    void initTestCase();
+
+    void adapterQuery_data();
+    void adapterQuery();
+    void adapterQueryRange();
+    void adapterQueryCached();
+    void adapterQueryCoalesced();
+
+    void parseAttributesList_data();
+    void parseAttributesList();
+
+    void fetchVariables_data();
+    void fetchVariables();
+    void fetchArguments_data();
+    void fetchArguments();
+
+    void getGPUs_data();
+    void getGPUs();
+
+    void queryTopology_data();
+    void queryTopology();
+
+    void updateGraph_data();
+    void updateGraph();
+    void updateGraphScene_data();
+    void updateGraphScene();
+};
+
+/**
+ * Puts the fake nvidia-settings first in the PATH
+ */
+void BenchGPUTweak::initTestCase()
+{
+    QVERIFY(this->dir.isValid());
+    QVERIFY(QFile::link(QString(GPUTWEAK_TOOLS_DIR) + "/fake-nvidia-settings", this->dir.filePath("nvidia-settings")));
+
+    qputenv("PATH", QFile::encodeName(this->dir.path()) + ":" + qgetenv("PATH"));
+    qputenv("FAKE_NVIDIA_STATE", QFile::encodeName(this->dir.filePath("state")));
+    qunsetenv("GPUTWEAK_NVIDIA_SETTINGS");
+
+    // The process costs are measured, not the cache
+    NvidiaSettingsAdapter::setCacheTtl(0);
+
+    QCOMPARE(NvidiaSettingsAdapter::command(), QString("nvidia-settings"));
+    QCOMPARE(NvidiaSettingsAdapter::getGPUs().size(), 2);
+}
+
+void BenchGPUTweak::adapterQuery_data()
+{
+    QTest::addColumn<QString>("attribute");
+
+    QTest::newRow("temp")   << "[gpu:0]/GPUCoreTemp";
+    QTest::newRow("use")    << "[gpu:0]/GPUUtilization";
+    QTest::newRow("clocks") << "[gpu:0]/GPUCurrentClockFreqsString";
+    QTest::newRow("fan")    << "[fan:0]/GPUCurrentFanSpeed";
+}
+
+/**
+ * Cost of a single query, a process each
+ */
+void BenchGPUTweak::adapterQuery()
+{
+    QFETCH(QString, attribute);
+
+    QString value;
+    QBENCHMARK {
+        value = NvidiaSettingsAdapter::queryAtrribute(attribute);
+    }
+
+    QVERIFY(!value.isEmpty());
+}
+
+/**
+ * Cost of reading the valid range of an attribute from the full output
+ */
+void BenchGPUTweak::adapterQueryRange()
+{
+    int min = 0, max = 0;
+    bool ok = false;
+
+    QBENCHMARK {
+        ok = NvidiaSettingsAdapter::queryAttributeRange("[gpu:0]/GPUGraphicsClockOffset[3]", min, max);
+    }
+
+    QVERIFY(ok);
+    QVERIFY(min < max);
+}
+
+/**
+ * Cost of a query answered from the cache, which neither spawns a process nor counts as a
+ * driver query, and is read again from the driver once the attribute is assigned
+ */
+void BenchGPUTweak::adapterQueryCached()
+{
+    QString attribute = "[gpu:0]/GPUFanControlState";
+
+    NvidiaSettingsAdapter::setCacheTtl(60000);
+    NvidiaSettingsAdapter::clearCache();
+
+    QString first = NvidiaSettingsAdapter::queryAtrribute(attribute);
+
+    GPUDiagnostics::Snapshot before = GPUDiagnostics::snapshot();
+
+    QString value;
+    QBENCHMARK {
+        value = NvidiaSettingsAdapter::queryAtrribute(attribute);
+    }
+
+    GPUDiagnostics::Snapshot cached = GPUDiagnostics::snapshot();
+
+    NvidiaSettingsAdapter::setAttribute(attribute, 1);
+    QString assigned = NvidiaSettingsAdapter::queryAtrribute(attribute);
+    NvidiaSettingsAdapter::setAttribute(attribute, 0);
+
+    GPUDiagnostics::Snapshot after = GPUDiagnostics::snapshot();
+
+    NvidiaSettingsAdapter::setCacheTtl(0);
+
+    QCOMPARE(value, first);
+    QCOMPARE(cached.counters[GPUDiagnostics::ProcessSpawns], before.counters[GPUDiagnostics::ProcessSpawns]);
+    QCOMPARE(cached.counters[GPUDiagnostics::DriverQueries], before.counters[GPUDiagnostics::DriverQueries]);
+    QVERIFY(cached.counters[GPUDiagnostics::DriverQueryCacheHits] > before.counters[GPUDiagnostics::DriverQueryCacheHits]);
+
+    // Two assignments and the query after the first one
+    QCOMPARE(assigned, QString("1"));
+    QCOMPARE(after.counters[GPUDiagnostics::ProcessSpawns], cached.counters[GPUDiagnostics::ProcessSpawns] + 3);
+}
+
+/**
+ * Cost of the same refresh asked for by several threads at once
+ * Each request either runs the query or shares the one running, even without cache
+ */
+void BenchGPUTweak::adapterQueryCoalesced()
+{
+    QStringList arguments = QStringList() << "-t"
+                                          << "-q" << "[gpu:0]/GPUCoreTemp"
+                                          << "-q" << "[gpu:0]/GPUUtilization"
+                                          << "-q" << "[fan:0]/GPUCurrentFanSpeed";
+
+    GPUDiagnostics::Snapshot before = GPUDiagnostics::snapshot();
+
+    QList<QStringList> results;
+    QBENCHMARK_ONCE {
+        QList<QFuture<QStringList> > futures;
+        for(int i=0; i < COALESCED_QUERIES; i++) {
+            futures.append(QtConcurrent::run(NvidiaSettingsAdapter::queryArguments, arguments, 3));
+        }
+
+        foreach(QFuture<QStringList> future, futures) {
+            results.append(future.result());
+        }
+    }
+
+    GPUDiagnostics::Snapshot after = GPUDiagnostics::snapshot();
+
+    qint64 spawns    = after.counters[GPUDiagnostics::ProcessSpawns] - before.counters[GPUDiagnostics::ProcessSpawns];
+    qint64 coalesced = after.counters[GPUDiagnostics::DriverQueriesCoalesced] - before.counters[GPUDiagnostics::DriverQueriesCoalesced];
+
+    QCOMPARE(spawns + coalesced, static_cast<qint64>(COALESCED_QUERIES));
+    foreach(QStringList values, results) {
+        QCOMPARE(values.size(), 3);
+    }
+}
+
+void BenchGPUTweak::parseAttributesList_data()
+{
+    QTest::addColumn<QString>("list");
+    QTest::addColumn<QString>("key");
+    QTest::addColumn<int>("expected");
+
+    QString utilization = "graphics=45, memory=12, video=0, PCIe=1";
+    QString clocks      = "nvclock=1607, nvclockmin=139, nvclockmax=1911, nvclockmineditable=139, nvclockmaxeditable=1911, memclock=5005, memclockmin=5005, memclockmax=5005, memTransferRate=10010, memTransferRatemin=10010, memTransferRatemax=10010";
+
+    QTest::newRow("utilization first") << utilization << "graphics"           << 45;
+    QTest::newRow("utilization last")  << utilization << "PCIe"               << 1;
+    QTest::newRow("clocks first")      << clocks      << "nvclock"            << 1607;
+    QTest::newRow("clocks last")       << clocks      << "memTransferRatemax" << 10010;
+    QTest::newRow("clocks missing")    << clocks      << "graphics"           << 0;
+}
+
+/**
+ * Cost of extracting a value from a "key=value, key=value" list
+ */
+void BenchGPUTweak::parseAttributesList()
+{
+    QFETCH(QString, list);
+    QFETCH(QString, key);
+    QFETCH(int, expected);
+
+    QByteArray latinKey = key.toLatin1();
+
+    int value = 0;
+    QBENCHMARK {
+        value = NvidiaSettingsAdapter::getValueFromAttributesList(list, QLatin1String(latinKey));
+    }
+
+    QCOMPARE(value, expected);
+}
+
+void BenchGPUTweak::fetchVariables_data()
+{
+    QTest::addColumn<int>("metrics");
+
+    QTest::newRow("temp")           << static_cast<int>(GPU::CoreTemp);
+    QTest::newRow("use and clocks") << static_cast<int>(GPU::Utilization | GPU::Clocks);
+    QTest::newRow("all")            << static_cast<int>(GPU::AllMetrics);
+}
+
+/**
+ * Cost of a refresh of a card, from the queries to the parsed values
+ */
+void BenchGPUTweak::fetchVariables()
+{
+    QFETCH(int, metrics);
+
+    GPUNvidia gpu(0, "GeForce GTX 1080", NvidiaSettingsAdapter::queryTopology().value(0));
+
+    QBENCHMARK {
+        gpu.fetchVariables(GPU::Metrics(metrics));
+    }
+
+    QVERIFY(gpu.getCurrentCoreTemp() > 0 || !(metrics & GPU::CoreTemp));
+}
+
+void BenchGPUTweak::fetchArguments_data()
+{
+    QTest::addColumn<int>("metrics");
+    QTest::addColumn<bool>("prepared");
+
+    QTest::newRow("temp formatted")           << static_cast<int>(GPU::CoreTemp)                  << false;
+    QTest::newRow("temp prepared")            << static_cast<int>(GPU::CoreTemp)                  << true;
+    QTest::newRow("use and clocks formatted") << static_cast<int>(GPU::Utilization | GPU::Clocks) << false;
+    QTest::newRow("use and clocks prepared")  << static_cast<int>(GPU::Utilization | GPU::Clocks) << true;
+    QTest::newRow("all formatted")            << static_cast<int>(GPU::AllMetrics)                << false;
+    QTest::newRow("all prepared")             << static_cast<int>(GPU::AllMetrics)                << true;
+}
+
+/**
+ * Allocations per refresh made to get the arguments of the nvidia-settings process,
+ * formatted for each attribute like before the descriptors, or prepared once per GPU
+ * Reported as the result instead of the time
+ */
+void BenchGPUTweak::fetchArguments()
+{
+#ifndef __GLIBC__
+    QSKIP("Allocations are only counted with glibc");
+#else
+    QFETCH(int, metrics);
+    QFETCH(bool, prepared);
+
+    NvidiaTopology topology = NvidiaSettingsAdapter::queryTopology().value(0);
+    GPUNvidia gpu(0, "GeForce GTX 1080", topology);
+
+    QStringList expected = gpu.getFetchArguments(GPU::Metrics(metrics));
+    QStringList arguments;
+
+    // Attributes the card has, the old code checked them with flags
+    QList<int> attributes;
+    for(int i=0; i < NvidiaAttributes::AttributeCount; i++) {
+        const NvidiaAttributes::Descriptor &descriptor = NvidiaAttributes::DESCRIPTORS[i];
+        if(descriptor.refresh == NvidiaAttributes::Variable && (metrics & descriptor.metrics)
+                && expected.join(" ").contains(descriptor.name)) {
+            attributes.append(i);
+        }
+    }
+
+    int before = allocations.load();
+
+    for(int tick=0; tick < ALLOCATION_TICKS; tick++) {
+        if(prepared) {
+            arguments = gpu.getFetchArguments(GPU::Metrics(metrics));
+            continue;
+        }
+
+        arguments = QStringList("-t");
+        foreach(int i, attributes) {
+            const NvidiaAttributes::Descriptor &descriptor = NvidiaAttributes::DESCRIPTORS[i];
+
+            QString target = QString("[gpu:%1]/%2").arg(0).arg(descriptor.name);
+            if(descriptor.perfLevel) {
+                target += QString("[%1]").arg(gpu.getPerfLevelCount() - 1);
+            }
+            // List values of the same attribute are read once
+            if(!arguments.contains(target)) {
+                arguments << "-q" << target;
+            }
+        }
+        if(metrics & GPU::FanSpeed) {
+            foreach(int fan, topology.fans) {
+                arguments << "-q" << QString("[fan:%1]/GPUCurrentFanSpeed").arg(fan);
+            }
+        }
+        if(metrics & GPU::CoreTemp) {
+            foreach(int sensor, topology.thermalSensors) {
+                arguments << "-q" << QString("[thermalsensor:%1]/ThermalSensorReading").arg(sensor);
+            }
+        }
+    }
+
+    int count = allocations.load() - before;
+
+    QTest::setBenchmarkResult(static_cast<qreal>(count) / ALLOCATION_TICKS, QTest::Events);
+
+    QCOMPARE(arguments, expected);
+    if(prepared) {
+        QCOMPARE(count, 0);
+    }
+#endif
+}
+
+void BenchGPUTweak::getGPUs_data()
+{
+    QTest::addColumn<int>("count");
+
+    QTest::newRow("1 GPU")  << 1;
+    QTest::newRow("2 GPUs") << 2;
+    QTest::newRow("8 GPUs") << 8;
+}
+
+/**
+ * Cost of the detection at startup, which fetches the constants of every card
+ */
+void BenchGPUTweak::getGPUs()
+{
+    QFETCH(int, count);
+
+    qputenv("FAKE_NVIDIA_GPUS", QByteArray::number(count));
+
+    int found = 0;
+    QBENCHMARK {
+        QList<GPU*> gpus = NvidiaSettingsAdapter::getGPUs();
+        found = gpus.size();
+        qDeleteAll(gpus);
+    }
+
+    qunsetenv("FAKE_NVIDIA_GPUS");
+
+    QCOMPARE(found, count);
+}
+
+void BenchGPUTweak::queryTopology_data()
+{
+    QTest::addColumn<int>("fans");
+
+    QTest::newRow("1 fan")  << 1;
+    QTest::newRow("2 fans") << 2;
+    QTest::newRow("3 fans") << 3;
+}
+
+/**
+ * Cost of the discovery of the fans and thermal sensors, and the speeds read from each fan
+ * of the second card, whose fans do not share its id
+ */
+void BenchGPUTweak::queryTopology()
+{
+    QFETCH(int, fans);
+
+    qputenv("FAKE_NVIDIA_FANS", QByteArray::number(fans));
+
+    QMap<int, NvidiaTopology> topologies;
+    QBENCHMARK {
+        topologies = NvidiaSettingsAdapter::queryTopology();
+    }
+
+    QList<int> expectedFans;
+    for(int i=0; i < fans; i++) {
+        expectedFans.append(fans + i);
+    }
+
+    QCOMPARE(topologies.size(), 2);
+    QCOMPARE(topologies.value(1).fans, expectedFans);
+    QCOMPARE(topologies.value(1).thermalSensors, QList<int>() << 1);
+
+    GPUNvidia gpu(1, "GeForce GTX 1080", topologies.value(1));
+    gpu.fetchVariables(GPU::FanSpeed | GPU::CoreTemp);
+
+    qunsetenv("FAKE_NVIDIA_FANS");
+
+    QCOMPARE(gpu.getFanCount(), fans);
+    for(int i=0; i < fans; i++) {
+        // Default speed of the fake tool, 5 % more for each fan of a card
+        QCOMPARE(gpu.getCurrentFanSpeedAt(i), 40 + i * 5);
+    }
+    QCOMPARE(gpu.getThermalSensorCount(), 1);
+    QCOMPARE(gpu.getThermalSensorTempAt(0), gpu.getCurrentCoreTemp() + 3);
+}
+
+/**
+ * Values spread over the time shown by the graphs
+ * @param count Number of values
+ * @return Values, oldest first
+ */
+QList<GPUHistory::HistoryValue> BenchGPUTweak::makeValues(int count)
+{
+    QList<GPUHistory::HistoryValue> values;
+    QTime now = QTime::currentTime();
+
+    for(int i=0; i < count; i++) {
+        GPUHistory::HistoryValue value;
+        value.time  = now.addMSecs(-GRAPH_TIME_LENGTH_SECS * 1000 + static_cast<qint64>(i) * GRAPH_TIME_LENGTH_SECS * 1000 / count);
+        value.value = 40 + (i * 7) % 50;
+        values.append(value);
+    }
+
+    return values;
+}
+
+void BenchGPUTweak::updateGraph_data()
+{
+    QTest::addColumn<int>("count");
+
+    QTest::newRow("30 values")    << 30;   // default polling
+    QTest::newRow("600 values")   << 600;
+    QTest::newRow("6000 values")  << 6000; // burst rate
+    QTest::newRow("60000 values") << 60000;
+}
+
+/**
+ * Cost of selecting the visible values and drawing a graph
+ */
+void BenchGPUTweak::updateGraph()
+{
+    QFETCH(int, count);
+
+    GPUSimulated gpu(0);
+    GPUHistory history(&gpu);
+    GPUEventLog log;
+    GPUPoller poller;
+    BenchStatsWindow window(&history, &log, &poller);
+
+    QGraphicsScene scene(0, 0, GRAPH_WIDTH, GRAPH_HEIGHT);
+    QList<GPUHistory::HistoryValue> values = this->makeValues(count);
+
+    QBENCHMARK {
+        window.updateGraph(&scene, values, GRAPH_TIME_LENGTH_SECS, 0, 100, 10, 20);
+    }
+
+    QVERIFY(!scene.items().isEmpty());
+}
+
+void BenchGPUTweak::updateGraphScene_data()
+{
+    this->updateGraph_data();
+}
+
+/**
+ * Cost of drawing alone
+ */
+void BenchGPUTweak::updateGraphScene()
+{
+    QFETCH(int, count);
+
+    GPUSimulated gpu(0);
+    GPUHistory history(&gpu);
+    GPUEventLog log;
+    GPUPoller poller;
+    BenchStatsWindow window(&history, &log, &poller);
+
+    QGraphicsScene scene(0, 0, GRAPH_WIDTH, GRAPH_HEIGHT);
+    QList<GPUHistory::HistoryValue> values = this->makeValues(count);
+    QTime graphEnd   = QTime::currentTime();
+    QTime graphStart = graphEnd.addSecs(-GRAPH_TIME_LENGTH_SECS);
+
+    QBENCHMARK {
+        window.updateGraphScene(&scene, values, 0, 100, graphStart, graphEnd, 20);
+    }
+
+    QVERIFY(!scene.items().isEmpty());
+}
+
+QTEST_MAIN(BenchGPUTweak)
+
+#include "benchgputweak.moc"
@@ -0,0 +1,556 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "benchmarks.h"
+
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QProcess>
+#include <QThread>
+#include <QImage>
+#include <QTextStream>
+#include <QTime>
+#include <QVector>
+
+#include <algorithm>
+
+#include "gpudashboardwindow.h"
+#include "gpuhistory.h"
+#include "gpupoller.h"
+#include "gpusimulated.h"
+#include "gpufancontroller.h"
+#include "gpuworkloadwatcher.h"
+#include "gputhrottledetector.h"
+#include "gpusketch.h"
+#include "gpunetwork.h"
+
+/**
+ * Number of frames drawn before measuring
+ */
+const int DASHBOARD_WARMUP_FRAMES = 10;
+/**
+ * Number of frames measured
+ */
+const int DASHBOARD_MEASURED_FRAMES = 200;
+/**
+ * Seconds of history generated for each GPU, one sample per second
+ */
+const int DASHBOARD_HISTORY_SECS = 60;
+/**
+ * Size of the window drawn
+ */
+const int DASHBOARD_WIDTH  = 1280;
+const int DASHBOARD_HEIGHT = 800;
+/**
+ * Simulated seconds given to the card to stabilize before the step, then measured after it
+ */
+const int PID_STABILIZE_SECS = 300;
+const int PID_MEASURED_SECS  = 600;
+/**
+ * Distance to the target (°C) under which the temperature is considered settled
+ */
+const int PID_SETTLED_BAND = 2;
+
+/**
+ * Number of scans of /proc measured, with and without the cache of known processes
+ */
+const int WATCHER_SCANS = 50;
+/**
+ * Time between two scans while waiting for the workload to be detected, and the longest wait
+ */
+const int WATCHER_POLL_MSECS    = 5;
+const int WATCHER_TIMEOUT_MSECS = 5000;
+
+/**
+ * Number of samples given to the throttle detector, and length of the throttled and normal periods
+ */
+const int THROTTLE_SAMPLES        = 1000000;
+const int THROTTLE_PERIOD_SAMPLES = 50;
+
+/**
+ * Number of values added to the sketches, and number of sketches merged
+ */
+const int SKETCH_VALUES  = 1000000;
+const int SKETCH_MERGES  = 288;
+/**
+ * Quantiles checked against the exact ones
+ */
+const double SKETCH_QUANTILES[] = {0.5, 0.9, 0.95, 0.99, 0.999};
+
+/**
+ * Seconds of samples encoded, one sample per GPU per second, and size of the backfill frames
+ */
+const int NETWORK_SECS           = 3600;
+const int NETWORK_BACKFILL_BATCH = 2048;
+
+/**
+ * Step applied to the simulated card during a PID run
+ */
+struct PidScenario {
+    const char *name;
+    int loadBefore;   // %
+    int loadAfter;    // %
+    int targetBefore; // °C
+    int targetAfter;  // °C
+};
+
+const PidScenario PID_SCENARIOS[] = {
+    {"load 50% -> 100%",   50, 100, 70, 70},
+    {"load 100% -> 50%",  100,  50, 70, 70},
+    {"load 30% -> 80%",    30,  80, 70, 70},
+    {"target 75 -> 65°C",  80,  80, 75, 65},
+    {"target 65 -> 75°C",  80,  80, 65, 75},
+};
+
+/**
+ * Runs a benchmark by name
+ * @param name Name of the benchmark
+ * @param gpus GPUs to use
+ * @return Exit code
+ */
+int Benchmarks::run(QString name, QList<GPU*> gpus)
+{
+    if(name == "dashboard") {
+        return Benchmarks::dashboard(gpus);
+    }
+
+    if(name == "pid") {
+        return Benchmarks::pid();
+    }
+
+    if(name == "watcher") {
+        return Benchmarks::watcher();
+    }
+
+    if(name == "throttle") {
+        return Benchmarks::throttle();
+    }
+
+    if(name == "sketch") {
+        return Benchmarks::sketch();
+    }
+
+    if(name == "network") {
+        return Benchmarks::network(gpus);
+    }
+
+    QTextStream(stderr) << "Unknown benchmark: " << name << endl;
+    return 1;
+}
+
+/**
+ * Measures the time needed to draw a frame of the dashboard
+ * @param gpus GPUs to display
+ * @return Exit code
+ */
+int Benchmarks::dashboard(QList<GPU*> gpus)
+{
+    QList<GPUHistory*> histories;
+    QTime now = QTime::currentTime();
+
+    foreach(GPU *gpu, gpus) {
+        GPUHistory *history = new GPUHistory(gpu);
+
+        // Signals are blocked so the samples are only stored with the generated times
+        gpu->blockSignals(true);
+        for(int i = DASHBOARD_HISTORY_SECS; i >= 0; i--) {
+            gpu->fetchVariables();
+            history->record(now.addSecs(-i));
+        }
+        gpu->blockSignals(false);
+
+        histories.append(history);
+    }
+
+    GPUPoller poller;
+    GPUDashboardWindow window(histories, &poller);
+    window.resize(DASHBOARD_WIDTH, DASHBOARD_HEIGHT);
+
+    QImage frame(window.size(), QImage::Format_ARGB32_Premultiplied);
+
+    for(int i=0; i < DASHBOARD_WARMUP_FRAMES; i++) {
+        window.render(&frame);
+    }
+
+    QVector<qint64> frameTimes;
+    frameTimes.reserve(DASHBOARD_MEASURED_FRAMES);
+
+    QElapsedTimer timer;
+    for(int i=0; i < DASHBOARD_MEASURED_FRAMES; i++) {
+        timer.start();
+        window.render(&frame);
+        frameTimes.append(timer.nsecsElapsed());
+    }
+
+    std::sort(frameTimes.begin(), frameTimes.end());
+
+    qint64 sum = 0;
+    foreach(qint64 nsecs, frameTimes) {
+        sum += nsecs;
+    }
+
+    QTextStream out(stdout);
+    out << "dashboard: " << gpus.size() << " GPUs, " << frameTimes.size() << " frames" << endl;
+    out << QString("  mean %1 ms").arg(static_cast<double>(sum) / frameTimes.size() / 1000000.0, 0, 'f', 3) << endl;
+    out << QString("  p50  %1 ms").arg(frameTimes.at(frameTimes.size() / 2) / 1000000.0, 0, 'f', 3) << endl;
+    out << QString("  p99  %1 ms").arg(frameTimes.at(frameTimes.size() * 99 / 100) / 1000000.0, 0, 'f', 3) << endl;
+    out << QString("  max  %1 ms").arg(frameTimes.last() / 1000000.0, 0, 'f', 3) << endl;
+
+    qDeleteAll(histories);
+
+    return 0;
+}
+
+/**
+ * Runs the target temperature mode of the fan controller against the thermal
+ * model of a simulated card, on simulated time, and measures how it reacts
+ * to steps of the load and of the target
+ * @return Exit code
+ */
+int Benchmarks::pid()
+{
+    QTextStream out(stdout);
+    out << "pid: " << PID_MEASURED_SECS << " s after each step, settled within " << PID_SETTLED_BAND << "°C" << endl;
+
+    GPUPoller poller;
+
+    for(unsigned int i=0; i < sizeof(PID_SCENARIOS) / sizeof(PID_SCENARIOS[0]); i++) {
+        const PidScenario &scenario = PID_SCENARIOS[i];
+
+        GPUSimulated gpu(0);
+        gpu.setLoad(scenario.loadBefore);
+        gpu.setFanControlEnabled(true);
+
+        // The controller is driven directly, without subscribing to the poller which runs on real time
+        GPUFanController controller(&gpu, &poller);
+        controller.setMode(GPUFanController::TargetTempMode);
+        controller.setTargetTemp(scenario.targetBefore);
+
+        for(int t=0; t < PID_STABILIZE_SECS; t++) {
+            gpu.fetchVariables(GPU::CoreTemp);
+            controller.process(gpu.getCurrentCoreTemp(), 1.0);
+        }
+
+        gpu.setLoad(scenario.loadAfter);
+        controller.setTargetTemp(scenario.targetAfter);
+
+        int writesBefore = controller.getWriteCount();
+        int settlingSecs = 0;
+        int overshoot    = 0;
+        int temp         = 0;
+
+        // Overshoot is measured in the direction the temperature was pushed
+        int direction = scenario.targetAfter < scenario.targetBefore || scenario.loadAfter < scenario.loadBefore ? -1 : 1;
+
+        for(int t=1; t <= PID_MEASURED_SECS; t++) {
+            gpu.fetchVariables(GPU::CoreTemp);
+            temp = gpu.getCurrentCoreTemp();
+            controller.process(temp, 1.0);
+
+            overshoot = qMax(overshoot, (temp - scenario.targetAfter) * direction);
+
+            if(qAbs(temp - scenario.targetAfter) > PID_SETTLED_BAND) {
+                settlingSecs = t;
+            }
+        }
+
+        out << QString("  %1 settling %2 s, overshoot %3°C, final %4°C, fan %5%, %6 writes")
+               .arg(scenario.name, -20)
+               .arg(settlingSecs, 3)
+               .arg(overshoot)
+               .arg(temp)
+               .arg(gpu.getCurrentFanSpeed())
+               .arg(controller.getWriteCount() - writesBefore) << endl;
+    }
+
+    return 0;
+}
+
+/**
+ * Measures the cost of a scan of /proc by the workload watcher, matching every
+ * process again versus only the new or re-executed ones, then how long it takes to switch
+ * after a matching process starts
+ * @return Exit code
+ */
+int Benchmarks::watcher()
+{
+    QTextStream out(stdout);
+
+    GPUWorkloadWatcher::Rule rule;
+    rule.type    = GPUWorkloadWatcher::Rule::Executable;
+    rule.pattern = "*sleep";
+    rule.profile = "benchmark";
+
+    QList<GPUWorkloadWatcher::Rule> rules;
+    rules.append(rule);
+
+    GPUWorkloadWatcher watcher;
+    watcher.setRules(rules, QString());
+    watcher.setDebounceMsecs(0);
+
+    qint64 fullNsecs = 0;
+    qint64 fullCpu   = 0;
+    for(int i=0; i < WATCHER_SCANS; i++) {
+        // Setting the rules forgets the known processes
+        watcher.setRules(rules, QString());
+        qint64 cpuBefore = watcher.getScanCpuNsecs();
+        watcher.scan();
+        fullNsecs += watcher.getLastScanNsecs();
+        fullCpu   += watcher.getScanCpuNsecs() - cpuBefore;
+    }
+
+    qint64 diffNsecs = 0;
+    qint64 diffCpu   = 0;
+    for(int i=0; i < WATCHER_SCANS; i++) {
+        qint64 cpuBefore = watcher.getScanCpuNsecs();
+        watcher.scan();
+        diffNsecs += watcher.getLastScanNsecs();
+        diffCpu   += watcher.getScanCpuNsecs() - cpuBefore;
+    }
+
+    out << "watcher: " << watcher.getProcessCount() << " processes, " << WATCHER_SCANS << " scans" << endl;
+    out << QString("  full scan %1 ms, %2 ms CPU").arg(fullNsecs / WATCHER_SCANS / 1000000.0, 0, 'f', 3).arg(fullCpu / WATCHER_SCANS / 1000000.0, 0, 'f', 3) << endl;
+    out << QString("  diff scan %1 ms, %2 ms CPU").arg(diffNsecs / WATCHER_SCANS / 1000000.0, 0, 'f', 3).arg(diffCpu / WATCHER_SCANS / 1000000.0, 0, 'f', 3) << endl;
+
+    QProcess workload;
+    QElapsedTimer timer;
+    timer.start();
+    workload.start("sleep", QStringList() << "30");
+
+    if(!workload.waitForStarted()) {
+        QTextStream(stderr) << "Could not start the workload" << endl;
+        return 1;
+    }
+
+    while(watcher.getActiveProfile().isEmpty() && timer.elapsed() < WATCHER_TIMEOUT_MSECS) {
+        watcher.scan();
+        QThread::msleep(WATCHER_POLL_MSECS);
+    }
+
+    qint64 switchNsecs = timer.nsecsElapsed();
+
+    workload.kill();
+    workload.waitForFinished();
+
+    if(watcher.getActiveProfile().isEmpty()) {
+        QTextStream(stderr) << "The workload was not detected" << endl;
+        return 1;
+    }
+
+    // In the app the scan interval and the debounce delay are added to this
+    out << QString("  switch %1 ms after the start, scanning every %2 ms").arg(switchNsecs / 1000000.0, 0, 'f', 3).arg(WATCHER_POLL_MSECS) << endl;
+
+    return 0;
+}
+
+/**
+ * Feeds the throttle detector with a long series of samples alternating
+ * normal and throttled periods, and measures the time taken per sample
+ * @return Exit code
+ */
+int Benchmarks::throttle()
+{
+    GPUSimulated gpu(0);
+    GPUEventLog log;
+    GPUThrottleDetector detector(&gpu, &log);
+
+    QDateTime time = QDateTime::currentDateTime();
+
+    QElapsedTimer timer;
+    timer.start();
+
+    for(int i=0; i < THROTTLE_SAMPLES; i++) {
+        bool throttled = (i / THROTTLE_PERIOD_SAMPLES) % 2 == 1;
+        int  depth     = 100 + (i / (2 * THROTTLE_PERIOD_SAMPLES)) % 5 * 100;
+
+        detector.process(time.addMSecs(i * 1000), throttled ? 1800 - depth : 1800, 95, throttled ? 86 : 75);
+    }
+
+    qint64 nsecs = timer.nsecsElapsed();
+
+    QTextStream out(stdout);
+    out << "throttle: " << THROTTLE_SAMPLES << " samples" << endl;
+    out << QString("  %1 ns per sample").arg(static_cast<double>(nsecs) / THROTTLE_SAMPLES, 0, 'f', 1) << endl;
+    out << QString("  %1 events detected of %2, %3 kept").arg(log.getEvents().isEmpty() ? 0 : log.getEvents().last().id + 1).arg(THROTTLE_SAMPLES / THROTTLE_PERIOD_SAMPLES / 2).arg(log.getEvents().size()) << endl;
+
+    return 0;
+}
+
+/**
+ * Compares the quantiles of the sketch to the exact ones on a few
+ * distributions, and measures the cost of adding values and merging sketches
+ * @return Exit code
+ */
+int Benchmarks::sketch()
+{
+    QTextStream out(stdout);
+    out << "sketch: " << SKETCH_VALUES << " values, relative accuracy " << GPUSketch::getRelativeAccuracy() << endl;
+
+    const char * const names[] = {"temperature", "usage", "clock", "long tail"};
+
+    quint32 seed = 2463534242u;
+
+    for(int distribution=0; distribution < 4; distribution++) {
+        QVector<double> values(SKETCH_VALUES);
+
+        for(int i=0; i < SKETCH_VALUES; i++) {
+            seed ^= seed << 13;
+            seed ^= seed >> 17;
+            seed ^= seed << 5;
+            double uniform = (seed % 1000000) / 1000000.0;
+
+            switch(distribution) {
+            case 0:
+                // Integer degrees around 70
+                values[i] = qRound(60 + 20 * uniform * uniform);
+                break;
+            case 1:
+                // Mostly idle or fully busy
+                values[i] = uniform < 0.3 ? 0 : qRound(60 + 40 * uniform);
+                break;
+            case 2:
+                values[i] = uniform < 0.05 ? 300 : 1500 + qRound(400 * uniform);
+                break;
+            default:
+                values[i] = 1 / (1 - uniform * 0.999);
+            }
+        }
+
+        GPUSketch sketch;
+
+        QElapsedTimer timer;
+        timer.start();
+        for(int i=0; i < SKETCH_VALUES; i++) {
+            sketch.add(values.at(i));
+        }
+        qint64 addNsecs = timer.nsecsElapsed();
+
+        std::sort(values.begin(), values.end());
+
+        double worstError = 0;
+        QStringList errors;
+        for(unsigned int q=0; q < sizeof(SKETCH_QUANTILES) / sizeof(SKETCH_QUANTILES[0]); q++) {
+            double exact    = values.at(static_cast<int>(SKETCH_QUANTILES[q] * (SKETCH_VALUES - 1)));
+            double estimate = sketch.getQuantile(SKETCH_QUANTILES[q]);
+            double error    = exact != 0 ? qAbs(estimate - exact) / qAbs(exact) : qAbs(estimate);
+
+            worstError = qMax(worstError, error);
+            errors.append(QString("p%1 %2").arg(SKETCH_QUANTILES[q] * 100).arg(error * 100, 0, 'f', 2));
+        }
+
+        out << QString("  %1 %2 ns per value, %3 bins, error %: %4 (worst %5)")
+               .arg(names[distribution], -12)
+               .arg(static_cast<double>(addNsecs) / SKETCH_VALUES, 0, 'f', 1)
+               .arg(sketch.getBinCount())
+               .arg(errors.join(", "))
+               .arg(worstError * 100, 0, 'f', 2) << endl;
+    }
+
+    // A day of 5 minutes buckets, as summarized by the stats window
+    QVector<GPUSketch> buckets(SKETCH_MERGES);
+    for(int i=0; i < SKETCH_MERGES; i++) {
+        for(int v=0; v < 150; v++) {
+            buckets[i].add(60 + (i + v) % 25);
+        }
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    GPUSketch merged;
+    foreach(const GPUSketch &bucket, buckets) {
+        merged.merge(bucket);
+    }
+    qint64 mergeNsecs = timer.nsecsElapsed();
+
+    out << QString("  merge of %1 buckets %2 µs, p99 %3").arg(SKETCH_MERGES).arg(mergeNsecs / 1000.0, 0, 'f', 1).arg(merged.getQuantile(0.99)) << endl;
+
+    return 0;
+}
+
+/**
+ * Measures the size and the encoding cost of the frames of the agents,
+ * batched every second like the live stream and in large batches like a backfill
+ * @param gpus Simulated GPUs to sample
+ * @return Exit code
+ */
+int Benchmarks::network(QList<GPU*> gpus)
+{
+    GPU::Metrics metrics = GPU::CoreTemp | GPU::FanSpeed | GPU::Clocks | GPU::Utilization | GPU::PerfLevel | GPU::PcieLink | GPU::Power;
+
+    QList<GPUNetwork::Sample> samples;
+    quint64 seq = 1;
+    qint64 time = QDateTime::currentMSecsSinceEpoch();
+
+    for(int sec=0; sec < NETWORK_SECS; sec++) {
+        for(int i=0; i < gpus.size(); i++) {
+            gpus.at(i)->fetchVariables(metrics);
+
+            GPUNetwork::Sample sample = GPUNetwork::sample(gpus.at(i), i, metrics, time + sec * 1000 + i);
+            sample.seq = seq++;
+            samples.append(sample);
+        }
+    }
+
+    QTextStream out(stdout);
+    out << "network: " << samples.size() << " samples of " << gpus.size() << " GPUs" << endl;
+
+    const int   batches[] = {gpus.size(), NETWORK_BACKFILL_BATCH};
+    const char * const names[] = {"live", "backfill"};
+
+    for(int b=0; b < 2; b++) {
+        int batch = qMax(1, batches[b]);
+
+        qint64 payloadBytes = 0;
+        qint64 frameBytes   = 0;
+        QList<QByteArray> frames;
+
+        QElapsedTimer timer;
+        timer.start();
+        for(int start=0; start < samples.size(); start += batch) {
+            QByteArray payload = GPUNetwork::encodeSamples(QString(), samples.mid(start, batch));
+            payloadBytes += payload.size();
+
+            frames.append(GPUNetwork::encodeFrame(GPUNetwork::Samples, payload));
+            frameBytes += frames.last().size();
+        }
+        qint64 encodeNsecs = timer.nsecsElapsed();
+
+        timer.restart();
+        int decoded = 0;
+        foreach(QByteArray buffer, frames) {
+            GPUNetwork::Frame frame;
+            QString host;
+            QList<GPUNetwork::Sample> received;
+
+            if(GPUNetwork::takeFrame(buffer, frame) == GPUNetwork::FrameRead && GPUNetwork::decodeSamples(frame.payload, host, received)) {
+                decoded += received.size();
+            }
+        }
+        qint64 decodeNsecs = timer.nsecsElapsed();
+
+        out << QString("  %1 %2 samples per frame, %3 bytes per sample encoded, %4 on the wire, encode %5 ns, decode %6 ns per sample%7")
+               .arg(names[b], -8)
+               .arg(batch)
+               .arg(static_cast<double>(payloadBytes) / samples.size(), 0, 'f', 1)
+               .arg(static_cast<double>(frameBytes) / samples.size(), 0, 'f', 1)
+               .arg(static_cast<double>(encodeNsecs) / samples.size(), 0, 'f', 1)
+               .arg(static_cast<double>(decodeNsecs) / samples.size(), 0, 'f', 1)
+               .arg(decoded == samples.size() ? "" : " (DECODING FAILED)") << endl;
+    }
+
+    return 0;
+}
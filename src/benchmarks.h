@@ -15,29 +15,28 @@
  * You should have received a copy of the GNU Lesser General Public License
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
-#ifndef NVIDIASETTINGSADAPTER
-#define NVIDIASETTINGSADAPTER
+#ifndef BENCHMARKS_H
+#define BENCHMARKS_H
 
+#include <QList>
 #include <QString>
 
 #include "gpu.h"
 
 /**
- * This namespace holds global functions used to access the NVIDIA driver data trough the nvidia-settings linux tool
+ * Self-benchmarks that can be run from the command line
+ * Results are written on the standard output
  */
-namespace NvidiaSettingsAdapter
+namespace Benchmarks
 {
-    QString cmdLineProcess(QString command);
-
-    QString queryAtrribute(QString attribute);
-
-    void setAttribute(QString attribute, QString value);
-    void setAttribute(QString attribute, int value);
-
-    int getValueFromAttributesList(QString list, QString key);
-
-    QList<GPU*> getGPUs();
+    int run(QString name, QList<GPU*> gpus);
+
+    int dashboard(QList<GPU*> gpus);
+    int pid();
+    int watcher();
+    int throttle();
+    int sketch();
+    int network(QList<GPU*> gpus);
 }
 
-#endif // NVIDIASETTINGSADAPTER
-
+#endif // BENCHMARKS_H
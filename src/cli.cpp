@@ -0,0 +1,541 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "cli.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QProcess>
+#include <QTimer>
+#include <QStringList>
+#include <QTextStream>
+
+#include "gpuburstcapture.h"
+#include "gpudiagnostics.h"
+#include "gpuenergymeter.h"
+#include "gpuhistory.h"
+#include "gpujobmarkers.h"
+#include "gpupoller.h"
+#include "gpuprofile.h"
+
+/**
+ * Time between two samples of the percentiles command
+ */
+const int QUANTILES_INTERVAL_MSECS = 1000;
+/**
+ * Time between two samples of the diagnostics command, like the stats window
+ */
+const int DIAGNOSTICS_INTERVAL_MSECS = 1000;
+/**
+ * Header of the CSV printed by the energy commands
+ */
+const char ENERGY_CSV_HEADER[] = "job,gpu,start,end,duration_s,energy_j,average_w,peak_w,samples,longest_gap_s";
+
+/**
+ * Parses a comma-separated list of metric names
+ * @param list Names among temp, fan, clocks, use, perf, offsets, pcie, power and all
+ * @return Metrics, empty if a name is unknown
+ */
+GPU::Metrics Cli::parseMetrics(QString list)
+{
+    GPU::Metrics metrics = 0;
+
+    foreach(QString name, list.split(",", QString::SkipEmptyParts)) {
+        name = name.trimmed();
+
+        if(name == "temp") {
+            metrics |= GPU::CoreTemp;
+        } else if(name == "fan") {
+            metrics |= GPU::FanSpeed;
+        } else if(name == "clocks") {
+            metrics |= GPU::Clocks;
+        } else if(name == "use") {
+            metrics |= GPU::Utilization;
+        } else if(name == "perf") {
+            metrics |= GPU::PerfLevel;
+        } else if(name == "offsets") {
+            metrics |= GPU::ClockOffsets;
+        } else if(name == "pcie") {
+            metrics |= GPU::PcieLink;
+        } else if(name == "power") {
+            metrics |= GPU::Power;
+        } else if(name == "all") {
+            metrics |= GPU::AllMetrics;
+        } else {
+            QTextStream(stderr) << "Unknown metric: " << name << endl;
+            return 0;
+        }
+    }
+
+    return metrics;
+}
+
+/**
+ * Parses a comma-separated list of GPU indexes
+ * @param list     Indexes, or "all"
+ * @param gpus     All the GPUs
+ * @param selected Set to the GPUs of the list
+ * @return False if an index is invalid
+ */
+bool Cli::parseGPUs(QString list, QList<GPU*> gpus, QList<GPU*> &selected)
+{
+    selected.clear();
+
+    if(list == "all") {
+        selected = gpus;
+        return true;
+    }
+
+    foreach(QString index, list.split(",", QString::SkipEmptyParts)) {
+        bool ok;
+        int gpuInd = index.trimmed().toInt(&ok);
+
+        if(!ok || gpuInd < 0 || gpuInd >= gpus.size()) {
+            QTextStream(stderr) << "Invalid GPU: " << index << endl;
+            return false;
+        }
+
+        selected.append(gpus.at(gpuInd));
+    }
+
+    return !selected.isEmpty();
+}
+
+/**
+ * Runs a burst capture and prints its summary
+ * @param gpu           GPU to sample
+ * @param metrics       Metrics to sample
+ * @param durationMsecs Length of the capture
+ * @param outputFile    If not empty, all the samples are written there as CSV
+ * @return Exit code
+ */
+int Cli::burst(GPU *gpu, GPU::Metrics metrics, int durationMsecs, QString outputFile)
+{
+    GPUBurstCapture capture(gpu, metrics, durationMsecs);
+    capture.run();
+
+    QTextStream(stdout) << capture.getSummary();
+
+    if(outputFile.isEmpty()) {
+        return 0;
+    }
+
+    QFile file(outputFile);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        QTextStream(stderr) << "Cannot write " << outputFile << endl;
+        return 1;
+    }
+
+    QTextStream out(&file);
+
+    QList<GPUHistory::Series> captured;
+    out << "time_ns";
+    for(int i=0; i < GPUHistory::SeriesCount; i++) {
+        GPUHistory::Series series = static_cast<GPUHistory::Series>(i);
+
+        if(capture.isSeriesCaptured(series)) {
+            captured.append(series);
+            out << ",\"" << GPUBurstCapture::getSeriesName(series) << "\"";
+        }
+    }
+    out << "\n";
+
+    foreach(const GPUBurstCapture::Sample &sample, capture.getSamples()) {
+        out << sample.nsecs;
+        foreach(GPUHistory::Series series, captured) {
+            out << "," << sample.values[series];
+        }
+        out << "\n";
+    }
+
+    return 0;
+}
+
+/**
+ * Applies a profile in one batch, verifies it and prints the time taken by both steps
+ * @param gpus    GPUs to tweak
+ * @param profile Profile without controller
+ * @param label   Printed before the number of GPUs, ex: "profile compute"
+ * @return Exit code
+ */
+static int applyAndVerify(QList<GPU*> gpus, const GPUProfile &profile, QString label)
+{
+    GPUPoller poller;
+    QList<GPUFanController*> controllers;
+    foreach(GPU *gpu, gpus) {
+        controllers.append(new GPUFanController(gpu, &poller));
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    bool applied = profile.apply(controllers);
+    qint64 applyNsecs = timer.nsecsElapsed();
+
+    timer.restart();
+    QStringList failures = profile.verify(controllers);
+    qint64 verifyNsecs = timer.nsecsElapsed();
+
+    qDeleteAll(controllers);
+
+    QTextStream out(stdout);
+    out << label << ": " << gpus.size() << " GPUs" << endl;
+    out << QString("  apply  %1 ms%2").arg(applyNsecs / 1000000.0, 0, 'f', 3).arg(applied ? "" : " (the driver reported an error)") << endl;
+    out << QString("  verify %1 ms").arg(verifyNsecs / 1000000.0, 0, 'f', 3) << endl;
+
+    foreach(QString failure, failures) {
+        out << "  " << failure << endl;
+    }
+
+    return applied && failures.isEmpty() ? 0 : 1;
+}
+
+/**
+ * Applies a saved profile, verifies it and prints the time taken by both steps
+ * Fan curves and target temperatures need the app to keep running, they are
+ * skipped here, start the GUI with --profile for them
+ * @param gpus GPUs to tweak
+ * @param name Name of the profile
+ * @return Exit code
+ */
+int Cli::applyProfile(QList<GPU*> gpus, QString name)
+{
+    GPUProfile profile;
+    if(!GPUProfile::load(name, profile)) {
+        QTextStream(stderr) << "Unknown profile: " << name << " (profiles are read from " << GPUProfile::storagePath() << ")" << endl;
+        return 1;
+    }
+
+    if(profile.needsController()) {
+        QTextStream(stderr) << "The fan mode of " << name << " only works while GPUTweak runs, the fans are left unchanged" << endl;
+        profile.fanMode = GPUProfile::FanUnchanged;
+    }
+
+    return applyAndVerify(gpus, profile, QString("profile %1").arg(name));
+}
+
+/**
+ * Sets the power limit of the GPUs in one batch, reads it back and prints the time taken by both steps
+ * The limit is bounded to the range of each GPU
+ * @param gpus  GPUs to tweak
+ * @param watts Limit in W
+ * @return Exit code
+ */
+int Cli::setPowerLimit(QList<GPU*> gpus, int watts)
+{
+    foreach(GPU *gpu, gpus) {
+        if(!gpu->isPowerLimitControlAvailable()) {
+            QTextStream(stderr) << gpu->getIdentifier() << " cannot limit its power, skipped" << endl;
+        }
+    }
+
+    GPUProfile profile;
+    profile.powerLimit = watts;
+
+    return applyAndVerify(gpus, profile, QString("power limit %1 W").arg(watts));
+}
+
+/**
+ * Samples the GPUs at a regular interval and prints the percentiles of each series as CSV
+ * @param gpus          GPUs to sample
+ * @param metrics       Metrics to sample
+ * @param durationMsecs Length of the sampling
+ * @param outputFile    If not empty, the percentiles are also written there as JSON
+ * @return Exit code
+ */
+int Cli::quantiles(QList<GPU*> gpus, GPU::Metrics metrics, int durationMsecs, QString outputFile)
+{
+    GPUPoller poller;
+    QList<GPUHistory*> histories;
+    foreach(GPU *gpu, gpus) {
+        GPUHistory *history = new GPUHistory(gpu);
+        histories.append(history);
+        poller.subscribe(history, gpu, metrics, QUANTILES_INTERVAL_MSECS);
+    }
+
+    QEventLoop loop;
+    QTimer::singleShot(durationMsecs, &loop, SLOT(quit()));
+    loop.exec();
+
+    QTextStream out(stdout);
+    out << "gpu,series,count,min,p50,p90,p95,p99,max" << endl;
+
+    QJsonArray json;
+
+    foreach(GPUHistory *history, histories) {
+        for(int i=0; i < GPUHistory::SeriesCount; i++) {
+            GPUHistory::Series series = static_cast<GPUHistory::Series>(i);
+            GPUSketch sketch = history->getSketch(series, 0);
+
+            if(!(metrics & GPUHistory::getSeriesMetric(series)) || sketch.getCount() == 0) {
+                continue;
+            }
+
+            out << history->getGPU()->getIdentifier()
+                << ",\"" << GPUBurstCapture::getSeriesName(series) << "\""
+                << "," << sketch.getCount()
+                << "," << sketch.getMin()
+                << "," << sketch.getQuantile(0.50)
+                << "," << sketch.getQuantile(0.90)
+                << "," << sketch.getQuantile(0.95)
+                << "," << sketch.getQuantile(0.99)
+                << "," << sketch.getMax() << endl;
+
+            QJsonObject object = sketch.toJson();
+            object.insert("gpu", history->getGPU()->getIdentifier());
+            object.insert("series", GPUBurstCapture::getSeriesName(series));
+            json.append(object);
+        }
+    }
+
+    qDeleteAll(histories);
+
+    if(outputFile.isEmpty()) {
+        return 0;
+    }
+
+    QFile file(outputFile);
+    if(!file.open(QIODevice::WriteOnly)) {
+        QTextStream(stderr) << "Cannot write " << outputFile << endl;
+        return 1;
+    }
+
+    file.write(QJsonDocument(json).toJson());
+
+    return 0;
+}
+
+/**
+ * Polls GPUs like the app would, then prints what GPUTweak itself cost
+ * Prints a CSV with the counters, then the distribution of each duration in microseconds
+ * @param gpus          GPUs to poll
+ * @param metrics       Metrics to poll
+ * @param durationMsecs Length of the polling
+ * @param outputFile    If not empty, the values are also written there as JSON
+ * @return Exit code
+ */
+int Cli::diagnostics(QList<GPU*> gpus, GPU::Metrics metrics, int durationMsecs, QString outputFile)
+{
+    // The values are not reset, the detection of the GPUs is part of the cost
+    GPUPoller poller;
+    QList<GPUHistory*> histories;
+    foreach(GPU *gpu, gpus) {
+        GPUHistory *history = new GPUHistory(gpu);
+        histories.append(history);
+        poller.subscribe(history, gpu, metrics, DIAGNOSTICS_INTERVAL_MSECS);
+    }
+
+    QEventLoop loop;
+    QTimer::singleShot(durationMsecs, &loop, SLOT(quit()));
+    loop.exec();
+
+    GPUDiagnostics::Snapshot snapshot = GPUDiagnostics::snapshot();
+
+    QTextStream out(stdout);
+    out << "kind,name,count,p50,p90,p99,max" << endl;
+
+    for(int i=0; i < GPUDiagnostics::CounterCount; i++) {
+        out << "counter," << GPUDiagnostics::getCounterName(static_cast<GPUDiagnostics::Counter>(i))
+            << "," << snapshot.counters[i] << ",,,," << endl;
+    }
+
+    for(int i=0; i < GPUDiagnostics::TimingCount; i++) {
+        QMapIterator<QString, GPUSketch> it(snapshot.timings[i]);
+        while(it.hasNext()) {
+            it.next();
+
+            out << GPUDiagnostics::getTimingName(static_cast<GPUDiagnostics::Timing>(i))
+                << ",\"" << it.key() << "\""
+                << "," << it.value().getCount()
+                << "," << it.value().getQuantile(0.50)
+                << "," << it.value().getQuantile(0.90)
+                << "," << it.value().getQuantile(0.99)
+                << "," << it.value().getMax() << endl;
+        }
+    }
+
+    QJsonObject json = GPUDiagnostics::toJson(snapshot);
+    QJsonArray historyBytes;
+
+    foreach(GPUHistory *history, histories) {
+        out << "history_bytes," << history->getGPU()->getIdentifier() << "," << history->getMemoryUsage() << ",,,," << endl;
+
+        QJsonObject object;
+        object.insert("gpu", history->getGPU()->getIdentifier());
+        object.insert("bytes", static_cast<double>(history->getMemoryUsage()));
+        historyBytes.append(object);
+    }
+
+    json.insert("history_bytes", historyBytes);
+
+    qDeleteAll(histories);
+
+    if(outputFile.isEmpty()) {
+        return 0;
+    }
+
+    QFile file(outputFile);
+    if(!file.open(QIODevice::WriteOnly)) {
+        QTextStream(stderr) << "Cannot write " << outputFile << endl;
+        return 1;
+    }
+
+    file.write(QJsonDocument(json).toJson());
+
+    return 0;
+}
+
+/**
+ * Creates an energy meter for each GPU and polls their power draw
+ * @param gpus          GPUs to measure
+ * @param intervalMsecs Time between two power samples
+ * @param poller        Poller the meters subscribe to
+ * @return Meters, owned by the caller
+ */
+static QList<GPUEnergyMeter*> createEnergyMeters(QList<GPU*> gpus, int intervalMsecs, GPUPoller &poller)
+{
+    QList<GPUEnergyMeter*> meters;
+    foreach(GPU *gpu, gpus) {
+        if(!gpu->isPowerDrawAvailable()) {
+            QTextStream(stderr) << gpu->getIdentifier() << " does not report its power draw, skipped" << endl;
+            continue;
+        }
+
+        GPUEnergyMeter *meter = new GPUEnergyMeter(gpu);
+        meters.append(meter);
+        poller.subscribe(meter, gpu, GPU::Power, intervalMsecs);
+    }
+
+    return meters;
+}
+
+/**
+ * Prints the CSV line of a job
+ * @param out
+ * @param gpu
+ * @param job
+ */
+static void printEnergyJob(QTextStream &out, GPU *gpu, const GPUEnergyMeter::Job &job)
+{
+    out << "\"" << job.name << "\""
+        << "," << gpu->getIdentifier()
+        << "," << job.start.toString(Qt::ISODate)
+        << "," << job.end.toString(Qt::ISODate)
+        << "," << job.secs
+        << "," << job.energy
+        << "," << GPUEnergyMeter::getAveragePower(job)
+        << "," << job.peakPower
+        << "," << job.samples
+        << "," << job.longestGapSecs << endl;
+}
+
+/**
+ * Measures the energy of the GPUs between start and stop markers until interrupted
+ * SIGUSR1 starts a job, SIGUSR2 stops it and prints one CSV line per GPU
+ * @param gpus          GPUs to measure
+ * @param intervalMsecs Time between two power samples
+ * @return Exit code
+ */
+int Cli::energy(QList<GPU*> gpus, int intervalMsecs)
+{
+    GPUJobMarkers markers;
+    if(!markers.isListening()) {
+        QTextStream(stderr) << "Cannot listen to the job markers" << endl;
+        return 1;
+    }
+
+    GPUPoller poller;
+    QList<GPUEnergyMeter*> meters = createEnergyMeters(gpus, intervalMsecs, poller);
+    if(meters.isEmpty()) {
+        return 1;
+    }
+
+    QTextStream out(stdout);
+    out << ENERGY_CSV_HEADER << endl;
+
+    QTextStream(stderr) << "Send SIGUSR1 to " << QCoreApplication::applicationPid() << " to start a job, SIGUSR2 to stop it" << endl;
+
+    for(int jobNumber = 1; ; jobNumber++) {
+        QEventLoop startLoop;
+        QObject::connect(&markers, SIGNAL(startRequested()), &startLoop, SLOT(quit()));
+        startLoop.exec();
+
+        foreach(GPUEnergyMeter *meter, meters) {
+            meter->startJob(QString("job%1").arg(jobNumber));
+        }
+
+        QEventLoop stopLoop;
+        QObject::connect(&markers, SIGNAL(stopRequested()), &stopLoop, SLOT(quit()));
+        stopLoop.exec();
+
+        foreach(GPUEnergyMeter *meter, meters) {
+            printEnergyJob(out, meter->getGPU(), meter->stopJob());
+        }
+    }
+}
+
+/**
+ * Runs a command and prints the energy the GPUs used while it ran as CSV
+ * The standard channels of the command are forwarded
+ * @param gpus          GPUs to measure
+ * @param command       Shell command
+ * @param intervalMsecs Time between two power samples
+ * @return Exit code of the command
+ */
+int Cli::energyRun(QList<GPU*> gpus, QString command, int intervalMsecs)
+{
+    GPUPoller poller;
+    QList<GPUEnergyMeter*> meters = createEnergyMeters(gpus, intervalMsecs, poller);
+    if(meters.isEmpty()) {
+        return 1;
+    }
+
+    QProcess process;
+    process.setProcessChannelMode(QProcess::ForwardedChannels);
+
+    QEventLoop loop;
+    QObject::connect(&process, SIGNAL(finished(int)), &loop, SLOT(quit()));
+
+    foreach(GPUEnergyMeter *meter, meters) {
+        meter->startJob(command);
+    }
+
+    process.start("sh", QStringList() << "-c" << command);
+
+    if(process.waitForStarted()) {
+        loop.exec();
+    }
+
+    QTextStream out(stdout);
+    out << ENERGY_CSV_HEADER << endl;
+
+    foreach(GPUEnergyMeter *meter, meters) {
+        printEnergyJob(out, meter->getGPU(), meter->stopJob());
+    }
+
+    qDeleteAll(meters);
+
+    if(process.exitStatus() != QProcess::NormalExit || process.error() == QProcess::FailedToStart) {
+        QTextStream(stderr) << "Cannot run " << command << endl;
+        return 1;
+    }
+
+    return process.exitCode();
+}
@@ -0,0 +1,43 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef CLI_H
+#define CLI_H
+
+#include <QList>
+#include <QString>
+
+#include "gpu.h"
+
+/**
+ * Commands that run without the GUI, results are written on the standard output
+ */
+namespace Cli
+{
+    GPU::Metrics parseMetrics(QString list);
+    bool         parseGPUs(QString list, QList<GPU*> gpus, QList<GPU*> &selected);
+
+    int burst(GPU *gpu, GPU::Metrics metrics, int durationMsecs, QString outputFile);
+    int applyProfile(QList<GPU*> gpus, QString name);
+    int setPowerLimit(QList<GPU*> gpus, int watts);
+    int quantiles(QList<GPU*> gpus, GPU::Metrics metrics, int durationMsecs, QString outputFile);
+    int diagnostics(QList<GPU*> gpus, GPU::Metrics metrics, int durationMsecs, QString outputFile);
+    int energy(QList<GPU*> gpus, int intervalMsecs);
+    int energyRun(QList<GPU*> gpus, QString command, int intervalMsecs);
+}
+
+#endif // CLI_H
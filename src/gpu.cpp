@@ -1,12 +1,233 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
 #include "gpu.h"
 
-GPU::GPU()
+GPU::GPU() : QObject()
 {
-
+    this->updatedMetrics = 0;
 }
 
 GPU::~GPU()
 {
+    // no-op
+}
+
+int GPU::getRefreshPeriod()
+{
+    return 0;
+}
+
+bool GPU::waitForNewValues(int msecs)
+{
+    Q_UNUSED(msecs);
+
+    return true;
+}
+
+QString GPU::getExtraValue(QString key)
+{
+    Q_UNUSED(key);
+
+    return QString();
+}
+
+int GPU::getFanCount()
+{
+    return 1;
+}
+
+int GPU::getCurrentFanSpeedAt(int index)
+{
+    Q_UNUSED(index);
+
+    return this->getCurrentFanSpeed();
+}
+
+int GPU::getThermalSensorCount()
+{
+    return 0;
+}
+
+int GPU::getThermalSensorTempAt(int index)
+{
+    Q_UNUSED(index);
+
+    return 0;
+}
+
+void GPU::setFanSpeedAt(int index, int speed)
+{
+    Q_UNUSED(index);
+
+    this->setFanSpeed(speed);
+}
+
+int GPU::getCoreClockOffset()
+{
+    return 0;
+}
+
+int GPU::getCoreClockOffsetMin()
+{
+    return 0;
+}
+
+int GPU::getCoreClockOffsetMax()
+{
+    return 0;
+}
+
+int GPU::getMemoryClockOffset()
+{
+    return 0;
+}
+
+int GPU::getMemoryClockOffsetMin()
+{
+    return 0;
+}
+
+int GPU::getMemoryClockOffsetMax()
+{
+    return 0;
+}
 
+bool GPU::setCoreClockOffset(int offset)
+{
+    Q_UNUSED(offset);
+
+    return false;
 }
 
+bool GPU::setMemoryClockOffset(int offset)
+{
+    Q_UNUSED(offset);
+
+    return false;
+}
+
+int GPU::getPerfLevelCount()
+{
+    return 0;
+}
+
+int GPU::getCurrentPerfLevel()
+{
+    return -1;
+}
+
+bool GPU::isPowerMizerAvailable()
+{
+    return false;
+}
+
+GPU::PowerMizerMode GPU::getPowerMizerMode()
+{
+    return PowerMizerAuto;
+}
+
+bool GPU::setPowerMizerMode(PowerMizerMode mode)
+{
+    Q_UNUSED(mode);
+
+    return false;
+}
+
+int GPU::getPcieMaxLinkWidth()
+{
+    return 0;
+}
+
+int GPU::getPcieMaxLinkGen()
+{
+    return 0;
+}
+
+int GPU::getPcieLinkWidth()
+{
+    return 0;
+}
+
+int GPU::getPcieLinkGen()
+{
+    return 0;
+}
+
+bool GPU::isPowerDrawAvailable()
+{
+    return false;
+}
+
+double GPU::getCurrentPowerDraw()
+{
+    return 0;
+}
+
+double GPU::getPowerLimit()
+{
+    return 0;
+}
+
+bool GPU::isPowerLimitControlAvailable()
+{
+    return false;
+}
+
+double GPU::getPowerLimitMin()
+{
+    return 0;
+}
+
+double GPU::getPowerLimitDefault()
+{
+    return 0;
+}
+
+double GPU::getPowerLimitMax()
+{
+    return 0;
+}
+
+bool GPU::setPowerLimit(double watts)
+{
+    Q_UNUSED(watts);
+
+    return false;
+}
+
+/**
+ * Converts the transfer rate of a PCI-E link to its generation, each one doubles the rate from Gen3
+ * @param gigaTransfers Rate per lane in GT/s, ex: 8.0
+ * @return Generation, 0 if unknown
+ */
+int GPU::pcieGenFromSpeed(double gigaTransfers)
+{
+    if(gigaTransfers >= 32) {
+        return 5;
+    } else if(gigaTransfers >= 16) {
+        return 4;
+    } else if(gigaTransfers >= 8) {
+        return 3;
+    } else if(gigaTransfers >= 5) {
+        return 2;
+    } else if(gigaTransfers > 0) {
+        return 1;
+    }
+
+    return 0;
+}
@@ -29,15 +29,63 @@ class GPU : public QObject
     Q_OBJECT
 
 public:
+    /**
+     * Groups of variables that can be fetched independently
+     */
+    enum Metric {
+        CoreTemp        = 0x01,
+        FanSpeed        = 0x02,
+        Clocks          = 0x04, // core and memory
+        Utilization     = 0x08, // core and memory
+        FanControlState = 0x10,
+        PerfLevel       = 0x20, // current performance level and PowerMizer mode
+        ClockOffsets    = 0x40, // core and memory, only change when set
+        PcieLink        = 0x80, // current link width and generation, change with the power state
+        Power           = 0x100, // power draw and limit
+        AllMetrics      = 0x1FF
+    };
+    Q_DECLARE_FLAGS(Metrics, Metric)
+
+    /**
+     * PowerMizer modes, with the values used by the NVIDIA driver
+     */
+    enum PowerMizerMode {
+        PowerMizerAdaptive       = 0,
+        PowerMizerMaxPerformance = 1, // "Prefer Maximum Performance"
+        PowerMizerAuto           = 2,
+        PowerMizerConsistent     = 3  // "Prefer Consistent Performance"
+    };
+
+    GPU();
+    virtual ~GPU();
+
     /**
      * Fetches all data that does not change during operation
      */
     virtual void    fetchConstants() = 0;
     /**
-     * Fetches all data that can change during operation
-     * Should emit an "updated" event if a value has changed
+     * Fetches data that can change during operation
+     * Should store the fetched metrics in updatedMetrics and emit an "updated" event
+     * @param metrics Metrics to refresh, the others keep their last value
+     */
+    virtual void    fetchVariables(Metrics metrics = AllMetrics) = 0;
+
+    /**
+     * Metrics refreshed by the last fetch, to be read from the "updated" handlers
      */
-    virtual void    fetchVariables() = 0;
+    Metrics getUpdatedMetrics() const { return this->updatedMetrics; }
+
+    /**
+     * Period at which the backend refreshes the values it reports, fetching faster gives the same values again
+     * @return Milliseconds, 0 when every fetch reads the driver
+     */
+    virtual int     getRefreshPeriod();
+    /**
+     * Blocks until values newer than the ones of the last fetch are available
+     * @param msecs Timeout
+     * @return False if nothing came in time, always true when every fetch reads the driver
+     */
+    virtual bool    waitForNewValues(int msecs);
 
     virtual QString getIdentifier() = 0;    // ex: gpu:0
     virtual QString getName() = 0;          // ex: GeForce GT 530
@@ -46,6 +94,13 @@ public:
     virtual QString getBusId() = 0;         // ex: PCI:1:0:0
     virtual int     getTotalMemory() = 0;   // MB
 
+    /**
+     * Value of a backend-specific field, see GPUBackend::getExtraFields()
+     * @param key Key of the field
+     * @return Displayable value
+     */
+    virtual QString getExtraValue(QString key);
+
     virtual int     getCurrentCoreTemp() = 0;    // °C
     virtual int     getCurrentFanSpeed() = 0;    // %
     virtual int     getCurrentCoreClock() = 0;   // MHz
@@ -53,6 +108,11 @@ public:
     virtual int     getCurrentCoreUse() = 0;     // %
     virtual int     getCurrentMemoryUse() = 0;   // %
 
+    virtual int     getFanCount();               // 1 unless the backend knows the fans of the card
+    virtual int     getCurrentFanSpeedAt(int index); // %, of one of the fans
+    virtual int     getThermalSensorCount();     // 0 if only the core temperature is known
+    virtual int     getThermalSensorTempAt(int index); // °C
+
     virtual bool    isFanControlAvailable() = 0;
     virtual bool    isFanControlEnabled() = 0;
     virtual bool    isCoreClockControlAvailable() = 0;
@@ -60,6 +120,33 @@ public:
     virtual bool    isMemoryClockControlAvailable() = 0;
     virtual bool    isMemoryClockControlEnabled() = 0;
 
+    virtual int     getCoreClockOffset();        // MHz, 0 for stock clocks
+    virtual int     getCoreClockOffsetMin();     // MHz
+    virtual int     getCoreClockOffsetMax();     // MHz
+    virtual int     getMemoryClockOffset();      // MHz, 0 for stock clocks
+    virtual int     getMemoryClockOffsetMin();   // MHz
+    virtual int     getMemoryClockOffsetMax();   // MHz
+
+    virtual int     getPerfLevelCount();         // 0 if performance levels are not reported
+    virtual int     getCurrentPerfLevel();       // 0 is the lowest, -1 if unknown
+
+    virtual bool           isPowerMizerAvailable();
+    virtual PowerMizerMode getPowerMizerMode();
+
+    virtual int     getPcieMaxLinkWidth();       // ex: 16, 0 if unknown
+    virtual int     getPcieMaxLinkGen();         // ex: 3, 0 if unknown
+    virtual int     getPcieLinkWidth();          // lanes in use, 0 if unknown
+    virtual int     getPcieLinkGen();            // generation in use, 0 if unknown
+
+    virtual bool    isPowerDrawAvailable();
+    virtual double  getCurrentPowerDraw();       // W, 0 if unknown
+    virtual double  getPowerLimit();             // W, 0 if unknown
+
+    virtual bool    isPowerLimitControlAvailable();
+    virtual double  getPowerLimitMin();          // W
+    virtual double  getPowerLimitDefault();      // W
+    virtual double  getPowerLimitMax();          // W
+
     /**
      * Enables manual control ofthe fans
      * @param enabled True to enable
@@ -70,12 +157,50 @@ public:
      * @param speed Speed in %
      */
     virtual void    setFanSpeed(int speed) = 0;
+    /**
+     * Sets the speed of one of the fans, the others keep theirs
+     * @param index Index of the fan, below getFanCount()
+     * @param speed Speed in %
+     */
+    virtual void    setFanSpeedAt(int index, int speed);
+    /**
+     * Sets the core clock offset, the previous one is restored if the driver refuses it
+     * @param offset Offset in MHz, 0 for stock clocks
+     * @return True if the offset is applied
+     */
+    virtual bool    setCoreClockOffset(int offset);
+    /**
+     * Sets the memory clock offset, the previous one is restored if the driver refuses it
+     * @param offset Offset in MHz, 0 for stock clocks
+     * @return True if the offset is applied
+     */
+    virtual bool    setMemoryClockOffset(int offset);
+    /**
+     * Sets the PowerMizer mode, ex: to prevent the card from dropping to low-power levels
+     * @param mode New mode
+     * @return True if the mode is applied
+     */
+    virtual bool    setPowerMizerMode(PowerMizerMode mode);
+    /**
+     * Sets the power limit, the card lowers its clocks to stay under it
+     * Usually needs root
+     * @param watts Limit in W, between getPowerLimitMin() and getPowerLimitMax()
+     * @return True if the limit is applied
+     */
+    virtual bool    setPowerLimit(double watts);
 
 signals:
     /**
      * Signal that should be emitted whenever an attribute has changed
      */
     void updated();
+
+protected:
+    static int pcieGenFromSpeed(double gigaTransfers);
+
+    Metrics updatedMetrics;
 };
 
+Q_DECLARE_OPERATORS_FOR_FLAGS(GPU::Metrics)
+
 #endif // GPU_H
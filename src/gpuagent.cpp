@@ -0,0 +1,300 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "gpuagent.h"
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QTextStream>
+
+/**
+ * Samples are gathered during this time and sent in a single frame
+ */
+const int BATCH_INTERVAL_MSECS = 1000;
+/**
+ * Largest number of samples in a frame, a backfill is sent in several frames
+ */
+const int MAX_BATCH_SAMPLES = 2048;
+/**
+ * Nothing more is sent while this many samples wait for an acknowledgement
+ */
+const int MAX_UNACKED_SAMPLES = 8192;
+/**
+ * Nothing more is sent while this many bytes are not written to the network
+ */
+const qint64 MAX_PENDING_BYTES = 256 * 1024;
+/**
+ * Samples kept while the collector is away, the oldest are dropped first
+ * An hour of 8 GPUs polled every second
+ */
+const int MAX_BACKLOG_SAMPLES = 8 * 3600;
+/**
+ * Delay before reconnecting, doubled after each failure up to the maximum
+ */
+const int RECONNECT_MIN_MSECS = 1000;
+const int RECONNECT_MAX_MSECS = 30000;
+
+/**
+ * @param gpus          GPUs to stream
+ * @param name          Name of the host given to the collector
+ * @param metrics       Metrics to poll
+ * @param intervalMsecs Time between two samples of a GPU
+ * @param parent
+ */
+GPUAgent::GPUAgent(QList<GPU*> gpus, QString name, GPU::Metrics metrics, int intervalMsecs, QObject *parent) :
+    QObject(parent)
+{
+    this->gpus = gpus;
+    this->name = name;
+    this->session = (static_cast<quint64>(QDateTime::currentMSecsSinceEpoch()) << 16) ^ static_cast<quint64>(QCoreApplication::applicationPid());
+
+    this->nextSeq = 1;
+    this->sentSeq = 0;
+    this->welcomed = false;
+    this->droppedSamples = 0;
+    this->port = 0;
+    this->reconnectDelayMsecs = RECONNECT_MIN_MSECS;
+
+    for(int i=0; i < this->gpus.size(); i++) {
+        GPU *gpu = this->gpus.at(i);
+
+        this->indexes.insert(gpu, i);
+
+        connect(gpu, SIGNAL(updated()), this, SLOT(gpuUpdated()));
+        this->poller.subscribe(this, gpu, metrics, intervalMsecs);
+    }
+
+    connect(&this->socket, SIGNAL(connected()), this, SLOT(connected()));
+    connect(&this->socket, SIGNAL(disconnected()), this, SLOT(disconnected()));
+    connect(&this->socket, SIGNAL(error(QAbstractSocket::SocketError)), this, SLOT(disconnected()));
+    connect(&this->socket, SIGNAL(readyRead()), this, SLOT(readFrames()));
+    // Continues a backfill once the previous frames are written
+    connect(&this->socket, SIGNAL(bytesWritten(qint64)), this, SLOT(flush()));
+
+    connect(&this->batchTimer, SIGNAL(timeout()), this, SLOT(flush()));
+    this->batchTimer.start(BATCH_INTERVAL_MSECS);
+
+    this->reconnectTimer.setSingleShot(true);
+    connect(&this->reconnectTimer, SIGNAL(timeout()), this, SLOT(reconnect()));
+}
+
+GPUAgent::~GPUAgent()
+{
+    // no-op
+}
+
+/**
+ * Connects to the collector, and reconnects whenever the connection is lost
+ * @param host
+ * @param port
+ */
+void GPUAgent::connectTo(QString host, quint16 port)
+{
+    this->host = host;
+    this->port = port;
+
+    this->reconnect();
+}
+
+/**
+ * Samples dropped because the backlog was full
+ * @return Count
+ */
+qint64 GPUAgent::getDroppedSamples() const
+{
+    return this->droppedSamples;
+}
+
+/**
+ * Stores the values of the GPU that just got fetched
+ */
+void GPUAgent::gpuUpdated()
+{
+    GPU *gpu = qobject_cast<GPU*>(sender());
+    if(!gpu || !gpu->getUpdatedMetrics()) {
+        return;
+    }
+
+    GPUNetwork::Sample sample = GPUNetwork::sample(gpu, this->indexes.value(gpu), gpu->getUpdatedMetrics(), QDateTime::currentMSecsSinceEpoch());
+    sample.seq = this->nextSeq++;
+
+    this->backlog.append(sample);
+
+    if(this->backlog.size() > MAX_BACKLOG_SAMPLES) {
+        this->backlog.removeFirst();
+        this->droppedSamples++;
+    }
+}
+
+/**
+ * Sends the samples that were not sent yet, as long as the collector keeps up
+ */
+void GPUAgent::flush()
+{
+    if(!this->welcomed || this->backlog.isEmpty()) {
+        return;
+    }
+
+    quint64 firstSeq = this->backlog.first().seq;
+
+    while(this->sentSeq < this->backlog.last().seq) {
+        if(this->socket.bytesToWrite() > MAX_PENDING_BYTES) {
+            return;
+        }
+
+        // Samples not acknowledged yet are the whole backlog before the first unsent one
+        int start = static_cast<int>(qMax(this->sentSeq + 1, firstSeq) - firstSeq);
+        if(start >= MAX_UNACKED_SAMPLES) {
+            return;
+        }
+
+        int count = qMin(this->backlog.size() - start, MAX_BATCH_SAMPLES);
+
+        this->send(GPUNetwork::Samples, GPUNetwork::encodeSamples(QString(), this->backlog.mid(start, count)));
+        this->sentSeq = this->backlog.at(start + count - 1).seq;
+    }
+}
+
+void GPUAgent::send(GPUNetwork::FrameType type, const QByteArray &payload)
+{
+    this->socket.write(GPUNetwork::encodeFrame(type, payload));
+}
+
+/**
+ * Introduces the agent and its GPUs, the collector answers with the samples it already has
+ */
+void GPUAgent::connected()
+{
+    QTextStream(stderr) << "Connected to " << this->host << ":" << this->port << endl;
+
+    this->reconnectDelayMsecs = RECONNECT_MIN_MSECS;
+    this->buffer.clear();
+
+    QByteArray payload;
+    QDataStream stream(&payload, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    stream << static_cast<quint8>(GPUNetwork::AgentRole)
+           << GPUNetwork::protocolVersion()
+           << this->name
+           << this->session
+           << static_cast<quint32>(this->gpus.size());
+
+    foreach(GPU *gpu, this->gpus) {
+        stream << GPUNetwork::describe(gpu);
+    }
+
+    this->send(GPUNetwork::Hello, payload);
+}
+
+/**
+ * Schedules the next connection attempt, the samples keep accumulating meanwhile
+ */
+void GPUAgent::disconnected()
+{
+    if(this->reconnectTimer.isActive()) {
+        return;
+    }
+
+    if(this->welcomed) {
+        QTextStream(stderr) << "Disconnected from " << this->host << ":" << this->port << ", " << this->backlog.size() << " samples waiting" << endl;
+    }
+
+    this->welcomed = false;
+
+    // Started first, aborting emits disconnected() again
+    this->reconnectTimer.start(this->reconnectDelayMsecs);
+    this->reconnectDelayMsecs = qMin(this->reconnectDelayMsecs * 2, RECONNECT_MAX_MSECS);
+
+    this->socket.abort();
+}
+
+void GPUAgent::reconnect()
+{
+    this->socket.abort();
+    this->socket.connectToHost(this->host, this->port);
+}
+
+void GPUAgent::readFrames()
+{
+    this->buffer.append(this->socket.readAll());
+
+    GPUNetwork::Frame frame;
+    GPUNetwork::ReadResult result;
+
+    while((result = GPUNetwork::takeFrame(this->buffer, frame)) == GPUNetwork::FrameRead) {
+        switch(frame.type) {
+        case GPUNetwork::Welcome:
+            this->readWelcome(frame.payload);
+            break;
+        case GPUNetwork::Ack:
+            this->readAck(frame.payload);
+            break;
+        default:
+            break;
+        }
+    }
+
+    if(result == GPUNetwork::FrameInvalid) {
+        this->disconnected();
+    }
+}
+
+/**
+ * Starts sending after the last sample the collector received, which backfills what it missed
+ * @param payload
+ */
+void GPUAgent::readWelcome(const QByteArray &payload)
+{
+    QDataStream stream(payload);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    quint64 lastSeq;
+    stream >> lastSeq;
+
+    this->acknowledge(lastSeq);
+
+    this->sentSeq = lastSeq;
+    this->welcomed = true;
+
+    this->flush();
+}
+
+void GPUAgent::readAck(const QByteArray &payload)
+{
+    QDataStream stream(payload);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    quint64 seq;
+    stream >> seq;
+
+    this->acknowledge(seq);
+
+    // The window may have room again
+    this->flush();
+}
+
+/**
+ * Forgets the samples the collector has
+ * @param seq Last sequence number received
+ */
+void GPUAgent::acknowledge(quint64 seq)
+{
+    while(!this->backlog.isEmpty() && this->backlog.first().seq <= seq) {
+        this->backlog.removeFirst();
+    }
+}
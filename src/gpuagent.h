@@ -0,0 +1,86 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GPUAGENT_H
+#define GPUAGENT_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QTcpSocket>
+#include <QTimer>
+
+#include "gpu.h"
+#include "gpunetwork.h"
+#include "gpupoller.h"
+
+/**
+ * Headless side of the fleet monitoring: polls the local GPUs and streams their samples to a collector
+ * Samples are kept until the collector acknowledges them, so they are sent again after a reconnection.
+ * Sending stops while too many samples are unacknowledged or the socket is not drained,
+ * the oldest samples are dropped if the collector stays away too long.
+ */
+class GPUAgent : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit GPUAgent(QList<GPU*> gpus, QString name, GPU::Metrics metrics, int intervalMsecs, QObject *parent = 0);
+    ~GPUAgent();
+
+    void connectTo(QString host, quint16 port);
+
+    qint64 getDroppedSamples() const;
+
+private:
+    void send(GPUNetwork::FrameType type, const QByteArray &payload);
+    void readWelcome(const QByteArray &payload);
+    void readAck(const QByteArray &payload);
+    void acknowledge(quint64 seq);
+
+    QList<GPU*>        gpus;
+    QHash<GPU*, int>   indexes;
+    QString            name;
+    quint64            session; // random, tells the collector the sequence numbers started over
+
+    GPUPoller  poller;
+    QTcpSocket socket;
+    QByteArray buffer;   // bytes received, until a whole frame is there
+    QString    host;
+    quint16    port;
+
+    QList<GPUNetwork::Sample> backlog; // unacknowledged samples, consecutive sequence numbers
+    quint64                   nextSeq;
+    quint64                   sentSeq;  // last sequence number written on the current connection
+    bool                      welcomed; // hello answered on the current connection
+    qint64                    droppedSamples;
+
+    QTimer batchTimer;
+    QTimer reconnectTimer;
+    int    reconnectDelayMsecs;
+
+private slots:
+    void gpuUpdated();
+    void flush();
+    void connected();
+    void disconnected();
+    void readFrames();
+    void reconnect();
+};
+
+#endif // GPUAGENT_H
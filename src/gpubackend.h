@@ -0,0 +1,93 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GPUBACKEND_H
+#define GPUBACKEND_H
+
+#include <QtPlugin>
+#include <QList>
+#include <QMap>
+#include <QString>
+
+#include "gpu.h"
+
+/**
+ * Interface of the backend plugins, each one gives access to the GPUs of a driver
+ * The plugin metadata can hold a "probe" object listing "paths" and "env" variables:
+ * the plugin is only loaded if one of them exists, so unused vendors cost nothing at startup
+ */
+class GPUBackend
+{
+public:
+    /**
+     * Backend-specific value displayed in the information window
+     * Values are read with GPU::getExtraValue(key)
+     */
+    struct ExtraField {
+        QString key;
+        QString label;
+    };
+
+    virtual ~GPUBackend() {}
+
+    virtual QString getName() = 0;
+
+    /**
+     * Checks that the driver is usable, should be cheap
+     * Called outside of the GUI thread
+     * @return True if getGPUs() can be called
+     */
+    virtual bool probe() = 0;
+    /**
+     * Creates the GPUs of the driver
+     * Called outside of the GUI thread
+     * @return List of GPUs
+     */
+    virtual QList<GPU*> getGPUs() = 0;
+    /**
+     * Lists the GPUs currently present without creating them, should be cheap
+     * Called periodically from the GUI thread to notice the added and removed GPUs
+     * @return Identifier of each GPU (as GPU::getIdentifier()) by bus id (as GPU::getBusId())
+     */
+    virtual QMap<QString, QString> enumerate() = 0;
+    /**
+     * Creates a GPU listed by the last call to enumerate()
+     * @param busId
+     * @return GPU, 0 if it is unknown
+     */
+    virtual GPU *createGPU(QString busId) = 0;
+
+    virtual QList<ExtraField> getExtraFields() = 0;
+
+    /**
+     * Starts grouping the writes of all the GPUs of the backend
+     * Setters may then only queue the values and report success, the caller
+     * verifies them after commitBatch()
+     */
+    virtual void beginBatch() {}
+    /**
+     * Sends the grouped writes, with a single driver invocation if possible
+     * @return False if the driver reported an error
+     */
+    virtual bool commitBatch() { return true; }
+};
+
+#define GPUBackend_iid "com.clarkwinkelmann.GPUTweak.GPUBackend/1.3"
+
+Q_DECLARE_INTERFACE(GPUBackend, GPUBackend_iid)
+
+#endif // GPUBACKEND_H
@@ -0,0 +1,347 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "gpubackends.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFileInfo>
+#include <QFuture>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QPluginLoader>
+#include <QThread>
+#include <QtConcurrentRun>
+
+/**
+ * Directory of the plugins relative to the executable, can be replaced trough this environment variable
+ */
+const char *BACKENDS_PATH_ENV = "GPUTWEAK_BACKENDS_PATH";
+const QString BACKENDS_DIR = "backends";
+
+/**
+ * Backend that created each GPU
+ */
+static QHash<GPU*, GPUBackend*> gpuBackends;
+/**
+ * Backends that loaded and probed successfully at startup, the ones enumerated again to notice
+ * hot-plug, even the ones without GPUs yet
+ */
+static QList<GPUBackend*> usedBackends;
+
+/**
+ * Backend plugin found on disk whose metadata probe passed
+ */
+struct Candidate {
+    QString     name;
+    QString     fallbackFor; // only used if this other backend found nothing
+    GPUBackend *backend;
+};
+
+/**
+ * Outcome of probing a backend
+ */
+struct ProbeResult {
+    bool        probed; // the driver or tool of the backend is there
+    QList<GPU*> gpus;
+};
+
+/**
+ * Checks the probe described in the metadata of a plugin, without loading it
+ * @param probe "probe" object of the metadata
+ * @return True if one of the paths or environment variables exists, or if there is nothing to check
+ */
+static bool metadataProbe(QJsonObject probe)
+{
+    QJsonArray paths = probe.value("paths").toArray();
+    QJsonArray env   = probe.value("env").toArray();
+
+    if(paths.isEmpty() && env.isEmpty()) {
+        return true;
+    }
+
+    foreach(QJsonValue path, paths) {
+        if(QFileInfo(path.toString()).exists()) {
+            return true;
+        }
+    }
+
+    foreach(QJsonValue variable, env) {
+        if(!qgetenv(variable.toString().toLocal8Bit().constData()).isEmpty()) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Probes a backend and creates its GPUs, runs in a worker thread
+ * @param backend
+ * @return Probe outcome, the GPUs are moved to the GUI thread
+ */
+static ProbeResult probeBackend(GPUBackend *backend)
+{
+    ProbeResult result;
+    result.probed = backend->probe();
+
+    if(!result.probed) {
+        return result;
+    }
+
+    result.gpus = backend->getGPUs();
+
+    foreach(GPU *gpu, result.gpus) {
+        gpu->moveToThread(QCoreApplication::instance()->thread());
+    }
+
+    return result;
+}
+
+/**
+ * Probes the given backends in parallel
+ * @param candidates
+ * @return GPUs of each backend, by name
+ */
+static QHash<QString, QList<GPU*> > probeBackends(QList<Candidate> candidates)
+{
+    QList<QFuture<ProbeResult> > futures;
+
+    foreach(const Candidate &candidate, candidates) {
+        futures.append(QtConcurrent::run(probeBackend, candidate.backend));
+    }
+
+    QHash<QString, QList<GPU*> > results;
+
+    for(int i=0; i < candidates.size(); i++) {
+        ProbeResult result = futures[i].result();
+
+        // A card plugged later is still noticed by a backend without GPUs yet
+        if(result.probed) {
+            usedBackends.append(candidates.at(i).backend);
+        }
+
+        foreach(GPU *gpu, result.gpus) {
+            gpuBackends.insert(gpu, candidates.at(i).backend);
+        }
+
+        results.insert(candidates.at(i).name, result.gpus);
+    }
+
+    return results;
+}
+
+/**
+ * Gives the directory containing the backend plugins
+ * @return Path
+ */
+QString GPUBackends::pluginsPath()
+{
+    QString path = QString::fromLocal8Bit(qgetenv(BACKENDS_PATH_ENV));
+
+    return path.isEmpty() ? QDir(QCoreApplication::applicationDirPath()).filePath(BACKENDS_DIR) : path;
+}
+
+/**
+ * Loads the backends available on this machine and gets their GPUs
+ * @param only Name of the single backend to use, all if empty
+ * @return List of GPUs
+ */
+QList<GPU*> GPUBackends::discover(QString only)
+{
+    QList<Candidate> candidates;
+    QList<Candidate> fallbacks;
+
+    QDir dir(GPUBackends::pluginsPath());
+
+    foreach(QString fileName, dir.entryList(QDir::Files, QDir::Name)) {
+        QPluginLoader loader(dir.filePath(fileName));
+
+        QJsonObject metadata = loader.metaData();
+        if(metadata.value("IID").toString() != GPUBackend_iid) {
+            continue;
+        }
+
+        QJsonObject pluginData = metadata.value("MetaData").toObject();
+
+        Candidate candidate;
+        candidate.name        = pluginData.value("name").toString();
+        candidate.fallbackFor = only.isEmpty() ? pluginData.value("fallbackFor").toString() : QString();
+
+        if(!only.isEmpty() && candidate.name != only) {
+            continue;
+        }
+
+        if(!metadataProbe(pluginData.value("probe").toObject())) {
+            continue;
+        }
+
+        candidate.backend = qobject_cast<GPUBackend*>(loader.instance());
+        if(!candidate.backend) {
+            continue;
+        }
+
+        if(candidate.fallbackFor.isEmpty()) {
+            candidates.append(candidate);
+        } else {
+            fallbacks.append(candidate);
+        }
+    }
+
+    QHash<QString, QList<GPU*> > results = probeBackends(candidates);
+
+    QList<Candidate> neededFallbacks;
+    foreach(const Candidate &fallback, fallbacks) {
+        if(results.value(fallback.fallbackFor).isEmpty()) {
+            neededFallbacks.append(fallback);
+        }
+    }
+
+    QHash<QString, QList<GPU*> > fallbackResults = probeBackends(neededFallbacks);
+
+    // The cards of a fallback in use would be found a second time by the backend it replaces
+    foreach(const Candidate &fallback, neededFallbacks) {
+        if(fallbackResults.value(fallback.name).isEmpty()) {
+            continue;
+        }
+
+        foreach(const Candidate &candidate, candidates) {
+            if(candidate.name == fallback.fallbackFor) {
+                usedBackends.removeAll(candidate.backend);
+            }
+        }
+    }
+
+    results.unite(fallbackResults);
+
+    // Keep a stable order between runs
+    QStringList names = results.keys();
+    names.sort();
+
+    QList<GPU*> gpus;
+    foreach(QString name, names) {
+        gpus.append(results.value(name));
+    }
+
+    return gpus;
+}
+
+/**
+ * Backends that probed successfully at startup, see usedBackends
+ * @return List of backends
+ */
+QList<GPUBackend*> GPUBackends::getBackends()
+{
+    return usedBackends;
+}
+
+/**
+ * Creates a GPU found by GPUBackend::enumerate()
+ * @param backend
+ * @param busId
+ * @return GPU, 0 if the backend does not know it anymore
+ */
+GPU *GPUBackends::createGPU(GPUBackend *backend, QString busId)
+{
+    GPU *gpu = backend->createGPU(busId);
+
+    if(gpu) {
+        gpuBackends.insert(gpu, backend);
+    }
+
+    return gpu;
+}
+
+/**
+ * Forgets a GPU that is about to be deleted
+ * @param gpu
+ */
+void GPUBackends::forget(GPU *gpu)
+{
+    gpuBackends.remove(gpu);
+}
+
+/**
+ * Gives the backend that created a GPU
+ * @param gpu
+ * @return Backend, null for GPUs that do not come from a plugin
+ */
+GPUBackend *GPUBackends::getBackend(GPU *gpu)
+{
+    return gpuBackends.value(gpu, 0);
+}
+
+/**
+ * Gives the backend-specific fields of a GPU
+ * @param gpu
+ * @return List of fields, empty for GPUs that do not come from a plugin
+ */
+QList<GPUBackend::ExtraField> GPUBackends::getExtraFields(GPU *gpu)
+{
+    GPUBackend *backend = GPUBackends::getBackend(gpu);
+
+    return backend ? backend->getExtraFields() : QList<GPUBackend::ExtraField>();
+}
+
+/**
+ * Backends of the given GPUs, each one once
+ * @param gpus
+ * @return List of backends
+ */
+static QList<GPUBackend*> backendsOf(QList<GPU*> gpus)
+{
+    QList<GPUBackend*> backends;
+
+    foreach(GPU *gpu, gpus) {
+        GPUBackend *backend = GPUBackends::getBackend(gpu);
+
+        if(backend && !backends.contains(backend)) {
+            backends.append(backend);
+        }
+    }
+
+    return backends;
+}
+
+/**
+ * Starts grouping the writes to the given GPUs, see GPUBackend::beginBatch()
+ * GPUs without backend (ex: simulated) apply their values immediately
+ * @param gpus
+ */
+void GPUBackends::beginBatch(QList<GPU*> gpus)
+{
+    foreach(GPUBackend *backend, backendsOf(gpus)) {
+        backend->beginBatch();
+    }
+}
+
+/**
+ * Sends the grouped writes, one invocation per backend
+ * @param gpus Same list as for beginBatch()
+ * @return False if a backend reported an error
+ */
+bool GPUBackends::commitBatch(QList<GPU*> gpus)
+{
+    bool ok = true;
+
+    foreach(GPUBackend *backend, backendsOf(gpus)) {
+        ok = backend->commitBatch() && ok;
+    }
+
+    return ok;
+}
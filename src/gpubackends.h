@@ -0,0 +1,47 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GPUBACKENDS_H
+#define GPUBACKENDS_H
+
+#include <QList>
+#include <QString>
+
+#include "gpu.h"
+#include "gpubackend.h"
+
+/**
+ * This namespace holds global functions used to find, load and query the backend plugins
+ */
+namespace GPUBackends
+{
+    QString pluginsPath();
+
+    QList<GPU*> discover(QString only = QString());
+
+    QList<GPUBackend*> getBackends();
+    GPU *createGPU(GPUBackend *backend, QString busId);
+    void forget(GPU *gpu);
+
+    GPUBackend *getBackend(GPU *gpu);
+    QList<GPUBackend::ExtraField> getExtraFields(GPU *gpu);
+
+    void beginBatch(QList<GPU*> gpus);
+    bool commitBatch(QList<GPU*> gpus);
+}
+
+#endif // GPUBACKENDS_H
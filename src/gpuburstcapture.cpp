@@ -0,0 +1,348 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "gpuburstcapture.h"
+
+#include <QTextStream>
+
+#include <math.h>
+
+/**
+ * Highest sample rate the buffer is sized for, the capture stops early if it is full
+ */
+const int MAX_SAMPLES_PER_SEC = 2000;
+/**
+ * Constant for the number of msecs in a sec
+ */
+const int MSEC_IN_A_SEC = 1000;
+/**
+ * Constant for the number of nsecs in a msec
+ */
+const double NSEC_IN_A_MSEC = 1000000.0;
+
+GPUBurstCapture::GPUBurstCapture(GPU *gpu, GPU::Metrics metrics, int durationMsecs, QObject *parent) :
+    QObject(parent)
+{
+    this->gpu           = gpu;
+    this->metrics       = metrics;
+    this->durationMsecs = durationMsecs;
+    this->running       = false;
+    this->blocking      = false;
+
+    // Zero-interval timer: one sample per event loop iteration so the GUI stays usable
+    this->timer.setInterval(0);
+    connect(&this->timer, SIGNAL(timeout()), this, SLOT(tick()));
+}
+
+GPUBurstCapture::~GPUBurstCapture()
+{
+    // no-op
+}
+
+/**
+ * Starts the capture in the event loop, "finished" is emitted at the end
+ */
+void GPUBurstCapture::start()
+{
+    this->samples.clear();
+    this->samples.reserve(static_cast<int>(static_cast<qint64>(this->durationMsecs) * MAX_SAMPLES_PER_SEC / MSEC_IN_A_SEC) + 1);
+
+    this->running  = true;
+    this->blocking = false;
+    this->clock.start();
+    this->timer.start();
+}
+
+/**
+ * Runs the whole capture before returning, for use without an event loop
+ */
+void GPUBurstCapture::run()
+{
+    this->start();
+    this->timer.stop();
+    this->blocking = true;
+
+    while(this->sample()) {
+        // sample until done
+    }
+
+    this->running = false;
+
+    emit finished();
+}
+
+bool GPUBurstCapture::isRunning()
+{
+    return this->running;
+}
+
+/**
+ * Takes a single sample
+ * A backend refreshing its values periodically would give the same sample again until its next refresh,
+ * so a sample is only taken once new values are available
+ * @return False once the capture is over
+ */
+bool GPUBurstCapture::sample()
+{
+    if(this->clock.elapsed() >= this->durationMsecs || this->samples.size() >= this->samples.capacity()) {
+        return false;
+    }
+
+    if(this->gpu->getRefreshPeriod() > 0) {
+        // Without an event loop, wait up to the end of the capture; in it, try again on the next iteration
+        int wait = this->blocking ? static_cast<int>(this->durationMsecs - this->clock.elapsed()) : 0;
+
+        if(!this->gpu->waitForNewValues(qMax(0, wait))) {
+            return !this->blocking;
+        }
+    }
+
+    // The histories, sketches, detectors and meters only record the samples of the poller,
+    // a capture would weigh its window much more than the rest of the time
+    this->gpu->blockSignals(true);
+    this->gpu->fetchVariables(this->metrics);
+    this->gpu->blockSignals(false);
+
+    Sample sample;
+    sample.nsecs = this->clock.nsecsElapsed();
+    sample.values[GPUHistory::CoreTemp]    = this->gpu->getCurrentCoreTemp();
+    sample.values[GPUHistory::CoreUse]     = this->gpu->getCurrentCoreUse();
+    sample.values[GPUHistory::MemoryUse]   = this->gpu->getCurrentMemoryUse();
+    sample.values[GPUHistory::FanSpeed]    = this->gpu->getCurrentFanSpeed();
+    sample.values[GPUHistory::CoreClock]   = this->gpu->getCurrentCoreClock();
+    sample.values[GPUHistory::MemoryClock] = this->gpu->getCurrentMemoryClock();
+    sample.values[GPUHistory::PcieLinkWidth] = this->gpu->getPcieLinkWidth();
+    sample.values[GPUHistory::PcieLinkGen]   = this->gpu->getPcieLinkGen();
+    sample.values[GPUHistory::PowerDraw]     = qRound(this->gpu->getCurrentPowerDraw());
+
+    this->samples.append(sample);
+
+    return true;
+}
+
+/**
+ * Takes a sample from the event loop
+ */
+void GPUBurstCapture::tick()
+{
+    if(!this->sample()) {
+        this->timer.stop();
+        this->running = false;
+
+        emit finished();
+    }
+}
+
+GPU *GPUBurstCapture::getGPU()
+{
+    return this->gpu;
+}
+
+GPU::Metrics GPUBurstCapture::getMetrics()
+{
+    return this->metrics;
+}
+
+/**
+ * Tells if a series is part of the captured metrics
+ * @param series
+ * @return True if captured
+ */
+bool GPUBurstCapture::isSeriesCaptured(GPUHistory::Series series)
+{
+    return this->metrics & GPUHistory::getSeriesMetric(series);
+}
+
+const QVector<GPUBurstCapture::Sample> &GPUBurstCapture::getSamples() const
+{
+    return this->samples;
+}
+
+/**
+ * Number of samples per second actually achieved
+ * @return Rate in Hz
+ */
+double GPUBurstCapture::getAchievedRate()
+{
+    double interval = this->getMeanInterval();
+
+    return interval > 0 ? MSEC_IN_A_SEC / interval : 0;
+}
+
+/**
+ * Mean time between two samples
+ * @return Interval in ms
+ */
+double GPUBurstCapture::getMeanInterval()
+{
+    if(this->samples.size() < 2) {
+        return 0;
+    }
+
+    return (this->samples.last().nsecs - this->samples.first().nsecs) / NSEC_IN_A_MSEC / (this->samples.size() - 1);
+}
+
+/**
+ * Standard deviation of the time between two samples
+ * @return Jitter in ms
+ */
+double GPUBurstCapture::getJitter()
+{
+    if(this->samples.size() < 2) {
+        return 0;
+    }
+
+    double mean = this->getMeanInterval();
+    double sum = 0;
+
+    for(int i=1; i < this->samples.size(); i++) {
+        double deviation = (this->samples.at(i).nsecs - this->samples.at(i-1).nsecs) / NSEC_IN_A_MSEC - mean;
+        sum += deviation * deviation;
+    }
+
+    return sqrt(sum / (this->samples.size() - 1));
+}
+
+/**
+ * Longest time between two samples
+ * @return Interval in ms
+ */
+double GPUBurstCapture::getMaxInterval()
+{
+    qint64 max = 0;
+
+    for(int i=1; i < this->samples.size(); i++) {
+        max = qMax(max, this->samples.at(i).nsecs - this->samples.at(i-1).nsecs);
+    }
+
+    return max / NSEC_IN_A_MSEC;
+}
+
+/**
+ * Computes the summary of a series
+ * @param series
+ * @return Statistics, all zero if there is no sample
+ */
+GPUBurstCapture::Statistics GPUBurstCapture::getStatistics(GPUHistory::Series series)
+{
+    Statistics statistics;
+    statistics.min    = 0;
+    statistics.max    = 0;
+    statistics.mean   = 0;
+    statistics.stddev = 0;
+
+    if(this->samples.isEmpty()) {
+        return statistics;
+    }
+
+    statistics.min = this->samples.first().values[series];
+    statistics.max = statistics.min;
+
+    double sum = 0;
+    foreach(const Sample &sample, this->samples) {
+        int value = sample.values[series];
+        statistics.min = qMin(statistics.min, value);
+        statistics.max = qMax(statistics.max, value);
+        sum += value;
+    }
+    statistics.mean = sum / this->samples.size();
+
+    double deviations = 0;
+    foreach(const Sample &sample, this->samples) {
+        double deviation = sample.values[series] - statistics.mean;
+        deviations += deviation * deviation;
+    }
+    statistics.stddev = sqrt(deviations / this->samples.size());
+
+    return statistics;
+}
+
+/**
+ * Human readable summary of the capture
+ * @return Multiline text
+ */
+QString GPUBurstCapture::getSummary()
+{
+    QString summary;
+    QTextStream out(&summary);
+
+    out << QString("%1 samples of %2 in %3 s")
+           .arg(this->samples.size())
+           .arg(this->gpu->getIdentifier())
+           .arg(this->samples.isEmpty() ? 0 : this->samples.last().nsecs / NSEC_IN_A_MSEC / MSEC_IN_A_SEC, 0, 'f', 2) << "\n";
+    out << QString("Rate: %1 Hz (mean interval %2 ms)")
+           .arg(this->getAchievedRate(), 0, 'f', 1)
+           .arg(this->getMeanInterval(), 0, 'f', 2) << "\n";
+    out << QString("Jitter: %1 ms (max interval %2 ms)")
+           .arg(this->getJitter(), 0, 'f', 2)
+           .arg(this->getMaxInterval(), 0, 'f', 2) << "\n";
+
+    if(this->gpu->getRefreshPeriod() > 0) {
+        out << QString("Rate limited by the backend, which refreshes its values every %1 ms")
+               .arg(this->gpu->getRefreshPeriod()) << "\n";
+    }
+
+    for(int i=0; i < GPUHistory::SeriesCount; i++) {
+        GPUHistory::Series series = static_cast<GPUHistory::Series>(i);
+
+        if(!this->isSeriesCaptured(series)) {
+            continue;
+        }
+
+        Statistics statistics = this->getStatistics(series);
+
+        out << QString("%1: min %2, max %3, mean %4, stddev %5")
+               .arg(GPUBurstCapture::getSeriesName(series))
+               .arg(statistics.min)
+               .arg(statistics.max)
+               .arg(statistics.mean, 0, 'f', 1)
+               .arg(statistics.stddev, 0, 'f', 1) << "\n";
+    }
+
+    return summary;
+}
+
+/**
+ * Display name of a series
+ * @param series
+ * @return Name with unit
+ */
+QString GPUBurstCapture::getSeriesName(GPUHistory::Series series)
+{
+    switch(series) {
+    case GPUHistory::CoreTemp:
+        return "GPU Temp, °C";
+    case GPUHistory::CoreUse:
+        return "GPU Usage, %";
+    case GPUHistory::MemoryUse:
+        return "Memory Usage, %";
+    case GPUHistory::FanSpeed:
+        return "Fan Speed, %";
+    case GPUHistory::CoreClock:
+        return "Core Clock, MHz";
+    case GPUHistory::MemoryClock:
+        return "Memory Clock, MHz";
+    case GPUHistory::PcieLinkWidth:
+        return "PCI-E Link Width, lanes";
+    case GPUHistory::PcieLinkGen:
+        return "PCI-E Link Generation";
+    case GPUHistory::PowerDraw:
+        return "Power Draw, W";
+    default:
+        return QString();
+    }
+}
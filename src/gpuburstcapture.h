@@ -0,0 +1,102 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GPUBURSTCAPTURE_H
+#define GPUBURSTCAPTURE_H
+
+#include <QObject>
+#include <QVector>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QString>
+
+#include "gpu.h"
+#include "gpuhistory.h"
+
+/**
+ * Samples some metrics of a GPU as fast as the backend allows for a given duration
+ * Samples are stored in a buffer allocated before the capture starts
+ */
+class GPUBurstCapture : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * Values of all the series at a given time, only the captured ones are meaningful
+     */
+    struct Sample {
+        qint64 nsecs; // since the start of the capture
+        int    values[GPUHistory::SeriesCount];
+    };
+
+    /**
+     * Summary of the captured values of a series
+     */
+    struct Statistics {
+        int    min;
+        int    max;
+        double mean;
+        double stddev;
+    };
+
+    GPUBurstCapture(GPU *gpu, GPU::Metrics metrics, int durationMsecs, QObject *parent = 0);
+    ~GPUBurstCapture();
+
+    void start();
+    void run();
+
+    bool isRunning();
+
+    GPU          *getGPU();
+    GPU::Metrics  getMetrics();
+    bool          isSeriesCaptured(GPUHistory::Series series);
+
+    const QVector<Sample> &getSamples() const;
+
+    double     getAchievedRate();   // Hz
+    double     getMeanInterval();   // ms
+    double     getJitter();         // ms, standard deviation of the intervals
+    double     getMaxInterval();    // ms
+    Statistics getStatistics(GPUHistory::Series series);
+
+    QString    getSummary();
+
+    static QString getSeriesName(GPUHistory::Series series);
+
+signals:
+    void finished();
+
+private:
+    bool sample();
+
+    GPU          *gpu;
+    GPU::Metrics  metrics;
+    int           durationMsecs;
+
+    QVector<Sample> samples;
+
+    QElapsedTimer clock;
+    QTimer        timer;
+    bool          running;
+    bool          blocking; // run() without an event loop
+
+private slots:
+    void tick();
+};
+
+#endif // GPUBURSTCAPTURE_H
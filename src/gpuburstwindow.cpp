@@ -0,0 +1,123 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "gpuburstwindow.h"
+#include "ui_gpuburstwindow.h"
+
+#include <QGraphicsTextItem>
+
+#include "gpudiagnostics.h"
+#include "gputrace.h"
+
+/**
+ * Approx. height of a text line in the graph for margins
+ */
+const int TEXT_LINE_HEIGHT = 26;
+/**
+ * Constant for the number of nsecs in a msec
+ */
+const double NSEC_IN_A_MSEC = 1000000.0;
+
+GPUBurstWindow::GPUBurstWindow(GPUBurstCapture *capture, QWidget *parent, Qt::WindowFlags f) :
+    QWidget(parent, f),
+    ui(new Ui::GPUBurstWindow)
+{
+    ui->setupUi(this);
+
+    this->capture = capture;
+    this->capture->setParent(this);
+
+    GPU *gpu = this->capture->getGPU();
+    this->setWindowTitle(QString("[%1] %2 - Burst Capture").arg(gpu->getIdentifier()).arg(gpu->getName()));
+
+    for(int i=0; i < GPUHistory::SeriesCount; i++) {
+        GPUHistory::Series series = static_cast<GPUHistory::Series>(i);
+
+        if(this->capture->isSeriesCaptured(series)) {
+            this->ui->seriesCombo->addItem(GPUBurstCapture::getSeriesName(series), i);
+        }
+    }
+
+    this->scene = new QGraphicsScene(this->ui->graphic->rect(), this);
+    this->ui->graphic->setFrameShape(QFrame::NoFrame);
+    this->ui->graphic->setScene(this->scene);
+
+    this->ui->summaryLabel->setText(this->capture->getSummary());
+
+    connect(this->ui->seriesCombo, SIGNAL(currentIndexChanged(int)), this, SLOT(display()));
+}
+
+GPUBurstWindow::~GPUBurstWindow()
+{
+    delete ui;
+}
+
+/**
+ * Redraws the graph to the new size
+ * @param event
+ */
+void GPUBurstWindow::resizeEvent(QResizeEvent *event)
+{
+    QWidget::resizeEvent(event);
+
+    this->display();
+}
+
+/**
+ * Draws every sample of the selected series
+ */
+void GPUBurstWindow::display()
+{
+    GPUTWEAK_TRACE_SCOPE("GPUBurstWindow::display");
+
+    GPUDiagnostics::ScopedTimer renderTimer(GPUDiagnostics::Render, "burst");
+
+    this->scene->clear();
+    this->scene->setSceneRect(this->ui->graphic->rect());
+
+    const QVector<GPUBurstCapture::Sample> &samples = this->capture->getSamples();
+
+    if(samples.size() < 2 || this->ui->seriesCombo->currentIndex() < 0) {
+        return;
+    }
+
+    GPUHistory::Series series = static_cast<GPUHistory::Series>(this->ui->seriesCombo->currentData().toInt());
+    GPUBurstCapture::Statistics statistics = this->capture->getStatistics(series);
+
+    int minVal = statistics.min;
+    int maxVal = statistics.max > statistics.min ? statistics.max : statistics.min + 1;
+
+    double valInterval = maxVal - minVal;
+    double timeLength = samples.last().nsecs - samples.first().nsecs;
+    double height = this->scene->height() - 2 * TEXT_LINE_HEIGHT;
+
+    for(int i=0; i < samples.size()-1; i++) {
+        double x1 = (samples.at(i).nsecs - samples.first().nsecs) / timeLength * this->scene->width();
+        double y1 = TEXT_LINE_HEIGHT + height - (samples.at(i).values[series] - minVal) / valInterval * height;
+        double x2 = (samples.at(i+1).nsecs - samples.first().nsecs) / timeLength * this->scene->width();
+        double y2 = TEXT_LINE_HEIGHT + height - (samples.at(i+1).values[series] - minVal) / valInterval * height;
+
+        this->scene->addLine(x1, y1, x2, y2, QPen(Qt::darkBlue, 1));
+    }
+
+    QGraphicsTextItem *maxValText = this->scene->addText(QString::number(maxVal));
+    maxValText->setPos(0, 0);
+    QGraphicsTextItem *minValText = this->scene->addText(QString::number(minVal));
+    minValText->setPos(0, this->scene->height() - TEXT_LINE_HEIGHT);
+    QGraphicsTextItem *lengthText = this->scene->addText(QString("%1 ms").arg(timeLength / NSEC_IN_A_MSEC, 0, 'f', 0));
+    lengthText->setPos(this->scene->width() - lengthText->boundingRect().width(), this->scene->height() - TEXT_LINE_HEIGHT);
+}
@@ -0,0 +1,54 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GPUBURSTWINDOW_H
+#define GPUBURSTWINDOW_H
+
+#include <QWidget>
+#include <QGraphicsScene>
+
+#include "gpuburstcapture.h"
+
+namespace Ui {
+class GPUBurstWindow;
+}
+
+/**
+ * Window displaying the result of a burst capture
+ */
+class GPUBurstWindow : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit GPUBurstWindow(GPUBurstCapture *capture, QWidget *parent = 0, Qt::WindowFlags f = 0);
+    ~GPUBurstWindow();
+
+protected:
+    void resizeEvent(QResizeEvent *event);
+
+private:
+    Ui::GPUBurstWindow *ui;
+    GPUBurstCapture *capture;
+
+    QGraphicsScene *scene;
+
+private slots:
+    void display();
+};
+
+#endif // GPUBURSTWINDOW_H
@@ -0,0 +1,353 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "gpucollector.h"
+
+#include <QTextStream>
+
+/**
+ * Frames are skipped for a viewer while this many bytes are not written to it
+ */
+const qint64 MAX_VIEWER_PENDING_BYTES = 1024 * 1024;
+
+GPUCollector::GPUCollector(QObject *parent) :
+    QObject(parent)
+{
+    connect(&this->server, SIGNAL(newConnection()), this, SLOT(newConnection()));
+}
+
+GPUCollector::~GPUCollector()
+{
+    // no-op
+}
+
+/**
+ * Starts accepting agents and viewers
+ * @param port TCP port, on all the interfaces
+ * @return False if the port cannot be used
+ */
+bool GPUCollector::listen(quint16 port)
+{
+    return this->server.listen(QHostAddress::Any, port);
+}
+
+void GPUCollector::newConnection()
+{
+    while(this->server.hasPendingConnections()) {
+        QTcpSocket *socket = this->server.nextPendingConnection();
+
+        Connection connection;
+        connection.role = -1;
+        this->connections.insert(socket, connection);
+
+        connect(socket, SIGNAL(readyRead()), this, SLOT(readFrames()));
+        connect(socket, SIGNAL(disconnected()), this, SLOT(socketDisconnected()));
+        connect(socket, SIGNAL(bytesWritten(qint64)), this, SLOT(viewerDrained()));
+    }
+}
+
+void GPUCollector::readFrames()
+{
+    QTcpSocket *socket = qobject_cast<QTcpSocket*>(sender());
+    if(!socket || !this->connections.contains(socket)) {
+        return;
+    }
+
+    this->connections[socket].buffer.append(socket->readAll());
+
+    GPUNetwork::Frame frame;
+    GPUNetwork::ReadResult result = GPUNetwork::FrameIncomplete;
+
+    // The connection can be dropped by a frame, ex: a second agent with the same name
+    while(this->connections.contains(socket)
+          && (result = GPUNetwork::takeFrame(this->connections[socket].buffer, frame)) == GPUNetwork::FrameRead) {
+        int role = this->connections.value(socket).role;
+
+        if(frame.type == GPUNetwork::Hello && role < 0) {
+            this->readHello(socket, frame.payload);
+        } else if(frame.type == GPUNetwork::Samples && role == GPUNetwork::AgentRole) {
+            this->readSamples(socket, frame.payload);
+        } else {
+            result = GPUNetwork::FrameInvalid;
+            break;
+        }
+    }
+
+    if(this->connections.contains(socket) && result == GPUNetwork::FrameInvalid) {
+        socket->abort();
+    }
+}
+
+/**
+ * Registers an agent, or sends the current state to a viewer
+ * @param socket
+ * @param payload
+ */
+void GPUCollector::readHello(QTcpSocket *socket, const QByteArray &payload)
+{
+    QDataStream stream(payload);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    quint8  role = 0;
+    quint16 version = 0;
+    stream >> role >> version;
+
+    if(stream.status() != QDataStream::Ok || version != GPUNetwork::protocolVersion()) {
+        QTextStream(stderr) << "Refused " << socket->peerAddress().toString() << ": protocol " << version << endl;
+        socket->abort();
+        return;
+    }
+
+    if(role == GPUNetwork::ViewerRole) {
+        this->connections[socket].role = GPUNetwork::ViewerRole;
+
+        foreach(const Host &host, this->hosts) {
+            this->describe(host, socket);
+            this->sendLatest(host, socket);
+        }
+
+        return;
+    }
+
+    QString name;
+    quint64 session;
+    quint32 count;
+    stream >> name >> session >> count;
+
+    QList<GPUNetwork::GPUDescription> gpus;
+    for(quint32 i=0; i < count && stream.status() == QDataStream::Ok; i++) {
+        GPUNetwork::GPUDescription description;
+        stream >> description;
+        gpus.append(description);
+    }
+
+    if(stream.status() != QDataStream::Ok || role != GPUNetwork::AgentRole) {
+        socket->abort();
+        return;
+    }
+
+    // A new session is an agent that restarted, its sequence numbers start over
+    if(!this->hosts.contains(name) || this->hosts.value(name).session != session) {
+        Host created;
+        created.name            = name;
+        created.session         = session;
+        created.lastSeq         = 0;
+        created.agent           = this->hosts.contains(name) ? this->hosts.value(name).agent : 0;
+        created.receivedSamples = 0;
+        created.missedSamples   = 0;
+
+        this->hosts.insert(name, created);
+    }
+
+    Host &host = this->hosts[name];
+
+    // The previous connection of the agent may not be noticed as closed yet
+    if(host.agent && host.agent != socket) {
+        QTcpSocket *previous = host.agent;
+        host.agent = 0;
+        previous->abort();
+    }
+
+    host.agent = socket;
+    host.gpus  = gpus;
+    host.latest.resize(gpus.size());
+    for(int i=0; i < host.latest.size(); i++) {
+        host.latest[i].gpu = i;
+    }
+
+    Connection &connection = this->connections[socket];
+    connection.role = GPUNetwork::AgentRole;
+    connection.host = name;
+
+    QTextStream(stderr) << "Agent " << name << " connected from " << socket->peerAddress().toString()
+                        << " with " << gpus.size() << " GPUs, resuming after sample " << host.lastSeq << endl;
+
+    QByteArray welcome;
+    QDataStream welcomeStream(&welcome, QIODevice::WriteOnly);
+    welcomeStream.setVersion(QDataStream::Qt_5_0);
+    welcomeStream << host.lastSeq;
+    this->send(socket, GPUNetwork::Welcome, welcome);
+
+    foreach(QTcpSocket *viewer, this->connections.keys()) {
+        if(this->connections.value(viewer).role == GPUNetwork::ViewerRole) {
+            this->describe(host, viewer);
+        }
+    }
+}
+
+/**
+ * Stores the samples of an agent, acknowledges them and relays them to the viewers
+ * Samples sent again after a reconnection are ignored
+ * @param socket
+ * @param payload
+ */
+void GPUCollector::readSamples(QTcpSocket *socket, const QByteArray &payload)
+{
+    QString unused;
+    QList<GPUNetwork::Sample> samples;
+
+    if(!GPUNetwork::decodeSamples(payload, unused, samples)) {
+        socket->abort();
+        return;
+    }
+
+    Host &host = this->hosts[this->connections.value(socket).host];
+
+    QList<GPUNetwork::Sample> fresh;
+    foreach(const GPUNetwork::Sample &sample, samples) {
+        if(sample.seq <= host.lastSeq || sample.gpu >= host.latest.size()) {
+            continue;
+        }
+
+        host.missedSamples += sample.seq - host.lastSeq - 1;
+        host.receivedSamples++;
+        host.lastSeq = sample.seq;
+
+        GPUNetwork::merge(host.latest[sample.gpu], sample);
+        fresh.append(sample);
+    }
+
+    QByteArray ack;
+    QDataStream ackStream(&ack, QIODevice::WriteOnly);
+    ackStream.setVersion(QDataStream::Qt_5_0);
+    ackStream << host.lastSeq;
+    this->send(socket, GPUNetwork::Ack, ack);
+
+    if(fresh.isEmpty()) {
+        return;
+    }
+
+    // Encoded once for all the viewers
+    QByteArray frame = GPUNetwork::encodeFrame(GPUNetwork::Samples, GPUNetwork::encodeSamples(host.name, fresh));
+
+    QMutableHashIterator<QTcpSocket*, Connection> i(this->connections);
+    while(i.hasNext()) {
+        i.next();
+
+        if(i.value().role != GPUNetwork::ViewerRole) {
+            continue;
+        }
+
+        // A slow viewer only gets the latest values once it catches up
+        if(i.key()->bytesToWrite() > MAX_VIEWER_PENDING_BYTES) {
+            i.value().dirtyHosts.insert(host.name);
+        } else {
+            i.key()->write(frame);
+        }
+    }
+}
+
+/**
+ * Sends the GPUs of a host to a viewer
+ * @param host
+ * @param viewer
+ */
+void GPUCollector::describe(const Host &host, QTcpSocket *viewer)
+{
+    QByteArray payload;
+    QDataStream stream(&payload, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    stream << host.name << (host.agent != 0) << static_cast<quint32>(host.gpus.size());
+    foreach(const GPUNetwork::GPUDescription &description, host.gpus) {
+        stream << description;
+    }
+
+    this->send(viewer, GPUNetwork::Describe, payload);
+}
+
+/**
+ * Sends the latest values of the GPUs of a host to a viewer
+ * The sequence numbers of such a frame do not mean anything
+ * @param host
+ * @param viewer
+ */
+void GPUCollector::sendLatest(const Host &host, QTcpSocket *viewer)
+{
+    QList<GPUNetwork::Sample> samples;
+
+    foreach(const GPUNetwork::Sample &sample, host.latest) {
+        if(sample.metrics) {
+            samples.append(sample);
+        }
+    }
+
+    if(!samples.isEmpty()) {
+        this->send(viewer, GPUNetwork::Samples, GPUNetwork::encodeSamples(host.name, samples));
+    }
+}
+
+void GPUCollector::send(QTcpSocket *socket, GPUNetwork::FrameType type, const QByteArray &payload)
+{
+    socket->write(GPUNetwork::encodeFrame(type, payload));
+}
+
+/**
+ * Catches a slow viewer up with the hosts it missed samples of
+ */
+void GPUCollector::viewerDrained()
+{
+    QTcpSocket *socket = qobject_cast<QTcpSocket*>(sender());
+    if(!socket || !this->connections.contains(socket) || socket->bytesToWrite() > MAX_VIEWER_PENDING_BYTES / 2) {
+        return;
+    }
+
+    QSet<QString> dirtyHosts = this->connections.value(socket).dirtyHosts;
+    if(dirtyHosts.isEmpty()) {
+        return;
+    }
+
+    this->connections[socket].dirtyHosts.clear();
+
+    foreach(QString name, dirtyHosts) {
+        this->sendLatest(this->hosts.value(name), socket);
+    }
+}
+
+/**
+ * Forgets a connection, the viewers are told when an agent goes away
+ */
+void GPUCollector::socketDisconnected()
+{
+    QTcpSocket *socket = qobject_cast<QTcpSocket*>(sender());
+    if(!socket || !this->connections.contains(socket)) {
+        return;
+    }
+
+    Connection connection = this->connections.take(socket);
+    socket->deleteLater();
+
+    if(connection.role != GPUNetwork::AgentRole || !this->hosts.contains(connection.host)) {
+        return;
+    }
+
+    Host &host = this->hosts[connection.host];
+    if(host.agent != socket) {
+        return;
+    }
+
+    host.agent = 0;
+
+    QTextStream(stderr) << "Agent " << host.name << " disconnected, " << host.receivedSamples << " samples received, "
+                        << host.missedSamples << " missed" << endl;
+
+    foreach(QTcpSocket *viewer, this->connections.keys()) {
+        if(this->connections.value(viewer).role == GPUNetwork::ViewerRole) {
+            this->describe(host, viewer);
+        }
+    }
+}
@@ -0,0 +1,90 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GPUCOLLECTOR_H
+#define GPUCOLLECTOR_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QSet>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QVector>
+
+#include "gpunetwork.h"
+
+/**
+ * Receives the samples of many agents and relays them to the viewers, ex: a GPUTweak window
+ * Keeps the latest values of every GPU so a viewer that connects, or that was too slow
+ * to read everything, gets the current state at once instead of the whole stream
+ */
+class GPUCollector : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit GPUCollector(QObject *parent = 0);
+    ~GPUCollector();
+
+    bool listen(quint16 port);
+
+private:
+    /**
+     * Host streaming its GPUs, kept when its agent disconnects
+     */
+    struct Host {
+        QString    name;
+        quint64    session;
+        quint64    lastSeq;  // last sample received of the session
+        QTcpSocket *agent;   // 0 while disconnected
+        QList<GPUNetwork::GPUDescription> gpus;
+        QVector<GPUNetwork::Sample>       latest; // merged samples, one per GPU
+        qint64     receivedSamples;
+        qint64     missedSamples;  // dropped by the agent before it could send them
+    };
+
+    /**
+     * State of a connected socket
+     */
+    struct Connection {
+        QByteArray buffer;     // bytes received, until a whole frame is there
+        int        role;       // GPUNetwork::Role, -1 before the hello
+        QString    host;       // for the agents
+        QSet<QString> dirtyHosts; // for the viewers, hosts whose samples were skipped
+    };
+
+    void readHello(QTcpSocket *socket, const QByteArray &payload);
+    void readSamples(QTcpSocket *socket, const QByteArray &payload);
+    void describe(const Host &host, QTcpSocket *viewer);
+    void sendLatest(const Host &host, QTcpSocket *viewer);
+    void send(QTcpSocket *socket, GPUNetwork::FrameType type, const QByteArray &payload);
+
+    QTcpServer                       server;
+    QHash<QTcpSocket*, Connection>   connections;
+    QMap<QString, Host>              hosts;
+
+private slots:
+    void newConnection();
+    void readFrames();
+    void socketDisconnected();
+    void viewerDrained();
+};
+
+#endif // GPUCOLLECTOR_H
@@ -0,0 +1,272 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "gpudashboardwindow.h"
+
+#include <QTimer>
+#include <QPainter>
+#include <QElapsedTimer>
+
+#include "gpudiagnostics.h"
+#include "gputrace.h"
+
+/**
+ * Number of seconds showed on the sparklines
+ */
+const int GRAPH_TIME_LENGTH_SECS = 60;
+/**
+ * Time between two fetches of the displayed values
+ */
+const int POLL_INTERVAL_MSECS = 2000;
+/**
+ * Refresh the dashboard every n msecs
+ */
+const int GRAPH_REFRESH_MSECS = 1000;
+/**
+ * Size of a GPU cell, the width grows to fill the window
+ */
+const int CELL_MIN_WIDTH = 260;
+const int CELL_HEIGHT    = 64;
+/**
+ * Space around and between the cells
+ */
+const int CELL_MARGIN = 4;
+/**
+ * Height of a text line in a cell
+ */
+const int CELL_TEXT_HEIGHT = 16;
+/**
+ * Height of the footer displaying the frame time
+ */
+const int FOOTER_HEIGHT = 20;
+/**
+ * Number of frames used to compute the frame time statistics
+ */
+const int FRAME_TIMES_KEPT = 60;
+/**
+ * Scale of the temperature sparkline
+ */
+const int TEMP_MIN = 20;
+const int TEMP_MAX = 100;
+/**
+ * Scale of the percent sparklines
+ */
+const int PERCENT_MIN = 0;
+const int PERCENT_MAX = 100;
+
+GPUDashboardWindow::GPUDashboardWindow(QList<GPUHistory*> histories, GPUPoller *poller, QWidget *parent, Qt::WindowFlags f) :
+    QWidget(parent, f)
+{
+    this->histories = histories;
+    this->poller = poller;
+
+    this->frameTimes.fill(0, FRAME_TIMES_KEPT);
+    this->frameTimesNext = 0;
+
+    this->setWindowTitle("GPUTweak - Dashboard");
+
+    foreach(GPUHistory *history, this->histories) {
+        this->poller->subscribe(this, history->getGPU(), GPU::CoreTemp | GPU::FanSpeed | GPU::Clocks | GPU::Utilization, POLL_INTERVAL_MSECS);
+    }
+
+    int columns = qMin(4, qMax(1, this->histories.size()));
+    int rows    = (this->histories.size() + columns - 1) / columns;
+    this->resize(columns * (CELL_MIN_WIDTH + CELL_MARGIN) + CELL_MARGIN,
+                 rows * (CELL_HEIGHT + CELL_MARGIN) + CELL_MARGIN + FOOTER_HEIGHT);
+
+    this->tick();
+}
+
+GPUDashboardWindow::~GPUDashboardWindow()
+{
+    // no-op
+}
+
+/**
+ * Adds the cell of a GPU that was plugged
+ * @param history
+ */
+void GPUDashboardWindow::addHistory(GPUHistory *history)
+{
+    this->histories.append(history);
+
+    this->poller->subscribe(this, history->getGPU(), GPU::CoreTemp | GPU::FanSpeed | GPU::Clocks | GPU::Utilization, POLL_INTERVAL_MSECS);
+
+    this->update();
+}
+
+/**
+ * Removes the cell of a GPU that was unplugged, the poller drops its subscription by itself
+ * @param history
+ */
+void GPUDashboardWindow::removeHistory(GPUHistory *history)
+{
+    this->histories.removeOne(history);
+
+    this->update();
+}
+
+/**
+ * Draws the whole grid
+ * @param event
+ */
+void GPUDashboardWindow::paintEvent(QPaintEvent *event)
+{
+    GPUTWEAK_TRACE_SCOPE("GPUDashboardWindow::paintEvent");
+
+    Q_UNUSED(event);
+
+    QElapsedTimer frameTimer;
+    frameTimer.start();
+
+    QPainter painter(this);
+    painter.fillRect(this->rect(), this->palette().window());
+
+    QTime graphEnd = QTime::currentTime();
+    QTime graphStart = graphEnd.addSecs(-GRAPH_TIME_LENGTH_SECS);
+
+    int columns   = qMax(1, (this->width() - CELL_MARGIN) / (CELL_MIN_WIDTH + CELL_MARGIN));
+    int cellWidth = (this->width() - CELL_MARGIN) / columns - CELL_MARGIN;
+
+    for(int i=0; i < this->histories.size(); i++) {
+        QRect cell(CELL_MARGIN + (i % columns) * (cellWidth + CELL_MARGIN),
+                   CELL_MARGIN + (i / columns) * (CELL_HEIGHT + CELL_MARGIN),
+                   cellWidth,
+                   CELL_HEIGHT);
+
+        this->paintCell(painter, cell, this->histories.at(i), graphStart, graphEnd);
+    }
+
+    // Frame time statistics over the last frames, the current one is not included
+    qint64 sum = 0;
+    qint64 max = 0;
+    int count = 0;
+    foreach(qint64 nsecs, this->frameTimes) {
+        if(nsecs > 0) {
+            sum += nsecs;
+            max = qMax(max, nsecs);
+            count++;
+        }
+    }
+
+    if(count > 0) {
+        painter.setPen(this->palette().color(QPalette::WindowText));
+        painter.drawText(QRect(CELL_MARGIN, this->height() - FOOTER_HEIGHT, this->width() - 2 * CELL_MARGIN, FOOTER_HEIGHT),
+                         Qt::AlignVCenter | Qt::AlignRight,
+                         QString("%1 GPUs - frame %2 ms avg, %3 ms max")
+                         .arg(this->histories.size())
+                         .arg(static_cast<double>(sum) / count / 1000000.0, 0, 'f', 2)
+                         .arg(static_cast<double>(max) / 1000000.0, 0, 'f', 2));
+    }
+
+    this->storeFrameTime(frameTimer.nsecsElapsed());
+    GPUDiagnostics::recordTiming(GPUDiagnostics::Render, "dashboard", frameTimer.nsecsElapsed());
+}
+
+/**
+ * Draws the cell of a single GPU
+ * @param painter    Painter of the window
+ * @param cell       Area of the cell
+ * @param history    History of the GPU
+ * @param graphStart Earlier time displayed on the sparklines
+ * @param graphEnd   Last time displayed on the sparklines
+ */
+void GPUDashboardWindow::paintCell(QPainter &painter, const QRect &cell, GPUHistory *history, QTime graphStart, QTime graphEnd)
+{
+    GPU *gpu = history->getGPU();
+
+    painter.setPen(QPen(QColor(200, 200, 200), 1));
+    painter.setBrush(Qt::white);
+    painter.drawRect(cell.adjusted(0, 0, -1, -1));
+
+    QRect textLine(cell.left() + CELL_MARGIN, cell.top() + 2, cell.width() - 2 * CELL_MARGIN, CELL_TEXT_HEIGHT);
+
+    painter.setPen(Qt::black);
+    painter.drawText(textLine, Qt::AlignVCenter | Qt::AlignLeft,
+                     painter.fontMetrics().elidedText(QString("[%1] %2").arg(gpu->getIdentifier()).arg(gpu->getName()),
+                                                      Qt::ElideRight, textLine.width()));
+
+    textLine.translate(0, CELL_TEXT_HEIGHT);
+
+    painter.setPen(Qt::darkRed);
+    painter.drawText(textLine, Qt::AlignVCenter | Qt::AlignLeft, QString("%1 °C").arg(gpu->getCurrentCoreTemp()));
+    painter.setPen(Qt::darkBlue);
+    painter.drawText(textLine, Qt::AlignVCenter | Qt::AlignHCenter, QString("GPU %1 %  Mem %2 %").arg(gpu->getCurrentCoreUse()).arg(gpu->getCurrentMemoryUse()));
+    painter.setPen(Qt::darkGray);
+    painter.drawText(textLine, Qt::AlignVCenter | Qt::AlignRight, QString("%1 MHz  Fan %2 %").arg(gpu->getCurrentCoreClock()).arg(gpu->getCurrentFanSpeed()));
+
+    QRect graphArea(cell.left() + CELL_MARGIN,
+                    textLine.bottom() + 2,
+                    cell.width() - 2 * CELL_MARGIN,
+                    cell.bottom() - textLine.bottom() - 2 - CELL_MARGIN);
+
+    painter.setPen(QPen(Qt::darkRed, 1));
+    this->paintSparkline(painter, graphArea, history->getValues(GPUHistory::CoreTemp), TEMP_MIN, TEMP_MAX, graphStart, graphEnd);
+    painter.setPen(QPen(Qt::darkBlue, 1));
+    this->paintSparkline(painter, graphArea, history->getValues(GPUHistory::CoreUse), PERCENT_MIN, PERCENT_MAX, graphStart, graphEnd);
+}
+
+/**
+ * Draws a series as a single polyline with the current pen
+ * @param painter    Painter of the window
+ * @param area       Area of the sparkline
+ * @param values     Historical values of the series
+ * @param minVal     Value at the bottom of the area
+ * @param maxVal     Value at the top of the area
+ * @param graphStart Earlier time displayed on the sparkline
+ * @param graphEnd   Last time displayed on the sparkline
+ */
+void GPUDashboardWindow::paintSparkline(QPainter &painter, const QRect &area, const QList<GPUHistory::HistoryValue> &values, int minVal, int maxVal, QTime graphStart, QTime graphEnd)
+{
+    this->points.resize(0);
+
+    double timeLength = graphStart.msecsTo(graphEnd);
+    double valInterval = maxVal - minVal;
+
+    for(int i = values.size()-1; i >= 0 && values.at(i).time > graphStart; i--) {
+        const GPUHistory::HistoryValue &val = values.at(i);
+
+        int value = qBound(minVal, val.value, maxVal);
+
+        this->points.append(QPointF(area.left() + graphStart.msecsTo(val.time) / timeLength * area.width(),
+                                    area.bottom() - (value - minVal) / valInterval * area.height()));
+    }
+
+    if(this->points.size() > 1) {
+        painter.drawPolyline(this->points.constData(), this->points.size());
+    }
+}
+
+/**
+ * Adds a frame time to the statistics
+ * @param nsecs Time spent drawing the frame
+ */
+void GPUDashboardWindow::storeFrameTime(qint64 nsecs)
+{
+    this->frameTimes[this->frameTimesNext] = nsecs;
+    this->frameTimesNext = (this->frameTimesNext + 1) % FRAME_TIMES_KEPT;
+}
+
+/**
+ * Tick to refresh the GUI periodically
+ */
+void GPUDashboardWindow::tick()
+{
+    QTimer::singleShot(GRAPH_REFRESH_MSECS, this, SLOT(tick()));
+
+    this->update();
+}
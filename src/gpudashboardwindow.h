@@ -0,0 +1,69 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GPUDASHBOARDWINDOW_H
+#define GPUDASHBOARDWINDOW_H
+
+#include <QWidget>
+#include <QList>
+#include <QVector>
+#include <QPointF>
+#include <QTime>
+
+#include "gpuhistory.h"
+#include "gpupoller.h"
+
+/**
+ * Window giving an overview of all the GPUs at once
+ * Every card gets a compact cell with its current values and sparklines,
+ * the whole grid is drawn in a single paint pass from the shared histories
+ */
+class GPUDashboardWindow : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit GPUDashboardWindow(QList<GPUHistory*> histories, GPUPoller *poller, QWidget *parent = 0, Qt::WindowFlags f = 0);
+    ~GPUDashboardWindow();
+
+public slots:
+    void addHistory(GPUHistory *history);
+    void removeHistory(GPUHistory *history);
+
+protected:
+    void paintEvent(QPaintEvent *event);
+
+private:
+    void paintCell(QPainter &painter, const QRect &cell, GPUHistory *history, QTime graphStart, QTime graphEnd);
+    void paintSparkline(QPainter &painter, const QRect &area, const QList<GPUHistory::HistoryValue> &values, int minVal, int maxVal, QTime graphStart, QTime graphEnd);
+    void storeFrameTime(qint64 nsecs);
+
+    QList<GPUHistory*> histories;
+    GPUPoller         *poller;
+
+    // Reused between sparklines to avoid allocating on every frame
+    QVector<QPointF> points;
+
+    // Last frame times in nanoseconds, used as a ring buffer
+    QVector<qint64> frameTimes;
+    int             frameTimesNext;
+
+private slots:
+    void tick();
+};
+
+#endif // GPUDASHBOARDWINDOW_H
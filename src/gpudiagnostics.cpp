@@ -0,0 +1,321 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "gpudiagnostics.h"
+
+#include <QHash>
+#include <QJsonArray>
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThreadStorage>
+
+namespace
+{
+    /**
+     * Values recorded by a single thread
+     */
+    struct ThreadData {
+        ThreadData();
+        ~ThreadData();
+
+        QMutex                    mutex; // only contended while a reader merges
+        qint64                    counters[GPUDiagnostics::CounterCount];
+        QHash<QString, GPUSketch> timings[GPUDiagnostics::TimingCount];
+    };
+
+    /**
+     * Storages of the running threads, plus what the finished ones left
+     */
+    struct Registry {
+        QMutex                   mutex;
+        QList<ThreadData*>       threads;
+        GPUDiagnostics::Snapshot retired;
+        QElapsedTimer            clock;
+    };
+}
+
+Q_GLOBAL_STATIC(Registry, registry)
+
+/**
+ * Storage of the calling thread, deleted by Qt when the thread finishes
+ */
+static QThreadStorage<ThreadData*> threadData;
+
+/**
+ * Adds the values of a thread to a snapshot
+ * The thread mutex must be locked
+ * @param snapshot
+ * @param data
+ */
+static void mergeThreadData(GPUDiagnostics::Snapshot &snapshot, const ThreadData *data)
+{
+    for(int i=0; i < GPUDiagnostics::CounterCount; i++) {
+        snapshot.counters[i] += data->counters[i];
+    }
+
+    for(int i=0; i < GPUDiagnostics::TimingCount; i++) {
+        QHashIterator<QString, GPUSketch> it(data->timings[i]);
+        while(it.hasNext()) {
+            it.next();
+            snapshot.timings[i][it.key()].merge(it.value());
+        }
+    }
+}
+
+/**
+ * Clears the values of a thread
+ * The thread mutex must be locked
+ * @param data
+ */
+static void clearThreadData(ThreadData *data)
+{
+    for(int i=0; i < GPUDiagnostics::CounterCount; i++) {
+        data->counters[i] = 0;
+    }
+
+    for(int i=0; i < GPUDiagnostics::TimingCount; i++) {
+        data->timings[i].clear();
+    }
+}
+
+ThreadData::ThreadData()
+{
+    clearThreadData(this);
+}
+
+ThreadData::~ThreadData()
+{
+    // The registry may already be gone when the main thread finishes
+    if(registry.isDestroyed()) {
+        return;
+    }
+
+    QMutexLocker registryLocker(&registry()->mutex);
+    QMutexLocker locker(&this->mutex);
+
+    mergeThreadData(registry()->retired, this);
+    registry()->threads.removeOne(this);
+}
+
+/**
+ * Storage of the calling thread, created on first use
+ * @return Storage
+ */
+static ThreadData *localData()
+{
+    if(!threadData.hasLocalData()) {
+        ThreadData *data = new ThreadData();
+
+        QMutexLocker locker(&registry()->mutex);
+        if(!registry()->clock.isValid()) {
+            registry()->clock.start();
+        }
+        registry()->threads.append(data);
+
+        threadData.setLocalData(data);
+    }
+
+    return threadData.localData();
+}
+
+GPUDiagnostics::Snapshot::Snapshot()
+{
+    this->elapsedMsecs = 0;
+
+    for(int i=0; i < CounterCount; i++) {
+        this->counters[i] = 0;
+    }
+}
+
+/**
+ * Counts events
+ * @param counter
+ * @param n Number of events
+ */
+void GPUDiagnostics::count(Counter counter, qint64 n)
+{
+    ThreadData *data = localData();
+
+    QMutexLocker locker(&data->mutex);
+    data->counters[counter] += n;
+}
+
+/**
+ * Records a duration
+ * @param timing Family of the duration
+ * @param key    What was timed in the family
+ * @param nsecs  Duration
+ */
+void GPUDiagnostics::recordTiming(Timing timing, const QString &key, qint64 nsecs)
+{
+    ThreadData *data = localData();
+
+    QMutexLocker locker(&data->mutex);
+    data->timings[timing][key].add(nsecs / 1000.0);
+}
+
+/**
+ * Records a query to a driver tool
+ * @param target    Card or fan queried, ex: gpu:0
+ * @param attribute Attribute queried
+ * @param nsecs     Duration of the query
+ * @param ok        False if the query failed
+ */
+void GPUDiagnostics::recordQuery(const QString &target, const QString &attribute, qint64 nsecs, bool ok)
+{
+    ThreadData *data = localData();
+
+    QMutexLocker locker(&data->mutex);
+    data->counters[DriverQueries]++;
+    if(!ok) {
+        data->counters[DriverQueryFailures]++;
+    }
+    data->timings[DriverQuery][target + " " + attribute].add(nsecs / 1000.0);
+}
+
+/**
+ * Merges the values of all the threads
+ * Recording threads only wait while their own storage is read
+ * @return Values since the start or the last reset
+ */
+GPUDiagnostics::Snapshot GPUDiagnostics::snapshot()
+{
+    localData(); // starts the clock
+
+    QMutexLocker registryLocker(&registry()->mutex);
+
+    Snapshot snapshot = registry()->retired;
+    snapshot.elapsedMsecs = registry()->clock.elapsed();
+
+    foreach(ThreadData *data, registry()->threads) {
+        QMutexLocker locker(&data->mutex);
+        mergeThreadData(snapshot, data);
+    }
+
+    return snapshot;
+}
+
+/**
+ * Clears the values of all the threads
+ */
+void GPUDiagnostics::reset()
+{
+    localData();
+
+    QMutexLocker registryLocker(&registry()->mutex);
+
+    registry()->retired = Snapshot();
+    registry()->clock.start();
+
+    foreach(ThreadData *data, registry()->threads) {
+        QMutexLocker locker(&data->mutex);
+        clearThreadData(data);
+    }
+}
+
+/**
+ * Name of a counter, used in the exports
+ * @param counter
+ * @return Name
+ */
+QString GPUDiagnostics::getCounterName(Counter counter)
+{
+    switch(counter) {
+    case ProcessSpawns:
+        return "process_spawns";
+    case DriverQueries:
+        return "driver_queries";
+    case DriverQueryFailures:
+        return "driver_query_failures";
+    case DriverQueryCacheHits:
+        return "driver_query_cache_hits";
+    case DriverQueriesCoalesced:
+        return "driver_queries_coalesced";
+    case PollerTicks:
+        return "poller_ticks";
+    case TickOverruns:
+        return "tick_overruns";
+    default:
+        return "";
+    }
+}
+
+/**
+ * Name of a family of durations, used in the exports
+ * @param timing
+ * @return Name
+ */
+QString GPUDiagnostics::getTimingName(Timing timing)
+{
+    switch(timing) {
+    case DriverQuery:
+        return "driver_query";
+    case GPUFetch:
+        return "gpu_fetch";
+    case Render:
+        return "render";
+    default:
+        return "";
+    }
+}
+
+/**
+ * Exports a snapshot, durations are in microseconds
+ * @param snapshot
+ * @return {"elapsed_msecs":.., "counters":{name: value}, "<timing>":[{"key":.., "count":.., "p50":.., ..}]}
+ */
+QJsonObject GPUDiagnostics::toJson(const Snapshot &snapshot)
+{
+    QJsonObject json;
+    json.insert("elapsed_msecs", static_cast<double>(snapshot.elapsedMsecs));
+
+    QJsonObject counters;
+    for(int i=0; i < CounterCount; i++) {
+        counters.insert(getCounterName(static_cast<Counter>(i)), static_cast<double>(snapshot.counters[i]));
+    }
+    json.insert("counters", counters);
+
+    for(int i=0; i < TimingCount; i++) {
+        QJsonArray timings;
+
+        QMapIterator<QString, GPUSketch> it(snapshot.timings[i]);
+        while(it.hasNext()) {
+            it.next();
+
+            QJsonObject object = it.value().toJson();
+            object.insert("key", it.key());
+            timings.append(object);
+        }
+
+        json.insert(getTimingName(static_cast<Timing>(i)), timings);
+    }
+
+    return json;
+}
+
+GPUDiagnostics::ScopedTimer::ScopedTimer(Timing timing, const QString &key) :
+    timing(timing),
+    key(key)
+{
+    this->timer.start();
+}
+
+GPUDiagnostics::ScopedTimer::~ScopedTimer()
+{
+    GPUDiagnostics::recordTiming(this->timing, this->key, this->timer.nsecsElapsed());
+}
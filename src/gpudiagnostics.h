@@ -0,0 +1,98 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GPUDIAGNOSTICS_H
+#define GPUDIAGNOSTICS_H
+
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QMap>
+#include <QString>
+
+#include "gpusketch.h"
+
+/**
+ * Self-instrumentation of GPUTweak, to tell what the app itself costs
+ * Each thread counts in its own storage, so recording never waits on another thread,
+ * the storages are only merged when the values are read
+ */
+namespace GPUDiagnostics
+{
+    /**
+     * Plain event counts
+     */
+    enum Counter {
+        ProcessSpawns,
+        DriverQueries,
+        DriverQueryFailures,
+        DriverQueryCacheHits,   // answered from a recent value, not counted in DriverQueries
+        DriverQueriesCoalesced, // answered by the same query already running in another thread
+        PollerTicks,
+        TickOverruns,
+        CounterCount
+    };
+
+    /**
+     * Families of durations, each one split by a free key
+     */
+    enum Timing {
+        DriverQuery, // key: "<target> <attribute>", ex: "gpu:0 GPUCoreTemp"
+        GPUFetch,    // key: "<GPU identifier> <metrics>", a whole fetchVariables()
+        Render,      // key: window
+        TimingCount
+    };
+
+    /**
+     * Merged values of all the threads
+     */
+    struct Snapshot {
+        Snapshot();
+
+        qint64                   elapsedMsecs; // since the start or the last reset
+        qint64                   counters[CounterCount];
+        QMap<QString, GPUSketch> timings[TimingCount]; // microseconds
+    };
+
+    void count(Counter counter, qint64 n = 1);
+    void recordTiming(Timing timing, const QString &key, qint64 nsecs);
+    void recordQuery(const QString &target, const QString &attribute, qint64 nsecs, bool ok);
+
+    Snapshot snapshot();
+    void     reset();
+
+    QString getCounterName(Counter counter);
+    QString getTimingName(Timing timing);
+
+    QJsonObject toJson(const Snapshot &snapshot);
+
+    /**
+     * Records the time spent in its scope
+     */
+    class ScopedTimer
+    {
+    public:
+        ScopedTimer(Timing timing, const QString &key);
+        ~ScopedTimer();
+
+    private:
+        Timing        timing;
+        QString       key;
+        QElapsedTimer timer;
+    };
+}
+
+#endif // GPUDIAGNOSTICS_H
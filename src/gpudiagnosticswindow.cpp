@@ -0,0 +1,250 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "gpudiagnosticswindow.h"
+
+#include <QFile>
+#include <QFileDialog>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QMessageBox>
+#include <QPushButton>
+#include <QTimer>
+#include <QVBoxLayout>
+
+#include "gputrace.h"
+
+/**
+ * Refresh the values every n msecs
+ */
+const int REFRESH_MSECS = 1000;
+/**
+ * Columns of the durations tree
+ */
+enum TimingColumn {
+    NameColumn,
+    CountColumn,
+    P50Column,
+    P99Column,
+    MaxColumn,
+    ColumnCount
+};
+
+/**
+ * Formats a duration of the sketches
+ * @param usecs Microseconds
+ * @return Text in milliseconds
+ */
+static QString formatMsecs(double usecs)
+{
+    return QString::number(usecs / 1000.0, 'f', 2);
+}
+
+GPUDiagnosticsWindow::GPUDiagnosticsWindow(QList<GPUHistory*> histories, QWidget *parent, Qt::WindowFlags f) :
+    QWidget(parent, f)
+{
+    this->histories = histories;
+
+    this->setWindowTitle("GPUTweak - Diagnostics");
+    this->resize(560, 480);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+
+    this->summaryLabel = new QLabel();
+    this->summaryLabel->setTextInteractionFlags(Qt::TextSelectableByMouse);
+    layout->addWidget(this->summaryLabel);
+
+    this->timingsTree = new QTreeWidget();
+    this->timingsTree->setColumnCount(ColumnCount);
+    this->timingsTree->setHeaderLabels(QStringList() << "Duration" << "Count" << "p50 (ms)" << "p99 (ms)" << "Max (ms)");
+    this->timingsTree->header()->setSectionResizeMode(NameColumn, QHeaderView::Stretch);
+    this->timingsTree->header()->setStretchLastSection(false);
+    layout->addWidget(this->timingsTree);
+
+    for(int i=0; i < GPUDiagnostics::TimingCount; i++) {
+        this->timingItems[i] = new QTreeWidgetItem(this->timingsTree);
+        this->timingItems[i]->setExpanded(true);
+    }
+    this->timingItems[GPUDiagnostics::DriverQuery]->setText(NameColumn, "Driver queries");
+    this->timingItems[GPUDiagnostics::GPUFetch]   ->setText(NameColumn, "GPU fetches");
+    this->timingItems[GPUDiagnostics::Render]     ->setText(NameColumn, "Window renders");
+
+    QHBoxLayout *buttons = new QHBoxLayout();
+    buttons->addStretch();
+
+    QPushButton *resetBtn = new QPushButton("Reset");
+    connect(resetBtn, SIGNAL(clicked()), this, SLOT(resetValues()));
+    buttons->addWidget(resetBtn);
+
+    QPushButton *exportBtn = new QPushButton("Export...");
+    connect(exportBtn, SIGNAL(clicked()), this, SLOT(exportJson()));
+    buttons->addWidget(exportBtn);
+
+    QPushButton *traceBtn = new QPushButton("Save trace...");
+    traceBtn->setEnabled(GPUTrace::isEnabled());
+    traceBtn->setToolTip(GPUTrace::isEnabled() ? "Spans of the last moments, for chrome://tracing or ui.perfetto.dev" : "Built without GPUTWEAK_TRACING");
+    connect(traceBtn, SIGNAL(clicked()), this, SLOT(saveTrace()));
+    buttons->addWidget(traceBtn);
+
+    layout->addLayout(buttons);
+
+    this->tick();
+}
+
+GPUDiagnosticsWindow::~GPUDiagnosticsWindow()
+{
+    // no-op
+}
+
+void GPUDiagnosticsWindow::addHistory(GPUHistory *history)
+{
+    this->histories.append(history);
+}
+
+void GPUDiagnosticsWindow::removeHistory(GPUHistory *history)
+{
+    this->histories.removeOne(history);
+}
+
+/**
+ * Updates the GUI
+ */
+void GPUDiagnosticsWindow::display()
+{
+    GPUDiagnostics::Snapshot snapshot = GPUDiagnostics::snapshot();
+
+    // Rates since the previous refresh, or since the start for the first one
+    qint64 elapsedMsecs = snapshot.elapsedMsecs - this->lastSnapshot.elapsedMsecs;
+    if(elapsedMsecs <= 0) {
+        elapsedMsecs = 1;
+    }
+    double spawnsPerSec = (snapshot.counters[GPUDiagnostics::ProcessSpawns] - this->lastSnapshot.counters[GPUDiagnostics::ProcessSpawns]) * 1000.0 / elapsedMsecs;
+
+    qint64 historyBytes = 0;
+    foreach(GPUHistory *history, this->histories) {
+        historyBytes += history->getMemoryUsage();
+    }
+
+    this->summaryLabel->setText(QString("Process spawns: %1 (%2/s)\n"
+                                        "Driver queries: %3, %4 failed, %5 cached, %6 coalesced\n"
+                                        "Poller ticks: %7, %8 overran\n"
+                                        "History memory: %9 KiB for %10 GPUs")
+                                .arg(snapshot.counters[GPUDiagnostics::ProcessSpawns])
+                                .arg(spawnsPerSec, 0, 'f', 1)
+                                .arg(snapshot.counters[GPUDiagnostics::DriverQueries])
+                                .arg(snapshot.counters[GPUDiagnostics::DriverQueryFailures])
+                                .arg(snapshot.counters[GPUDiagnostics::DriverQueryCacheHits])
+                                .arg(snapshot.counters[GPUDiagnostics::DriverQueriesCoalesced])
+                                .arg(snapshot.counters[GPUDiagnostics::PollerTicks])
+                                .arg(snapshot.counters[GPUDiagnostics::TickOverruns])
+                                .arg(historyBytes / 1024)
+                                .arg(this->histories.size()));
+
+    for(int i=0; i < GPUDiagnostics::TimingCount; i++) {
+        QMapIterator<QString, GPUSketch> it(snapshot.timings[i]);
+        while(it.hasNext()) {
+            it.next();
+
+            QTreeWidgetItem *item = this->keyItems[i].value(it.key());
+            if(!item) {
+                item = new QTreeWidgetItem(this->timingItems[i]);
+                item->setText(NameColumn, it.key());
+                this->keyItems[i].insert(it.key(), item);
+            }
+
+            item->setText(CountColumn, QString::number(it.value().getCount()));
+            item->setText(P50Column,   formatMsecs(it.value().getQuantile(0.50)));
+            item->setText(P99Column,   formatMsecs(it.value().getQuantile(0.99)));
+            item->setText(MaxColumn,   formatMsecs(it.value().getMax()));
+        }
+    }
+
+    this->lastSnapshot = snapshot;
+}
+
+/**
+ * Tick to refresh the GUI periodically
+ */
+void GPUDiagnosticsWindow::tick()
+{
+    QTimer::singleShot(REFRESH_MSECS, this, SLOT(tick()));
+
+    this->display();
+}
+
+/**
+ * Clears the values of the whole application
+ */
+void GPUDiagnosticsWindow::resetValues()
+{
+    GPUDiagnostics::reset();
+
+    for(int i=0; i < GPUDiagnostics::TimingCount; i++) {
+        qDeleteAll(this->keyItems[i]);
+        this->keyItems[i].clear();
+    }
+    this->lastSnapshot = GPUDiagnostics::Snapshot();
+
+    this->display();
+}
+
+/**
+ * Asks for a file and writes the values as JSON, like --diagnostics-output
+ */
+void GPUDiagnosticsWindow::exportJson()
+{
+    QString path = QFileDialog::getSaveFileName(this, "Export diagnostics", "gputweak-diagnostics.json", "JSON (*.json)");
+    if(path.isEmpty()) {
+        return;
+    }
+
+    QJsonObject json = GPUDiagnostics::toJson(GPUDiagnostics::snapshot());
+
+    QJsonArray historyBytes;
+    foreach(GPUHistory *history, this->histories) {
+        QJsonObject object;
+        object.insert("gpu", history->getGPU()->getIdentifier());
+        object.insert("bytes", static_cast<double>(history->getMemoryUsage()));
+        historyBytes.append(object);
+    }
+    json.insert("history_bytes", historyBytes);
+
+    QFile file(path);
+    if(!file.open(QIODevice::WriteOnly)) {
+        QMessageBox::warning(this, "Export diagnostics", QString("Cannot write %1").arg(path));
+        return;
+    }
+
+    file.write(QJsonDocument(json).toJson());
+}
+
+/**
+ * Asks for a file and writes the trace spans as Chrome trace-event JSON
+ */
+void GPUDiagnosticsWindow::saveTrace()
+{
+    QString path = QFileDialog::getSaveFileName(this, "Save trace", "gputweak-trace.json", "JSON (*.json)");
+    if(path.isEmpty()) {
+        return;
+    }
+
+    if(!GPUTrace::writeChromeJson(path)) {
+        QMessageBox::warning(this, "Save trace", QString("Cannot write %1").arg(path));
+    }
+}
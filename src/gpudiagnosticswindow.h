@@ -0,0 +1,68 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GPUDIAGNOSTICSWINDOW_H
+#define GPUDIAGNOSTICSWINDOW_H
+
+#include <QWidget>
+#include <QHash>
+#include <QLabel>
+#include <QList>
+#include <QTreeWidget>
+
+#include "gpudiagnostics.h"
+#include "gpuhistory.h"
+
+/**
+ * Window showing what GPUTweak itself costs: driver queries, spawned processes,
+ * poller overruns, render times and memory used by the histories
+ */
+class GPUDiagnosticsWindow : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit GPUDiagnosticsWindow(QList<GPUHistory*> histories, QWidget *parent = 0, Qt::WindowFlags f = 0);
+    ~GPUDiagnosticsWindow();
+
+public slots:
+    void addHistory(GPUHistory *history);
+    void removeHistory(GPUHistory *history);
+
+private:
+    void display();
+
+    QList<GPUHistory*> histories;
+
+    QLabel      *summaryLabel;
+    QTreeWidget *timingsTree;
+
+    // One top level item per family of durations, one child per key
+    QTreeWidgetItem                  *timingItems[GPUDiagnostics::TimingCount];
+    QHash<QString, QTreeWidgetItem*>  keyItems[GPUDiagnostics::TimingCount];
+
+    // Previous snapshot, for the rates
+    GPUDiagnostics::Snapshot lastSnapshot;
+
+private slots:
+    void tick();
+    void resetValues();
+    void exportJson();
+    void saveTrace();
+};
+
+#endif // GPUDIAGNOSTICSWINDOW_H
@@ -0,0 +1,163 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "gpuenergymeter.h"
+
+#include "gputrace.h"
+
+/**
+ * Constant for the number of nsecs in a sec
+ */
+const double NSECS_IN_A_SEC = 1000000000.0;
+
+GPUEnergyMeter::GPUEnergyMeter(GPU *gpu, QObject *parent) :
+    QObject(parent)
+{
+    this->gpu = gpu;
+
+    this->hasSample  = false;
+    this->lastNsecs  = 0;
+    this->lastPower  = 0;
+    this->energy     = 0;
+    this->jobRunning = false;
+    this->jobStartEnergy = 0;
+    this->jobStartNsecs  = 0;
+
+    this->clock.start();
+
+    connect(this->gpu, SIGNAL(updated()), this, SLOT(newValues()));
+}
+
+GPUEnergyMeter::~GPUEnergyMeter()
+{
+    // no-op
+}
+
+GPU *GPUEnergyMeter::getGPU()
+{
+    return this->gpu;
+}
+
+/**
+ * Energy used since the meter was created, up to the last sample
+ * @return Energy in J
+ */
+double GPUEnergyMeter::getEnergy() const
+{
+    return this->energy;
+}
+
+/**
+ * Starts measuring a job, a sample is taken right away
+ * @param name Name given to the report
+ */
+void GPUEnergyMeter::startJob(QString name)
+{
+    this->gpu->fetchVariables(GPU::Power);
+
+    this->job = Job();
+    this->job.name           = name;
+    this->job.start          = QDateTime::currentDateTime();
+    this->job.secs           = 0;
+    this->job.energy         = 0;
+    this->job.peakPower      = this->lastPower;
+    this->job.samples        = this->hasSample ? 1 : 0;
+    this->job.longestGapSecs = 0;
+
+    this->jobStartEnergy = this->energy;
+    this->jobStartNsecs  = this->lastNsecs;
+    this->jobRunning     = true;
+}
+
+/**
+ * Ends the job, a sample is taken right away
+ * @return Report of the job
+ */
+GPUEnergyMeter::Job GPUEnergyMeter::stopJob()
+{
+    if(!this->jobRunning) {
+        return Job();
+    }
+
+    this->gpu->fetchVariables(GPU::Power);
+
+    this->jobRunning = false;
+
+    this->job.end    = QDateTime::currentDateTime();
+    this->job.secs   = (this->lastNsecs - this->jobStartNsecs) / NSECS_IN_A_SEC;
+    this->job.energy = this->energy - this->jobStartEnergy;
+
+    return this->job;
+}
+
+bool GPUEnergyMeter::isJobRunning() const
+{
+    return this->jobRunning;
+}
+
+/**
+ * Average power of a job
+ * @param job
+ * @return Power in W, 0 for an empty job
+ */
+double GPUEnergyMeter::getAveragePower(const Job &job)
+{
+    return job.secs > 0 ? job.energy / job.secs : 0;
+}
+
+/**
+ * Integrates a power sample
+ * @param nsecs Time of the sample on a monotonic clock
+ * @param watts Power drawn
+ */
+void GPUEnergyMeter::addSample(qint64 nsecs, double watts)
+{
+    if(this->hasSample && nsecs > this->lastNsecs) {
+        double secs = (nsecs - this->lastNsecs) / NSECS_IN_A_SEC;
+
+        this->energy += (this->lastPower + watts) / 2 * secs;
+
+        if(this->jobRunning) {
+            this->job.longestGapSecs = qMax(this->job.longestGapSecs, secs);
+        }
+    }
+
+    if(!this->hasSample && this->jobRunning) {
+        // First sample ever, the job starts there
+        this->jobStartNsecs = nsecs;
+    }
+
+    this->hasSample = true;
+    this->lastNsecs = nsecs;
+    this->lastPower = watts;
+
+    if(this->jobRunning) {
+        this->job.peakPower = qMax(this->job.peakPower, watts);
+        this->job.samples++;
+    }
+}
+
+void GPUEnergyMeter::newValues()
+{
+    if(!(this->gpu->getUpdatedMetrics() & GPU::Power) || !this->gpu->isPowerDrawAvailable()) {
+        return;
+    }
+
+    GPUTWEAK_TRACE_SCOPE("GPUEnergyMeter::newValues");
+
+    this->addSample(this->clock.nsecsElapsed(), this->gpu->getCurrentPowerDraw());
+}
@@ -0,0 +1,87 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GPUENERGYMETER_H
+#define GPUENERGYMETER_H
+
+#include <QObject>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QString>
+
+#include "gpu.h"
+
+/**
+ * Energy used by a GPU, integrated from its power draw samples
+ * The power is taken as linear between two samples (trapezoidal rule) over the time that actually
+ * separates them, so the result stays right when the polling rate changes
+ * A job measures the energy between a start and a stop marker, a sample is taken at both so the
+ * interval is measured exactly instead of being rounded to the surrounding samples
+ */
+class GPUEnergyMeter : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * Energy report of a job
+     */
+    struct Job {
+        QString   name;
+        QDateTime start;
+        QDateTime end;            // invalid while the job runs
+        double    secs;
+        double    energy;         // J
+        double    peakPower;      // W
+        int       samples;
+        double    longestGapSecs; // longest time between two samples, the larger the less precise
+    };
+
+    explicit GPUEnergyMeter(GPU *gpu, QObject *parent = 0);
+    ~GPUEnergyMeter();
+
+    GPU *getGPU();
+
+    double getEnergy() const;
+
+    void startJob(QString name);
+    Job  stopJob();
+    bool isJobRunning() const;
+
+    static double getAveragePower(const Job &job);
+
+    void addSample(qint64 nsecs, double watts);
+
+private:
+    GPU *gpu;
+
+    QElapsedTimer clock;
+    bool          hasSample;
+    qint64        lastNsecs;
+    double        lastPower;  // W
+    double        energy;     // J since the meter was created
+
+    bool   jobRunning;
+    Job    job;
+    double jobStartEnergy;    // J
+    qint64 jobStartNsecs;
+
+private slots:
+    void newValues();
+};
+
+#endif // GPUENERGYMETER_H
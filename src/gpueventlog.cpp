@@ -0,0 +1,230 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "gpueventlog.h"
+
+#include <QFile>
+#include <QTextStream>
+
+/**
+ * Number of events kept in memory, the oldest finished ones are dropped first
+ */
+const int MAX_EVENTS = 1000;
+/**
+ * Severity from which an event is considered medium and high
+ */
+const int SEVERITY_MEDIUM = 20;
+const int SEVERITY_HIGH   = 40;
+
+GPUEventLog::GPUEventLog(QObject *parent) :
+    QObject(parent)
+{
+    this->nextId = 0;
+}
+
+GPUEventLog::~GPUEventLog()
+{
+    // no-op
+}
+
+QString GPUEventLog::getTypeName(Type type)
+{
+    switch(type) {
+    case ThermalThrottle:
+        return "Thermal throttle";
+    case ClockThrottle:
+        return "Clock throttle";
+    case PcieDegraded:
+        return "PCI-E link degraded";
+    }
+
+    return "Unknown";
+}
+
+QString GPUEventLog::getSeverityName(int severity)
+{
+    if(severity >= SEVERITY_HIGH) {
+        return "high";
+    }
+
+    return severity >= SEVERITY_MEDIUM ? "medium" : "low";
+}
+
+/**
+ * Records the start of an event
+ * @param gpu      GPU concerned
+ * @param type     Kind of event
+ * @param start    Time the event started
+ * @param severity 0-100
+ * @param details  Human readable values
+ * @return Identifier to update and end the event
+ */
+int GPUEventLog::begin(GPU *gpu, Type type, QDateTime start, int severity, QString details)
+{
+    Event event;
+    event.id       = this->nextId++;
+    event.gpuIdentifier = gpu->getIdentifier();
+    event.busId         = gpu->getBusId();
+    event.type     = type;
+    event.start    = start;
+    event.severity = severity;
+    event.details  = details;
+
+    this->events.append(event);
+
+    if(this->events.size() > MAX_EVENTS) {
+        for(int i=0; i < this->events.size(); i++) {
+            if(this->events.at(i).end.isValid()) {
+                this->events.removeAt(i);
+                break;
+            }
+        }
+    }
+
+    emit changed();
+
+    return event.id;
+}
+
+/**
+ * Changes an event that goes on, ex: when it gets worse
+ * @param id       Identifier given by begin()
+ * @param type     Kind of event
+ * @param severity 0-100
+ * @param details  Human readable values
+ */
+void GPUEventLog::update(int id, Type type, int severity, QString details)
+{
+    Event *event = this->find(id);
+    if(!event) {
+        return;
+    }
+
+    event->type     = type;
+    event->severity = severity;
+    event->details  = details;
+
+    emit changed();
+}
+
+/**
+ * Records the end of an event
+ * @param id  Identifier given by begin()
+ * @param end Time the event ended
+ */
+void GPUEventLog::end(int id, QDateTime end)
+{
+    Event *event = this->find(id);
+    if(!event) {
+        return;
+    }
+
+    event->end = end;
+
+    emit changed();
+}
+
+/**
+ * Ends the ongoing events of a GPU, ex: when it is unplugged
+ * @param gpu
+ * @param end Time the events ended
+ */
+void GPUEventLog::endAll(GPU *gpu, QDateTime end)
+{
+    bool ended = false;
+
+    for(int i=0; i < this->events.size(); i++) {
+        Event &event = this->events[i];
+
+        if(event.busId == gpu->getBusId() && !event.end.isValid()) {
+            event.end = end;
+            ended = true;
+        }
+    }
+
+    if(ended) {
+        emit changed();
+    }
+}
+
+/**
+ * Looks for an event, the ongoing ones are the most recent
+ * @param id Identifier given by begin()
+ * @return Event, 0 if it was dropped
+ */
+GPUEventLog::Event *GPUEventLog::find(int id)
+{
+    for(int i=this->events.size() - 1; i >= 0; i--) {
+        if(this->events.at(i).id == id) {
+            return &this->events[i];
+        }
+    }
+
+    return 0;
+}
+
+const QList<GPUEventLog::Event> &GPUEventLog::getEvents() const
+{
+    return this->events;
+}
+
+/**
+ * Events of a single GPU, including the ones from before it was unplugged
+ * @param gpu
+ * @return Events, oldest first
+ */
+QList<GPUEventLog::Event> GPUEventLog::getEvents(GPU *gpu) const
+{
+    QList<Event> list;
+
+    foreach(const Event &event, this->events) {
+        if(event.busId == gpu->getBusId()) {
+            list.append(event);
+        }
+    }
+
+    return list;
+}
+
+/**
+ * Writes all the events as CSV
+ * @param path File to write
+ * @return False if the file cannot be written
+ */
+bool GPUEventLog::exportCsv(QString path) const
+{
+    QFile file(path);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        return false;
+    }
+
+    QTextStream out(&file);
+    out << "gpu,bus_id,type,start,end,duration_s,severity,details\n";
+
+    foreach(const Event &event, this->events) {
+        out << "\"" << event.gpuIdentifier << "\""
+            << ",\"" << event.busId << "\""
+            << ",\"" << GPUEventLog::getTypeName(event.type) << "\""
+            << "," << event.start.toString(Qt::ISODate)
+            << "," << (event.end.isValid() ? event.end.toString(Qt::ISODate) : QString())
+            << "," << (event.end.isValid() ? QString::number(event.start.msecsTo(event.end) / 1000.0, 'f', 1) : QString())
+            << "," << event.severity
+            << ",\"" << QString(event.details).replace("\"", "\"\"") << "\"\n";
+    }
+
+    return true;
+}
@@ -0,0 +1,83 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GPUEVENTLOG_H
+#define GPUEVENTLOG_H
+
+#include <QObject>
+#include <QDateTime>
+#include <QList>
+#include <QString>
+
+#include "gpu.h"
+
+/**
+ * Log of the notable events detected on the GPUs, shared by all the windows
+ * An event has a start and, once it is over, an end
+ */
+class GPUEventLog : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Type {
+        ThermalThrottle, // clock dropped under load while the card is hot
+        ClockThrottle,   // clock dropped under load for another reason, usually the power limit
+        PcieDegraded     // PCI-E link narrower or slower than the card supports while busy
+    };
+
+    struct Event {
+        int       id;
+        QString   gpuIdentifier; // copied, the GPU may be unplugged since
+        QString   busId;
+        Type      type;
+        QDateTime start;
+        QDateTime end;      // invalid while the event goes on
+        int       severity; // 0-100, ex: % of clock or bandwidth lost
+        QString   details;
+    };
+
+    explicit GPUEventLog(QObject *parent = 0);
+    ~GPUEventLog();
+
+    static QString getTypeName(Type type);
+    static QString getSeverityName(int severity);
+
+    int  begin(GPU *gpu, Type type, QDateTime start, int severity, QString details);
+    void update(int id, Type type, int severity, QString details);
+    void end(int id, QDateTime end);
+    void endAll(GPU *gpu, QDateTime end);
+
+    const QList<Event> &getEvents() const;
+    QList<Event>        getEvents(GPU *gpu) const;
+
+    bool exportCsv(QString path) const;
+
+signals:
+    /**
+     * Emitted when an event begins, changes or ends
+     */
+    void changed();
+
+private:
+    Event *find(int id);
+
+    QList<Event> events; // oldest first
+    int          nextId;
+};
+
+#endif // GPUEVENTLOG_H
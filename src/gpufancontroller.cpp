@@ -0,0 +1,369 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "gpufancontroller.h"
+
+#include "gputrace.h"
+
+/**
+ * Time between two temperature samples used by the controller
+ */
+const int CONTROL_INTERVAL_MSECS = 1000;
+/**
+ * Constant for the number of msecs in a sec
+ */
+const double MSEC_IN_A_SEC = 1000.0;
+/**
+ * PID gains, tuned on the simulated card: proportional (%/°C), integral
+ * (%/°C/s) and derivative (%/(°C/s))
+ */
+const double PID_KP = 6.0;
+const double PID_KI = 0.3;
+const double PID_KD = 10.0;
+/**
+ * Limits of the fan speed given by the PID, in %
+ * Some fans stall below the minimum
+ */
+const double PID_OUTPUT_MIN = 20.0;
+const double PID_OUTPUT_MAX = 100.0;
+/**
+ * Default target temperature, in °C
+ */
+const int PID_DEFAULT_TARGET = 70;
+/**
+ * The PID output is already smooth, it only skips the writes that would not change anything
+ */
+const int PID_DEADBAND = 1;
+
+/**
+ * Gives a reasonable curve, silent when idle and full speed before throttling
+ * @return Curve
+ */
+GPUFanCurve GPUFanCurve::defaultCurve()
+{
+    GPUFanCurve curve;
+    curve.points << QPoint(30, 30) << QPoint(50, 40) << QPoint(65, 60) << QPoint(75, 80) << QPoint(85, 100);
+    curve.hysteresis     = 3;
+    curve.rampUpPerSec   = 10;
+    curve.rampDownPerSec = 3;
+    curve.deadband       = 3;
+
+    return curve;
+}
+
+/**
+ * Interpolates the speed for a temperature
+ * @param temp Core temp in °C
+ * @return Fan speed in %
+ */
+int GPUFanCurve::getSpeed(int temp) const
+{
+    if(this->points.isEmpty()) {
+        return 100;
+    }
+
+    if(temp <= this->points.first().x()) {
+        return this->points.first().y();
+    }
+
+    for(int i=1; i < this->points.size(); i++) {
+        QPoint previous = this->points.at(i-1);
+        QPoint next     = this->points.at(i);
+
+        if(temp <= next.x()) {
+            if(next.x() == previous.x()) {
+                return next.y();
+            }
+
+            return previous.y() + (next.y() - previous.y()) * (temp - previous.x()) / (next.x() - previous.x());
+        }
+    }
+
+    return this->points.last().y();
+}
+
+GPUFanPid::GPUFanPid()
+{
+    this->target       = PID_DEFAULT_TARGET;
+    this->integral     = PID_OUTPUT_MIN;
+    this->previousTemp = -1;
+}
+
+int GPUFanPid::getTarget() const
+{
+    return this->target;
+}
+
+void GPUFanPid::setTarget(int temp)
+{
+    this->target = temp;
+}
+
+/**
+ * Forgets the history of the controller
+ * @param output Speed the controller starts from, usually the current one so the switch is bumpless
+ */
+void GPUFanPid::reset(double output)
+{
+    this->integral     = qBound(PID_OUTPUT_MIN, output, PID_OUTPUT_MAX);
+    this->previousTemp = -1;
+}
+
+/**
+ * Computes the fan speed for a new temperature sample
+ * The derivative is taken on the temperature rather than on the error so a
+ * change of the target does not kick the fan, and the integral stops growing
+ * while the output is saturated (anti-windup)
+ * @param temp Core temp in °C
+ * @param elapsedSecs Time since the previous sample
+ * @return Fan speed in %
+ */
+double GPUFanPid::step(int temp, double elapsedSecs)
+{
+    double error      = temp - this->target;
+    double derivative = 0;
+
+    if(this->previousTemp >= 0 && elapsedSecs > 0) {
+        derivative = (temp - this->previousTemp) / elapsedSecs;
+    }
+    this->previousTemp = temp;
+
+    double integral = this->integral + PID_KI * error * elapsedSecs;
+    double output   = PID_KP * error + integral + PID_KD * derivative;
+
+    bool saturatedHigh = output > PID_OUTPUT_MAX && error > 0;
+    bool saturatedLow  = output < PID_OUTPUT_MIN && error < 0;
+
+    if(!saturatedHigh && !saturatedLow) {
+        this->integral = qBound(PID_OUTPUT_MIN, integral, PID_OUTPUT_MAX);
+    }
+
+    return qBound(PID_OUTPUT_MIN, PID_KP * error + this->integral + PID_KD * derivative, PID_OUTPUT_MAX);
+}
+
+GPUFanController::GPUFanController(GPU *gpu, GPUPoller *poller, QObject *parent) :
+    QObject(parent)
+{
+    this->gpu            = gpu;
+    this->poller         = poller;
+    this->curve          = GPUFanCurve::defaultCurve();
+    this->mode           = CurveMode;
+    this->enabled        = false;
+    this->subscriptionId = 0;
+    this->effectiveTemp  = -1;
+    this->commandedSpeed = 0;
+    this->writtenSpeed   = -1;
+    this->writeCount     = 0;
+}
+
+/**
+ * Gives the fan back to the driver if it is still driven
+ * A fan left in manual mode would keep its last speed with nothing watching the temperature
+ * The GPU may already be deleted on exit, the subscription ends with the controller
+ */
+GPUFanController::~GPUFanController()
+{
+    if(this->enabled && this->gpu) {
+        this->gpu->setFanControlEnabled(false);
+    }
+}
+
+GPU *GPUFanController::getGPU()
+{
+    return this->gpu;
+}
+
+GPUFanCurve GPUFanController::getCurve()
+{
+    return this->curve;
+}
+
+void GPUFanController::setCurve(GPUFanCurve curve)
+{
+    this->curve = curve;
+}
+
+GPUFanController::Mode GPUFanController::getMode()
+{
+    return this->mode;
+}
+
+void GPUFanController::setMode(Mode mode)
+{
+    if(mode != this->mode) {
+        this->mode = mode;
+        this->resetState();
+    }
+}
+
+int GPUFanController::getTargetTemp()
+{
+    return this->pid.getTarget();
+}
+
+void GPUFanController::setTargetTemp(int temp)
+{
+    this->pid.setTarget(temp);
+}
+
+bool GPUFanController::isEnabled()
+{
+    return this->enabled;
+}
+
+/**
+ * Starts or stops driving the fan
+ * The fan is given back to the driver when stopped
+ * @param enabled
+ */
+void GPUFanController::setEnabled(bool enabled)
+{
+    if(enabled == this->enabled) {
+        return;
+    }
+
+    this->enabled = enabled;
+
+    if(enabled) {
+        this->gpu->setFanControlEnabled(true);
+        this->resetState();
+
+        connect(this->gpu, SIGNAL(updated()), this, SLOT(step()));
+        this->subscriptionId = this->poller->subscribe(this, this->gpu, GPU::CoreTemp, CONTROL_INTERVAL_MSECS);
+    } else {
+        this->poller->unsubscribe(this->subscriptionId);
+        disconnect(this->gpu, SIGNAL(updated()), this, SLOT(step()));
+
+        this->gpu->setFanControlEnabled(false);
+    }
+}
+
+/**
+ * Number of speeds written to the driver since the creation of the controller
+ * @return Count
+ */
+int GPUFanController::getWriteCount()
+{
+    return this->writeCount;
+}
+
+/**
+ * Starts the control loop again from the current fan speed
+ */
+void GPUFanController::resetState()
+{
+    this->effectiveTemp  = -1;
+    this->writtenSpeed   = -1;
+    this->commandedSpeed = this->gpu->getCurrentFanSpeed();
+    this->pid.reset(this->commandedSpeed);
+    this->lastStep.invalidate();
+}
+
+/**
+ * Runs the control loop on the last fetched temperature
+ * Its timing only depends on its own subscription to the poller, not on the windows
+ * Writing the speed refreshes the fan speed of the GPU and emits updated() again, so it
+ * waits for this emission to finish, or the handlers after this one would only see FanSpeed
+ */
+void GPUFanController::step()
+{
+    GPUTWEAK_TRACE_SCOPE("GPUFanController::step");
+
+    if(!(this->gpu->getUpdatedMetrics() & GPU::CoreTemp)) {
+        return;
+    }
+
+    double elapsedSecs = CONTROL_INTERVAL_MSECS / MSEC_IN_A_SEC;
+    if(this->lastStep.isValid()) {
+        elapsedSecs = this->lastStep.restart() / MSEC_IN_A_SEC;
+    } else {
+        this->lastStep.start();
+    }
+
+    QMetaObject::invokeMethod(this, "processStep", Qt::QueuedConnection,
+                              Q_ARG(int, this->gpu->getCurrentCoreTemp()), Q_ARG(double, elapsedSecs));
+}
+
+/**
+ * Processes a sample queued by step(), unless the controller was stopped meanwhile
+ * @param temp Core temp in °C
+ * @param elapsedSecs Time since the previous sample
+ */
+void GPUFanController::processStep(int temp, double elapsedSecs)
+{
+    if(!this->enabled || !this->gpu) {
+        return;
+    }
+
+    this->process(temp, elapsedSecs);
+}
+
+/**
+ * Computes the new speed for a temperature sample and writes it if needed
+ * @param temp Core temp in °C
+ * @param elapsedSecs Time since the previous sample
+ */
+void GPUFanController::process(int temp, double elapsedSecs)
+{
+    if(this->mode == TargetTempMode) {
+        int speed = qRound(this->pid.step(temp, elapsedSecs));
+
+        if(this->writtenSpeed < 0 || qAbs(speed - this->writtenSpeed) > PID_DEADBAND) {
+            this->writeSpeed(speed);
+        }
+
+        return;
+    }
+
+    // Hysteresis: going up follows the temperature, going down waits for a drop of "hysteresis" degrees
+    if(this->effectiveTemp < 0 || temp > this->effectiveTemp) {
+        this->effectiveTemp = temp;
+    } else if(temp < this->effectiveTemp - this->curve.hysteresis) {
+        this->effectiveTemp = temp + this->curve.hysteresis;
+    }
+
+    int target = this->curve.getSpeed(this->effectiveTemp);
+
+    if(target > this->commandedSpeed) {
+        this->commandedSpeed = qMin(static_cast<double>(target), this->commandedSpeed + this->curve.rampUpPerSec * elapsedSecs);
+    } else {
+        this->commandedSpeed = qMax(static_cast<double>(target), this->commandedSpeed - this->curve.rampDownPerSec * elapsedSecs);
+    }
+
+    int speed = qRound(this->commandedSpeed);
+    int maxSpeed = this->curve.points.isEmpty() ? 100 : this->curve.getSpeed(this->curve.points.last().x());
+
+    if(this->writtenSpeed < 0
+            || qAbs(speed - this->writtenSpeed) > this->curve.deadband
+            || (speed == maxSpeed && this->writtenSpeed != maxSpeed)) {
+        this->writeSpeed(speed);
+    }
+}
+
+/**
+ * Sends a speed to the driver
+ * @param speed Fan speed in %
+ */
+void GPUFanController::writeSpeed(int speed)
+{
+    this->gpu->setFanSpeed(speed);
+
+    this->writtenSpeed = speed;
+    this->writeCount++;
+
+    emit speedWritten(speed);
+}
@@ -0,0 +1,129 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GPUFANCONTROLLER_H
+#define GPUFANCONTROLLER_H
+
+#include <QObject>
+#include <QList>
+#include <QPoint>
+#include <QPointer>
+#include <QElapsedTimer>
+
+#include "gpu.h"
+#include "gpupoller.h"
+
+/**
+ * Temperature to fan speed curve along with the parameters of its controller
+ */
+struct GPUFanCurve {
+    QList<QPoint> points; // x: core temp in °C, y: fan speed in %, sorted by temp
+    int hysteresis;       // °C the temperature must drop before the speed goes down
+    int rampUpPerSec;     // max increase of the speed, %/s
+    int rampDownPerSec;   // max decrease of the speed, %/s
+    int deadband;         // % the speed must move before it is written to the driver
+
+    static GPUFanCurve defaultCurve();
+
+    int getSpeed(int temp) const;
+};
+
+/**
+ * PID controller computing the fan speed holding a target temperature
+ * Time is given by the caller so it can run on simulated time
+ */
+class GPUFanPid
+{
+public:
+    GPUFanPid();
+
+    int    getTarget() const;
+    void   setTarget(int temp);
+
+    void   reset(double output);
+    double step(int temp, double elapsedSecs);
+
+private:
+    int    target;       // °C
+    double integral;     // integral term, in % of fan speed
+    int    previousTemp; // for the derivative term, -1 before the first sample
+};
+
+/**
+ * Drives the fan speed of a GPU from its temperature
+ * Runs on the temperatures fetched by the poller, and only writes to the driver
+ * when the target moved by more than the deadband
+ */
+class GPUFanController : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Mode {
+        CurveMode,     // speed given by the curve
+        TargetTempMode // speed given by the PID to hold a temperature
+    };
+
+    GPUFanController(GPU *gpu, GPUPoller *poller, QObject *parent = 0);
+    ~GPUFanController();
+
+    GPU         *getGPU();
+    GPUFanCurve  getCurve();
+    void         setCurve(GPUFanCurve curve);
+
+    Mode         getMode();
+    void         setMode(Mode mode);
+    int          getTargetTemp();
+    void         setTargetTemp(int temp);
+
+    bool         isEnabled();
+    void         setEnabled(bool enabled);
+
+    int          getWriteCount();
+
+    void         process(int temp, double elapsedSecs);
+
+signals:
+    /**
+     * Emitted when a new speed has been written
+     */
+    void speedWritten(int speed);
+
+private:
+    void resetState();
+    void writeSpeed(int speed);
+
+    QPointer<GPU> gpu; // cleared if the GPU is deleted first, ex: on exit
+    GPUPoller   *poller;
+    GPUFanCurve  curve;
+    GPUFanPid    pid;
+    Mode         mode;
+    bool         enabled;
+    int          subscriptionId;
+
+    int           effectiveTemp;  // temperature after hysteresis, -1 before the first sample
+    double        commandedSpeed; // speed after ramp limits
+    int           writtenSpeed;   // last speed written to the driver, -1 if none
+    int           writeCount;
+    QElapsedTimer lastStep;
+
+private slots:
+    void step();
+    void processStep(int temp, double elapsedSecs);
+};
+
+#endif // GPUFANCONTROLLER_H
@@ -0,0 +1,248 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "gpufancurveeditor.h"
+
+#include <QPainter>
+#include <QMouseEvent>
+
+/**
+ * Temperature range shown on the horizontal axis, in °C
+ */
+const int TEMP_MIN = 20;
+const int TEMP_MAX = 100;
+/**
+ * Margin around the plot, leaves room for the axis labels
+ */
+const int PLOT_MARGIN = 24;
+/**
+ * Radius of the point handles, also used as the grab distance
+ */
+const int HANDLE_RADIUS = 5;
+/**
+ * A curve needs at least this many points to stay meaningful
+ */
+const int MIN_POINTS = 2;
+
+GPUFanCurveEditor::GPUFanCurveEditor(QWidget *parent) :
+    QWidget(parent)
+{
+    this->dragged = -1;
+    this->points  = GPUFanCurve::defaultCurve().points;
+
+    this->setMinimumHeight(150);
+}
+
+QList<QPoint> GPUFanCurveEditor::getPoints()
+{
+    return this->points;
+}
+
+void GPUFanCurveEditor::setPoints(QList<QPoint> points)
+{
+    this->points  = points;
+    this->dragged = -1;
+
+    this->update();
+}
+
+QSize GPUFanCurveEditor::sizeHint() const
+{
+    return QSize(400, 200);
+}
+
+/**
+ * Area in which the curve is drawn
+ * @return
+ */
+QRect GPUFanCurveEditor::plotArea() const
+{
+    return this->rect().adjusted(PLOT_MARGIN, HANDLE_RADIUS * 2, -HANDLE_RADIUS * 2, -PLOT_MARGIN);
+}
+
+/**
+ * Converts a curve point to widget coordinates
+ * @param point Temperature and speed
+ * @return
+ */
+QPointF GPUFanCurveEditor::toScreen(QPoint point) const
+{
+    QRect area = this->plotArea();
+
+    return QPointF(area.left() + area.width() * (point.x() - TEMP_MIN) / double(TEMP_MAX - TEMP_MIN),
+                   area.bottom() - area.height() * point.y() / 100.0);
+}
+
+/**
+ * Converts widget coordinates to a curve point
+ * @param position
+ * @return Temperature and speed, clamped to the axis
+ */
+QPoint GPUFanCurveEditor::fromScreen(QPoint position) const
+{
+    QRect area = this->plotArea();
+
+    int temp  = TEMP_MIN + qRound((position.x() - area.left()) * (TEMP_MAX - TEMP_MIN) / double(area.width()));
+    int speed = qRound((area.bottom() - position.y()) * 100.0 / area.height());
+
+    return QPoint(qBound(TEMP_MIN, temp, TEMP_MAX), qBound(0, speed, 100));
+}
+
+/**
+ * Finds the point under the cursor
+ * @param position
+ * @return Index in the list or -1
+ */
+int GPUFanCurveEditor::pointAt(QPoint position) const
+{
+    for(int i=0; i < this->points.size(); i++) {
+        QPointF delta = this->toScreen(this->points.at(i)) - position;
+
+        if(delta.manhattanLength() <= HANDLE_RADIUS * 2) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+void GPUFanCurveEditor::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+
+    QPainter painter(this);
+    painter.setRenderHint(QPainter::Antialiasing);
+
+    QRect area = this->plotArea();
+
+    painter.fillRect(area, this->palette().base());
+
+    // Grid every 10°C and 20%
+    painter.setPen(QPen(this->palette().mid().color(), 0, Qt::DotLine));
+    for(int temp = TEMP_MIN; temp <= TEMP_MAX; temp += 10) {
+        QPointF top = this->toScreen(QPoint(temp, 100));
+        painter.drawLine(top, QPointF(top.x(), area.bottom()));
+        painter.drawText(QRectF(top.x() - PLOT_MARGIN, area.bottom(), PLOT_MARGIN * 2, PLOT_MARGIN), Qt::AlignCenter, QString::number(temp));
+    }
+    for(int speed = 0; speed <= 100; speed += 20) {
+        QPointF left = this->toScreen(QPoint(TEMP_MIN, speed));
+        painter.drawLine(left, QPointF(area.right(), left.y()));
+        painter.drawText(QRectF(0, left.y() - PLOT_MARGIN / 2, PLOT_MARGIN - 2, PLOT_MARGIN), Qt::AlignRight | Qt::AlignVCenter, QString::number(speed));
+    }
+
+    if(this->points.isEmpty()) {
+        return;
+    }
+
+    // The curve is flat before the first and after the last point
+    QVector<QPointF> line;
+    line << this->toScreen(QPoint(TEMP_MIN, this->points.first().y()));
+    foreach(QPoint point, this->points) {
+        line << this->toScreen(point);
+    }
+    line << this->toScreen(QPoint(TEMP_MAX, this->points.last().y()));
+
+    painter.setPen(QPen(this->palette().highlight().color(), 2));
+    painter.drawPolyline(line.constData(), line.size());
+
+    painter.setBrush(this->palette().highlight());
+    for(int i=0; i < this->points.size(); i++) {
+        painter.drawEllipse(this->toScreen(this->points.at(i)), HANDLE_RADIUS, HANDLE_RADIUS);
+    }
+
+    if(this->dragged >= 0) {
+        QPoint point = this->points.at(this->dragged);
+        painter.setPen(this->palette().text().color());
+        painter.drawText(this->toScreen(point) + QPointF(HANDLE_RADIUS * 2, -HANDLE_RADIUS * 2), QString("%1°C %2%").arg(point.x()).arg(point.y()));
+    }
+}
+
+void GPUFanCurveEditor::mousePressEvent(QMouseEvent *event)
+{
+    int index = this->pointAt(event->pos());
+
+    if(index < 0) {
+        return;
+    }
+
+    if(event->button() == Qt::RightButton) {
+        if(this->points.size() > MIN_POINTS) {
+            this->points.removeAt(index);
+            this->update();
+
+            emit curveChanged();
+        }
+    } else if(event->button() == Qt::LeftButton) {
+        this->dragged = index;
+        this->update();
+    }
+}
+
+void GPUFanCurveEditor::mouseMoveEvent(QMouseEvent *event)
+{
+    if(this->dragged < 0) {
+        return;
+    }
+
+    QPoint point = this->fromScreen(event->pos());
+
+    // Points keep their order so the curve stays a function of the temperature
+    if(this->dragged > 0) {
+        point.setX(qMax(point.x(), this->points.at(this->dragged - 1).x() + 1));
+    }
+    if(this->dragged < this->points.size() - 1) {
+        point.setX(qMin(point.x(), this->points.at(this->dragged + 1).x() - 1));
+    }
+
+    if(point != this->points.at(this->dragged)) {
+        this->points[this->dragged] = point;
+        this->update();
+
+        emit curveChanged();
+    }
+}
+
+void GPUFanCurveEditor::mouseReleaseEvent(QMouseEvent *event)
+{
+    Q_UNUSED(event);
+
+    this->dragged = -1;
+    this->update();
+}
+
+void GPUFanCurveEditor::mouseDoubleClickEvent(QMouseEvent *event)
+{
+    if(event->button() != Qt::LeftButton || this->pointAt(event->pos()) >= 0) {
+        return;
+    }
+
+    QPoint point = this->fromScreen(event->pos());
+
+    int index = 0;
+    while(index < this->points.size() && this->points.at(index).x() < point.x()) {
+        index++;
+    }
+
+    if(index < this->points.size() && this->points.at(index).x() == point.x()) {
+        return;
+    }
+
+    this->points.insert(index, point);
+    this->update();
+
+    emit curveChanged();
+}
@@ -0,0 +1,64 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GPUFANCURVEEDITOR_H
+#define GPUFANCURVEEDITOR_H
+
+#include <QWidget>
+
+#include "gpufancontroller.h"
+
+/**
+ * Widget to edit the points of a fan curve
+ * Drag a point to move it, double click to add one and right click to remove one
+ */
+class GPUFanCurveEditor : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit GPUFanCurveEditor(QWidget *parent = 0);
+
+    QList<QPoint> getPoints();
+    void          setPoints(QList<QPoint> points);
+
+    QSize sizeHint() const;
+
+signals:
+    /**
+     * Emitted when the user changed the curve
+     */
+    void curveChanged();
+
+protected:
+    void paintEvent(QPaintEvent *event);
+    void mousePressEvent(QMouseEvent *event);
+    void mouseMoveEvent(QMouseEvent *event);
+    void mouseReleaseEvent(QMouseEvent *event);
+    void mouseDoubleClickEvent(QMouseEvent *event);
+
+private:
+    QRect   plotArea() const;
+    QPointF toScreen(QPoint point) const;
+    QPoint  fromScreen(QPoint position) const;
+    int     pointAt(QPoint position) const;
+
+    QList<QPoint> points;
+    int           dragged;
+};
+
+#endif // GPUFANCURVEEDITOR_H
@@ -0,0 +1,264 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "gpuhistory.h"
+
+#include <QDateTime>
+
+#include "gputrace.h"
+
+/**
+ * Number of seconds of history kept in memory
+ */
+const int HISTORY_LENGTH_SECS = 60;
+/**
+ * Time between cleanups of the memory
+ */
+const int CLEAN_AFTER_SECS = HISTORY_LENGTH_SECS / 2;
+/**
+ * Constant for the number of msecs in a sec
+ */
+const int MSEC_IN_A_SEC = 1000;
+/**
+ * Longest gap between two performance level samples that is credited to a level,
+ * about two polling intervals of the stats window. A longer gap means nobody was
+ * polling the level, so what the card did meanwhile is unknown
+ */
+const int PERF_LEVEL_MAX_GAP_MSECS = 5000;
+
+GPUHistory::GPUHistory(GPU *gpu, QObject *parent) :
+    QObject(parent),
+    quantiles(SeriesCount)
+{
+    this->gpu = gpu;
+    this->lastPerfLevel = -1;
+
+    connect(this->gpu, SIGNAL(updated()), this, SLOT(newValues()));
+
+    this->lastCleanup.start();
+}
+
+GPUHistory::~GPUHistory()
+{
+    // no-op
+}
+
+GPU *GPUHistory::getGPU()
+{
+    return this->gpu;
+}
+
+/**
+ * Continues the history with another GPU object, used when an unplugged card comes back
+ * The time spent away is not counted in any performance level
+ * @param gpu 0 while the card is unplugged
+ */
+void GPUHistory::setGPU(GPU *gpu)
+{
+    if(this->gpu) {
+        disconnect(this->gpu, SIGNAL(updated()), this, SLOT(newValues()));
+    }
+
+    this->gpu = gpu;
+    this->lastPerfLevel = -1;
+
+    if(this->gpu) {
+        connect(this->gpu, SIGNAL(updated()), this, SLOT(newValues()));
+    }
+}
+
+/**
+ * Gives the stored values of a series, oldest first
+ * @param series Series to read
+ * @return List of values
+ */
+const QList<GPUHistory::HistoryValue> &GPUHistory::getValues(Series series) const
+{
+    return this->values[series];
+}
+
+/**
+ * Metric fetching the values of a series
+ * @param series
+ * @return Metric
+ */
+GPU::Metric GPUHistory::getSeriesMetric(Series series)
+{
+    switch(series) {
+    case CoreTemp:
+        return GPU::CoreTemp;
+    case CoreUse:
+    case MemoryUse:
+        return GPU::Utilization;
+    case FanSpeed:
+        return GPU::FanSpeed;
+    case CoreClock:
+    case MemoryClock:
+        return GPU::Clocks;
+    case PcieLinkWidth:
+    case PcieLinkGen:
+        return GPU::PcieLink;
+    case PowerDraw:
+        return GPU::Power;
+    default:
+        return GPU::AllMetrics;
+    }
+}
+
+/**
+ * Stores the current values of the GPU
+ * Only the series refreshed by the last fetch are recorded
+ * @param time Time to associate with the values
+ */
+void GPUHistory::record(QTime time)
+{
+    GPU::Metrics updated = this->gpu->getUpdatedMetrics();
+    if(!this->gpu->isPowerDrawAvailable()) {
+        updated &= ~GPU::Metrics(GPU::Power);
+    }
+
+    int current[SeriesCount];
+    current[CoreTemp]    = this->gpu->getCurrentCoreTemp();
+    current[CoreUse]     = this->gpu->getCurrentCoreUse();
+    current[MemoryUse]   = this->gpu->getCurrentMemoryUse();
+    current[FanSpeed]    = this->gpu->getCurrentFanSpeed();
+    current[CoreClock]   = this->gpu->getCurrentCoreClock();
+    current[MemoryClock] = this->gpu->getCurrentMemoryClock();
+    current[PcieLinkWidth] = this->gpu->getPcieLinkWidth();
+    current[PcieLinkGen]   = this->gpu->getPcieLinkGen();
+    current[PowerDraw]     = qRound(this->gpu->getCurrentPowerDraw());
+
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+
+    for(int i=0; i < SeriesCount; i++) {
+        if(!(updated & GPUHistory::getSeriesMetric(static_cast<Series>(i)))) {
+            continue;
+        }
+
+        HistoryValue value;
+        value.time  = time;
+        value.value = current[i];
+        this->values[i].append(value);
+
+        this->quantiles.add(i, now, current[i]);
+    }
+
+    if(updated & GPU::PerfLevel) {
+        this->recordPerfLevel();
+    }
+
+    if(this->lastCleanup.elapsed() > CLEAN_AFTER_SECS * MSEC_IN_A_SEC) {
+        this->cleanValues(time);
+        this->lastCleanup.restart();
+    }
+
+    emit recorded();
+}
+
+/**
+ * Adds the time since the previous sample to the level the card was in,
+ * unless the samples are too far apart to tell, see PERF_LEVEL_MAX_GAP_MSECS
+ */
+void GPUHistory::recordPerfLevel()
+{
+    if(this->lastPerfLevel >= 0 && this->lastPerfLevelTime.isValid()) {
+        qint64 msecs = this->lastPerfLevelTime.elapsed();
+
+        // The subscription ended and restarted in between, the gap is dropped
+        if(msecs > 0 && msecs <= PERF_LEVEL_MAX_GAP_MSECS) {
+            if(this->perfLevelResidency.size() <= this->lastPerfLevel) {
+                this->perfLevelResidency.resize(this->lastPerfLevel + 1);
+            }
+
+            this->perfLevelResidency[this->lastPerfLevel] += msecs;
+        }
+    }
+
+    this->lastPerfLevel = this->gpu->getCurrentPerfLevel();
+    this->lastPerfLevelTime.restart();
+}
+
+/**
+ * Time spent in each performance level since the start or the last reset
+ * @return Msecs indexed by level
+ */
+QVector<qint64> GPUHistory::getPerfLevelResidency() const
+{
+    return this->perfLevelResidency;
+}
+
+void GPUHistory::resetPerfLevelResidency()
+{
+    this->perfLevelResidency.clear();
+}
+
+/**
+ * Summarizes the values of a series over a recent window, see GPUQuantiles
+ * @param series     Series to summarize
+ * @param windowSecs Length of the window, 0 for everything since the start
+ * @return Sketch giving the quantiles
+ */
+GPUSketch GPUHistory::getSketch(Series series, int windowSecs) const
+{
+    return this->quantiles.getSketch(series, QDateTime::currentMSecsSinceEpoch(), windowSecs);
+}
+
+void GPUHistory::resetQuantiles()
+{
+    this->quantiles.clear();
+}
+
+/**
+ * Approximate memory used by the values and the sketches
+ * @return Bytes
+ */
+qint64 GPUHistory::getMemoryUsage() const
+{
+    qint64 bytes = this->quantiles.getMemoryUsage();
+
+    for(int i=0; i < SeriesCount; i++) {
+        // QList keeps a pointer to a heap node for each value
+        bytes += this->values[i].size() * static_cast<qint64>(sizeof(void*) + sizeof(HistoryValue));
+    }
+
+    return bytes;
+}
+
+/**
+ * Cleans the history content to prevent from eating the whole RAM if the user decides to go on vacation leaving this app open
+ * @param now Reference time
+ */
+void GPUHistory::cleanValues(QTime now)
+{
+    int deleteIfMoreThanMsecs = HISTORY_LENGTH_SECS * MSEC_IN_A_SEC;
+
+    for(int i=0; i < SeriesCount; i++) {
+        while(this->values[i].size() && this->values[i].first().time.msecsTo(now) > deleteIfMoreThanMsecs) {
+            this->values[i].removeFirst();
+        }
+    }
+}
+
+/**
+ * Store new values when they change on the GPU
+ */
+void GPUHistory::newValues()
+{
+    GPUTWEAK_TRACE_SCOPE("GPUHistory::newValues");
+
+    this->record(QTime::currentTime());
+}
@@ -0,0 +1,108 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GPUHISTORY_H
+#define GPUHISTORY_H
+
+#include <QObject>
+#include <QList>
+#include <QTime>
+#include <QElapsedTimer>
+#include <QVector>
+
+#include "gpu.h"
+#include "gpuquantiles.h"
+
+/**
+ * Sample history of a GPU, shared by all the windows displaying it
+ * Values are recorded every time the GPU emits "updated"
+ */
+class GPUHistory : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * Recorded series, one list of values each
+     */
+    enum Series {
+        CoreTemp,
+        CoreUse,
+        MemoryUse,
+        FanSpeed,
+        CoreClock,
+        MemoryClock,
+        PcieLinkWidth,
+        PcieLinkGen,
+        PowerDraw,
+        SeriesCount
+    };
+
+    /**
+     * Structure holding integer data along with the time it was stored
+     */
+    struct HistoryValue {
+        QTime time;
+        int   value;
+    };
+
+    explicit GPUHistory(GPU *gpu, QObject *parent = 0);
+    ~GPUHistory();
+
+    GPU *getGPU();
+    void setGPU(GPU *gpu);
+
+    static GPU::Metric getSeriesMetric(Series series);
+
+    const QList<HistoryValue> &getValues(Series series) const;
+
+    void record(QTime time);
+
+    QVector<qint64> getPerfLevelResidency() const;
+    void            resetPerfLevelResidency();
+
+    GPUSketch getSketch(Series series, int windowSecs) const;
+    void      resetQuantiles();
+
+    qint64 getMemoryUsage() const;
+
+signals:
+    /**
+     * Emitted after a new set of values has been recorded
+     */
+    void recorded();
+
+private:
+    void cleanValues(QTime now);
+    void recordPerfLevel();
+
+    GPU *gpu;
+
+    QList<HistoryValue> values[SeriesCount];
+    GPUQuantiles        quantiles; // unlike the values, kept for a day
+
+    QVector<qint64> perfLevelResidency; // msecs spent in each performance level since the start
+    int             lastPerfLevel;      // -1 before the first sample
+    QElapsedTimer   lastPerfLevelTime;  // monotonic, unlike QTime across midnight
+
+    QTime lastCleanup;
+
+private slots:
+    void newValues();
+};
+
+#endif // GPUHISTORY_H
@@ -18,9 +18,19 @@
 #include "gpuinfowindow.h"
 #include "ui_gpuinfowindow.h"
 
-#include "gpunvidia.h"
+#include <QLabel>
+#include <QStringList>
 
-GPUInfoWindow::GPUInfoWindow(GPU *gpu, QWidget *parent, Qt::WindowFlags f) :
+#include "gpubackends.h"
+#include "gpudiagnostics.h"
+#include "gputrace.h"
+
+/**
+ * Time between two fetches of the displayed values
+ */
+const int POLL_INTERVAL_MSECS = 2000;
+
+GPUInfoWindow::GPUInfoWindow(GPU *gpu, GPUPoller *poller, QWidget *parent, Qt::WindowFlags f) :
     QWidget(parent, f),
     ui(new Ui::GPUInfoWindow)
 {
@@ -28,11 +38,27 @@ GPUInfoWindow::GPUInfoWindow(GPU *gpu, QWidget *parent, Qt::WindowFlags f) :
 
     this->gpu = gpu;
 
+    foreach(const GPUBackend::ExtraField &field, GPUBackends::getExtraFields(this->gpu)) {
+        int row = this->ui->gridLayout->rowCount();
+
+        QLineEdit *input = new QLineEdit(this);
+        input->setReadOnly(true);
+
+        this->ui->gridLayout->addWidget(new QLabel(field.label, this), row, 0);
+        this->ui->gridLayout->addWidget(input, row, 1, 1, 3);
+
+        this->extraInputs.insert(field.key, input);
+    }
+
     // Initial display of informations
     this->display();
 
     // To automatically update displayed informations
     connect(this->gpu, SIGNAL(updated()), this, SLOT(display()));
+    // The card was unplugged
+    connect(this->gpu, SIGNAL(destroyed()), this, SLOT(close()));
+
+    poller->subscribe(this, this->gpu, GPU::CoreTemp | GPU::FanSpeed | GPU::Clocks | GPU::Utilization, POLL_INTERVAL_MSECS);
 }
 
 GPUInfoWindow::~GPUInfoWindow()
@@ -45,6 +71,10 @@ GPUInfoWindow::~GPUInfoWindow()
  */
 void GPUInfoWindow::display()
 {
+    GPUTWEAK_TRACE_SCOPE("GPUInfoWindow::display");
+
+    GPUDiagnostics::ScopedTimer renderTimer(GPUDiagnostics::Render, "info");
+
     this->setWindowTitle(QString("[%1] %2 - Informations").arg(this->gpu->getIdentifier()).arg(this->gpu->getName()));
 
     this->ui->nameInput         ->setText(this->gpu->getName());
@@ -52,17 +82,29 @@ void GPUInfoWindow::display()
     this->ui->busTypeInput      ->setText(this->gpu->getBusType());
     this->ui->busIdInput        ->setText(this->gpu->getBusId());
 
-    if (GPUNvidia *ngpu = dynamic_cast<GPUNvidia*>(this->gpu)) {
-        this->ui->cudaCoresInput->show();
-        this->ui->cudaCoresInput->setText(QString::number(ngpu->getCudaCores()));
-    } else {
-        this->ui->cudaCoresInput->hide();
+    QHashIterator<QString, QLineEdit*> i(this->extraInputs);
+    while(i.hasNext()) {
+        i.next();
+        i.value()->setText(this->gpu->getExtraValue(i.key()));
     }
 
     this->ui->totalMemoryInput       ->setText(QString("%1 MB") .arg(this->gpu->getTotalMemory()));
 
-    this->ui->currentCoreTempInput   ->setText(QString("%1 °C") .arg(this->gpu->getCurrentCoreTemp()));
-    this->ui->currentFanSpeedInput   ->setText(QString("%1 %")  .arg(this->gpu->getCurrentFanSpeed()));
+    // Cards with several fans or thermal sensors also show each of them, ex: "45 % (40 %, 50 %)"
+    QStringList sensorTemps;
+    for(int i=0; i < this->gpu->getThermalSensorCount(); i++) {
+        sensorTemps.append(QString("%1 °C").arg(this->gpu->getThermalSensorTempAt(i)));
+    }
+
+    QStringList fanSpeeds;
+    for(int i=0; this->gpu->getFanCount() > 1 && i < this->gpu->getFanCount(); i++) {
+        fanSpeeds.append(QString("%1 %").arg(this->gpu->getCurrentFanSpeedAt(i)));
+    }
+
+    this->ui->currentCoreTempInput   ->setText(QString("%1 °C") .arg(this->gpu->getCurrentCoreTemp())
+                                               + (sensorTemps.isEmpty() ? "" : QString(" (%1)").arg(sensorTemps.join(", "))));
+    this->ui->currentFanSpeedInput   ->setText(QString("%1 %")  .arg(this->gpu->getCurrentFanSpeed())
+                                               + (fanSpeeds.isEmpty() ? "" : QString(" (%1)").arg(fanSpeeds.join(", "))));
     this->ui->currentCoreClockInput  ->setText(QString("%1 MHz").arg(this->gpu->getCurrentCoreClock()));
     this->ui->currentMemoryClockInput->setText(QString("%1 MHz").arg(this->gpu->getCurrentMemoryClock()));
     this->ui->currentCoreUseInput    ->setText(QString("%1 %")  .arg(this->gpu->getCurrentCoreUse()));
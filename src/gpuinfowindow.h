@@ -19,8 +19,11 @@
 #define GPUINFOWINDOW_H
 
 #include <QWidget>
+#include <QHash>
+#include <QLineEdit>
 
 #include "gpu.h"
+#include "gpupoller.h"
 
 namespace Ui {
 class GPUInfoWindow;
@@ -34,13 +37,16 @@ class GPUInfoWindow : public QWidget
     Q_OBJECT
 
 public:
-    explicit GPUInfoWindow(GPU *gpu, QWidget *parent = 0, Qt::WindowFlags f = 0);
+    explicit GPUInfoWindow(GPU *gpu, GPUPoller *poller, QWidget *parent = 0, Qt::WindowFlags f = 0);
     ~GPUInfoWindow();
 
 private:
     Ui::GPUInfoWindow *ui;
     GPU *gpu;
 
+    // Inputs of the backend-specific fields, by key
+    QHash<QString, QLineEdit*> extraInputs;
+
 private slots:
     void display();
 
@@ -0,0 +1,109 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "gpujobmarkers.h"
+
+#include <QSocketNotifier>
+
+#include <csignal>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/**
+ * Byte written to the pipe for a start marker
+ */
+const char MARKER_START = 's';
+/**
+ * Byte written to the pipe for a stop marker
+ */
+const char MARKER_STOP = 'e';
+
+int GPUJobMarkers::markerPipe[2] = {-1, -1};
+
+GPUJobMarkers::GPUJobMarkers(QObject *parent) :
+    QObject(parent)
+{
+    this->notifier = 0;
+
+    if(::socketpair(AF_UNIX, SOCK_STREAM, 0, GPUJobMarkers::markerPipe) != 0) {
+        GPUJobMarkers::markerPipe[0] = -1;
+        GPUJobMarkers::markerPipe[1] = -1;
+        return;
+    }
+
+    // A full pipe must not block the handler, the marker is lost instead
+    ::fcntl(GPUJobMarkers::markerPipe[1], F_SETFL, ::fcntl(GPUJobMarkers::markerPipe[1], F_GETFL) | O_NONBLOCK);
+
+    this->notifier = new QSocketNotifier(GPUJobMarkers::markerPipe[0], QSocketNotifier::Read, this);
+    connect(this->notifier, SIGNAL(activated(int)), this, SLOT(readPipe()));
+
+    struct sigaction action;
+    action.sa_handler = GPUJobMarkers::handleSignal;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+
+    ::sigaction(SIGUSR1, &action, 0);
+    ::sigaction(SIGUSR2, &action, 0);
+}
+
+GPUJobMarkers::~GPUJobMarkers()
+{
+    ::signal(SIGUSR1, SIG_DFL);
+    ::signal(SIGUSR2, SIG_DFL);
+
+    if(GPUJobMarkers::markerPipe[0] >= 0) {
+        ::close(GPUJobMarkers::markerPipe[0]);
+        ::close(GPUJobMarkers::markerPipe[1]);
+        GPUJobMarkers::markerPipe[0] = -1;
+        GPUJobMarkers::markerPipe[1] = -1;
+    }
+}
+
+/**
+ * Whether the signal handlers could be installed
+ * @return
+ */
+bool GPUJobMarkers::isListening() const
+{
+    return this->notifier != 0;
+}
+
+/**
+ * Signal handler, only async-signal-safe calls are allowed here
+ * @param number
+ */
+void GPUJobMarkers::handleSignal(int number)
+{
+    char marker = number == SIGUSR1 ? MARKER_START : MARKER_STOP;
+    ssize_t written = ::write(GPUJobMarkers::markerPipe[1], &marker, sizeof(marker));
+    Q_UNUSED(written);
+}
+
+void GPUJobMarkers::readPipe()
+{
+    char marker;
+    if(::read(GPUJobMarkers::markerPipe[0], &marker, sizeof(marker)) != sizeof(marker)) {
+        return;
+    }
+
+    if(marker == MARKER_START) {
+        emit startRequested();
+    } else {
+        emit stopRequested();
+    }
+}
@@ -0,0 +1,56 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GPUJOBMARKERS_H
+#define GPUJOBMARKERS_H
+
+#include <QObject>
+
+class QSocketNotifier;
+
+/**
+ * Turns SIGUSR1 and SIGUSR2 into start and stop markers of a job
+ * So an external scheduler can mark the interval with `kill -USR1 <pid>` and `kill -USR2 <pid>`
+ * The handlers only write to a pipe, the signals are emitted from the event loop
+ * Only one instance can exist at a time
+ */
+class GPUJobMarkers : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit GPUJobMarkers(QObject *parent = 0);
+    ~GPUJobMarkers();
+
+    bool isListening() const;
+
+signals:
+    void startRequested();
+    void stopRequested();
+
+private:
+    static int markerPipe[2];
+
+    QSocketNotifier *notifier;
+
+    static void handleSignal(int number);
+
+private slots:
+    void readPipe();
+};
+
+#endif // GPUJOBMARKERS_H
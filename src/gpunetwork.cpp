@@ -0,0 +1,403 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "gpunetwork.h"
+
+#include <QtEndian>
+
+/**
+ * Version sent in the hello frame, increased when the frames change
+ */
+const quint16 PROTOCOL_VERSION = 2;
+/**
+ * Size of the header: payload length (4), type (1), flags (1)
+ */
+const int FRAME_HEADER_BYTES = 6;
+/**
+ * Larger frames are refused, a corrupted length would otherwise make the reader wait forever
+ */
+const quint32 MAX_PAYLOAD_BYTES = 16 * 1024 * 1024;
+/**
+ * Payloads smaller than this are sent as is, zlib would barely shrink them
+ */
+const int COMPRESS_MIN_BYTES = 512;
+/**
+ * zlib level, the lowest already gets most of the gain on the repetitive samples
+ */
+const int COMPRESS_LEVEL = 1;
+/**
+ * Flag of the header telling the payload is compressed
+ */
+const quint8 FLAG_COMPRESSED = 0x01;
+
+quint16 GPUNetwork::protocolVersion()
+{
+    return PROTOCOL_VERSION;
+}
+
+/**
+ * Copies the constants of a GPU, fetchConstants() must have been called
+ * @param gpu
+ * @return Description
+ */
+GPUNetwork::GPUDescription GPUNetwork::describe(GPU *gpu)
+{
+    GPUDescription description;
+    description.identifier       = gpu->getIdentifier();
+    description.name             = gpu->getName();
+    description.driverVersion    = gpu->getDriverVersion();
+    description.busType          = gpu->getBusType();
+    description.busId            = gpu->getBusId();
+    description.totalMemory      = gpu->getTotalMemory();
+    description.perfLevelCount   = gpu->getPerfLevelCount();
+    description.pcieMaxLinkWidth = gpu->getPcieMaxLinkWidth();
+    description.pcieMaxLinkGen   = gpu->getPcieMaxLinkGen();
+
+    return description;
+}
+
+/**
+ * Copies the current values of a GPU
+ * @param gpu
+ * @param index   Index of the GPU in the agent
+ * @param metrics Metrics refreshed by the last fetch
+ * @param time    Msecs since epoch
+ * @return Sample, without sequence number
+ */
+GPUNetwork::Sample GPUNetwork::sample(GPU *gpu, int index, GPU::Metrics metrics, qint64 time)
+{
+    Sample sample;
+    sample.seq               = 0;
+    sample.gpu               = index;
+    sample.time              = time;
+    sample.metrics           = static_cast<int>(metrics);
+    sample.coreTemp          = gpu->getCurrentCoreTemp();
+    sample.fanSpeed          = gpu->getCurrentFanSpeed();
+    sample.coreClock         = gpu->getCurrentCoreClock();
+    sample.memoryClock       = gpu->getCurrentMemoryClock();
+    sample.coreUse           = gpu->getCurrentCoreUse();
+    sample.memoryUse         = gpu->getCurrentMemoryUse();
+    sample.fanControlEnabled = gpu->isFanControlEnabled() ? 1 : 0;
+    sample.perfLevel         = gpu->getCurrentPerfLevel();
+    sample.coreClockOffset   = gpu->getCoreClockOffset();
+    sample.memoryClockOffset = gpu->getMemoryClockOffset();
+    sample.pcieLinkWidth     = gpu->getPcieLinkWidth();
+    sample.pcieLinkGen       = gpu->getPcieLinkGen();
+    sample.powerDraw         = qRound(gpu->getCurrentPowerDraw() * GPUNetwork::POWER_SCALE);
+    sample.powerLimit        = qRound(gpu->getPowerLimit() * GPUNetwork::POWER_SCALE);
+
+    return sample;
+}
+
+/**
+ * Overwrites the fields of the metrics of a newer sample, the others are kept
+ * @param into   Sample to update
+ * @param sample Newer sample of the same GPU
+ */
+void GPUNetwork::merge(Sample &into, const Sample &sample)
+{
+    into.seq  = sample.seq;
+    into.time = sample.time;
+
+    if(sample.metrics & GPU::CoreTemp) {
+        into.coreTemp = sample.coreTemp;
+    }
+    if(sample.metrics & GPU::FanSpeed) {
+        into.fanSpeed = sample.fanSpeed;
+    }
+    if(sample.metrics & GPU::Clocks) {
+        into.coreClock   = sample.coreClock;
+        into.memoryClock = sample.memoryClock;
+    }
+    if(sample.metrics & GPU::Utilization) {
+        into.coreUse   = sample.coreUse;
+        into.memoryUse = sample.memoryUse;
+    }
+    if(sample.metrics & GPU::FanControlState) {
+        into.fanControlEnabled = sample.fanControlEnabled;
+    }
+    if(sample.metrics & GPU::PerfLevel) {
+        into.perfLevel = sample.perfLevel;
+    }
+    if(sample.metrics & GPU::ClockOffsets) {
+        into.coreClockOffset   = sample.coreClockOffset;
+        into.memoryClockOffset = sample.memoryClockOffset;
+    }
+    if(sample.metrics & GPU::PcieLink) {
+        into.pcieLinkWidth = sample.pcieLinkWidth;
+        into.pcieLinkGen   = sample.pcieLinkGen;
+    }
+    if(sample.metrics & GPU::Power) {
+        into.powerDraw  = sample.powerDraw;
+        into.powerLimit = sample.powerLimit;
+    }
+
+    into.metrics |= sample.metrics;
+}
+
+/**
+ * Builds a frame
+ * @param type
+ * @param payload
+ * @return Bytes to write on the socket
+ */
+QByteArray GPUNetwork::encodeFrame(FrameType type, const QByteArray &payload)
+{
+    QByteArray body = payload;
+    quint8 flags = 0;
+
+    if(payload.size() >= COMPRESS_MIN_BYTES) {
+        QByteArray compressed = qCompress(payload, COMPRESS_LEVEL);
+
+        if(compressed.size() < payload.size()) {
+            body = compressed;
+            flags |= FLAG_COMPRESSED;
+        }
+    }
+
+    QByteArray frame(FRAME_HEADER_BYTES, Qt::Uninitialized);
+    qToBigEndian<quint32>(body.size(), reinterpret_cast<uchar*>(frame.data()));
+    frame[4] = static_cast<char>(type);
+    frame[5] = static_cast<char>(flags);
+    frame.append(body);
+
+    return frame;
+}
+
+/**
+ * Removes the first frame from the bytes received so far
+ * @param buffer Bytes received, the frame is removed from it
+ * @param frame  Frame read, with its payload uncompressed
+ * @return FrameIncomplete until all the bytes of the frame are received, FrameInvalid if the connection should be closed
+ */
+GPUNetwork::ReadResult GPUNetwork::takeFrame(QByteArray &buffer, Frame &frame)
+{
+    if(buffer.size() < FRAME_HEADER_BYTES) {
+        return FrameIncomplete;
+    }
+
+    quint32 length = qFromBigEndian<quint32>(reinterpret_cast<const uchar*>(buffer.constData()));
+    if(length > MAX_PAYLOAD_BYTES) {
+        return FrameInvalid;
+    }
+
+    if(static_cast<quint32>(buffer.size()) < FRAME_HEADER_BYTES + length) {
+        return FrameIncomplete;
+    }
+
+    quint8 flags = static_cast<quint8>(buffer.at(5));
+
+    frame.type    = static_cast<FrameType>(buffer.at(4));
+    frame.payload = buffer.mid(FRAME_HEADER_BYTES, length);
+    buffer.remove(0, FRAME_HEADER_BYTES + length);
+
+    if(flags & FLAG_COMPRESSED) {
+        frame.payload = qUncompress(frame.payload);
+
+        if(frame.payload.isEmpty()) {
+            return FrameInvalid;
+        }
+    }
+
+    return FrameRead;
+}
+
+/**
+ * Encodes consecutive samples, only the fields of the metrics of each sample are written,
+ * as 16 bits integers, and the times as deltas
+ * @param host    Host of the samples, empty from the agents since the collector knows it
+ * @param samples Samples with consecutive sequence numbers
+ * @return Payload of a Samples frame
+ */
+QByteArray GPUNetwork::encodeSamples(QString host, const QList<Sample> &samples)
+{
+    QByteArray payload;
+    QDataStream stream(&payload, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    stream << host
+           << static_cast<quint64>(samples.isEmpty() ? 0 : samples.first().seq)
+           << static_cast<quint32>(samples.size())
+           << static_cast<qint64>(samples.isEmpty() ? 0 : samples.first().time);
+
+    qint64 previousTime = samples.isEmpty() ? 0 : samples.first().time;
+
+    foreach(const Sample &sample, samples) {
+        stream << static_cast<quint16>(sample.gpu)
+               << static_cast<qint32>(sample.time - previousTime)
+               << static_cast<quint16>(sample.metrics);
+
+        if(sample.metrics & GPU::CoreTemp) {
+            stream << static_cast<qint16>(sample.coreTemp);
+        }
+        if(sample.metrics & GPU::FanSpeed) {
+            stream << static_cast<qint16>(sample.fanSpeed);
+        }
+        if(sample.metrics & GPU::Clocks) {
+            stream << static_cast<qint16>(sample.coreClock) << static_cast<qint16>(sample.memoryClock);
+        }
+        if(sample.metrics & GPU::Utilization) {
+            stream << static_cast<qint16>(sample.coreUse) << static_cast<qint16>(sample.memoryUse);
+        }
+        if(sample.metrics & GPU::FanControlState) {
+            stream << static_cast<qint16>(sample.fanControlEnabled);
+        }
+        if(sample.metrics & GPU::PerfLevel) {
+            stream << static_cast<qint16>(sample.perfLevel);
+        }
+        if(sample.metrics & GPU::ClockOffsets) {
+            stream << static_cast<qint16>(sample.coreClockOffset) << static_cast<qint16>(sample.memoryClockOffset);
+        }
+        if(sample.metrics & GPU::PcieLink) {
+            stream << static_cast<qint16>(sample.pcieLinkWidth) << static_cast<qint16>(sample.pcieLinkGen);
+        }
+        if(sample.metrics & GPU::Power) {
+            stream << static_cast<qint16>(sample.powerDraw) << static_cast<qint16>(sample.powerLimit);
+        }
+
+        previousTime = sample.time;
+    }
+
+    return payload;
+}
+
+/**
+ * Reads a 16 bits field
+ * @param stream
+ * @return Value
+ */
+static int readField(QDataStream &stream)
+{
+    qint16 value;
+    stream >> value;
+
+    return value;
+}
+
+/**
+ * Decodes a payload written by encodeSamples()
+ * @param payload
+ * @param host    Host of the samples
+ * @param samples Decoded samples, the fields of the missing metrics are 0
+ * @return False if the payload is truncated
+ */
+bool GPUNetwork::decodeSamples(const QByteArray &payload, QString &host, QList<Sample> &samples)
+{
+    QDataStream stream(payload);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    quint64 seq;
+    quint32 count;
+    qint64  time;
+    stream >> host >> seq >> count >> time;
+
+    if(stream.status() != QDataStream::Ok) {
+        return false;
+    }
+
+    samples.reserve(samples.size() + static_cast<int>(qMin(count, static_cast<quint32>(payload.size()))));
+
+    for(quint32 i=0; i < count; i++) {
+        quint16 gpu;
+        qint32  delta;
+        quint16 metrics;
+        stream >> gpu >> delta >> metrics;
+
+        Sample sample = Sample();
+        sample.seq     = seq + i;
+        sample.gpu     = gpu;
+        sample.time    = time + delta;
+        sample.metrics = metrics;
+
+        if(metrics & GPU::CoreTemp) {
+            sample.coreTemp = readField(stream);
+        }
+        if(metrics & GPU::FanSpeed) {
+            sample.fanSpeed = readField(stream);
+        }
+        if(metrics & GPU::Clocks) {
+            sample.coreClock   = readField(stream);
+            sample.memoryClock = readField(stream);
+        }
+        if(metrics & GPU::Utilization) {
+            sample.coreUse   = readField(stream);
+            sample.memoryUse = readField(stream);
+        }
+        if(metrics & GPU::FanControlState) {
+            sample.fanControlEnabled = readField(stream);
+        }
+        if(metrics & GPU::PerfLevel) {
+            sample.perfLevel = readField(stream);
+        }
+        if(metrics & GPU::ClockOffsets) {
+            sample.coreClockOffset   = readField(stream);
+            sample.memoryClockOffset = readField(stream);
+        }
+        if(metrics & GPU::PcieLink) {
+            sample.pcieLinkWidth = readField(stream);
+            sample.pcieLinkGen   = readField(stream);
+        }
+        if(metrics & GPU::Power) {
+            sample.powerDraw  = readField(stream);
+            sample.powerLimit = readField(stream);
+        }
+
+        if(stream.status() != QDataStream::Ok) {
+            return false;
+        }
+
+        samples.append(sample);
+        time = sample.time;
+    }
+
+    return true;
+}
+
+QDataStream &operator<<(QDataStream &stream, const GPUNetwork::GPUDescription &description)
+{
+    return stream << description.identifier
+                  << description.name
+                  << description.driverVersion
+                  << description.busType
+                  << description.busId
+                  << static_cast<qint32>(description.totalMemory)
+                  << static_cast<qint32>(description.perfLevelCount)
+                  << static_cast<qint32>(description.pcieMaxLinkWidth)
+                  << static_cast<qint32>(description.pcieMaxLinkGen);
+}
+
+QDataStream &operator>>(QDataStream &stream, GPUNetwork::GPUDescription &description)
+{
+    qint32 totalMemory, perfLevelCount, pcieMaxLinkWidth, pcieMaxLinkGen;
+
+    stream >> description.identifier
+           >> description.name
+           >> description.driverVersion
+           >> description.busType
+           >> description.busId
+           >> totalMemory
+           >> perfLevelCount
+           >> pcieMaxLinkWidth
+           >> pcieMaxLinkGen;
+
+    description.totalMemory      = totalMemory;
+    description.perfLevelCount   = perfLevelCount;
+    description.pcieMaxLinkWidth = pcieMaxLinkWidth;
+    description.pcieMaxLinkGen   = pcieMaxLinkGen;
+
+    return stream;
+}
@@ -0,0 +1,119 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GPUNETWORK_H
+#define GPUNETWORK_H
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QList>
+#include <QString>
+
+#include "gpu.h"
+
+/**
+ * Binary protocol between the agents, the collector and the viewers, see README
+ * Every frame is a 6 bytes header (payload length, type, flags) followed by the payload,
+ * compressed with zlib when it is large enough for it to pay off
+ */
+namespace GPUNetwork
+{
+    enum FrameType {
+        Hello    = 1, // first frame of any client: role, name, session and GPUs
+        Welcome  = 2, // collector to agent: last sequence number received, the agent sends what follows
+        Samples  = 3, // batch of consecutive samples
+        Ack      = 4, // collector to agent: samples received up to a sequence number
+        Describe = 5  // collector to viewer: GPUs of a host and whether its agent is connected
+    };
+
+    enum Role {
+        AgentRole  = 0,
+        ViewerRole = 1
+    };
+
+    enum ReadResult {
+        FrameIncomplete,
+        FrameRead,
+        FrameInvalid
+    };
+
+    /**
+     * Values of a GPU that do not change, enough to display it
+     */
+    struct GPUDescription {
+        QString identifier;
+        QString name;
+        QString driverVersion;
+        QString busType;
+        QString busId;
+        int     totalMemory;
+        int     perfLevelCount;
+        int     pcieMaxLinkWidth;
+        int     pcieMaxLinkGen;
+    };
+
+    /**
+     * Values of a GPU at some time, only the fields of the metrics are meaningful
+     */
+    struct Sample {
+        quint64 seq;     // consecutive within a session of an agent
+        int     gpu;     // index in the GPUs of the agent
+        qint64  time;    // msecs since epoch
+        int     metrics; // GPU::Metrics
+        int     coreTemp;
+        int     fanSpeed;
+        int     coreClock;
+        int     memoryClock;
+        int     coreUse;
+        int     memoryUse;
+        int     fanControlEnabled;
+        int     perfLevel;
+        int     coreClockOffset;
+        int     memoryClockOffset;
+        int     pcieLinkWidth;
+        int     pcieLinkGen;
+        int     powerDraw;  // 1/POWER_SCALE W
+        int     powerLimit; // 1/POWER_SCALE W
+    };
+
+    /**
+     * Powers are sent in tenths of W
+     */
+    const int POWER_SCALE = 10;
+
+    struct Frame {
+        FrameType  type;
+        QByteArray payload;
+    };
+
+    quint16 protocolVersion();
+
+    GPUDescription describe(GPU *gpu);
+    Sample         sample(GPU *gpu, int index, GPU::Metrics metrics, qint64 time);
+    void           merge(Sample &into, const Sample &sample);
+
+    QByteArray encodeFrame(FrameType type, const QByteArray &payload);
+    ReadResult takeFrame(QByteArray &buffer, Frame &frame);
+
+    QByteArray encodeSamples(QString host, const QList<Sample> &samples);
+    bool       decodeSamples(const QByteArray &payload, QString &host, QList<Sample> &samples);
+}
+
+QDataStream &operator<<(QDataStream &stream, const GPUNetwork::GPUDescription &description);
+QDataStream &operator>>(QDataStream &stream, GPUNetwork::GPUDescription &description);
+
+#endif // GPUNETWORK_H
@@ -0,0 +1,139 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "gpupciemonitor.h"
+
+#include "gputrace.h"
+
+/**
+ * Core use (%) above which the link is expected to run at its full width and speed
+ */
+const int PCIE_MIN_USE = 50;
+/**
+ * Number of consecutive samples needed to report a degraded link, the driver takes a moment to raise it
+ */
+const int PCIE_CONFIRM_SAMPLES = 2;
+/**
+ * Usable bandwidth of a lane for each generation, in MB/s, after the encoding overhead
+ */
+const int PCIE_LANE_BANDWIDTH[] = {0, 250, 500, 985, 1969, 3938};
+const int PCIE_MAX_GEN          = 5;
+
+GPUPcieMonitor::GPUPcieMonitor(GPU *gpu, GPUEventLog *log, QObject *parent) :
+    QObject(parent)
+{
+    this->gpu = gpu;
+    this->log = log;
+
+    this->degradedSamples = 0;
+    this->eventId         = -1;
+    this->worstShare      = 100;
+
+    connect(this->gpu, SIGNAL(updated()), this, SLOT(newValues()));
+}
+
+GPUPcieMonitor::~GPUPcieMonitor()
+{
+    // no-op
+}
+
+/**
+ * Bandwidth of a link compared to the best one of the card
+ * @param width    Lanes in use
+ * @param gen      Generation in use
+ * @param maxWidth Lanes supported
+ * @param maxGen   Generation supported
+ * @return %, 100 if unknown
+ */
+int GPUPcieMonitor::getBandwidthShare(int width, int gen, int maxWidth, int maxGen)
+{
+    if(width <= 0 || maxWidth <= 0 || gen <= 0 || maxGen <= 0) {
+        return 100;
+    }
+
+    qint64 current = static_cast<qint64>(width) * PCIE_LANE_BANDWIDTH[qMin(gen, PCIE_MAX_GEN)];
+    qint64 max     = static_cast<qint64>(maxWidth) * PCIE_LANE_BANDWIDTH[qMin(maxGen, PCIE_MAX_GEN)];
+
+    return qMin(100, static_cast<int>(current * 100 / max));
+}
+
+bool GPUPcieMonitor::isDegraded()
+{
+    return this->eventId >= 0;
+}
+
+/**
+ * Looks at a new sample of the link, starts, updates or ends the event
+ * @param time    Time of the sample
+ * @param width   Lanes in use
+ * @param gen     Generation in use
+ * @param coreUse %
+ */
+void GPUPcieMonitor::process(QDateTime time, int width, int gen, int coreUse)
+{
+    int share = GPUPcieMonitor::getBandwidthShare(width, gen, this->gpu->getPcieMaxLinkWidth(), this->gpu->getPcieMaxLinkGen());
+
+    // The link is allowed to slow down with the load
+    if(coreUse < PCIE_MIN_USE || share >= 100) {
+        this->degradedSamples = 0;
+
+        if(this->eventId >= 0) {
+            this->log->end(this->eventId, time);
+            this->eventId = -1;
+        }
+
+        return;
+    }
+
+    if(this->degradedSamples++ == 0) {
+        this->degradedSince = time;
+    }
+
+    if(this->degradedSamples < PCIE_CONFIRM_SAMPLES || (this->eventId >= 0 && share >= this->worstShare)) {
+        return;
+    }
+
+    this->worstShare = this->eventId < 0 ? share : qMin(this->worstShare, share);
+
+    QString details = QString("x%1 Gen%2 instead of x%3 Gen%4, %5% of the bandwidth at %6% use")
+            .arg(width)
+            .arg(gen)
+            .arg(this->gpu->getPcieMaxLinkWidth())
+            .arg(this->gpu->getPcieMaxLinkGen())
+            .arg(this->worstShare)
+            .arg(coreUse);
+
+    if(this->eventId < 0) {
+        this->eventId = this->log->begin(this->gpu, GPUEventLog::PcieDegraded, this->degradedSince, 100 - this->worstShare, details);
+    } else {
+        this->log->update(this->eventId, GPUEventLog::PcieDegraded, 100 - this->worstShare, details);
+    }
+}
+
+/**
+ * Checks the link when the GPU fetched it
+ */
+void GPUPcieMonitor::newValues()
+{
+    GPUTWEAK_TRACE_SCOPE("GPUPcieMonitor::newValues");
+
+    if(!(this->gpu->getUpdatedMetrics() & GPU::PcieLink)) {
+        return;
+    }
+
+    this->process(QDateTime::currentDateTime(), this->gpu->getPcieLinkWidth(), this->gpu->getPcieLinkGen(), this->gpu->getCurrentCoreUse());
+}
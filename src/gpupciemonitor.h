@@ -0,0 +1,58 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GPUPCIEMONITOR_H
+#define GPUPCIEMONITOR_H
+
+#include <QObject>
+#include <QDateTime>
+
+#include "gpu.h"
+#include "gpueventlog.h"
+
+/**
+ * Watches the PCI-E link of a GPU and logs an event while it stays narrower
+ * or slower than the card supports under load, ex: stuck at Gen1 or x4
+ * An idle card lowering its link to save power is not reported
+ */
+class GPUPcieMonitor : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit GPUPcieMonitor(GPU *gpu, GPUEventLog *log, QObject *parent = 0);
+    ~GPUPcieMonitor();
+
+    static int getBandwidthShare(int width, int gen, int maxWidth, int maxGen);
+
+    void process(QDateTime time, int width, int gen, int coreUse);
+    bool isDegraded();
+
+private:
+    GPU         *gpu;
+    GPUEventLog *log;
+
+    int       degradedSamples; // consecutive samples of a degraded link under load
+    QDateTime degradedSince;
+    int       eventId;         // -1 when the link is fine
+    int       worstShare;      // % of the bandwidth, lowest seen during the event
+
+private slots:
+    void newValues();
+};
+
+#endif // GPUPCIEMONITOR_H
@@ -0,0 +1,259 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "gpupoller.h"
+
+#include "gpudiagnostics.h"
+#include "gputrace.h"
+
+/**
+ * Metrics that become due within this delay are fetched together with the due ones
+ * so that a single driver round-trip serves them all
+ */
+const int POLL_ALIGN_MSECS = 100;
+
+GPUPoller::GPUPoller(QObject *parent) :
+    QObject(parent)
+{
+    this->nextSubscriptionId = 1;
+
+    this->clock.start();
+
+    this->timer.setSingleShot(true);
+    connect(&this->timer, SIGNAL(timeout()), this, SLOT(tick()));
+}
+
+GPUPoller::~GPUPoller()
+{
+    // no-op
+}
+
+/**
+ * Registers interest in metrics of a GPU
+ * Metrics that were never fetched are fetched as soon as the event loop runs again, not from
+ * within this call, so the subscriber can finish setting up before its first updated()
+ * @param subscriber    Object interested in the values, the subscription ends when it is destroyed
+ * @param gpu           GPU to poll
+ * @param metrics       Metrics to poll
+ * @param intervalMsecs Requested time between two fetches
+ * @return Id of the subscription
+ */
+int GPUPoller::subscribe(QObject *subscriber, GPU *gpu, GPU::Metrics metrics, int intervalMsecs)
+{
+    Subscription subscription;
+    subscription.id            = this->nextSubscriptionId++;
+    subscription.subscriber    = subscriber;
+    subscription.gpu           = gpu;
+    subscription.metrics       = metrics;
+    subscription.intervalMsecs = intervalMsecs;
+
+    this->subscriptions.append(subscription);
+
+    connect(subscriber, SIGNAL(destroyed(QObject*)), this, SLOT(subscriberDestroyed(QObject*)), Qt::UniqueConnection);
+    connect(gpu, SIGNAL(destroyed(QObject*)), this, SLOT(gpuDestroyed(QObject*)), Qt::UniqueConnection);
+
+    this->timer.start(0);
+
+    return subscription.id;
+}
+
+/**
+ * Ends a subscription
+ * @param subscriptionId Id given by subscribe()
+ */
+void GPUPoller::unsubscribe(int subscriptionId)
+{
+    for(int i=0; i < this->subscriptions.size(); i++) {
+        if(this->subscriptions.at(i).id == subscriptionId) {
+            this->subscriptions.removeAt(i);
+            break;
+        }
+    }
+
+    this->schedule();
+}
+
+/**
+ * Ends all the subscriptions of a subscriber
+ * @param subscriber
+ */
+void GPUPoller::unsubscribeAll(QObject *subscriber)
+{
+    for(int i = this->subscriptions.size()-1; i >= 0; i--) {
+        if(this->subscriptions.at(i).subscriber == subscriber) {
+            this->subscriptions.removeAt(i);
+        }
+    }
+
+    this->schedule();
+}
+
+/**
+ * Union of the metrics subscribed for a GPU
+ * @param gpu
+ * @return Metrics
+ */
+GPU::Metrics GPUPoller::getSubscribedMetrics(GPU *gpu)
+{
+    GPU::Metrics metrics = 0;
+
+    foreach(const Subscription &subscription, this->subscriptions) {
+        if(subscription.gpu == gpu) {
+            metrics |= subscription.metrics;
+        }
+    }
+
+    return metrics;
+}
+
+/**
+ * Arms the timer for the next metric to become due, or stops it if there is nothing to poll
+ */
+void GPUPoller::schedule()
+{
+    if(this->subscriptions.isEmpty()) {
+        this->timer.stop();
+        this->lastFetches.clear();
+        return;
+    }
+
+    qint64 now = this->clock.elapsed();
+    qint64 next = -1;
+
+    foreach(const Subscription &subscription, this->subscriptions) {
+        // Shared copy, looking up with operator[] would insert the GPUs never fetched
+        const QHash<int, qint64> gpuFetches = this->lastFetches.value(subscription.gpu);
+
+        for(int metric = 1; metric <= GPU::AllMetrics; metric <<= 1) {
+            if(!(subscription.metrics & metric)) {
+                continue;
+            }
+
+            qint64 due = gpuFetches.contains(metric) ? gpuFetches.value(metric) + subscription.intervalMsecs : now;
+
+            if(next < 0 || due < next) {
+                next = due;
+            }
+        }
+    }
+
+    this->timer.start(static_cast<int>(qMax(static_cast<qint64>(0), next - now)));
+}
+
+/**
+ * Fetches the metrics that are due, one fetch per GPU
+ * The tick overruns when the fetches take longer than the fastest interval they serve
+ */
+void GPUPoller::tick()
+{
+    GPUTWEAK_TRACE_SCOPE("GPUPoller::tick");
+
+    qint64 now = this->clock.elapsed();
+    int fastestDueInterval = -1;
+
+    GPUDiagnostics::count(GPUDiagnostics::PollerTicks);
+
+    // Fastest requested interval per metric per GPU
+    QHash<GPU*, QHash<int, int> > intervals;
+    QList<GPU*> gpus;
+
+    foreach(const Subscription &subscription, this->subscriptions) {
+        if(!intervals.contains(subscription.gpu)) {
+            gpus.append(subscription.gpu);
+        }
+
+        QHash<int, int> &gpuIntervals = intervals[subscription.gpu];
+
+        for(int metric = 1; metric <= GPU::AllMetrics; metric <<= 1) {
+            if(subscription.metrics & metric) {
+                if(!gpuIntervals.contains(metric) || subscription.intervalMsecs < gpuIntervals.value(metric)) {
+                    gpuIntervals[metric] = subscription.intervalMsecs;
+                }
+            }
+        }
+    }
+
+    foreach(GPU *gpu, gpus) {
+        const QHash<int, int> &gpuIntervals = intervals[gpu];
+        const QHash<int, qint64> gpuFetches = this->lastFetches.value(gpu);
+
+        GPU::Metrics due = 0;
+
+        QHashIterator<int, int> i(gpuIntervals);
+        while(i.hasNext()) {
+            i.next();
+
+            if(!gpuFetches.contains(i.key()) || gpuFetches.value(i.key()) + i.value() <= now + POLL_ALIGN_MSECS) {
+                due |= static_cast<GPU::Metric>(i.key());
+
+                if(fastestDueInterval < 0 || i.value() < fastestDueInterval) {
+                    fastestDueInterval = i.value();
+                }
+            }
+        }
+
+        if(due) {
+            QElapsedTimer fetchTimer;
+            fetchTimer.start();
+
+            gpu->fetchVariables(due);
+
+            GPUDiagnostics::recordTiming(GPUDiagnostics::GPUFetch, gpu->getIdentifier(), fetchTimer.nsecsElapsed());
+
+            // The "updated" handlers may have subscribed or unsubscribed, which changes lastFetches
+            QHash<int, qint64> &fetches = this->lastFetches[gpu];
+
+            for(int metric = 1; metric <= GPU::AllMetrics; metric <<= 1) {
+                if(due & metric) {
+                    fetches[metric] = now;
+                }
+            }
+        }
+    }
+
+    if(fastestDueInterval >= 0 && this->clock.elapsed() - now > fastestDueInterval) {
+        GPUDiagnostics::count(GPUDiagnostics::TickOverruns);
+    }
+
+    this->schedule();
+}
+
+/**
+ * Removes the subscriptions of a destroyed subscriber
+ * @param subscriber
+ */
+void GPUPoller::subscriberDestroyed(QObject *subscriber)
+{
+    this->unsubscribeAll(subscriber);
+}
+
+/**
+ * Removes the subscriptions to a GPU that was unplugged
+ * @param gpu
+ */
+void GPUPoller::gpuDestroyed(QObject *gpu)
+{
+    for(int i = this->subscriptions.size()-1; i >= 0; i--) {
+        if(this->subscriptions.at(i).gpu == gpu) {
+            this->subscriptions.removeAt(i);
+        }
+    }
+
+    this->lastFetches.remove(static_cast<GPU*>(gpu));
+
+    this->schedule();
+}
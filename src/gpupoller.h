@@ -0,0 +1,78 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GPUPOLLER_H
+#define GPUPOLLER_H
+
+#include <QObject>
+#include <QList>
+#include <QHash>
+#include <QTimer>
+#include <QElapsedTimer>
+
+#include "gpu.h"
+
+/**
+ * Fetches the variables of the GPUs on behalf of the subscribers
+ * Each subscriber registers the metrics it is interested in along with a refresh interval,
+ * only the union of the active subscriptions is fetched, at the fastest requested interval per metric.
+ * Nothing is fetched when nothing is subscribed.
+ */
+class GPUPoller : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit GPUPoller(QObject *parent = 0);
+    ~GPUPoller();
+
+    int  subscribe(QObject *subscriber, GPU *gpu, GPU::Metrics metrics, int intervalMsecs);
+    void unsubscribe(int subscriptionId);
+    void unsubscribeAll(QObject *subscriber);
+
+    GPU::Metrics getSubscribedMetrics(GPU *gpu);
+
+private:
+    /**
+     * Interest of a subscriber in some metrics of a GPU
+     */
+    struct Subscription {
+        int          id;
+        QObject     *subscriber;
+        GPU         *gpu;
+        GPU::Metrics metrics;
+        int          intervalMsecs;
+    };
+
+    void schedule();
+
+    QList<Subscription> subscriptions;
+    int nextSubscriptionId;
+
+    // Last time each metric of each GPU was fetched, in msecs of the clock
+    QHash<GPU*, QHash<int, qint64> > lastFetches;
+
+    QElapsedTimer clock;
+    QTimer        timer;
+
+private slots:
+    void tick();
+    void subscriberDestroyed(QObject *subscriber);
+    void gpuDestroyed(QObject *gpu);
+};
+
+#endif // GPUPOLLER_H
@@ -0,0 +1,369 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "gpuprofile.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QStandardPaths>
+
+#include "gpubackends.h"
+
+/**
+ * Names used in the JSON file, in the order of the enums
+ */
+const char * const FAN_MODE_NAMES[]   = {"unchanged", "auto", "fixed", "curve", "targetTemp"};
+const char * const POWERMIZER_NAMES[] = {"adaptive", "maxPerformance", "auto", "consistent"};
+const int FAN_MODE_COUNT   = 5;
+const int POWERMIZER_COUNT = 4;
+/**
+ * File holding all the profiles, in the config directory of the app
+ */
+const QString PROFILES_FILE = "profiles.json";
+
+GPUProfile::GPUProfile()
+{
+    this->fanMode           = FanUnchanged;
+    this->fanSpeed          = 60;
+    this->fanCurve          = GPUFanCurve::defaultCurve();
+    this->targetTemp        = 70;
+    this->clockOffsets      = false;
+    this->coreClockOffset   = 0;
+    this->memoryClockOffset = 0;
+    this->powerMizerMode    = -1;
+    this->powerLimit        = 0;
+}
+
+/**
+ * The curve and target temperature modes only work while the app runs
+ * @return True if the fan mode relies on a GPUFanController
+ */
+bool GPUProfile::needsController() const
+{
+    return this->fanMode == FanCurve || this->fanMode == FanTargetTemp;
+}
+
+/**
+ * Applies the profile to the GPUs of the given controllers
+ * All the writes are grouped, so nvidia-settings is only started once for all the cards
+ * Values are not read back, see verify()
+ * @param controllers Fan controller of each GPU to tweak
+ * @return False if a driver reported an error
+ */
+bool GPUProfile::apply(QList<GPUFanController*> controllers) const
+{
+    QList<GPU*> gpus;
+    foreach(GPUFanController *controller, controllers) {
+        gpus.append(controller->getGPU());
+    }
+
+    GPUBackends::beginBatch(gpus);
+
+    foreach(GPUFanController *controller, controllers) {
+        GPU *gpu = controller->getGPU();
+
+        if(this->clockOffsets) {
+            if(gpu->isCoreClockControlAvailable()) {
+                gpu->setCoreClockOffset(qBound(gpu->getCoreClockOffsetMin(), this->coreClockOffset, gpu->getCoreClockOffsetMax()));
+            }
+
+            if(gpu->isMemoryClockControlAvailable()) {
+                gpu->setMemoryClockOffset(qBound(gpu->getMemoryClockOffsetMin(), this->memoryClockOffset, gpu->getMemoryClockOffsetMax()));
+            }
+        }
+
+        if(this->powerMizerMode >= 0 && gpu->isPowerMizerAvailable()) {
+            gpu->setPowerMizerMode(static_cast<GPU::PowerMizerMode>(this->powerMizerMode));
+        }
+
+        if(this->powerLimit > 0 && gpu->isPowerLimitControlAvailable()) {
+            gpu->setPowerLimit(qBound(gpu->getPowerLimitMin(), static_cast<double>(this->powerLimit), gpu->getPowerLimitMax()));
+        }
+
+        if(!gpu->isFanControlAvailable()) {
+            continue;
+        }
+
+        switch(this->fanMode) {
+        case FanUnchanged:
+            break;
+        case FanAuto:
+            if(controller->isEnabled()) {
+                controller->setEnabled(false);
+            } else {
+                gpu->setFanControlEnabled(false);
+            }
+            break;
+        case FanFixed:
+            controller->setEnabled(false);
+            gpu->setFanControlEnabled(true);
+            gpu->setFanSpeed(this->fanSpeed);
+            break;
+        case FanCurve:
+            controller->setCurve(this->fanCurve);
+            controller->setMode(GPUFanController::CurveMode);
+            controller->setEnabled(true);
+            break;
+        case FanTargetTemp:
+            controller->setTargetTemp(this->targetTemp);
+            controller->setMode(GPUFanController::TargetTempMode);
+            controller->setEnabled(true);
+            break;
+        }
+    }
+
+    return GPUBackends::commitBatch(gpus);
+}
+
+/**
+ * Reads the values back from the drivers and compares them to the profile
+ * @param controllers Same list as for apply()
+ * @return Description of each difference, empty if the profile is applied
+ */
+QStringList GPUProfile::verify(QList<GPUFanController*> controllers) const
+{
+    QStringList failures;
+
+    foreach(GPUFanController *controller, controllers) {
+        GPU *gpu = controller->getGPU();
+
+        gpu->fetchVariables(GPU::FanControlState | GPU::PerfLevel | GPU::ClockOffsets | GPU::Power);
+
+        if(this->clockOffsets) {
+            int core   = qBound(gpu->getCoreClockOffsetMin(), this->coreClockOffset, gpu->getCoreClockOffsetMax());
+            int memory = qBound(gpu->getMemoryClockOffsetMin(), this->memoryClockOffset, gpu->getMemoryClockOffsetMax());
+
+            if(gpu->isCoreClockControlAvailable() && gpu->getCoreClockOffset() != core) {
+                failures.append(QString("%1: core clock offset is %2 MHz instead of %3 MHz").arg(gpu->getIdentifier()).arg(gpu->getCoreClockOffset()).arg(core));
+            }
+
+            if(gpu->isMemoryClockControlAvailable() && gpu->getMemoryClockOffset() != memory) {
+                failures.append(QString("%1: memory clock offset is %2 MHz instead of %3 MHz").arg(gpu->getIdentifier()).arg(gpu->getMemoryClockOffset()).arg(memory));
+            }
+        }
+
+        if(this->powerMizerMode >= 0 && gpu->isPowerMizerAvailable() && gpu->getPowerMizerMode() != this->powerMizerMode) {
+            failures.append(QString("%1: PowerMizer mode is %2 instead of %3").arg(gpu->getIdentifier()).arg(gpu->getPowerMizerMode()).arg(this->powerMizerMode));
+        }
+
+        if(this->powerLimit > 0 && gpu->isPowerLimitControlAvailable()) {
+            double limit = qBound(gpu->getPowerLimitMin(), static_cast<double>(this->powerLimit), gpu->getPowerLimitMax());
+
+            if(qAbs(gpu->getPowerLimit() - limit) >= 1) {
+                failures.append(QString("%1: power limit is %2 W instead of %3 W").arg(gpu->getIdentifier()).arg(gpu->getPowerLimit()).arg(limit));
+            }
+        }
+
+        if(this->fanMode != FanUnchanged && gpu->isFanControlAvailable() && gpu->isFanControlEnabled() != (this->fanMode != FanAuto)) {
+            failures.append(QString("%1: fan control is %2").arg(gpu->getIdentifier()).arg(gpu->isFanControlEnabled() ? "manual" : "auto"));
+        }
+    }
+
+    return failures;
+}
+
+QJsonObject GPUProfile::toJson() const
+{
+    QJsonArray points;
+    foreach(QPoint point, this->fanCurve.points) {
+        points.append(QJsonArray() << point.x() << point.y());
+    }
+
+    QJsonObject fan;
+    fan.insert("mode", QString(FAN_MODE_NAMES[this->fanMode]));
+    fan.insert("speed", this->fanSpeed);
+    fan.insert("curve", points);
+    fan.insert("hysteresis", this->fanCurve.hysteresis);
+    fan.insert("rampUpPerSec", this->fanCurve.rampUpPerSec);
+    fan.insert("rampDownPerSec", this->fanCurve.rampDownPerSec);
+    fan.insert("deadband", this->fanCurve.deadband);
+    fan.insert("targetTemp", this->targetTemp);
+
+    QJsonObject json;
+    json.insert("name", this->name);
+    json.insert("fan", fan);
+
+    if(this->clockOffsets) {
+        QJsonObject clocks;
+        clocks.insert("coreOffset", this->coreClockOffset);
+        clocks.insert("memoryOffset", this->memoryClockOffset);
+        json.insert("clocks", clocks);
+    }
+
+    if(this->powerMizerMode >= 0 && this->powerMizerMode < POWERMIZER_COUNT) {
+        json.insert("powerMizer", QString(POWERMIZER_NAMES[this->powerMizerMode]));
+    }
+
+    if(this->powerLimit > 0) {
+        json.insert("powerLimit", this->powerLimit);
+    }
+
+    return json;
+}
+
+/**
+ * Reads a profile written by toJson()
+ * Missing or unknown values leave the corresponding setting unchanged
+ * @param json
+ * @return Profile
+ */
+GPUProfile GPUProfile::fromJson(QJsonObject json)
+{
+    GPUProfile profile;
+    profile.name = json.value("name").toString();
+
+    QJsonObject fan = json.value("fan").toObject();
+    QString fanMode = fan.value("mode").toString();
+    for(int i=0; i < FAN_MODE_COUNT; i++) {
+        if(fanMode == FAN_MODE_NAMES[i]) {
+            profile.fanMode = static_cast<FanMode>(i);
+        }
+    }
+
+    profile.fanSpeed   = qBound(0, fan.value("speed").toInt(profile.fanSpeed), 100);
+    profile.targetTemp = fan.value("targetTemp").toInt(profile.targetTemp);
+
+    QJsonArray points = fan.value("curve").toArray();
+    if(!points.isEmpty()) {
+        profile.fanCurve.points.clear();
+        foreach(QJsonValue point, points) {
+            profile.fanCurve.points.append(QPoint(point.toArray().at(0).toInt(), point.toArray().at(1).toInt()));
+        }
+    }
+    profile.fanCurve.hysteresis     = fan.value("hysteresis").toInt(profile.fanCurve.hysteresis);
+    profile.fanCurve.rampUpPerSec   = fan.value("rampUpPerSec").toInt(profile.fanCurve.rampUpPerSec);
+    profile.fanCurve.rampDownPerSec = fan.value("rampDownPerSec").toInt(profile.fanCurve.rampDownPerSec);
+    profile.fanCurve.deadband       = fan.value("deadband").toInt(profile.fanCurve.deadband);
+
+    if(json.contains("clocks")) {
+        QJsonObject clocks = json.value("clocks").toObject();
+        profile.clockOffsets      = true;
+        profile.coreClockOffset   = clocks.value("coreOffset").toInt();
+        profile.memoryClockOffset = clocks.value("memoryOffset").toInt();
+    }
+
+    QString powerMizer = json.value("powerMizer").toString();
+    for(int i=0; i < POWERMIZER_COUNT; i++) {
+        if(powerMizer == POWERMIZER_NAMES[i]) {
+            profile.powerMizerMode = i;
+        }
+    }
+
+    profile.powerLimit = qMax(0, json.value("powerLimit").toInt());
+
+    return profile;
+}
+
+/**
+ * Path of the file holding the profiles
+ * @return ex: ~/.config/GPUTweak/profiles.json
+ */
+QString GPUProfile::storagePath()
+{
+    return QDir(QStandardPaths::writableLocation(QStandardPaths::ConfigLocation)).filePath(QString("GPUTweak/%1").arg(PROFILES_FILE));
+}
+
+/**
+ * Reads all the saved profiles
+ * @return List of profiles, empty if the file does not exist
+ */
+QList<GPUProfile> GPUProfile::loadAll()
+{
+    QList<GPUProfile> profiles;
+
+    QFile file(GPUProfile::storagePath());
+    if(!file.open(QIODevice::ReadOnly)) {
+        return profiles;
+    }
+
+    foreach(QJsonValue value, QJsonDocument::fromJson(file.readAll()).object().value("profiles").toArray()) {
+        profiles.append(GPUProfile::fromJson(value.toObject()));
+    }
+
+    return profiles;
+}
+
+/**
+ * Replaces all the saved profiles
+ * @param profiles
+ * @return False if the file could not be written
+ */
+bool GPUProfile::saveAll(QList<GPUProfile> profiles)
+{
+    QJsonArray array;
+    foreach(const GPUProfile &profile, profiles) {
+        array.append(profile.toJson());
+    }
+
+    QJsonObject root;
+    root.insert("profiles", array);
+
+    QString path = GPUProfile::storagePath();
+    QDir().mkpath(QFileInfo(path).path());
+
+    QFile file(path);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+
+    return file.write(QJsonDocument(root).toJson()) >= 0;
+}
+
+/**
+ * Finds a saved profile
+ * @param name Name of the profile
+ * @param profile Set to the profile if found
+ * @return False if there is no profile with this name
+ */
+bool GPUProfile::load(QString name, GPUProfile &profile)
+{
+    foreach(const GPUProfile &saved, GPUProfile::loadAll()) {
+        if(saved.name == name) {
+            profile = saved;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Saves a profile, replacing the one with the same name
+ * @param profile
+ * @return False if the file could not be written
+ */
+bool GPUProfile::save(GPUProfile profile)
+{
+    QList<GPUProfile> profiles = GPUProfile::loadAll();
+
+    bool replaced = false;
+    for(int i=0; i < profiles.size(); i++) {
+        if(profiles.at(i).name == profile.name) {
+            profiles[i] = profile;
+            replaced = true;
+        }
+    }
+
+    if(!replaced) {
+        profiles.append(profile);
+    }
+
+    return GPUProfile::saveAll(profiles);
+}
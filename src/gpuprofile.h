@@ -0,0 +1,69 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GPUPROFILE_H
+#define GPUPROFILE_H
+
+#include <QJsonObject>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+#include "gpu.h"
+#include "gpufancontroller.h"
+
+/**
+ * Named set of tweaks that can be saved on disk and applied to several GPUs at once
+ */
+struct GPUProfile {
+    enum FanMode {
+        FanUnchanged,
+        FanAuto,
+        FanFixed,
+        FanCurve,
+        FanTargetTemp
+    };
+
+    QString     name;
+    FanMode     fanMode;
+    int         fanSpeed;          // %, for FanFixed
+    GPUFanCurve fanCurve;          // for FanCurve
+    int         targetTemp;        // °C, for FanTargetTemp
+    bool        clockOffsets;      // false to leave the clocks unchanged
+    int         coreClockOffset;   // MHz
+    int         memoryClockOffset; // MHz
+    int         powerMizerMode;    // GPU::PowerMizerMode, -1 to leave it unchanged
+    int         powerLimit;        // W, 0 to leave it unchanged
+
+    GPUProfile();
+
+    bool needsController() const;
+
+    bool        apply(QList<GPUFanController*> controllers) const;
+    QStringList verify(QList<GPUFanController*> controllers) const;
+
+    QJsonObject toJson() const;
+    static GPUProfile fromJson(QJsonObject json);
+
+    static QString           storagePath();
+    static QList<GPUProfile> loadAll();
+    static bool              saveAll(QList<GPUProfile> profiles);
+    static bool              load(QString name, GPUProfile &profile);
+    static bool              save(GPUProfile profile);
+};
+
+#endif // GPUPROFILE_H
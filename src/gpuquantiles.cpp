@@ -0,0 +1,124 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "gpuquantiles.h"
+
+/**
+ * Length of a time bucket, the granularity of the windows
+ */
+const int BUCKET_SECS = 300;
+/**
+ * Number of buckets kept, 24 hours
+ */
+const int MAX_BUCKETS = 288;
+/**
+ * Constant for the number of msecs in a sec
+ */
+const int MSEC_IN_A_SEC = 1000;
+
+GPUQuantiles::GPUQuantiles(int seriesCount)
+{
+    this->seriesCount = seriesCount;
+    this->total.resize(seriesCount);
+}
+
+int GPUQuantiles::getBucketSecs()
+{
+    return BUCKET_SECS;
+}
+
+int GPUQuantiles::getMaxWindowSecs()
+{
+    return BUCKET_SECS * MAX_BUCKETS;
+}
+
+/**
+ * Counts a value in the bucket of its time
+ * @param series Index of the series
+ * @param msecs  Time of the value, msecs since epoch
+ * @param value
+ */
+void GPUQuantiles::add(int series, qint64 msecs, double value)
+{
+    qint64 start = msecs - msecs % (BUCKET_SECS * MSEC_IN_A_SEC);
+
+    if(this->buckets.isEmpty() || this->buckets.last().start < start) {
+        Bucket bucket;
+        bucket.start = start;
+        bucket.sketches.resize(this->seriesCount);
+        this->buckets.append(bucket);
+
+        while(this->buckets.size() > MAX_BUCKETS) {
+            this->buckets.removeFirst();
+        }
+    }
+
+    // A value older than the last bucket, ex: after a clock change, goes to the last one
+    this->buckets.last().sketches[series].add(value);
+    this->total[series].add(value);
+}
+
+/**
+ * Summarizes a series over a window ending now
+ * The window is rounded up to whole buckets
+ * @param series     Index of the series
+ * @param now        End of the window, msecs since epoch
+ * @param windowSecs Length of the window, 0 for everything since the start
+ * @return Merged sketch
+ */
+GPUSketch GPUQuantiles::getSketch(int series, qint64 now, int windowSecs) const
+{
+    if(windowSecs <= 0) {
+        return this->total.at(series);
+    }
+
+    qint64 from = now - static_cast<qint64>(windowSecs) * MSEC_IN_A_SEC;
+
+    GPUSketch sketch;
+    for(int i=this->buckets.size() - 1; i >= 0 && this->buckets.at(i).start + BUCKET_SECS * MSEC_IN_A_SEC > from; i--) {
+        sketch.merge(this->buckets.at(i).sketches.at(series));
+    }
+
+    return sketch;
+}
+
+void GPUQuantiles::clear()
+{
+    this->buckets.clear();
+    this->total.fill(GPUSketch());
+}
+
+/**
+ * Approximate memory used by the sketches
+ * @return Bytes
+ */
+qint64 GPUQuantiles::getMemoryUsage() const
+{
+    qint64 bytes = 0;
+
+    foreach(const Bucket &bucket, this->buckets) {
+        foreach(const GPUSketch &sketch, bucket.sketches) {
+            bytes += sizeof(GPUSketch) + sketch.getBinCount() * sizeof(quint32);
+        }
+    }
+
+    foreach(const GPUSketch &sketch, this->total) {
+        bytes += sizeof(GPUSketch) + sketch.getBinCount() * sizeof(quint32);
+    }
+
+    return bytes;
+}
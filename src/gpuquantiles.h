@@ -0,0 +1,59 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GPUQUANTILES_H
+#define GPUQUANTILES_H
+
+#include <QList>
+#include <QVector>
+
+#include "gpusketch.h"
+
+/**
+ * Quantile sketches of several series, kept in time buckets so any recent
+ * window can be summarized by merging the buckets it covers
+ * Memory is bounded: old buckets are dropped and each sketch has a bounded size
+ */
+class GPUQuantiles
+{
+public:
+    explicit GPUQuantiles(int seriesCount);
+
+    void      add(int series, qint64 msecs, double value);
+    GPUSketch getSketch(int series, qint64 now, int windowSecs) const;
+    void      clear();
+
+    qint64    getMemoryUsage() const;
+
+    static int getBucketSecs();
+    static int getMaxWindowSecs();
+
+private:
+    /**
+     * Sketches of all the series for a period of time
+     */
+    struct Bucket {
+        qint64             start; // msecs since epoch
+        QVector<GPUSketch> sketches;
+    };
+
+    int                seriesCount;
+    QList<Bucket>      buckets; // oldest first
+    QVector<GPUSketch> total;   // since the start or the last clear
+};
+
+#endif // GPUQUANTILES_H
@@ -0,0 +1,139 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "gpuregistry.h"
+
+#include "gpubackends.h"
+#include "gputrace.h"
+
+/**
+ * A GPU is removed once it is missing from this many scans in a row,
+ * so a hiccup of the driver tool does not tear it down
+ */
+const int REMOVE_AFTER_MISSED_SCANS = 2;
+
+GPURegistry::GPURegistry(QList<GPU*> gpus, QObject *parent) :
+    QObject(parent)
+{
+    this->gpus = gpus;
+
+    connect(&this->timer, SIGNAL(timeout()), this, SLOT(rescan()));
+}
+
+GPURegistry::~GPURegistry()
+{
+    // no-op
+}
+
+/**
+ * GPUs currently present
+ * @return List of GPUs
+ */
+QList<GPU*> GPURegistry::getGPUs() const
+{
+    return this->gpus;
+}
+
+/**
+ * Starts enumerating the backends periodically
+ * @param intervalMsecs Time between two scans
+ */
+void GPURegistry::start(int intervalMsecs)
+{
+    this->timer.start(intervalMsecs);
+}
+
+void GPURegistry::stop()
+{
+    this->timer.stop();
+}
+
+/**
+ * Enumerates the backends and applies the differences with the known GPUs
+ * A GPU listed with the same bus id but another identifier (ex: after a driver reload changed
+ * the indexes) is created again, since its queries would target another card
+ */
+void GPURegistry::rescan()
+{
+    GPUTWEAK_TRACE_SCOPE("GPURegistry::rescan");
+
+    foreach(GPUBackend *backend, GPUBackends::getBackends()) {
+        // Identifier by bus id, the ones left at the end are new
+        QMap<QString, QString> present = backend->enumerate();
+
+        QList<GPU*> removed;
+
+        foreach(GPU *gpu, this->gpus) {
+            if(GPUBackends::getBackend(gpu) != backend) {
+                continue;
+            }
+
+            QString busId = gpu->getBusId();
+
+            if(!present.contains(busId)) {
+                int missed = this->missedScans.value(gpu) + 1;
+
+                if(missed >= REMOVE_AFTER_MISSED_SCANS) {
+                    removed.append(gpu);
+                } else {
+                    this->missedScans.insert(gpu, missed);
+                }
+
+                continue;
+            }
+
+            this->missedScans.remove(gpu);
+
+            if(present.value(busId) != gpu->getIdentifier()) {
+                removed.append(gpu);
+                continue;
+            }
+
+            present.remove(busId);
+        }
+
+        foreach(GPU *gpu, removed) {
+            this->remove(gpu);
+        }
+
+        foreach(QString busId, present.keys()) {
+            GPU *gpu = GPUBackends::createGPU(backend, busId);
+            if(!gpu) {
+                continue;
+            }
+
+            this->gpus.append(gpu);
+
+            emit gpuAdded(gpu);
+        }
+    }
+}
+
+/**
+ * Removes a GPU, the receivers of gpuRemoved() can still use it
+ * @param gpu
+ */
+void GPURegistry::remove(GPU *gpu)
+{
+    this->gpus.removeOne(gpu);
+    this->missedScans.remove(gpu);
+
+    emit gpuRemoved(gpu);
+
+    GPUBackends::forget(gpu);
+    gpu->deleteLater();
+}
@@ -0,0 +1,68 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GPUREGISTRY_H
+#define GPUREGISTRY_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QTimer>
+
+#include "gpu.h"
+
+/**
+ * Set of the GPUs currently present
+ * The backends are enumerated periodically and compared by bus id: only the GPUs that appeared
+ * are created and only the ones that disappeared are removed, the others are not touched
+ * GPUs that do not come from a backend (ex: simulated) are kept forever
+ */
+class GPURegistry : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit GPURegistry(QList<GPU*> gpus, QObject *parent = 0);
+    ~GPURegistry();
+
+    QList<GPU*> getGPUs() const;
+
+    void start(int intervalMsecs);
+    void stop();
+
+signals:
+    /**
+     * Emitted when a GPU appeared, or came back
+     */
+    void gpuAdded(GPU *gpu);
+    /**
+     * Emitted when a GPU disappeared, it is deleted once the event loop is reached
+     */
+    void gpuRemoved(GPU *gpu);
+
+public slots:
+    void rescan();
+
+private:
+    void remove(GPU *gpu);
+
+    QList<GPU*>      gpus;
+    QHash<GPU*, int> missedScans; // consecutive scans that did not list the GPU
+    QTimer           timer;
+};
+
+#endif // GPUREGISTRY_H
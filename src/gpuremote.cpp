@@ -0,0 +1,243 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "gpuremote.h"
+
+/**
+ * @param host        Name of the host given by its agent
+ * @param description Constants of the GPU
+ */
+GPURemote::GPURemote(QString host, const GPUNetwork::GPUDescription &description) : GPU()
+{
+    this->host = host;
+    this->description = description;
+    this->sample = GPUNetwork::Sample();
+    this->sample.perfLevel = -1;
+    this->online = true;
+}
+
+GPURemote::~GPURemote()
+{
+    // no-op
+}
+
+void GPURemote::setDescription(const GPUNetwork::GPUDescription &description)
+{
+    this->description = description;
+}
+
+/**
+ * Stores values received from the collector, they are reported by the next fetch
+ * @param sample
+ */
+void GPURemote::setSample(const GPUNetwork::Sample &sample)
+{
+    GPUNetwork::merge(this->sample, sample);
+}
+
+/**
+ * Sets whether the agent of the host is connected, nothing is reported while it is not
+ * @param online
+ */
+void GPURemote::setOnline(bool online)
+{
+    this->online = online;
+}
+
+bool GPURemote::isOnline()
+{
+    return this->online;
+}
+
+void GPURemote::fetchConstants()
+{
+    // Received with the description
+}
+
+/**
+ * Reports the last values received, nothing is read from the network here
+ * @param metrics Metrics to report, only the ones the agent sends are
+ */
+void GPURemote::fetchVariables(Metrics metrics)
+{
+    this->updatedMetrics = this->online ? metrics & Metrics(QFlag(this->sample.metrics)) : Metrics();
+
+    emit updated();
+}
+
+/**
+ * Identifier prefixed by the host, ex: node12/gpu:0
+ * @return Identifier
+ */
+QString GPURemote::getIdentifier()
+{
+    return QString("%1/%2").arg(this->host).arg(this->description.identifier);
+}
+
+QString GPURemote::getName()
+{
+    return this->online ? this->description.name : QString("%1 (offline)").arg(this->description.name);
+}
+
+QString GPURemote::getDriverVersion()
+{
+    return this->description.driverVersion;
+}
+
+QString GPURemote::getBusType()
+{
+    return this->description.busType;
+}
+
+/**
+ * Bus id prefixed by the host, so it is unique among all the GPUs, ex: node12/PCI:1:0:0
+ * @return Bus id
+ */
+QString GPURemote::getBusId()
+{
+    return QString("%1/%2").arg(this->host).arg(this->description.busId);
+}
+
+int GPURemote::getTotalMemory()
+{
+    return this->description.totalMemory;
+}
+
+int GPURemote::getCurrentCoreTemp()
+{
+    return this->sample.coreTemp;
+}
+
+int GPURemote::getCurrentFanSpeed()
+{
+    return this->sample.fanSpeed;
+}
+
+int GPURemote::getCurrentCoreClock()
+{
+    return this->sample.coreClock;
+}
+
+int GPURemote::getCurrentMemoryClock()
+{
+    return this->sample.memoryClock;
+}
+
+int GPURemote::getCurrentCoreUse()
+{
+    return this->sample.coreUse;
+}
+
+int GPURemote::getCurrentMemoryUse()
+{
+    return this->sample.memoryUse;
+}
+
+bool GPURemote::isFanControlAvailable()
+{
+    return false;
+}
+
+bool GPURemote::isFanControlEnabled()
+{
+    return this->sample.fanControlEnabled != 0;
+}
+
+bool GPURemote::isCoreClockControlAvailable()
+{
+    return false;
+}
+
+bool GPURemote::isCoreClockControlEnabled()
+{
+    return false;
+}
+
+bool GPURemote::isMemoryClockControlAvailable()
+{
+    return false;
+}
+
+bool GPURemote::isMemoryClockControlEnabled()
+{
+    return false;
+}
+
+int GPURemote::getCoreClockOffset()
+{
+    return this->sample.coreClockOffset;
+}
+
+int GPURemote::getMemoryClockOffset()
+{
+    return this->sample.memoryClockOffset;
+}
+
+int GPURemote::getPerfLevelCount()
+{
+    return this->description.perfLevelCount;
+}
+
+int GPURemote::getCurrentPerfLevel()
+{
+    return this->sample.perfLevel;
+}
+
+int GPURemote::getPcieMaxLinkWidth()
+{
+    return this->description.pcieMaxLinkWidth;
+}
+
+int GPURemote::getPcieMaxLinkGen()
+{
+    return this->description.pcieMaxLinkGen;
+}
+
+int GPURemote::getPcieLinkWidth()
+{
+    return this->sample.pcieLinkWidth;
+}
+
+int GPURemote::getPcieLinkGen()
+{
+    return this->sample.pcieLinkGen;
+}
+
+bool GPURemote::isPowerDrawAvailable()
+{
+    return this->sample.metrics & GPU::Power;
+}
+
+double GPURemote::getCurrentPowerDraw()
+{
+    return static_cast<double>(this->sample.powerDraw) / GPUNetwork::POWER_SCALE;
+}
+
+double GPURemote::getPowerLimit()
+{
+    return static_cast<double>(this->sample.powerLimit) / GPUNetwork::POWER_SCALE;
+}
+
+void GPURemote::setFanControlEnabled(bool enabled)
+{
+    Q_UNUSED(enabled);
+}
+
+void GPURemote::setFanSpeed(int speed)
+{
+    Q_UNUSED(speed);
+}
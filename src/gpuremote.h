@@ -15,25 +15,31 @@
  * You should have received a copy of the GNU Lesser General Public License
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
-#ifndef GPUNVIDIA_H
-#define GPUNVIDIA_H
+#ifndef GPUREMOTE_H
+#define GPUREMOTE_H
 
 #include <QString>
 
 #include "gpu.h"
+#include "gpunetwork.h"
 
 /**
- * NVIDIA Card using the nvidia proprietary driver
- * Data is accessed trough the nvidia-settings command-line utility
+ * GPU of another host, whose values are streamed by a collector, see GPURemoteLink
+ * Fetching only reports the last values received, the card cannot be tweaked
  */
-class GPUNvidia : public GPU
+class GPURemote : public GPU
 {
 public:
-    GPUNvidia(int id, QString name);
-    ~GPUNvidia();
+    GPURemote(QString host, const GPUNetwork::GPUDescription &description);
+    ~GPURemote();
+
+    void    setDescription(const GPUNetwork::GPUDescription &description);
+    void    setSample(const GPUNetwork::Sample &sample);
+    void    setOnline(bool online);
+    bool    isOnline();
 
     void    fetchConstants();
-    void    fetchVariables();
+    void    fetchVariables(Metrics metrics = AllMetrics);
 
     QString getIdentifier();
     QString getName();
@@ -41,7 +47,6 @@ public:
     QString getBusType();
     QString getBusId();
     int     getTotalMemory();
-    int     getCudaCores();
 
     int     getCurrentCoreTemp();
     int     getCurrentFanSpeed();
@@ -57,36 +62,29 @@ public:
     bool    isMemoryClockControlAvailable();
     bool    isMemoryClockControlEnabled();
 
-    void    setFanControlEnabled(bool enabled);
-    void    setFanSpeed(int speed);
+    int     getCoreClockOffset();
+    int     getMemoryClockOffset();
 
-private:
-    QString queryStringAttribute(QString attribute);
-    int     queryIntAttribute(QString attribute);
+    int     getPerfLevelCount();
+    int     getCurrentPerfLevel();
 
-    // Constants
-    int     id;   // nvidia id of the gpu (0-based)
-    QString name; // card name, comes from the cards list
+    int     getPcieMaxLinkWidth();
+    int     getPcieMaxLinkGen();
+    int     getPcieLinkWidth();
+    int     getPcieLinkGen();
 
-    // Constants, fetched from nvidia-settings
-    QString nvidiaDriverVersion;     // ex: 331.113
-    int     pcieMaxLinkWidth;        // ex: 16
-    int     pcieCurrentLinkWidth;    // ex: 16
-    int     pcieGen;                 // ex: 2
-    int     pciBus;                  // 1st part of PCI address
-    int     pciDevice;               // 2nd part of PCI address
-    int     pciFunc;                 // 3rd part of PCI address
-    int     totalDedicatedGPUMemory; // ex: 2048
-    int     cudaCores;               // ex: 96
+    bool    isPowerDrawAvailable();
+    double  getCurrentPowerDraw();
+    double  getPowerLimit();
 
-    // Variables, fetched from nvidia-settings
-    int     gpuCoreTemp;             // ex: 37
-    int     gpuCurrentNvClock;       // MHz
-    int     gpuCurrentMemoryClock;   // MHz
-    int     currentCoreUse;          // %
-    int     currentMemoryUse;        // %
-    int     currentFanSpeed;         // %
-    bool    fanControlState;
+    void    setFanControlEnabled(bool enabled);
+    void    setFanSpeed(int speed);
+
+private:
+    QString                    host;
+    GPUNetwork::GPUDescription description;
+    GPUNetwork::Sample         sample; // merged, holds the metrics ever received
+    bool                       online;
 };
 
-#endif // GPUNVIDIA_H
+#endif // GPUREMOTE_H
@@ -0,0 +1,195 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "gpuremotelink.h"
+
+#include <QTextStream>
+
+/**
+ * Delay before reconnecting to the collector
+ */
+const int RECONNECT_MSECS = 5000;
+
+GPURemoteLink::GPURemoteLink(QObject *parent) :
+    QObject(parent)
+{
+    this->port = 0;
+
+    connect(&this->socket, SIGNAL(connected()), this, SLOT(connected()));
+    connect(&this->socket, SIGNAL(disconnected()), this, SLOT(disconnected()));
+    connect(&this->socket, SIGNAL(error(QAbstractSocket::SocketError)), this, SLOT(disconnected()));
+    connect(&this->socket, SIGNAL(readyRead()), this, SLOT(readFrames()));
+
+    this->reconnectTimer.setSingleShot(true);
+    connect(&this->reconnectTimer, SIGNAL(timeout()), this, SLOT(reconnect()));
+}
+
+GPURemoteLink::~GPURemoteLink()
+{
+    // no-op
+}
+
+/**
+ * Connects to the collector, and reconnects whenever the connection is lost
+ * @param host
+ * @param port
+ */
+void GPURemoteLink::connectTo(QString host, quint16 port)
+{
+    this->host = host;
+    this->port = port;
+
+    this->reconnect();
+}
+
+/**
+ * GPUs of all the hosts received so far
+ * @return List of GPUs
+ */
+QList<GPU*> GPURemoteLink::getGPUs() const
+{
+    QList<GPU*> list;
+
+    foreach(const QList<GPURemote*> &hostGPUs, this->gpus) {
+        foreach(GPURemote *gpu, hostGPUs) {
+            list.append(gpu);
+        }
+    }
+
+    return list;
+}
+
+void GPURemoteLink::connected()
+{
+    this->buffer.clear();
+
+    QByteArray payload;
+    QDataStream stream(&payload, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream << static_cast<quint8>(GPUNetwork::ViewerRole) << GPUNetwork::protocolVersion();
+
+    this->socket.write(GPUNetwork::encodeFrame(GPUNetwork::Hello, payload));
+}
+
+/**
+ * Shows all the GPUs as offline until the collector describes them again
+ */
+void GPURemoteLink::disconnected()
+{
+    if(this->reconnectTimer.isActive()) {
+        return;
+    }
+
+    // Started first, aborting emits disconnected() again
+    this->reconnectTimer.start(RECONNECT_MSECS);
+
+    this->setAllOnline(false);
+    this->socket.abort();
+}
+
+void GPURemoteLink::reconnect()
+{
+    this->socket.abort();
+    this->socket.connectToHost(this->host, this->port);
+}
+
+void GPURemoteLink::readFrames()
+{
+    this->buffer.append(this->socket.readAll());
+
+    GPUNetwork::Frame frame;
+    GPUNetwork::ReadResult result;
+
+    while((result = GPUNetwork::takeFrame(this->buffer, frame)) == GPUNetwork::FrameRead) {
+        switch(frame.type) {
+        case GPUNetwork::Describe:
+            this->readDescribe(frame.payload);
+            break;
+        case GPUNetwork::Samples:
+            this->readSamples(frame.payload);
+            break;
+        default:
+            break;
+        }
+    }
+
+    if(result == GPUNetwork::FrameInvalid) {
+        QTextStream(stderr) << "Invalid frame from " << this->host << ":" << this->port << endl;
+        this->disconnected();
+    }
+}
+
+/**
+ * Creates the GPUs of a host seen for the first time, updates the others
+ * @param payload
+ */
+void GPURemoteLink::readDescribe(const QByteArray &payload)
+{
+    QDataStream stream(payload);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    QString name;
+    bool    online;
+    quint32 count;
+    stream >> name >> online >> count;
+
+    QList<GPURemote*> &hostGPUs = this->gpus[name];
+
+    for(quint32 i=0; i < count && stream.status() == QDataStream::Ok; i++) {
+        GPUNetwork::GPUDescription description;
+        stream >> description;
+
+        if(static_cast<int>(i) < hostGPUs.size()) {
+            hostGPUs.at(i)->setDescription(description);
+            hostGPUs.at(i)->setOnline(online);
+            continue;
+        }
+
+        GPURemote *gpu = new GPURemote(name, description);
+        gpu->setOnline(online);
+        hostGPUs.append(gpu);
+
+        emit gpuAdded(gpu);
+    }
+}
+
+void GPURemoteLink::readSamples(const QByteArray &payload)
+{
+    QString name;
+    QList<GPUNetwork::Sample> samples;
+
+    if(!GPUNetwork::decodeSamples(payload, name, samples)) {
+        return;
+    }
+
+    QList<GPURemote*> hostGPUs = this->gpus.value(name);
+
+    foreach(const GPUNetwork::Sample &sample, samples) {
+        if(sample.gpu < hostGPUs.size()) {
+            hostGPUs.at(sample.gpu)->setSample(sample);
+        }
+    }
+}
+
+void GPURemoteLink::setAllOnline(bool online)
+{
+    foreach(const QList<GPURemote*> &hostGPUs, this->gpus) {
+        foreach(GPURemote *gpu, hostGPUs) {
+            gpu->setOnline(online);
+        }
+    }
+}
@@ -0,0 +1,74 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GPUREMOTELINK_H
+#define GPUREMOTELINK_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QList>
+#include <QMap>
+#include <QTcpSocket>
+#include <QTimer>
+
+#include "gpu.h"
+#include "gpuremote.h"
+
+/**
+ * Connection of a viewer to a collector
+ * Creates a GPURemote for every GPU of every host the collector knows and keeps their values current
+ */
+class GPURemoteLink : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit GPURemoteLink(QObject *parent = 0);
+    ~GPURemoteLink();
+
+    void connectTo(QString host, quint16 port);
+
+    QList<GPU*> getGPUs() const;
+
+signals:
+    /**
+     * Emitted when the collector tells about a GPU for the first time
+     */
+    void gpuAdded(GPU *gpu);
+
+private:
+    void readDescribe(const QByteArray &payload);
+    void readSamples(const QByteArray &payload);
+    void setAllOnline(bool online);
+
+    QTcpSocket socket;
+    QByteArray buffer; // bytes received, until a whole frame is there
+    QString    host;
+    quint16    port;
+
+    QMap<QString, QList<GPURemote*> > gpus; // by host, in the order of its agent
+
+    QTimer reconnectTimer;
+
+private slots:
+    void connected();
+    void disconnected();
+    void readFrames();
+    void reconnect();
+};
+
+#endif // GPUREMOTELINK_H
@@ -0,0 +1,470 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "gpusimulated.h"
+
+#include <QtGlobal>
+
+#include "gputrace.h"
+
+/**
+ * Clocks of the simulated card at full load
+ */
+const int SIMULATED_MAX_CORE_CLOCK   = 1800;
+const int SIMULATED_MAX_MEMORY_CLOCK = 5000;
+/**
+ * Idle clocks of the simulated card
+ */
+const int SIMULATED_IDLE_CORE_CLOCK   = 300;
+const int SIMULATED_IDLE_MEMORY_CLOCK = 405;
+/**
+ * Core clock of the middle performance level
+ */
+const int SIMULATED_MIDDLE_CORE_CLOCK = 900;
+/**
+ * Temperature from which the card cuts its clock, and by how much for each degree above it (MHz)
+ */
+const int SIMULATED_THROTTLE_TEMP        = 84;
+const int SIMULATED_THROTTLE_MHZ_PER_DEG = 40;
+/**
+ * Valid ranges of the clock offsets, in MHz
+ */
+const int SIMULATED_CORE_OFFSET_MIN   = -200;
+const int SIMULATED_CORE_OFFSET_MAX   = 1000;
+const int SIMULATED_MEMORY_OFFSET_MIN = -1000;
+const int SIMULATED_MEMORY_OFFSET_MAX = 2000;
+/**
+ * Number of performance levels, and use above which the card leaves the idle and middle ones
+ */
+const int SIMULATED_PERF_LEVELS       = 3;
+const int SIMULATED_MIDDLE_LEVEL_USE  = 10;
+const int SIMULATED_HIGHEST_LEVEL_USE = 40;
+/**
+ * PCI-E link of the simulated card, which drops to Gen1 in the idle performance level
+ */
+const int SIMULATED_PCIE_WIDTH   = 16;
+const int SIMULATED_PCIE_MAX_GEN = 3;
+/**
+ * Ambient temperature the card cools down to
+ */
+const int SIMULATED_AMBIENT_TEMP = 30;
+/**
+ * Thermal model: power drawn at idle and per % of use (W), heat capacity
+ * of the card (J/°C) and thermal conductance to the air without fan and
+ * per % of fan speed (W/°C)
+ */
+const double SIMULATED_IDLE_POWER          = 30.0;
+const double SIMULATED_POWER_PER_USE       = 2.2;
+const double SIMULATED_HEAT_CAPACITY       = 120.0;
+const double SIMULATED_PASSIVE_CONDUCTANCE = 2.0;
+const double SIMULATED_FAN_CONDUCTANCE     = 0.06;
+/**
+ * Default power limit of the simulated card and its range, the model never draws more (W)
+ */
+const double SIMULATED_POWER_LIMIT     = 250.0;
+const double SIMULATED_POWER_LIMIT_MIN = 100.0;
+const double SIMULATED_POWER_LIMIT_MAX = 300.0;
+/**
+ * Simulated time between two fetches, in seconds
+ */
+const double SIMULATED_FETCH_SECS = 1.0;
+
+GPUSimulated::GPUSimulated(int ID) : GPU()
+{
+    this->id   = ID;
+    this->seed = 2463534242u + static_cast<quint32>(ID) * 7919u;
+
+    this->fetchConstants();
+
+    this->coreTemp        = SIMULATED_AMBIENT_TEMP + 10;
+    this->pinnedLoad      = -1;
+    this->coreUse         = 0;
+    this->memoryUse       = 0;
+    this->fanSpeed        = 30;
+    this->coreClock       = SIMULATED_IDLE_CORE_CLOCK;
+    this->memoryClock     = SIMULATED_IDLE_MEMORY_CLOCK;
+    this->fanControlState = false;
+    this->coreClockOffset   = 0;
+    this->memoryClockOffset = 0;
+    this->perfLevel         = 0;
+    this->powerMizerMode    = PowerMizerAdaptive;
+    this->powerDraw         = SIMULATED_IDLE_POWER;
+    this->powerLimit        = SIMULATED_POWER_LIMIT;
+}
+
+GPUSimulated::~GPUSimulated()
+{
+    // no-op
+}
+
+/**
+ * Creates a given number of simulated GPUs
+ * @param count Number of GPUs
+ * @return List of GPUs
+ */
+QList<GPU*> GPUSimulated::getGPUs(int count)
+{
+    QList<GPU*> list;
+
+    for(int i=0; i < count; i++) {
+        list.append(new GPUSimulated(i));
+    }
+
+    return list;
+}
+
+void GPUSimulated::fetchConstants()
+{
+    // Nothing to fetch, constants are computed in the getters
+}
+
+void GPUSimulated::fetchVariables(Metrics metrics)
+{
+    GPUTWEAK_TRACE_SCOPE("GPUSimulated::fetchVariables");
+
+    // The simulation always advances, only the reported metrics depend on the request
+    if(this->pinnedLoad < 0) {
+        this->coreUse = qBound(0, this->coreUse + this->randomStep(15), 100);
+    } else {
+        this->coreUse = this->pinnedLoad;
+    }
+    this->memoryUse = qBound(0, this->coreUse / 2 + this->randomStep(5), 100);
+
+    // Adaptive modes drop to the lower levels when the load is light
+    if(this->powerMizerMode == PowerMizerMaxPerformance || this->coreUse > SIMULATED_HIGHEST_LEVEL_USE) {
+        this->perfLevel = SIMULATED_PERF_LEVELS - 1;
+    } else {
+        this->perfLevel = this->coreUse > SIMULATED_MIDDLE_LEVEL_USE ? 1 : 0;
+    }
+
+    // Like the NVIDIA driver, offsets only apply to the highest performance level
+    if(this->perfLevel == SIMULATED_PERF_LEVELS - 1) {
+        this->coreClock = SIMULATED_MAX_CORE_CLOCK + this->coreClockOffset;
+    } else {
+        this->coreClock = this->perfLevel == 1 ? SIMULATED_MIDDLE_CORE_CLOCK : SIMULATED_IDLE_CORE_CLOCK;
+    }
+
+    // A hot card gets throttled
+    if(this->getCurrentCoreTemp() > SIMULATED_THROTTLE_TEMP) {
+        this->coreClock = qMax(SIMULATED_IDLE_CORE_CLOCK, this->coreClock - (this->getCurrentCoreTemp() - SIMULATED_THROTTLE_TEMP) * SIMULATED_THROTTLE_MHZ_PER_DEG);
+    }
+    this->memoryClock = this->coreUse > 0 ? SIMULATED_MAX_MEMORY_CLOCK + this->memoryClockOffset : SIMULATED_IDLE_MEMORY_CLOCK;
+
+    this->simulate(SIMULATED_FETCH_SECS);
+
+    if(!this->fanControlState) {
+        // Mimics the driver automatic fan curve
+        this->fanSpeed = qBound(30, this->getCurrentCoreTemp() - 20, 100);
+    }
+
+    this->updatedMetrics = metrics;
+
+    emit updated();
+}
+
+/**
+ * Pins the load of the card, to get reproducible thermal scenarios
+ * @param use Core use in %, -1 to get back to a random load
+ */
+void GPUSimulated::setLoad(int use)
+{
+    this->pinnedLoad = use < 0 ? -1 : qMin(use, 100);
+}
+
+/**
+ * Advances the thermal model: the power drawn heats the card and the air
+ * flow given by the fan cools it down towards the ambient temperature
+ * @param secs Simulated time
+ */
+void GPUSimulated::simulate(double secs)
+{
+    double conductance = SIMULATED_PASSIVE_CONDUCTANCE + SIMULATED_FAN_CONDUCTANCE * this->fanSpeed;
+
+    this->powerDraw = qMin(SIMULATED_IDLE_POWER + SIMULATED_POWER_PER_USE * this->coreUse, this->powerLimit);
+    this->coreTemp += (this->powerDraw - conductance * (this->coreTemp - SIMULATED_AMBIENT_TEMP)) * secs / SIMULATED_HEAT_CAPACITY;
+}
+
+/**
+ * Xorshift generator giving a value in [-range;range]
+ * @param range Max absolute value
+ * @return Random value
+ */
+int GPUSimulated::randomStep(int range)
+{
+    this->seed ^= this->seed << 13;
+    this->seed ^= this->seed >> 17;
+    this->seed ^= this->seed << 5;
+
+    return static_cast<int>(this->seed % static_cast<quint32>(2 * range + 1)) - range;
+}
+
+QString GPUSimulated::getIdentifier()
+{
+    return QString("sim:%1").arg(this->id);
+}
+
+QString GPUSimulated::getName()
+{
+    return QString("Simulated GPU %1").arg(this->id);
+}
+
+QString GPUSimulated::getDriverVersion()
+{
+    return "simulated";
+}
+
+QString GPUSimulated::getBusType()
+{
+    return "PCI-E x16 Gen3 @ x16";
+}
+
+int GPUSimulated::getPcieMaxLinkWidth()
+{
+    return SIMULATED_PCIE_WIDTH;
+}
+
+int GPUSimulated::getPcieMaxLinkGen()
+{
+    return SIMULATED_PCIE_MAX_GEN;
+}
+
+int GPUSimulated::getPcieLinkWidth()
+{
+    return SIMULATED_PCIE_WIDTH;
+}
+
+int GPUSimulated::getPcieLinkGen()
+{
+    return this->perfLevel == 0 ? 1 : SIMULATED_PCIE_MAX_GEN;
+}
+
+QString GPUSimulated::getBusId()
+{
+    return QString("PCI:%1:0:0").arg(this->id + 1);
+}
+
+int GPUSimulated::getTotalMemory()
+{
+    return 8192;
+}
+
+int GPUSimulated::getCurrentCoreTemp()
+{
+    return qRound(this->coreTemp);
+}
+
+int GPUSimulated::getCurrentFanSpeed()
+{
+    return this->fanSpeed;
+}
+
+int GPUSimulated::getCurrentCoreClock()
+{
+    return this->coreClock;
+}
+
+int GPUSimulated::getCurrentMemoryClock()
+{
+    return this->memoryClock;
+}
+
+int GPUSimulated::getCurrentCoreUse()
+{
+    return this->coreUse;
+}
+
+int GPUSimulated::getCurrentMemoryUse()
+{
+    return this->memoryUse;
+}
+
+bool GPUSimulated::isFanControlAvailable()
+{
+    return true;
+}
+
+bool GPUSimulated::isFanControlEnabled()
+{
+    return this->fanControlState;
+}
+
+bool GPUSimulated::isCoreClockControlAvailable()
+{
+    return true;
+}
+
+bool GPUSimulated::isCoreClockControlEnabled()
+{
+    return this->coreClockOffset != 0;
+}
+
+bool GPUSimulated::isMemoryClockControlAvailable()
+{
+    return true;
+}
+
+bool GPUSimulated::isMemoryClockControlEnabled()
+{
+    return this->memoryClockOffset != 0;
+}
+
+int GPUSimulated::getPerfLevelCount()
+{
+    return SIMULATED_PERF_LEVELS;
+}
+
+int GPUSimulated::getCurrentPerfLevel()
+{
+    return this->perfLevel;
+}
+
+bool GPUSimulated::isPowerMizerAvailable()
+{
+    return true;
+}
+
+GPU::PowerMizerMode GPUSimulated::getPowerMizerMode()
+{
+    return this->powerMizerMode;
+}
+
+int GPUSimulated::getCoreClockOffset()
+{
+    return this->coreClockOffset;
+}
+
+int GPUSimulated::getCoreClockOffsetMin()
+{
+    return SIMULATED_CORE_OFFSET_MIN;
+}
+
+int GPUSimulated::getCoreClockOffsetMax()
+{
+    return SIMULATED_CORE_OFFSET_MAX;
+}
+
+int GPUSimulated::getMemoryClockOffset()
+{
+    return this->memoryClockOffset;
+}
+
+int GPUSimulated::getMemoryClockOffsetMin()
+{
+    return SIMULATED_MEMORY_OFFSET_MIN;
+}
+
+int GPUSimulated::getMemoryClockOffsetMax()
+{
+    return SIMULATED_MEMORY_OFFSET_MAX;
+}
+
+bool GPUSimulated::isPowerDrawAvailable()
+{
+    return true;
+}
+
+double GPUSimulated::getCurrentPowerDraw()
+{
+    return this->powerDraw;
+}
+
+double GPUSimulated::getPowerLimit()
+{
+    return this->powerLimit;
+}
+
+bool GPUSimulated::isPowerLimitControlAvailable()
+{
+    return true;
+}
+
+double GPUSimulated::getPowerLimitMin()
+{
+    return SIMULATED_POWER_LIMIT_MIN;
+}
+
+double GPUSimulated::getPowerLimitDefault()
+{
+    return SIMULATED_POWER_LIMIT;
+}
+
+double GPUSimulated::getPowerLimitMax()
+{
+    return SIMULATED_POWER_LIMIT_MAX;
+}
+
+void GPUSimulated::setFanControlEnabled(bool enabled)
+{
+    this->fanControlState = enabled;
+
+    this->updatedMetrics = FanControlState;
+
+    emit updated();
+}
+
+void GPUSimulated::setFanSpeed(int speed)
+{
+    if(!this->fanControlState) {
+        return;
+    }
+
+    this->fanSpeed = qBound(0, speed, 100);
+
+    this->updatedMetrics = FanSpeed;
+
+    emit updated();
+}
+
+bool GPUSimulated::setCoreClockOffset(int offset)
+{
+    if(offset < SIMULATED_CORE_OFFSET_MIN || offset > SIMULATED_CORE_OFFSET_MAX) {
+        return false;
+    }
+
+    this->coreClockOffset = offset;
+
+    return true;
+}
+
+bool GPUSimulated::setMemoryClockOffset(int offset)
+{
+    if(offset < SIMULATED_MEMORY_OFFSET_MIN || offset > SIMULATED_MEMORY_OFFSET_MAX) {
+        return false;
+    }
+
+    this->memoryClockOffset = offset;
+
+    return true;
+}
+
+bool GPUSimulated::setPowerMizerMode(PowerMizerMode mode)
+{
+    this->powerMizerMode = mode;
+
+    return true;
+}
+
+bool GPUSimulated::setPowerLimit(double watts)
+{
+    if(watts < SIMULATED_POWER_LIMIT_MIN || watts > SIMULATED_POWER_LIMIT_MAX) {
+        return false;
+    }
+
+    this->powerLimit = watts;
+
+    return true;
+}
@@ -0,0 +1,121 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GPUSIMULATED_H
+#define GPUSIMULATED_H
+
+#include <QList>
+#include <QString>
+
+#include "gpu.h"
+
+/**
+ * Fake GPU producing plausible values without any driver
+ * Used to try the interface with many cards and to benchmark it
+ */
+class GPUSimulated : public GPU
+{
+public:
+    GPUSimulated(int id);
+    ~GPUSimulated();
+
+    static QList<GPU*> getGPUs(int count);
+
+    void    fetchConstants();
+    void    fetchVariables(Metrics metrics = AllMetrics);
+
+    QString getIdentifier();
+    QString getName();
+    QString getDriverVersion();
+    QString getBusType();
+    QString getBusId();
+    int     getTotalMemory();
+
+    int     getCurrentCoreTemp();
+    int     getCurrentFanSpeed();
+    int     getCurrentCoreClock();
+    int     getCurrentMemoryClock();
+    int     getCurrentCoreUse();
+    int     getCurrentMemoryUse();
+
+    bool    isFanControlAvailable();
+    bool    isFanControlEnabled();
+    bool    isCoreClockControlAvailable();
+    bool    isCoreClockControlEnabled();
+    bool    isMemoryClockControlAvailable();
+    bool    isMemoryClockControlEnabled();
+
+    int     getCoreClockOffset();
+    int     getCoreClockOffsetMin();
+    int     getCoreClockOffsetMax();
+    int     getMemoryClockOffset();
+    int     getMemoryClockOffsetMin();
+    int     getMemoryClockOffsetMax();
+
+    int     getPerfLevelCount();
+    int     getCurrentPerfLevel();
+
+    bool           isPowerMizerAvailable();
+    PowerMizerMode getPowerMizerMode();
+
+    int     getPcieMaxLinkWidth();
+    int     getPcieMaxLinkGen();
+    int     getPcieLinkWidth();
+    int     getPcieLinkGen();
+
+    bool    isPowerDrawAvailable();
+    double  getCurrentPowerDraw();
+    double  getPowerLimit();
+
+    bool    isPowerLimitControlAvailable();
+    double  getPowerLimitMin();
+    double  getPowerLimitDefault();
+    double  getPowerLimitMax();
+
+    void    setFanControlEnabled(bool enabled);
+    void    setFanSpeed(int speed);
+    bool    setCoreClockOffset(int offset);
+    bool    setMemoryClockOffset(int offset);
+    bool    setPowerMizerMode(PowerMizerMode mode);
+    bool    setPowerLimit(double watts);
+
+    void    setLoad(int use);
+    void    simulate(double secs);
+
+private:
+    int     randomStep(int range);
+
+    int     id;
+    quint32 seed; // state of the pseudo-random generator, one per GPU so runs are reproducible
+
+    double  coreTemp;     // °C, kept as a real number so slow changes accumulate
+    int     pinnedLoad;   // %, -1 for a random load
+    int     coreUse;      // %
+    int     memoryUse;    // %
+    int     fanSpeed;     // %
+    int     coreClock;    // MHz
+    int     memoryClock;  // MHz
+    bool    fanControlState;
+    int     coreClockOffset;   // MHz
+    int     memoryClockOffset; // MHz
+    int     perfLevel;
+    PowerMizerMode powerMizerMode;
+    double  powerDraw;    // W
+    double  powerLimit;   // W
+};
+
+#endif // GPUSIMULATED_H
@@ -0,0 +1,233 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "gpusketch.h"
+
+#include <math.h>
+
+/**
+ * Relative error of the quantiles, ex: 0.01 gives 70 ± 0.7
+ */
+const double SKETCH_RELATIVE_ACCURACY = 0.01;
+/**
+ * Growth of the bins derived from the accuracy, gamma = (1 + a) / (1 - a)
+ */
+const double SKETCH_GAMMA     = (1 + SKETCH_RELATIVE_ACCURACY) / (1 - SKETCH_RELATIVE_ACCURACY);
+const double SKETCH_LOG_GAMMA = log(SKETCH_GAMMA);
+/**
+ * Highest number of bins, the lowest ones are collapsed beyond
+ * Values from 1 to 1e9 fit in about 1000 bins at 1% accuracy
+ */
+const int SKETCH_MAX_BINS = 2048;
+
+GPUSketch::GPUSketch()
+{
+    this->clear();
+}
+
+void GPUSketch::clear()
+{
+    this->bins.clear();
+    this->offset    = 0;
+    this->zeroCount = 0;
+    this->count     = 0;
+    this->min       = 0;
+    this->max       = 0;
+}
+
+double GPUSketch::getRelativeAccuracy()
+{
+    return SKETCH_RELATIVE_ACCURACY;
+}
+
+/**
+ * Bin of a positive value
+ * @param value
+ * @return Index i such as gamma^(i-1) < value <= gamma^i
+ */
+int GPUSketch::indexOf(double value)
+{
+    return static_cast<int>(ceil(log(value) / SKETCH_LOG_GAMMA));
+}
+
+/**
+ * Value representing a bin, at equal relative distance of both bounds
+ * @param index
+ * @return Value
+ */
+double GPUSketch::valueOf(int index)
+{
+    return 2 * pow(SKETCH_GAMMA, index) / (SKETCH_GAMMA + 1);
+}
+
+/**
+ * Makes room for a bin, collapsing the lowest ones if there would be too many
+ * @param index
+ */
+void GPUSketch::ensureBin(int index)
+{
+    if(this->bins.isEmpty()) {
+        this->offset = index;
+        this->bins.append(0);
+        return;
+    }
+
+    if(index < this->offset) {
+        this->bins.insert(0, this->offset - index, 0);
+        this->offset = index;
+    } else if(index >= this->offset + this->bins.size()) {
+        this->bins.resize(index - this->offset + 1);
+    }
+
+    if(this->bins.size() > SKETCH_MAX_BINS) {
+        int extra = this->bins.size() - SKETCH_MAX_BINS;
+        quint32 collapsed = 0;
+        for(int i=0; i < extra; i++) {
+            collapsed += this->bins.at(i);
+        }
+
+        this->bins.remove(0, extra);
+        this->bins[0] += collapsed;
+        this->offset  += extra;
+    }
+}
+
+/**
+ * Counts a value
+ * @param value
+ */
+void GPUSketch::add(double value)
+{
+    if(this->count == 0) {
+        this->min = value;
+        this->max = value;
+    } else {
+        this->min = qMin(this->min, value);
+        this->max = qMax(this->max, value);
+    }
+    this->count++;
+
+    if(value <= 0) {
+        this->zeroCount++;
+        return;
+    }
+
+    int index = GPUSketch::indexOf(value);
+    this->ensureBin(index);
+
+    // The lowest bins may have been collapsed into the first one
+    this->bins[qMax(index, this->offset) - this->offset]++;
+}
+
+/**
+ * Adds the values of another sketch, ex: to cover several time buckets
+ * @param other
+ */
+void GPUSketch::merge(const GPUSketch &other)
+{
+    if(other.count == 0) {
+        return;
+    }
+
+    if(this->count == 0) {
+        *this = other;
+        return;
+    }
+
+    this->min        = qMin(this->min, other.min);
+    this->max        = qMax(this->max, other.max);
+    this->count     += other.count;
+    this->zeroCount += other.zeroCount;
+
+    if(other.bins.isEmpty()) {
+        return;
+    }
+
+    this->ensureBin(other.offset);
+    this->ensureBin(other.offset + other.bins.size() - 1);
+
+    for(int i=0; i < other.bins.size(); i++) {
+        this->bins[qMax(other.offset + i, this->offset) - this->offset] += other.bins.at(i);
+    }
+}
+
+qint64 GPUSketch::getCount() const
+{
+    return this->count;
+}
+
+double GPUSketch::getMin() const
+{
+    return this->min;
+}
+
+double GPUSketch::getMax() const
+{
+    return this->max;
+}
+
+int GPUSketch::getBinCount() const
+{
+    return this->bins.size();
+}
+
+/**
+ * Estimates a quantile
+ * @param q Between 0 and 1, ex: 0.95
+ * @return Value within the relative accuracy of the exact quantile, 0 if the sketch is empty
+ */
+double GPUSketch::getQuantile(double q) const
+{
+    if(this->count == 0) {
+        return 0;
+    }
+
+    qint64 rank = static_cast<qint64>(qBound(0.0, q, 1.0) * (this->count - 1));
+
+    if(rank < this->zeroCount) {
+        return qMin(0.0, this->max);
+    }
+
+    qint64 seen = this->zeroCount;
+    for(int i=0; i < this->bins.size(); i++) {
+        seen += this->bins.at(i);
+
+        if(seen > rank) {
+            return qBound(this->min, GPUSketch::valueOf(this->offset + i), this->max);
+        }
+    }
+
+    return this->max;
+}
+
+/**
+ * Summary of the sketch, for exports
+ * @return {"count", "min", "max", "p50", "p90", "p95", "p99"}
+ */
+QJsonObject GPUSketch::toJson() const
+{
+    QJsonObject json;
+    json.insert("count", static_cast<double>(this->count));
+    json.insert("min", this->min);
+    json.insert("max", this->max);
+    json.insert("p50", this->getQuantile(0.50));
+    json.insert("p90", this->getQuantile(0.90));
+    json.insert("p95", this->getQuantile(0.95));
+    json.insert("p99", this->getQuantile(0.99));
+
+    return json;
+}
@@ -0,0 +1,62 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GPUSKETCH_H
+#define GPUSKETCH_H
+
+#include <QJsonObject>
+#include <QVector>
+
+/**
+ * Streaming quantile sketch (DDSketch) with a bounded relative error
+ * Values are counted in logarithmic bins, so memory only depends on the range
+ * of the values and two sketches can be merged by adding their bins
+ */
+class GPUSketch
+{
+public:
+    GPUSketch();
+
+    void   add(double value);
+    void   merge(const GPUSketch &other);
+    void   clear();
+
+    qint64 getCount() const;
+    double getMin() const;
+    double getMax() const;
+    double getQuantile(double q) const;
+    int    getBinCount() const;
+
+    static double getRelativeAccuracy();
+
+    QJsonObject toJson() const;
+
+private:
+    static int    indexOf(double value);
+    static double valueOf(int index);
+
+    void   ensureBin(int index);
+
+    QVector<quint32> bins;      // counts of the values in (gamma^(i-1), gamma^i], i = offset + position
+    int              offset;    // index of bins[0]
+    qint64           zeroCount; // values <= 0, common for the usage
+    qint64           count;
+    double           min;
+    double           max;
+};
+
+#endif // GPUSKETCH_H
@@ -20,6 +20,14 @@
 
 #include <QTimer>
 #include <QGraphicsTextItem>
+#include <QFileDialog>
+#include <QMessageBox>
+
+#include "gpuburstcapture.h"
+#include "gpuburstwindow.h"
+#include "gpudiagnostics.h"
+#include "gpupciemonitor.h"
+#include "gputrace.h"
 
 #include <math.h>
 
@@ -27,6 +35,10 @@
  * Number of seconds showed on the graphs
  */
 const int GRAPH_TIME_LENGTH_SECS = 60;
+/**
+ * Time between two fetches of the graphed values
+ */
+const int POLL_INTERVAL_MSECS = 2000;
 /**
  * Refresh the graph every n msecs
  */
@@ -52,9 +64,24 @@ const int PERCENT_LINE_EVERY = 20;
  */
 const int TEMP_LINE_EVERY = 5;
 /**
- * Time between cleanups of the memory
+ * Default range of the clock graph, in MHz
+ */
+const int CLOCK_MIN = 0;
+const int CLOCK_MAX = 500;
+/**
+ * Rounding of the clock graph and distance between its lines, in MHz
+ */
+const int CLOCK_ROUND_AT   = 100;
+const int CLOCK_LINE_EVERY = 250;
+/**
+ * Windows proposed for the percentiles, in seconds, 0 for everything since the start
  */
-const int CLEAN_AFTER_SECS = GRAPH_TIME_LENGTH_SECS / 2;
+const int QUANTILE_WINDOWS_SECS[] = {300, 3600, 86400, 0};
+const char * const QUANTILE_WINDOWS_NAMES[] = {"the last 5 minutes", "the last hour", "the last 24 hours", "all the time"};
+/**
+ * Number of events listed under the graphs
+ */
+const int EVENTS_SHOWN = 3;
 /**
  * Approx. height of a text line in the graph for margins
  */
@@ -68,22 +95,25 @@ const int PERCENT_MAX = 100;
  * Constant for the min of a percentage
  */
 const int PERCENT_MIN = 0;
-/**
- * Constant for the number of msecs in a sec
- */
-const int MSEC_IN_A_SEC = 1000;
 
-GPUStatsWindow::GPUStatsWindow(GPU *gpu, QWidget *parent, Qt::WindowFlags f) :
+GPUStatsWindow::GPUStatsWindow(GPUHistory *history, GPUEventLog *eventLog, GPUPoller *poller, QWidget *parent, Qt::WindowFlags f) :
     QWidget(parent, f),
     ui(new Ui::GPUStatsWindow)
 {
     ui->setupUi(this);
 
-    this->gpu = gpu;
+    this->history = history;
+    this->eventLog = eventLog;
+    this->gpu = history->getGPU();
 
     this->setWindowTitle(QString("[%1] %2 - Stats").arg(this->gpu->getIdentifier()).arg(this->gpu->getName()));
 
-    connect(this->gpu, SIGNAL(updated()), this, SLOT(newValues()));
+    // The time spent in each performance level is only counted while the window is open
+    GPU::Metrics metrics = GPU::CoreTemp | GPU::Utilization | GPU::Clocks;
+    if(this->gpu->getPerfLevelCount() > 0) {
+        metrics |= GPU::PerfLevel;
+    }
+    poller->subscribe(this, this->gpu, metrics, POLL_INTERVAL_MSECS);
 
     this->gpuTempScene = new QGraphicsScene(this->ui->gpuTempGraphic->rect());
     this->ui->gpuTempGraphic->setFrameShape(QFrame::NoFrame);
@@ -97,7 +127,24 @@ GPUStatsWindow::GPUStatsWindow(GPU *gpu, QWidget *parent, Qt::WindowFlags f) :
     this->ui->memoryUseGraphic->setFrameShape(QFrame::NoFrame);
     this->ui->memoryUseGraphic->setScene(this->memoryUseScene);
 
-    lastCleanup.start();
+    this->pcieScene = new QGraphicsScene(this->ui->pcieGraphic->rect());
+    this->ui->pcieGraphic->setFrameShape(QFrame::NoFrame);
+    this->ui->pcieGraphic->setScene(this->pcieScene);
+
+    // The link is fetched at a low rate by the main window while this window is open
+    this->ui->pcieLabel->setVisible(this->gpu->getPcieMaxLinkWidth() > 0);
+    this->ui->pcieGraphic->setVisible(this->gpu->getPcieMaxLinkWidth() > 0);
+
+    this->coreClockScene = new QGraphicsScene(this->ui->coreClockGraphic->rect());
+    this->ui->coreClockGraphic->setFrameShape(QFrame::NoFrame);
+    this->ui->coreClockGraphic->setScene(this->coreClockScene);
+
+    for(unsigned int i=0; i < sizeof(QUANTILE_WINDOWS_SECS) / sizeof(QUANTILE_WINDOWS_SECS[0]); i++) {
+        this->ui->quantilesWindowInput->addItem(QUANTILE_WINDOWS_NAMES[i], QUANTILE_WINDOWS_SECS[i]);
+    }
+
+    // The card was unplugged, the history is kept by the main window in case it comes back
+    connect(this->gpu, SIGNAL(destroyed()), this, SLOT(close()));
 
     this->tick();
 }
@@ -118,8 +165,10 @@ GPUStatsWindow::~GPUStatsWindow()
  * @param lineEveryN          Distance between the horizontal lines in the background given in the unit beeing displayed
  * @param preventLineOnBorder If the graph line touches the border, this attribute will automatically add margin to prevent it
  */
-void GPUStatsWindow::updateGraph(QGraphicsScene *scene, QList<HistoryValue> allValues, int graphTimeLength, int defaultMin, int defaultMax, int roundInterval, int lineEveryN, bool preventLineOnBorder)
+void GPUStatsWindow::updateGraph(QGraphicsScene *scene, const QList<HistoryValue> &allValues, int graphTimeLength, int defaultMin, int defaultMax, int roundInterval, int lineEveryN, bool preventLineOnBorder)
 {
+    GPUTWEAK_TRACE_SCOPE("GPUStatsWindow::updateGraph");
+
     QTime graphEnd = QTime::currentTime();
     QTime graphStart = graphEnd.addSecs(-graphTimeLength);
 
@@ -171,6 +220,8 @@ void GPUStatsWindow::updateGraph(QGraphicsScene *scene, QList<HistoryValue> allV
  */
 void GPUStatsWindow::updateGraphScene(QGraphicsScene *scene, QList<HistoryValue> values, int minVal, int maxVal, QTime graphStart, QTime graphEnd, int lineEveryN)
 {
+    GPUTWEAK_TRACE_SCOPE("GPUStatsWindow::updateGraphScene");
+
     scene->clear();
 
     double valInterval = static_cast<double>(maxVal - minVal);
@@ -187,6 +238,8 @@ void GPUStatsWindow::updateGraphScene(QGraphicsScene *scene, QList<HistoryValue>
         scene->addLine(0, i, scene->width(), i, QPen(QColor(240, 240, 240), 1));
     }
 
+    this->drawEvents(scene, graphStart, graphEnd);
+
     QGraphicsTextItem *maxValText = scene->addText(QString::number(maxVal));
     maxValText->setPos(0, 0);
     QGraphicsTextItem *minValText = scene->addText(QString::number(minVal));
@@ -212,70 +265,256 @@ void GPUStatsWindow::updateGraphScene(QGraphicsScene *scene, QList<HistoryValue>
 }
 
 /**
- * Cleans the history content to prevent from eating the whole RAM if the user decides to go on vacation leaving this app open
+ * Updates the GUI
+ */
+void GPUStatsWindow::display()
+{
+    GPUTWEAK_TRACE_SCOPE("GPUStatsWindow::display");
+
+    GPUDiagnostics::ScopedTimer renderTimer(GPUDiagnostics::Render, "stats");
+
+    this->gpuTempScene  ->setSceneRect(this->ui->gpuTempGraphic  ->rect());
+    this->gpuUseScene   ->setSceneRect(this->ui->gpuUseGraphic   ->rect());
+    this->memoryUseScene->setSceneRect(this->ui->memoryUseGraphic->rect());
+    this->coreClockScene->setSceneRect(this->ui->coreClockGraphic->rect());
+    this->pcieScene     ->setSceneRect(this->ui->pcieGraphic     ->rect());
+
+    // GPU Temp Graph (°C)
+    this->updateGraph(this->gpuTempScene,   this->history->getValues(GPUHistory::CoreTemp),  GRAPH_TIME_LENGTH_SECS, TEMP_MIN,    TEMP_MAX,    GRAPH_ROUND_AT, TEMP_LINE_EVERY, true);
+    // GPU Use Graph (%)
+    this->updateGraph(this->gpuUseScene,    this->history->getValues(GPUHistory::CoreUse),   GRAPH_TIME_LENGTH_SECS, PERCENT_MIN, PERCENT_MAX, GRAPH_ROUND_AT, PERCENT_LINE_EVERY);
+    // PCI-E Link Graph (%)
+    this->updateGraph(this->pcieScene,      this->getPcieValues(),                           GRAPH_TIME_LENGTH_SECS, PERCENT_MIN, PERCENT_MAX, GRAPH_ROUND_AT, PERCENT_LINE_EVERY);
+    // GPU Temp Graph (%)
+    this->updateGraph(this->memoryUseScene, this->history->getValues(GPUHistory::MemoryUse), GRAPH_TIME_LENGTH_SECS, PERCENT_MIN, PERCENT_MAX, GRAPH_ROUND_AT, PERCENT_LINE_EVERY);
+    // GPU Clock Graph (MHz)
+    this->updateGraph(this->coreClockScene, this->history->getValues(GPUHistory::CoreClock), GRAPH_TIME_LENGTH_SECS, CLOCK_MIN,   CLOCK_MAX,   CLOCK_ROUND_AT, CLOCK_LINE_EVERY, true);
+
+    this->updatePerfLevels();
+    this->updateQuantiles();
+    this->updateEvents();
+}
+
+/**
+ * Shades the periods where the GPU was throttled
+ * @param scene      Scene to draw on
+ * @param graphStart Earlier time displayed on the graph
+ * @param graphEnd   Last time displayed on the graph
  */
-void GPUStatsWindow::cleanValues()
+void GPUStatsWindow::drawEvents(QGraphicsScene *scene, QTime graphStart, QTime graphEnd)
 {
-    QTime now = QTime::currentTime();
+    double length = graphStart.msecsTo(graphEnd);
 
-    int deleteIfMoreThanMsecs = GRAPH_TIME_LENGTH_SECS * MSEC_IN_A_SEC;
+    foreach(const GPUEventLog::Event &event, this->eventLog->getEvents(this->gpu)) {
+        QTime start = event.start.time();
+        QTime end   = event.end.isValid() ? event.end.time() : graphEnd;
 
-    while(this->gpuTempHistory.size() && this->gpuTempHistory.first().time.msecsTo(now) > deleteIfMoreThanMsecs) {
-        this->gpuTempHistory.removeFirst();
+        if(end < graphStart || start > graphEnd) {
+            continue;
+        }
+
+        double x1 = qMax(0.0, graphStart.msecsTo(start) / length * scene->width());
+        double x2 = qMin(scene->width(), graphStart.msecsTo(end) / length * scene->width());
+
+        QColor color;
+        switch(event.type) {
+        case GPUEventLog::ThermalThrottle:
+            color = QColor(255, 0, 0, 40);
+            break;
+        case GPUEventLog::ClockThrottle:
+            color = QColor(255, 160, 0, 40);
+            break;
+        default:
+            color = QColor(0, 0, 255, 30);
+        }
+        scene->addRect(x1, 0, qMax(x2 - x1, 1.0), scene->height(), QPen(Qt::NoPen), QBrush(color));
     }
+}
 
-    while(this->gpuUseHistory.size() && this->gpuUseHistory.first().time.msecsTo(now) > deleteIfMoreThanMsecs) {
-        this->gpuUseHistory.removeFirst();
+/**
+ * Bandwidth of the PCI-E link over time, from the recorded width and generation
+ * @return Values in % of the best link of the card
+ */
+QList<GPUStatsWindow::HistoryValue> GPUStatsWindow::getPcieValues()
+{
+    // Both series are recorded together
+    const QList<HistoryValue> &widths = this->history->getValues(GPUHistory::PcieLinkWidth);
+    const QList<HistoryValue> &gens   = this->history->getValues(GPUHistory::PcieLinkGen);
+
+    QList<HistoryValue> values;
+    for(int i=0; i < widths.size() && i < gens.size(); i++) {
+        HistoryValue value;
+        value.time  = widths.at(i).time;
+        value.value = GPUPcieMonitor::getBandwidthShare(widths.at(i).value, gens.at(i).value, this->gpu->getPcieMaxLinkWidth(), this->gpu->getPcieMaxLinkGen());
+        values.append(value);
+    }
+
+    return values;
+}
+
+/**
+ * Lists the last events of the GPU
+ */
+void GPUStatsWindow::updateEvents()
+{
+    QList<GPUEventLog::Event> events = this->eventLog->getEvents(this->gpu);
+
+    if(events.isEmpty()) {
+        return;
     }
 
-    while(this->memoryUseHistory.size() && this->memoryUseHistory.first().time.msecsTo(now) > deleteIfMoreThanMsecs) {
-        this->memoryUseHistory.removeFirst();
+    QStringList lines;
+    for(int i=qMax(0, events.size() - EVENTS_SHOWN); i < events.size(); i++) {
+        const GPUEventLog::Event &event = events.at(i);
+
+        QString duration = event.end.isValid()
+                ? QString("%1 s").arg(event.start.secsTo(event.end))
+                : QString("ongoing");
+
+        lines.prepend(QString("%1 %2, %3 severity (%4%), %5: %6")
+                      .arg(event.start.time().toString())
+                      .arg(GPUEventLog::getTypeName(event.type))
+                      .arg(GPUEventLog::getSeverityName(event.severity))
+                      .arg(event.severity)
+                      .arg(duration)
+                      .arg(event.details));
     }
+
+    this->ui->eventsLabel->setText(lines.join("\n"));
 }
 
 /**
- * Updates the GUI
+ * Writes the events of all the GPUs to a CSV file
  */
-void GPUStatsWindow::display()
+void GPUStatsWindow::on_eventsExportBtn_clicked()
 {
-    this->gpuTempScene  ->setSceneRect(this->ui->gpuTempGraphic  ->rect());
-    this->gpuUseScene   ->setSceneRect(this->ui->gpuUseGraphic   ->rect());
-    this->memoryUseScene->setSceneRect(this->ui->memoryUseGraphic->rect());
+    QString path = QFileDialog::getSaveFileName(this, "Export events", "gputweak-events.csv", "CSV (*.csv)");
+    if(path.isEmpty()) {
+        return;
+    }
 
-    // GPU Temp Graph (°C)
-    this->updateGraph(this->gpuTempScene,   this->gpuTempHistory,   GRAPH_TIME_LENGTH_SECS, TEMP_MIN,    TEMP_MAX,    GRAPH_ROUND_AT, TEMP_LINE_EVERY, true);
-    // GPU Use Graph (%)
-    this->updateGraph(this->gpuUseScene,    this->gpuUseHistory,    GRAPH_TIME_LENGTH_SECS, PERCENT_MIN, PERCENT_MAX, GRAPH_ROUND_AT, PERCENT_LINE_EVERY);
-    // GPU Temp Graph (%)
-    this->updateGraph(this->memoryUseScene, this->memoryUseHistory, GRAPH_TIME_LENGTH_SECS, PERCENT_MIN, PERCENT_MAX, GRAPH_ROUND_AT, PERCENT_LINE_EVERY);
+    if(!this->eventLog->exportCsv(path)) {
+        QMessageBox::warning(this, "Export events", QString("Cannot write %1").arg(path));
+    }
 }
 
 /**
- * Store new values when they change on the GPU
+ * Shows the share of time spent in each performance level along with the current one
  */
-void GPUStatsWindow::newValues()
+void GPUStatsWindow::updatePerfLevels()
 {
-    QTime time = QTime::currentTime();
-
-    HistoryValue gpuTemp;
-    gpuTemp.time = time;
-    gpuTemp.value = this->gpu->getCurrentCoreTemp();
-    this->gpuTempHistory.append(gpuTemp);
-
-    HistoryValue gpuUse;
-    gpuUse.time = time;
-    gpuUse.value = this->gpu->getCurrentCoreUse();
-    this->gpuUseHistory.append(gpuUse);
-
-    HistoryValue memoryUse;
-    memoryUse.time = time;
-    memoryUse.value = this->gpu->getCurrentMemoryUse();
-    this->memoryUseHistory.append(memoryUse);
-
-    if(lastCleanup.elapsed() > CLEAN_AFTER_SECS * MSEC_IN_A_SEC) {
-        this->cleanValues();
-        lastCleanup.restart();
+    int levelCount = this->gpu->getPerfLevelCount();
+
+    this->ui->perfLevelsResetBtn->setDisabled(levelCount == 0);
+
+    if(levelCount == 0) {
+        return;
+    }
+
+    QVector<qint64> residency = this->history->getPerfLevelResidency();
+
+    qint64 total = 0;
+    foreach(qint64 msecs, residency) {
+        total += msecs;
+    }
+
+    QStringList levels;
+    for(int level=0; level < levelCount; level++) {
+        qint64 msecs = level < residency.size() ? residency.at(level) : 0;
+        levels.append(QString("%1: %2%").arg(level).arg(total > 0 ? 100.0 * msecs / total : 0, 0, 'f', 1));
+    }
+
+    QString text = QString("Performance levels: %1 (current %2)").arg(levels.join(", ")).arg(this->gpu->getCurrentPerfLevel());
+
+    if(this->gpu->isPowerMizerAvailable()) {
+        const char *modes[] = {"Adaptive", "Prefer Maximum Performance", "Auto", "Prefer Consistent Performance"};
+        int mode = this->gpu->getPowerMizerMode();
+
+        text += QString(" - PowerMizer: %1").arg(mode >= 0 && mode < 4 ? modes[mode] : "Unknown");
+    }
+
+    this->ui->perfLevelsLabel->setText(text);
+}
+
+/**
+ * Shows the median and tail values of the temperature, usage and clock over the selected window
+ */
+void GPUStatsWindow::updateQuantiles()
+{
+    int windowSecs = this->ui->quantilesWindowInput->currentData().toInt();
+
+    GPUHistory::Series series[] = {GPUHistory::CoreTemp, GPUHistory::CoreUse, GPUHistory::MemoryUse, GPUHistory::CoreClock};
+    const char * const names[]  = {"GPU Temp", "GPU Usage", "Memory Usage", "GPU Clock"};
+    const char * const units[]  = {"°C", "%", "%", "MHz"};
+
+    QStringList lines;
+    for(int i=0; i < 4; i++) {
+        GPUSketch sketch = this->history->getSketch(series[i], windowSecs);
+
+        if(sketch.getCount() == 0) {
+            continue;
+        }
+
+        lines.append(QString("%1: p50 %2, p95 %3, p99 %4 %5 (%6 samples)")
+                     .arg(names[i])
+                     .arg(sketch.getQuantile(0.50), 0, 'f', 0)
+                     .arg(sketch.getQuantile(0.95), 0, 'f', 0)
+                     .arg(sketch.getQuantile(0.99), 0, 'f', 0)
+                     .arg(units[i])
+                     .arg(sketch.getCount()));
     }
+
+    this->ui->quantilesLabel->setText(lines.isEmpty() ? QString("No sample yet") : lines.join("\n"));
+}
+
+/**
+ * Starts computing the percentiles again
+ */
+void GPUStatsWindow::on_quantilesResetBtn_clicked()
+{
+    this->history->resetQuantiles();
+
+    this->updateQuantiles();
+}
+
+/**
+ * Starts counting the time spent in each performance level again
+ */
+void GPUStatsWindow::on_perfLevelsResetBtn_clicked()
+{
+    this->history->resetPerfLevelResidency();
+
+    this->updatePerfLevels();
+}
+
+/**
+ * Starts a burst capture of the usage and clocks
+ */
+void GPUStatsWindow::on_burstBtn_clicked()
+{
+    this->ui->burstBtn->setDisabled(true);
+    this->ui->burstBtn->setText("Capturing...");
+
+    GPUBurstCapture *capture = new GPUBurstCapture(this->gpu, GPU::Utilization | GPU::Clocks, this->ui->burstDurationInput->value() * 1000, this);
+    connect(capture, SIGNAL(finished()), this, SLOT(burstFinished()));
+    capture->start();
+}
+
+/**
+ * Displays the result of the burst capture
+ */
+void GPUStatsWindow::burstFinished()
+{
+    GPUBurstCapture* capture = qobject_cast<GPUBurstCapture*>(sender());
+    Q_ASSERT(capture);
+
+    this->ui->burstBtn->setDisabled(false);
+    this->ui->burstBtn->setText("Capture");
+
+    // The window takes ownership of the capture
+    GPUBurstWindow *window = new GPUBurstWindow(capture, this, Qt::Window);
+    window->setAttribute(Qt::WA_DeleteOnClose);
+    window->show();
 }
 
 /**
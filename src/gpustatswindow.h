@@ -23,6 +23,9 @@
 #include <QTime>
 
 #include "gpu.h"
+#include "gpuhistory.h"
+#include "gpueventlog.h"
+#include "gpupoller.h"
 
 namespace Ui {
 class GPUStatsWindow;
@@ -36,42 +39,46 @@ class GPUStatsWindow : public QWidget
     Q_OBJECT
 
 public:
-    explicit GPUStatsWindow(GPU *gpu, QWidget *parent = 0, Qt::WindowFlags f = 0);
+    explicit GPUStatsWindow(GPUHistory *history, GPUEventLog *eventLog, GPUPoller *poller, QWidget *parent = 0, Qt::WindowFlags f = 0);
     ~GPUStatsWindow();
 
-    /**
-     * Structure holding integer data along with the time it was stored
-     */
-    struct HistoryValue {
-        QTime time;
-        int   value;
-    };
+    typedef GPUHistory::HistoryValue HistoryValue;
 
-private:
-    void updateGraph(QGraphicsScene *scene, QList<HistoryValue> allValues, int graphTimeLength, int defaultMin, int defaultMax, int roundInterval, int lineEveryN, bool preventLineOnBorder = false);
+protected:
+    // Also used by the benchmarks
+    void updateGraph(QGraphicsScene *scene, const QList<HistoryValue> &allValues, int graphTimeLength, int defaultMin, int defaultMax, int roundInterval, int lineEveryN, bool preventLineOnBorder = false);
     void updateGraphScene(QGraphicsScene *scene, QList<HistoryValue> values, int minVal, int maxVal, QTime graphStart, QTime graphEnd, int lineEveryN);
 
-    void cleanValues();
+private:
+    void updatePerfLevels();
+    void updateEvents();
+    void updateQuantiles();
+    QList<HistoryValue> getPcieValues();
+    void drawEvents(QGraphicsScene *scene, QTime graphStart, QTime graphEnd);
 
     Ui::GPUStatsWindow *ui;
     GPU *gpu;
 
-    // Lists of stored data
-    QList<HistoryValue> gpuTempHistory;
-    QList<HistoryValue> gpuUseHistory;
-    QList<HistoryValue> memoryUseHistory;
+    // Stored data, shared with the other windows
+    GPUHistory *history;
+    GPUEventLog *eventLog;
 
     // Pointers to the Scenes used by the graphs
     QGraphicsScene *gpuTempScene;
     QGraphicsScene *gpuUseScene;
     QGraphicsScene *memoryUseScene;
-
-    QTime lastCleanup;
+    QGraphicsScene *coreClockScene;
+    QGraphicsScene *pcieScene;
 
 private slots:
     void display();
-    void newValues();
     void tick();
+
+    void on_perfLevelsResetBtn_clicked();
+    void on_eventsExportBtn_clicked();
+    void on_quantilesResetBtn_clicked();
+    void on_burstBtn_clicked();
+    void burstFinished();
 };
 
 #endif // GPUSTATSWINDOW_H
@@ -0,0 +1,178 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "gputhrottledetector.h"
+
+#include "gputrace.h"
+
+/**
+ * Core use (%) above which the card is expected to run at its highest clock
+ */
+const int THROTTLE_MIN_USE = 80;
+/**
+ * Share of the reference clock (%) that must be lost to count as throttling
+ */
+const int THROTTLE_MIN_DROP = 10;
+/**
+ * Number of consecutive samples needed to start and to end an event, so a single late sample is ignored
+ */
+const int THROTTLE_CONFIRM_SAMPLES = 2;
+/**
+ * Temperature (°C) from which a throttle is attributed to the heat
+ */
+const int THROTTLE_THERMAL_TEMP = 83;
+/**
+ * The reference clock slowly decays at each sample under load, so it follows the boost of the card getting older or a smaller offset
+ */
+const double REFERENCE_DECAY = 0.9999;
+
+GPUThrottleDetector::GPUThrottleDetector(GPU *gpu, GPUEventLog *log, QObject *parent) :
+    QObject(parent)
+{
+    this->gpu = gpu;
+    this->log = log;
+
+    this->referenceClock   = 0;
+    this->lastClockOffset  = gpu->getCoreClockOffset();
+    this->throttledSamples = 0;
+    this->clearSamples     = 0;
+    this->eventId          = -1;
+    this->worstDrop        = 0;
+    this->lowestClock      = 0;
+    this->highestTemp      = 0;
+    this->thermal          = false;
+
+    connect(this->gpu, SIGNAL(updated()), this, SLOT(newValues()));
+}
+
+GPUThrottleDetector::~GPUThrottleDetector()
+{
+    // no-op
+}
+
+GPU *GPUThrottleDetector::getGPU()
+{
+    return this->gpu;
+}
+
+bool GPUThrottleDetector::isThrottling()
+{
+    return this->eventId >= 0;
+}
+
+/**
+ * Highest clock seen under load, what the card should run at
+ * @return MHz
+ */
+int GPUThrottleDetector::getReferenceClock()
+{
+    return qRound(this->referenceClock);
+}
+
+/**
+ * Looks at a new sample, starts, updates or ends the throttle event
+ * @param time      Time of the sample
+ * @param coreClock MHz
+ * @param coreUse   %
+ * @param coreTemp  °C
+ */
+void GPUThrottleDetector::process(QDateTime time, int coreClock, int coreUse, int coreTemp)
+{
+    bool loaded = coreUse >= THROTTLE_MIN_USE;
+
+    if(loaded) {
+        this->referenceClock = qMax(static_cast<double>(coreClock), this->referenceClock * REFERENCE_DECAY);
+    }
+
+    int drop = this->referenceClock > 0 ? qRound(100 * (this->referenceClock - coreClock) / this->referenceClock) : 0;
+
+    if(!loaded || drop < THROTTLE_MIN_DROP) {
+        this->throttledSamples = 0;
+
+        if(this->eventId < 0) {
+            return;
+        }
+
+        if(this->clearSamples++ == 0) {
+            this->clearSince = time;
+        }
+
+        if(this->clearSamples >= THROTTLE_CONFIRM_SAMPLES) {
+            this->log->end(this->eventId, this->clearSince);
+            this->eventId = -1;
+        }
+
+        return;
+    }
+
+    this->clearSamples = 0;
+
+    if(this->throttledSamples++ == 0) {
+        this->throttledSince = time;
+    }
+
+    if(this->eventId < 0) {
+        if(this->throttledSamples < THROTTLE_CONFIRM_SAMPLES) {
+            return;
+        }
+
+        this->worstDrop   = 0;
+        this->lowestClock = coreClock;
+        this->highestTemp = coreTemp;
+        this->thermal     = false;
+    } else if(drop <= this->worstDrop && coreTemp <= this->highestTemp) {
+        // Nothing new to log
+        return;
+    }
+
+    if(drop > this->worstDrop) {
+        this->worstDrop   = drop;
+        this->lowestClock = coreClock;
+    }
+    this->highestTemp = qMax(this->highestTemp, coreTemp);
+    this->thermal     = this->thermal || coreTemp >= THROTTLE_THERMAL_TEMP;
+
+    GPUEventLog::Type type = this->thermal ? GPUEventLog::ThermalThrottle : GPUEventLog::ClockThrottle;
+    QString details = QString("%1 MHz instead of %2 MHz, up to %3°C").arg(this->lowestClock).arg(qRound(this->referenceClock)).arg(this->highestTemp);
+
+    if(this->eventId < 0) {
+        this->eventId = this->log->begin(this->gpu, type, this->throttledSince, this->worstDrop, details);
+    } else {
+        this->log->update(this->eventId, type, this->worstDrop, details);
+    }
+}
+
+/**
+ * Feeds the detector when the GPU fetched its clocks
+ */
+void GPUThrottleDetector::newValues()
+{
+    GPUTWEAK_TRACE_SCOPE("GPUThrottleDetector::newValues");
+
+    if(!(this->gpu->getUpdatedMetrics() & GPU::Clocks)) {
+        return;
+    }
+
+    // A smaller offset lowers the clock on purpose, the card is measured again
+    int offset = this->gpu->getCoreClockOffset();
+    if(offset != this->lastClockOffset) {
+        this->lastClockOffset = offset;
+        this->referenceClock  = 0;
+    }
+
+    this->process(QDateTime::currentDateTime(), this->gpu->getCurrentCoreClock(), this->gpu->getCurrentCoreUse(), this->gpu->getCurrentCoreTemp());
+}
@@ -0,0 +1,68 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GPUTHROTTLEDETECTOR_H
+#define GPUTHROTTLEDETECTOR_H
+
+#include <QObject>
+#include <QDateTime>
+
+#include "gpu.h"
+#include "gpueventlog.h"
+
+/**
+ * Detects the periods where the core clock drops while the card is busy
+ * Each sample is compared to a reference clock, the highest seen under load,
+ * so the detection takes constant time and memory per sample
+ */
+class GPUThrottleDetector : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit GPUThrottleDetector(GPU *gpu, GPUEventLog *log, QObject *parent = 0);
+    ~GPUThrottleDetector();
+
+    GPU *getGPU();
+
+    void process(QDateTime time, int coreClock, int coreUse, int coreTemp);
+    bool isThrottling();
+    int  getReferenceClock();
+
+private:
+    GPU         *gpu;
+    GPUEventLog *log;
+
+    double    referenceClock;    // MHz, 0 until the card has been seen under load
+    int       lastClockOffset;
+
+    int       throttledSamples;  // consecutive samples below the reference
+    int       clearSamples;      // consecutive samples back to normal during an event
+    QDateTime throttledSince;
+    QDateTime clearSince;
+
+    int       eventId;           // -1 when not throttling
+    int       worstDrop;         // %
+    int       lowestClock;
+    int       highestTemp;
+    bool      thermal;
+
+private slots:
+    void newValues();
+};
+
+#endif // GPUTHROTTLEDETECTOR_H
@@ -0,0 +1,234 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "gputrace.h"
+
+#include <QAtomicInteger>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+#include <QVector>
+
+#include <atomic>
+
+/**
+ * Number of spans kept per thread, the oldest are overwritten
+ */
+const int BUFFER_SPANS = 16384;
+
+namespace
+{
+    /**
+     * A finished span
+     */
+    struct SpanRecord {
+        const char *name;
+        qint64      start; // nsecs of the trace clock
+        qint64      end;
+    };
+
+    /**
+     * Entry of a ring buffer, read while its thread may overwrite it
+     * Relaxed atomics, the ordering comes from the fences around the written counter
+     */
+    struct SpanSlot {
+        QAtomicPointer<const char> name;
+        QAtomicInteger<qint64>     start;
+        QAtomicInteger<qint64>     end;
+    };
+
+    /**
+     * Ring buffer of a thread, only written by that thread
+     * Buffers are never freed so the spans of finished threads can still be dumped
+     */
+    struct ThreadBuffer {
+        int                     tid;
+        QString                 threadName;
+        SpanSlot               *spans;   // BUFFER_SPANS entries
+        QAtomicInteger<quint64> written; // spans recorded since the start, published after each write
+    };
+
+    /**
+     * Buffers of all the threads that recorded a span
+     */
+    struct Registry {
+        Registry() : nextTid(1) { this->clock.start(); }
+
+        QMutex               mutex; // only taken once per thread and when dumping
+        QList<ThreadBuffer*> buffers;
+        QElapsedTimer        clock;
+        int                  nextTid;
+    };
+}
+
+Q_GLOBAL_STATIC(Registry, registry)
+
+/**
+ * Buffer of the calling thread, registered on its first span
+ */
+static thread_local ThreadBuffer *localBuffer = 0;
+
+/**
+ * Tells if the application was built with the spans
+ * @return True if built with GPUTWEAK_TRACING
+ */
+bool GPUTrace::isEnabled()
+{
+#ifdef GPUTWEAK_TRACING
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * Time of the trace clock
+ * @return Nanoseconds since the start of the application
+ */
+qint64 GPUTrace::now()
+{
+    return registry()->clock.nsecsElapsed();
+}
+
+/**
+ * Stores a finished span in the buffer of the calling thread, without locking
+ * @param name       Literal naming the span
+ * @param startNsecs Start on the trace clock
+ * @param endNsecs   End on the trace clock
+ */
+void GPUTrace::record(const char *name, qint64 startNsecs, qint64 endNsecs)
+{
+    ThreadBuffer *buffer = localBuffer;
+
+    if(!buffer) {
+        buffer = new ThreadBuffer();
+        buffer->spans = new SpanSlot[BUFFER_SPANS];
+        buffer->written.store(0);
+
+        QThread *thread = QThread::currentThread();
+        bool isMain = QCoreApplication::instance() && thread == QCoreApplication::instance()->thread();
+
+        QMutexLocker locker(&registry()->mutex);
+        buffer->tid = registry()->nextTid++;
+        buffer->threadName = isMain ? "main" : (thread->objectName().isEmpty() ? QString("thread %1").arg(buffer->tid) : thread->objectName());
+        registry()->buffers.append(buffer);
+
+        localBuffer = buffer;
+    }
+
+    // Only this thread writes the counter, the release publishes the span to the readers
+    quint64 index = buffer->written.load();
+
+    // A reader seeing any of the stores below also sees the counter at index, so it knows
+    // the entry is being overwritten
+    std::atomic_thread_fence(std::memory_order_release);
+
+    SpanSlot &span = buffer->spans[index % BUFFER_SPANS];
+    span.name.store(name);
+    span.start.store(startNsecs);
+    span.end.store(endNsecs);
+
+    buffer->written.storeRelease(index + 1);
+}
+
+/**
+ * Writes the buffered spans of all the threads as Chrome trace-event JSON
+ * Threads keep recording meanwhile, spans overwritten during the copy are dropped
+ * @param path Destination file
+ * @return False if the file cannot be written
+ */
+bool GPUTrace::writeChromeJson(QString path)
+{
+    QJsonArray events;
+    qint64 pid = QCoreApplication::applicationPid();
+
+    QMutexLocker locker(&registry()->mutex);
+
+    foreach(ThreadBuffer *buffer, registry()->buffers) {
+        QJsonObject args;
+        args.insert("name", buffer->threadName);
+
+        QJsonObject threadName;
+        threadName.insert("name", QString("thread_name"));
+        threadName.insert("ph", QString("M"));
+        threadName.insert("pid", static_cast<double>(pid));
+        threadName.insert("tid", buffer->tid);
+        threadName.insert("args", args);
+        events.append(threadName);
+
+        quint64 written = buffer->written.loadAcquire();
+        quint64 first   = written > static_cast<quint64>(BUFFER_SPANS) ? written - BUFFER_SPANS : 0;
+
+        QVector<SpanRecord> copy;
+        copy.reserve(static_cast<int>(written - first));
+        for(quint64 i = first; i < written; i++) {
+            const SpanSlot &slot = buffer->spans[i % BUFFER_SPANS];
+
+            SpanRecord span;
+            span.name  = slot.name.load();
+            span.start = slot.start.load();
+            span.end   = slot.end.load();
+            copy.append(span);
+        }
+
+        // Entries the thread reached again while they were copied are not reliable, including
+        // the one it may be writing, which is only published once complete
+        // The fence keeps the copy above from being read after the counter below
+        std::atomic_thread_fence(std::memory_order_acquire);
+        quint64 after = buffer->written.loadAcquire();
+        quint64 valid = after >= static_cast<quint64>(BUFFER_SPANS) ? after - BUFFER_SPANS + 1 : 0;
+
+        for(int i = 0; i < copy.size(); i++) {
+            if(first + i < valid) {
+                continue;
+            }
+
+            const SpanRecord &span = copy.at(i);
+
+            QJsonObject event;
+            event.insert("name", QString::fromLatin1(span.name));
+            event.insert("ph", QString("X"));
+            event.insert("ts", span.start / 1000.0);
+            event.insert("dur", (span.end - span.start) / 1000.0);
+            event.insert("pid", static_cast<double>(pid));
+            event.insert("tid", buffer->tid);
+            events.append(event);
+        }
+    }
+
+    locker.unlock();
+
+    QJsonObject json;
+    json.insert("traceEvents", events);
+    json.insert("displayTimeUnit", QString("ms"));
+
+    QFile file(path);
+    if(!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+
+    file.write(QJsonDocument(json).toJson(QJsonDocument::Compact));
+
+    return true;
+}
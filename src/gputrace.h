@@ -0,0 +1,62 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GPUTRACE_H
+#define GPUTRACE_H
+
+#include <QString>
+
+/**
+ * Scoped trace spans, dumped as Chrome trace-event JSON (chrome://tracing, ui.perfetto.dev)
+ * Spans only exist when built with GPUTWEAK_TRACING (qmake CONFIG+=tracing), otherwise
+ * GPUTWEAK_TRACE_SCOPE compiles to nothing
+ * Each thread writes to its own ring buffer without any lock, the oldest spans are overwritten
+ */
+namespace GPUTrace
+{
+    bool isEnabled();
+
+    qint64 now();
+    void   record(const char *name, qint64 startNsecs, qint64 endNsecs);
+
+    bool writeChromeJson(QString path);
+
+    /**
+     * Records the time spent in its scope
+     */
+    class Span
+    {
+    public:
+        explicit Span(const char *name) : name(name), start(GPUTrace::now()) {}
+        ~Span() { GPUTrace::record(this->name, this->start, GPUTrace::now()); }
+
+    private:
+        const char *name; // must be a literal, it is only read when dumping
+        qint64      start;
+    };
+}
+
+#define GPUTWEAK_TRACE_CONCAT_(a, b) a##b
+#define GPUTWEAK_TRACE_CONCAT(a, b) GPUTWEAK_TRACE_CONCAT_(a, b)
+
+#ifdef GPUTWEAK_TRACING
+#define GPUTWEAK_TRACE_SCOPE(name) GPUTrace::Span GPUTWEAK_TRACE_CONCAT(traceSpan, __LINE__)(name)
+#else
+#define GPUTWEAK_TRACE_SCOPE(name) do {} while(0)
+#endif
+
+#endif // GPUTRACE_H
@@ -18,26 +18,61 @@
 #include "gputweakwindow.h"
 #include "ui_gputweakwindow.h"
 
-GPUTweakWindow::GPUTweakWindow(GPU *gpu, QWidget *parent, Qt::WindowFlags f) :
+#include <QMessageBox>
+
+#include "gpudiagnostics.h"
+
+GPUTweakWindow::GPUTweakWindow(GPUFanController *fanController, QWidget *parent, Qt::WindowFlags f) :
     QWidget(parent, f),
     ui(new Ui::GPUTweakWindow)
 {
     ui->setupUi(this);
 
-    this->gpu = gpu;
+    this->fanController = fanController;
+    this->gpu = fanController->getGPU();
 
     this->setWindowTitle(QString("[%1] %2 - Tweak").arg(this->gpu->getIdentifier()).arg(this->gpu->getName()));
 
+    // The window edits the settings from their values when it opens, they are not refreshed afterwards
+    this->gpu->fetchVariables(GPU::FanSpeed | GPU::FanControlState | GPU::PerfLevel | GPU::Power);
+
     this->resetValues();
 
-    this->coreClockEnabled   = this->gpu->isCoreClockControlEnabled();
-    this->memoryClockEnabled = this->gpu->isMemoryClockControlEnabled();
+    if(this->gpu->isCoreClockControlEnabled()) {
+        this->coreClockEnabled = true;
+        this->coreClock = this->gpu->getCoreClockOffset();
+    }
+
+    if(this->gpu->isMemoryClockControlEnabled()) {
+        this->memoryClockEnabled = true;
+        this->memoryClock = this->gpu->getMemoryClockOffset();
+    }
+
+    this->ui->fanCurveEditor->setPoints(this->fanController->getCurve().points);
 
-    if(this->gpu->isFanControlEnabled()) {
+    if(this->fanController->isEnabled()) {
+        this->fanCurveEnabled      = this->fanController->getMode() == GPUFanController::CurveMode;
+        this->fanTargetTempEnabled = this->fanController->getMode() == GPUFanController::TargetTempMode;
+        this->fanTargetTemp        = this->fanController->getTargetTemp();
+    } else if(this->gpu->isFanControlEnabled()) {
         this->fanSpeedEnabled = true;
         this->fanSpeed = this->gpu->getCurrentFanSpeed();
     }
 
+    if(this->gpu->isPowerMizerAvailable()) {
+        this->powerMizerMode = this->gpu->getPowerMizerMode();
+    }
+
+    if(this->gpu->isPowerLimitControlAvailable()) {
+        this->powerLimit = qRound(this->gpu->getPowerLimit());
+        this->powerLimitEnabled = this->powerLimit != qRound(this->gpu->getPowerLimitDefault());
+    }
+
+    this->reloadProfiles();
+
+    // The card was unplugged, the controller goes with it
+    connect(this->fanController, SIGNAL(destroyed()), this, SLOT(close()));
+
     this->valuesChanged = false;
 
     this->display();
@@ -49,16 +84,23 @@ GPUTweakWindow::~GPUTweakWindow()
 }
 
 /**
- * Resets all values to their "default" which means no manual control and arbitrary slider values
+ * Resets all values to their "default" which means no manual control, no clock offsets and arbitrary slider values
  */
 void GPUTweakWindow::resetValues()
 {
     this->coreClockEnabled = false;
-    this->coreClock = 300;
+    this->coreClock = 0;
     this->memoryClockEnabled = false;
-    this->memoryClock = 500;
+    this->memoryClock = 0;
     this->fanSpeedEnabled = false;
     this->fanSpeed = 60;
+    this->fanCurveEnabled = false;
+    this->fanTargetTempEnabled = false;
+    this->fanTargetTemp = 70;
+    this->powerMizerMode = GPU::PowerMizerAdaptive;
+    this->powerLimitEnabled = false;
+    this->powerLimit = qRound(this->gpu->getPowerLimitDefault());
+    this->ui->fanCurveEditor->setPoints(GPUFanCurve::defaultCurve().points);
 }
 
 /**
@@ -70,16 +112,78 @@ void GPUTweakWindow::save()
         return;
     }
 
-    if(this->fanSpeedEnabled) {
+    QStringList failures;
+
+    if(this->gpu->isCoreClockControlAvailable()) {
+        int offset = this->coreClockEnabled ? this->coreClock : 0;
+
+        if(offset != this->gpu->getCoreClockOffset() && !this->gpu->setCoreClockOffset(offset)) {
+            failures.append(QString("core clock offset of %1 MHz").arg(offset));
+        }
+
+        this->coreClock = this->gpu->getCoreClockOffset();
+        this->coreClockEnabled = this->coreClock != 0;
+    }
+
+    if(this->gpu->isMemoryClockControlAvailable()) {
+        int offset = this->memoryClockEnabled ? this->memoryClock : 0;
+
+        if(offset != this->gpu->getMemoryClockOffset() && !this->gpu->setMemoryClockOffset(offset)) {
+            failures.append(QString("memory clock offset of %1 MHz").arg(offset));
+        }
+
+        this->memoryClock = this->gpu->getMemoryClockOffset();
+        this->memoryClockEnabled = this->memoryClock != 0;
+    }
+
+    if(this->gpu->isPowerMizerAvailable()) {
+        GPU::PowerMizerMode mode = static_cast<GPU::PowerMizerMode>(this->powerMizerMode);
+
+        if(mode != this->gpu->getPowerMizerMode() && !this->gpu->setPowerMizerMode(mode)) {
+            failures.append(QString("PowerMizer mode \"%1\"").arg(this->ui->powerMizerInput->itemText(mode)));
+        }
+
+        this->powerMizerMode = this->gpu->getPowerMizerMode();
+    }
+
+    if(this->gpu->isPowerLimitControlAvailable()) {
+        int defaultLimit = qRound(this->gpu->getPowerLimitDefault());
+        int limit = this->powerLimitEnabled ? this->powerLimit : defaultLimit;
+
+        if(limit != qRound(this->gpu->getPowerLimit()) && !this->gpu->setPowerLimit(limit)) {
+            failures.append(QString("power limit of %1 W").arg(limit));
+        }
+
+        this->powerLimit = qRound(this->gpu->getPowerLimit());
+        this->powerLimitEnabled = this->powerLimit != defaultLimit;
+    }
+
+    if(this->fanTargetTempEnabled) {
+        this->fanController->setMode(GPUFanController::TargetTempMode);
+        this->fanController->setTargetTemp(this->fanTargetTemp);
+        this->fanController->setEnabled(true);
+    } else if(this->fanCurveEnabled) {
+        GPUFanCurve curve = this->fanController->getCurve();
+        curve.points = this->ui->fanCurveEditor->getPoints();
+        this->fanController->setCurve(curve);
+        this->fanController->setMode(GPUFanController::CurveMode);
+        this->fanController->setEnabled(true);
+    } else if(this->fanSpeedEnabled) {
+        this->fanController->setEnabled(false);
         this->gpu->setFanControlEnabled(true);
         this->gpu->setFanSpeed(this->fanSpeed);
     } else {
+        this->fanController->setEnabled(false);
         this->gpu->setFanControlEnabled(false);
     }
 
     this->valuesChanged = false;
 
     this->display();
+
+    if(!failures.isEmpty()) {
+        QMessageBox::warning(this, "Tweak", QString("The driver refused the %1, the previous values have been restored.").arg(failures.join(" and the ")));
+    }
 }
 
 /**
@@ -87,6 +191,38 @@ void GPUTweakWindow::save()
  */
 void GPUTweakWindow::display()
 {
+    GPUDiagnostics::ScopedTimer renderTimer(GPUDiagnostics::Render, "tweak");
+
+    // Core clock offset
+
+    bool coreClockAvailable = this->gpu->isCoreClockControlAvailable();
+
+    if(coreClockAvailable) {
+        this->ui->coreClockSlider->setRange(this->gpu->getCoreClockOffsetMin(), this->gpu->getCoreClockOffsetMax());
+        this->ui->coreClockInput->setText(QString::number(this->coreClock));
+        this->ui->coreClockSlider->setValue(this->coreClock);
+    }
+
+    this->ui->coreClockAutoCheckbox->setChecked(!coreClockAvailable || !this->coreClockEnabled);
+    this->ui->coreClockAutoCheckbox->setDisabled(!coreClockAvailable);
+    this->ui->coreClockInput->setDisabled(!coreClockAvailable || !this->coreClockEnabled);
+    this->ui->coreClockSlider->setDisabled(!coreClockAvailable || !this->coreClockEnabled);
+
+    // Memory clock offset
+
+    bool memoryClockAvailable = this->gpu->isMemoryClockControlAvailable();
+
+    if(memoryClockAvailable) {
+        this->ui->memoryClockSlider->setRange(this->gpu->getMemoryClockOffsetMin(), this->gpu->getMemoryClockOffsetMax());
+        this->ui->memoryClockInput->setText(QString::number(this->memoryClock));
+        this->ui->memoryClockSlider->setValue(this->memoryClock);
+    }
+
+    this->ui->memoryClockAutoCheckbox->setChecked(!memoryClockAvailable || !this->memoryClockEnabled);
+    this->ui->memoryClockAutoCheckbox->setDisabled(!memoryClockAvailable);
+    this->ui->memoryClockInput->setDisabled(!memoryClockAvailable || !this->memoryClockEnabled);
+    this->ui->memoryClockSlider->setDisabled(!memoryClockAvailable || !this->memoryClockEnabled);
+
     // Fan speed
 
     bool fanControlAvailable = this->gpu->isFanControlAvailable();
@@ -96,14 +232,139 @@ void GPUTweakWindow::display()
         this->ui->fanSpeedSlider->setValue(this->fanSpeed);
     }
 
+    bool manualFanSpeed = fanControlAvailable && !this->fanCurveEnabled && !this->fanTargetTempEnabled;
+
     this->ui->fanSpeedAutoCheckbox->setChecked(!fanControlAvailable || !this->fanSpeedEnabled);
-    this->ui->fanSpeedAutoCheckbox->setDisabled(!fanControlAvailable);
-    this->ui->fanSpeedInput->setDisabled(!fanControlAvailable || !this->fanSpeedEnabled);
-    this->ui->fanSpeedSlider->setDisabled(!fanControlAvailable || !this->fanSpeedEnabled);
+    this->ui->fanSpeedAutoCheckbox->setDisabled(!manualFanSpeed);
+    this->ui->fanSpeedInput->setDisabled(!manualFanSpeed || !this->fanSpeedEnabled);
+    this->ui->fanSpeedSlider->setDisabled(!manualFanSpeed || !this->fanSpeedEnabled);
+
+    // Fan curve
+
+    this->ui->fanCurveCheckbox->setChecked(fanControlAvailable && this->fanCurveEnabled);
+    this->ui->fanCurveCheckbox->setDisabled(!fanControlAvailable);
+    this->ui->fanCurveEditor->setDisabled(!fanControlAvailable || !this->fanCurveEnabled);
+
+    // Target temperature
+
+    this->ui->fanTargetTempInput->setValue(this->fanTargetTemp);
+    this->ui->fanTargetTempCheckbox->setChecked(fanControlAvailable && this->fanTargetTempEnabled);
+    this->ui->fanTargetTempCheckbox->setDisabled(!fanControlAvailable);
+    this->ui->fanTargetTempInput->setDisabled(!fanControlAvailable || !this->fanTargetTempEnabled);
+
+    // PowerMizer
+
+    this->ui->powerMizerInput->setCurrentIndex(this->powerMizerMode);
+    this->ui->powerMizerInput->setDisabled(!this->gpu->isPowerMizerAvailable());
+
+    // Power limit
+
+    bool powerLimitAvailable = this->gpu->isPowerLimitControlAvailable();
+
+    if(powerLimitAvailable) {
+        this->ui->powerLimitSlider->setRange(qRound(this->gpu->getPowerLimitMin()), qRound(this->gpu->getPowerLimitMax()));
+        this->ui->powerLimitInput->setText(QString::number(this->powerLimit));
+        this->ui->powerLimitSlider->setValue(this->powerLimit);
+    }
+
+    this->ui->powerLimitDefaultCheckbox->setChecked(!powerLimitAvailable || !this->powerLimitEnabled);
+    this->ui->powerLimitDefaultCheckbox->setDisabled(!powerLimitAvailable);
+    this->ui->powerLimitInput->setDisabled(!powerLimitAvailable || !this->powerLimitEnabled);
+    this->ui->powerLimitSlider->setDisabled(!powerLimitAvailable || !this->powerLimitEnabled);
 
     this->ui->applyBtn->setDisabled(!this->valuesChanged);
 }
 
+/**
+ * Handles core clock offset change from the input
+ * @param newText
+ */
+void GPUTweakWindow::on_coreClockInput_textEdited(QString newText)
+{
+    int newValue = qBound(this->gpu->getCoreClockOffsetMin(), newText.toInt(), this->gpu->getCoreClockOffsetMax());
+
+    if(newValue != this->coreClock) {
+        this->coreClock = newValue;
+        this->valuesChanged = true;
+
+        this->display();
+    }
+}
+
+/**
+ * Handles core clock offset change from the slider
+ * @param newValue
+ */
+void GPUTweakWindow::on_coreClockSlider_valueChanged(int newValue)
+{
+    if(newValue != this->coreClock) {
+        this->coreClock = newValue;
+        this->valuesChanged = true;
+
+        this->display();
+    }
+}
+
+/**
+ * Handles core clock change from/to auto
+ * @param newState
+ */
+void GPUTweakWindow::on_coreClockAutoCheckbox_stateChanged(int newState)
+{
+    bool enabled = newState == Qt::Unchecked;
+    if(enabled != this->coreClockEnabled) {
+        this->coreClockEnabled = enabled;
+        this->valuesChanged = true;
+
+        this->display();
+    }
+}
+
+/**
+ * Handles memory clock offset change from the input
+ * @param newText
+ */
+void GPUTweakWindow::on_memoryClockInput_textEdited(QString newText)
+{
+    int newValue = qBound(this->gpu->getMemoryClockOffsetMin(), newText.toInt(), this->gpu->getMemoryClockOffsetMax());
+
+    if(newValue != this->memoryClock) {
+        this->memoryClock = newValue;
+        this->valuesChanged = true;
+
+        this->display();
+    }
+}
+
+/**
+ * Handles memory clock offset change from the slider
+ * @param newValue
+ */
+void GPUTweakWindow::on_memoryClockSlider_valueChanged(int newValue)
+{
+    if(newValue != this->memoryClock) {
+        this->memoryClock = newValue;
+        this->valuesChanged = true;
+
+        this->display();
+    }
+}
+
+/**
+ * Handles memory clock change from/to auto
+ * @param newState
+ */
+void GPUTweakWindow::on_memoryClockAutoCheckbox_stateChanged(int newState)
+{
+    bool enabled = newState == Qt::Unchecked;
+    if(enabled != this->memoryClockEnabled) {
+        this->memoryClockEnabled = enabled;
+        this->valuesChanged = true;
+
+        this->display();
+    }
+}
+
 /**
  * Handles fan speed change from the input
  * @param newText
@@ -157,6 +418,247 @@ void GPUTweakWindow::on_fanSpeedAutoCheckbox_stateChanged(int newState)
     }
 }
 
+/**
+ * Handles fan speed change from/to curve
+ * @param newState
+ */
+void GPUTweakWindow::on_fanCurveCheckbox_stateChanged(int newState)
+{
+    bool enabled = newState == Qt::Checked;
+    if(enabled != this->fanCurveEnabled) {
+        this->fanCurveEnabled = enabled;
+        if(enabled) {
+            this->fanTargetTempEnabled = false;
+        }
+        this->valuesChanged = true;
+
+        this->display();
+    }
+}
+
+/**
+ * Handles points moved in the curve editor
+ */
+void GPUTweakWindow::on_fanCurveEditor_curveChanged()
+{
+    this->valuesChanged = true;
+
+    this->display();
+}
+
+/**
+ * Handles fan speed change from/to target temperature
+ * @param newState
+ */
+void GPUTweakWindow::on_fanTargetTempCheckbox_stateChanged(int newState)
+{
+    bool enabled = newState == Qt::Checked;
+    if(enabled != this->fanTargetTempEnabled) {
+        this->fanTargetTempEnabled = enabled;
+        if(enabled) {
+            this->fanCurveEnabled = false;
+        }
+        this->valuesChanged = true;
+
+        this->display();
+    }
+}
+
+/**
+ * Handles target temperature change
+ * @param newValue
+ */
+void GPUTweakWindow::on_fanTargetTempInput_valueChanged(int newValue)
+{
+    if(newValue != this->fanTargetTemp) {
+        this->fanTargetTemp = newValue;
+        this->valuesChanged = true;
+
+        this->display();
+    }
+}
+
+/**
+ * Handles PowerMizer mode change
+ * @param newIndex Index of the mode, same as GPU::PowerMizerMode
+ */
+void GPUTweakWindow::on_powerMizerInput_currentIndexChanged(int newIndex)
+{
+    if(newIndex >= 0 && newIndex != this->powerMizerMode) {
+        this->powerMizerMode = newIndex;
+        this->valuesChanged = true;
+
+        this->display();
+    }
+}
+
+/**
+ * Handles power limit change from the input
+ * @param newText
+ */
+void GPUTweakWindow::on_powerLimitInput_textEdited(QString newText)
+{
+    int newValue = qBound(qRound(this->gpu->getPowerLimitMin()), newText.toInt(), qRound(this->gpu->getPowerLimitMax()));
+
+    if(newValue != this->powerLimit) {
+        this->powerLimit = newValue;
+        this->valuesChanged = true;
+
+        this->display();
+    }
+}
+
+/**
+ * Handles power limit change from the slider
+ * @param newValue
+ */
+void GPUTweakWindow::on_powerLimitSlider_valueChanged(int newValue)
+{
+    if(newValue != this->powerLimit) {
+        this->powerLimit = newValue;
+        this->valuesChanged = true;
+
+        this->display();
+    }
+}
+
+/**
+ * Handles power limit change from/to default
+ * @param newState
+ */
+void GPUTweakWindow::on_powerLimitDefaultCheckbox_stateChanged(int newState)
+{
+    bool enabled = newState == Qt::Unchecked;
+    if(enabled != this->powerLimitEnabled) {
+        this->powerLimitEnabled = enabled;
+        this->valuesChanged = true;
+
+        this->display();
+    }
+}
+
+/**
+ * Fills the profile list from the saved profiles
+ */
+void GPUTweakWindow::reloadProfiles()
+{
+    QString current = this->ui->profileInput->currentText();
+
+    this->ui->profileInput->clear();
+    foreach(const GPUProfile &profile, GPUProfile::loadAll()) {
+        this->ui->profileInput->addItem(profile.name);
+    }
+
+    this->ui->profileInput->setEditText(current);
+}
+
+/**
+ * Creates a profile from the values of the window
+ * @param name Name of the profile
+ * @return Profile
+ */
+GPUProfile GPUTweakWindow::toProfile(QString name)
+{
+    GPUProfile profile;
+    profile.name = name;
+
+    if(this->fanTargetTempEnabled) {
+        profile.fanMode = GPUProfile::FanTargetTemp;
+    } else if(this->fanCurveEnabled) {
+        profile.fanMode = GPUProfile::FanCurve;
+    } else if(this->fanSpeedEnabled) {
+        profile.fanMode = GPUProfile::FanFixed;
+    } else {
+        profile.fanMode = GPUProfile::FanAuto;
+    }
+
+    profile.fanSpeed        = this->fanSpeed;
+    profile.fanCurve        = this->fanController->getCurve();
+    profile.fanCurve.points = this->ui->fanCurveEditor->getPoints();
+    profile.targetTemp      = this->fanTargetTemp;
+
+    profile.clockOffsets      = this->gpu->isCoreClockControlAvailable() || this->gpu->isMemoryClockControlAvailable();
+    profile.coreClockOffset   = this->coreClockEnabled ? this->coreClock : 0;
+    profile.memoryClockOffset = this->memoryClockEnabled ? this->memoryClock : 0;
+
+    profile.powerMizerMode = this->gpu->isPowerMizerAvailable() ? this->powerMizerMode : -1;
+
+    if(this->gpu->isPowerLimitControlAvailable()) {
+        profile.powerLimit = this->powerLimitEnabled ? this->powerLimit : qRound(this->gpu->getPowerLimitDefault());
+    }
+
+    return profile;
+}
+
+/**
+ * Puts the values of a profile in the window, they still have to be applied
+ * @param profile
+ */
+void GPUTweakWindow::loadProfile(const GPUProfile &profile)
+{
+    if(profile.fanMode != GPUProfile::FanUnchanged) {
+        this->fanSpeedEnabled      = profile.fanMode == GPUProfile::FanFixed;
+        this->fanCurveEnabled      = profile.fanMode == GPUProfile::FanCurve;
+        this->fanTargetTempEnabled = profile.fanMode == GPUProfile::FanTargetTemp;
+        this->fanSpeed             = profile.fanSpeed;
+        this->fanTargetTemp        = profile.targetTemp;
+        this->ui->fanCurveEditor->setPoints(profile.fanCurve.points);
+    }
+
+    if(profile.clockOffsets) {
+        this->coreClock          = qBound(this->gpu->getCoreClockOffsetMin(), profile.coreClockOffset, this->gpu->getCoreClockOffsetMax());
+        this->coreClockEnabled   = this->coreClock != 0;
+        this->memoryClock        = qBound(this->gpu->getMemoryClockOffsetMin(), profile.memoryClockOffset, this->gpu->getMemoryClockOffsetMax());
+        this->memoryClockEnabled = this->memoryClock != 0;
+    }
+
+    if(profile.powerMizerMode >= 0) {
+        this->powerMizerMode = profile.powerMizerMode;
+    }
+
+    if(profile.powerLimit > 0 && this->gpu->isPowerLimitControlAvailable()) {
+        this->powerLimit        = qBound(qRound(this->gpu->getPowerLimitMin()), profile.powerLimit, qRound(this->gpu->getPowerLimitMax()));
+        this->powerLimitEnabled = this->powerLimit != qRound(this->gpu->getPowerLimitDefault());
+    }
+
+    this->valuesChanged = true;
+
+    this->display();
+}
+
+/**
+ * Handles load profile button click
+ */
+void GPUTweakWindow::on_loadProfileBtn_clicked()
+{
+    GPUProfile profile;
+
+    if(GPUProfile::load(this->ui->profileInput->currentText(), profile)) {
+        this->loadProfile(profile);
+    }
+}
+
+/**
+ * Handles save profile button click
+ */
+void GPUTweakWindow::on_saveProfileBtn_clicked()
+{
+    QString name = this->ui->profileInput->currentText().trimmed();
+
+    if(name.isEmpty()) {
+        return;
+    }
+
+    if(!GPUProfile::save(this->toProfile(name))) {
+        QMessageBox::warning(this, "Profile", QString("Cannot write %1").arg(GPUProfile::storagePath()));
+        return;
+    }
+
+    this->reloadProfiles();
+
+    emit profilesChanged();
+}
+
 /**
  * Handles reset button click
  */
@@ -21,6 +21,8 @@
 #include <QWidget>
 
 #include "gpu.h"
+#include "gpufancontroller.h"
+#include "gpuprofile.h"
 
 namespace Ui {
 class GPUTweakWindow;
@@ -34,30 +36,65 @@ class GPUTweakWindow : public QWidget
     Q_OBJECT
 
 public:
-    explicit GPUTweakWindow(GPU *gpu, QWidget *parent = 0, Qt::WindowFlags f = 0);
+    explicit GPUTweakWindow(GPUFanController *fanController, QWidget *parent = 0, Qt::WindowFlags f = 0);
     ~GPUTweakWindow();
 
+signals:
+    /**
+     * Emitted when a profile has been saved
+     */
+    void profilesChanged();
+
 private:
     void resetValues();
     void save();
 
+    GPUProfile toProfile(QString name);
+    void       loadProfile(const GPUProfile &profile);
+    void       reloadProfiles();
+
     Ui::GPUTweakWindow *ui;
     GPU *gpu;
+    GPUFanController *fanController;
 
     bool coreClockEnabled;
-    int  coreClock;
+    int  coreClock;   // offset in MHz
     bool memoryClockEnabled;
-    int  memoryClock;
+    int  memoryClock; // offset in MHz
     bool fanSpeedEnabled;
     int  fanSpeed;
+    bool fanCurveEnabled;
+    bool fanTargetTempEnabled;
+    int  fanTargetTemp;
+    int  powerMizerMode; // see GPU::PowerMizerMode
+    bool powerLimitEnabled;
+    int  powerLimit;  // W
     bool valuesChanged;
 
 private slots:
     void display();
 
+    void on_coreClockInput_textEdited(QString newText);
+    void on_coreClockSlider_valueChanged(int newValue);
+    void on_coreClockAutoCheckbox_stateChanged(int newState);
+    void on_memoryClockInput_textEdited(QString newText);
+    void on_memoryClockSlider_valueChanged(int newValue);
+    void on_memoryClockAutoCheckbox_stateChanged(int newState);
+
     void on_fanSpeedInput_textEdited(QString newText);
     void on_fanSpeedSlider_valueChanged(int newValue);
     void on_fanSpeedAutoCheckbox_stateChanged(int newState);
+    void on_fanCurveCheckbox_stateChanged(int newState);
+    void on_fanCurveEditor_curveChanged();
+    void on_fanTargetTempCheckbox_stateChanged(int newState);
+    void on_fanTargetTempInput_valueChanged(int newValue);
+    void on_powerMizerInput_currentIndexChanged(int newIndex);
+    void on_powerLimitInput_textEdited(QString newText);
+    void on_powerLimitSlider_valueChanged(int newValue);
+    void on_powerLimitDefaultCheckbox_stateChanged(int newState);
+
+    void on_loadProfileBtn_clicked();
+    void on_saveProfileBtn_clicked();
 
     void on_resetBtn_clicked();
     void on_applyBtn_clicked();
@@ -0,0 +1,375 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "gpuworkloadwatcher.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegExp>
+#include <QSet>
+
+#include <dirent.h>
+#include <time.h>
+
+#include "gpuprofile.h"
+
+/**
+ * Time between two scans of /proc
+ */
+const int SCAN_INTERVAL_MSECS = 2000;
+/**
+ * A workload must be seen for this long before its profile is applied, so
+ * short-lived processes do not make the settings flap
+ */
+const int DEFAULT_DEBOUNCE_MSECS = 5000;
+/**
+ * Root of the proc filesystem, can be replaced through this environment variable to use a fake tree
+ */
+const char *PROC_ROOT_ENV = "GPUTWEAK_PROC_ROOT";
+const QString PROC_ROOT = "/proc";
+/**
+ * File holding the rules, next to the profiles
+ */
+const QString RULES_FILE = "rules.json";
+
+/**
+ * CPU time used by the calling thread
+ * @return Nanoseconds
+ */
+static qint64 threadCpuNsecs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+
+    return static_cast<qint64>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+GPUWorkloadWatcher::GPUWorkloadWatcher(QObject *parent) :
+    QObject(parent)
+{
+    this->debounceMsecs          = DEFAULT_DEBOUNCE_MSECS;
+    this->pendingDetectedAt      = 0;
+    this->scanCount              = 0;
+    this->lastScanNsecs          = 0;
+    this->scanCpuNsecs           = 0;
+    this->lastSwitchLatencyNsecs = -1;
+
+    QString root = QString::fromLocal8Bit(qgetenv(PROC_ROOT_ENV));
+    this->procRoot = root.isEmpty() ? PROC_ROOT : root;
+
+    this->timer.setInterval(SCAN_INTERVAL_MSECS);
+    connect(&this->timer, SIGNAL(timeout()), this, SLOT(scan()));
+
+    this->clock.start();
+}
+
+GPUWorkloadWatcher::~GPUWorkloadWatcher()
+{
+    // no-op
+}
+
+/**
+ * Path of the file holding the rules
+ * @return ex: ~/.config/GPUTweak/rules.json
+ */
+QString GPUWorkloadWatcher::rulesPath()
+{
+    return QFileInfo(GPUProfile::storagePath()).dir().filePath(RULES_FILE);
+}
+
+/**
+ * Reads the rules file, ex:
+ * {"default": "idle", "rules": [{"exe": "*blender", "profile": "render"}, {"cgroup": "*slurm*", "profile": "compute"}]}
+ * @param defaultProfile Set to the profile used when no rule matches, may be empty
+ * @return Rules in order
+ */
+QList<GPUWorkloadWatcher::Rule> GPUWorkloadWatcher::loadRules(QString &defaultProfile)
+{
+    QList<Rule> rules;
+
+    QFile file(GPUWorkloadWatcher::rulesPath());
+    if(!file.open(QIODevice::ReadOnly)) {
+        return rules;
+    }
+
+    QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+    defaultProfile = root.value("default").toString();
+
+    foreach(QJsonValue value, root.value("rules").toArray()) {
+        QJsonObject object = value.toObject();
+
+        Rule rule;
+        rule.type    = object.contains("cgroup") ? Rule::Cgroup : Rule::Executable;
+        rule.pattern = object.value(rule.type == Rule::Cgroup ? "cgroup" : "exe").toString();
+        rule.profile = object.value("profile").toString();
+
+        if(!rule.pattern.isEmpty() && !rule.profile.isEmpty()) {
+            rules.append(rule);
+        }
+    }
+
+    return rules;
+}
+
+/**
+ * Replaces the rules, all the processes are matched again at the next scan
+ * @param rules
+ * @param defaultProfile Profile used when no rule matches, empty to keep the last one
+ */
+void GPUWorkloadWatcher::setRules(QList<Rule> rules, QString defaultProfile)
+{
+    this->rules          = rules;
+    this->defaultProfile = defaultProfile;
+    this->processes.clear();
+}
+
+void GPUWorkloadWatcher::setDebounceMsecs(int msecs)
+{
+    this->debounceMsecs = msecs;
+}
+
+void GPUWorkloadWatcher::start()
+{
+    this->scan();
+    this->timer.start();
+}
+
+void GPUWorkloadWatcher::stop()
+{
+    this->timer.stop();
+    this->processes.clear();
+    this->activeProfile.clear();
+    this->pendingProfile.clear();
+}
+
+bool GPUWorkloadWatcher::isRunning()
+{
+    return this->timer.isActive();
+}
+
+QString GPUWorkloadWatcher::getActiveProfile()
+{
+    return this->activeProfile;
+}
+
+int GPUWorkloadWatcher::getProcessCount()
+{
+    return this->processes.size();
+}
+
+int GPUWorkloadWatcher::getScanCount()
+{
+    return this->scanCount;
+}
+
+qint64 GPUWorkloadWatcher::getLastScanNsecs()
+{
+    return this->lastScanNsecs;
+}
+
+/**
+ * CPU time used by all the scans
+ * @return Nanoseconds
+ */
+qint64 GPUWorkloadWatcher::getScanCpuNsecs()
+{
+    return this->scanCpuNsecs;
+}
+
+/**
+ * Time since the creation of the watcher, to compare with getScanCpuNsecs()
+ * @return Nanoseconds
+ */
+qint64 GPUWorkloadWatcher::getRunningNsecs()
+{
+    return this->clock.nsecsElapsed();
+}
+
+/**
+ * Time between the scan that saw the last workload change and the end of the profile switch, debounce included
+ * @return Nanoseconds, -1 if there was no switch yet
+ */
+qint64 GPUWorkloadWatcher::getLastSwitchLatencyNsecs()
+{
+    return this->lastSwitchLatencyNsecs;
+}
+
+/**
+ * Reads what a process runs, which changes when it calls exec
+ * The executable of other users can not be resolved, the name of the command is read instead
+ * @param pid
+ * @param exe  Set to the path of the executable, empty if unknown
+ * @param comm Set to the name of the command when the executable is unknown
+ */
+void GPUWorkloadWatcher::readImage(QString pid, QString &exe, QString &comm)
+{
+    QString path = QString("%1/%2").arg(this->procRoot).arg(pid);
+
+    exe = QFile::symLinkTarget(path + "/exe");
+    comm.clear();
+
+    if(exe.isEmpty()) {
+        QFile file(path + "/comm");
+        if(file.open(QIODevice::ReadOnly)) {
+            comm = QString::fromLocal8Bit(file.readAll()).trimmed();
+        }
+    }
+}
+
+/**
+ * Finds the first rule matching a process
+ * @param pid
+ * @param exe Path of the executable, see readImage()
+ * @return Index of the rule, -1 if none matches
+ */
+int GPUWorkloadWatcher::matchProcess(QString pid, QString exe)
+{
+    QString path = QString("%1/%2").arg(this->procRoot).arg(pid);
+
+    // Multi-call binaries hide the name of the command, and the executable of other users
+    // is unknown, so the first argument of the command line is matched too
+    QString command;
+
+    QFile cmdline(path + "/cmdline");
+    if(cmdline.open(QIODevice::ReadOnly)) {
+        command = QString::fromLocal8Bit(cmdline.readAll().split('\0').first());
+    }
+
+    QString cgroup;
+
+    for(int i=0; i < this->rules.size(); i++) {
+        const Rule &rule = this->rules.at(i);
+        QRegExp pattern(rule.pattern, Qt::CaseSensitive, QRegExp::Wildcard);
+
+        if(rule.type == Rule::Executable) {
+            if(pattern.exactMatch(exe) || pattern.exactMatch(command)) {
+                return i;
+            }
+            continue;
+        }
+
+        if(cgroup.isNull()) {
+            QFile file(path + "/cgroup");
+            cgroup = file.open(QIODevice::ReadOnly) ? QString::fromLocal8Bit(file.readAll()) : QString("");
+        }
+
+        // ex: "0::/system.slice/slurmstepd.scope/job_42"
+        foreach(QString line, cgroup.split('\n', QString::SkipEmptyParts)) {
+            if(pattern.exactMatch(line.section(':', 2))) {
+                return i;
+            }
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * Profile of the first rule matched by a running process
+ * @return Name, the default profile if no rule matches
+ */
+QString GPUWorkloadWatcher::wantedProfile()
+{
+    int best = this->rules.size();
+
+    foreach(const Process &process, this->processes) {
+        if(process.rule >= 0 && process.rule < best) {
+            best = process.rule;
+        }
+    }
+
+    return best < this->rules.size() ? this->rules.at(best).profile : this->defaultProfile;
+}
+
+/**
+ * Lists the processes, matches the new ones and the ones that ran another executable,
+ * and switches the profile once the wanted one is stable
+ */
+void GPUWorkloadWatcher::scan()
+{
+    qint64 cpuStart  = threadCpuNsecs();
+    qint64 scanStart = this->clock.nsecsElapsed();
+
+    // The known processes only cost a readlink of their exe, they are matched again if it changed
+    QSet<QString> seen;
+    bool changed = false;
+
+    DIR *dir = opendir(QFile::encodeName(this->procRoot).constData());
+    if(dir) {
+        struct dirent *entry;
+        while((entry = readdir(dir)) != NULL) {
+            if(entry->d_name[0] < '0' || entry->d_name[0] > '9') {
+                continue;
+            }
+
+            QString pid = QString::fromLatin1(entry->d_name);
+            seen.insert(pid);
+
+            Process process;
+            this->readImage(pid, process.exe, process.comm);
+
+            QHash<QString, Process>::const_iterator known = this->processes.constFind(pid);
+            if(known == this->processes.constEnd() || known.value().exe != process.exe || known.value().comm != process.comm) {
+                process.rule = this->matchProcess(pid, process.exe);
+                this->processes.insert(pid, process);
+                changed = true;
+            }
+        }
+        closedir(dir);
+    }
+
+    QHash<QString, Process>::iterator i = this->processes.begin();
+    while(i != this->processes.end()) {
+        if(seen.contains(i.key())) {
+            ++i;
+        } else {
+            i = this->processes.erase(i);
+            changed = true;
+        }
+    }
+
+    if(changed || !this->pendingProfile.isEmpty()) {
+        QString wanted = this->wantedProfile();
+
+        if(wanted.isEmpty() || wanted == this->activeProfile) {
+            this->pendingProfile.clear();
+        } else if(wanted != this->pendingProfile) {
+            this->pendingProfile    = wanted;
+            this->pendingDetectedAt = scanStart;
+            this->pendingSince.start();
+        }
+    }
+
+    this->scanCount++;
+    this->lastScanNsecs = this->clock.nsecsElapsed() - scanStart;
+    this->scanCpuNsecs += threadCpuNsecs() - cpuStart;
+
+    if(!this->pendingProfile.isEmpty() && this->pendingSince.elapsed() >= this->debounceMsecs) {
+        this->activeProfile = this->pendingProfile;
+        this->pendingProfile.clear();
+
+        emit profileRequested(this->activeProfile);
+
+        this->lastSwitchLatencyNsecs = this->clock.nsecsElapsed() - this->pendingDetectedAt;
+
+        emit profileSwitched();
+    }
+}
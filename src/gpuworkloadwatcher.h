@@ -0,0 +1,121 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GPUWORKLOADWATCHER_H
+#define GPUWORKLOADWATCHER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QTimer>
+
+/**
+ * Watches the running processes and asks for a saved profile when a matching workload starts
+ * /proc is scanned on a timer, only the processes that appeared since the previous
+ * scan or that ran another executable since (exec) are matched again, the others
+ * keep the rule they matched
+ */
+class GPUWorkloadWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * Associates a workload with a profile, the first matching rule wins
+     */
+    struct Rule {
+        enum Type {
+            Executable, // pattern matched against the path of the executable and the command
+            Cgroup      // pattern matched against the cgroup lines
+        };
+
+        Type    type;
+        QString pattern; // wildcard, ex: *blender
+        QString profile;
+    };
+
+    explicit GPUWorkloadWatcher(QObject *parent = 0);
+    ~GPUWorkloadWatcher();
+
+    static QString     rulesPath();
+    static QList<Rule> loadRules(QString &defaultProfile);
+
+    void    setRules(QList<Rule> rules, QString defaultProfile);
+    void    setDebounceMsecs(int msecs);
+
+    void    start();
+    void    stop();
+    bool    isRunning();
+
+    QString getActiveProfile();
+    int     getProcessCount();
+    int     getScanCount();
+    qint64  getLastScanNsecs();
+    qint64  getScanCpuNsecs();
+    qint64  getRunningNsecs();
+    qint64  getLastSwitchLatencyNsecs();
+
+signals:
+    /**
+     * Emitted when the workload changed for long enough, the profile should be applied
+     */
+    void profileRequested(QString name);
+    /**
+     * Emitted once the slots connected to profileRequested() returned, the switch latency is then known
+     */
+    void profileSwitched();
+
+public slots:
+    void scan();
+
+private:
+    /**
+     * A known process, matched again when what it runs changes
+     */
+    struct Process {
+        QString exe;  // empty if it can not be resolved
+        QString comm; // only read when the exe is empty
+        int     rule; // -1 for none
+    };
+
+    void    readImage(QString pid, QString &exe, QString &comm);
+    int     matchProcess(QString pid, QString exe);
+    QString wantedProfile();
+
+    QList<Rule>       rules;
+    QString           defaultProfile;
+    int               debounceMsecs;
+    QString           procRoot;
+
+    QTimer            timer;
+    QHash<QString, Process> processes; // by pid
+
+    QString           activeProfile;
+    QString           pendingProfile;   // wanted since pendingSince, not applied yet
+    QElapsedTimer     pendingSince;
+    qint64            pendingDetectedAt; // clock time of the scan that saw the change
+
+    QElapsedTimer     clock;
+    int               scanCount;
+    qint64            lastScanNsecs;
+    qint64            scanCpuNsecs;
+    qint64            lastSwitchLatencyNsecs;
+};
+
+#endif // GPUWORKLOADWATCHER_H
@@ -17,12 +17,299 @@
  */
 #include "mainwindow.h"
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QHostInfo>
+#include <QScopedPointer>
+#include <QStringList>
+#include <QTextStream>
+
+#include "benchmarks.h"
+#include "cli.h"
+#include "gpuagent.h"
+#include "gpubackends.h"
+#include "gpucollector.h"
+#include "gpuremotelink.h"
+#include "gpusimulated.h"
+#include "gputrace.h"
+
+/**
+ * Metrics streamed by an agent when --metrics is not given
+ */
+const char * const AGENT_DEFAULT_METRICS = "temp,fan,clocks,use,perf,pcie,power";
+/**
+ * Commands that never open a window
+ */
+const char * const HEADLESS_OPTIONS[] = {
+    "agent", "collector", "energy", "energy-run", "apply-profile", "power-limit", "quantiles", "diagnostics", "burst"
+};
+
+/**
+ * File given to --trace-output
+ */
+static QString traceOutput;
+
+/**
+ * Writes the trace spans when the application is destroyed, whatever command ran
+ */
+static void writeTraceOutput()
+{
+    if(!GPUTrace::writeChromeJson(traceOutput)) {
+        QTextStream(stderr) << "Cannot write " << traceOutput << endl;
+    }
+}
+
+/**
+ * Tells if the command runs without any window, so it needs no display
+ * The agents and collectors usually run on servers, the other commands from scripts
+ * @param argc
+ * @param argv
+ * @return True for the HEADLESS_OPTIONS
+ */
+static bool isHeadless(int argc, char *argv[])
+{
+    for(int i=1; i < argc; i++) {
+        QString arg(argv[i]);
+
+        for(size_t j=0; j < sizeof(HEADLESS_OPTIONS) / sizeof(HEADLESS_OPTIONS[0]); j++) {
+            QString option = QString("--%1").arg(HEADLESS_OPTIONS[j]);
+
+            if(arg == option || arg.startsWith(option + "=")) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Splits a host:port address
+ * @param address
+ * @param host
+ * @param port
+ * @return False if the address is invalid
+ */
+static bool parseAddress(QString address, QString &host, quint16 &port)
+{
+    int separator = address.lastIndexOf(':');
+    bool ok = false;
+
+    host = address.left(separator);
+    port = address.mid(separator + 1).toUShort(&ok);
+
+    return separator > 0 && ok && port > 0;
+}
 
 int main(int argc, char *argv[])
 {
-    QApplication a(argc, argv);
-    MainWindow w;
+    QScopedPointer<QCoreApplication> a(isHeadless(argc, argv) ? new QCoreApplication(argc, argv) : new QApplication(argc, argv));
+    QCoreApplication::setApplicationName("GPUTweak");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("GPU monitoring and tweaking tool");
+    parser.addHelpOption();
+
+    QCommandLineOption backendOption("backend", "Only use the <name> backend plugin to access the GPUs: nvidia-settings, nvidia-smi or amdgpu (default: all the available ones, nvidia-smi only if nvidia-settings finds nothing).", "name");
+    parser.addOption(backendOption);
+    QCommandLineOption simulateOption("simulate", "Use <count> simulated GPUs instead of the detected ones.", "count");
+    parser.addOption(simulateOption);
+    QCommandLineOption benchmarkOption("benchmark", "Run the <name> benchmark and exit (dashboard, pid, watcher, throttle, sketch, network).", "name");
+    parser.addOption(benchmarkOption);
+    QCommandLineOption gpuOption("gpu", "Comma-separated indexes of the GPUs used by the commands, or all (default 0 for --burst, all for --quantiles, --diagnostics, --energy, --power-limit and the profiles).", "list");
+    parser.addOption(gpuOption);
+    QCommandLineOption metricsOption("metrics", "Comma-separated metrics used by the commands: temp, fan, clocks, use, perf, offsets, pcie, power, all (default use,clocks).", "list", "use,clocks");
+    parser.addOption(metricsOption);
+    QCommandLineOption burstOption("burst", "Sample the metrics of the GPU as fast as possible for <secs> seconds, print a summary and exit.", "secs");
+    parser.addOption(burstOption);
+    QCommandLineOption burstOutputOption("burst-output", "Write the samples of the burst capture to <file> as CSV.", "file");
+    parser.addOption(burstOutputOption);
+    QCommandLineOption quantilesOption("quantiles", "Sample the metrics of the GPUs every second for <secs> seconds, print their percentiles as CSV and exit.", "secs");
+    parser.addOption(quantilesOption);
+    QCommandLineOption quantilesOutputOption("quantiles-output", "Also write the percentiles to <file> as JSON.", "file");
+    parser.addOption(quantilesOutputOption);
+    QCommandLineOption diagnosticsOption("diagnostics", "Poll the metrics of the GPUs every second for <secs> seconds, print the driver queries, process spawns and timings of GPUTweak itself (detection included) as CSV and exit.", "secs");
+    parser.addOption(diagnosticsOption);
+    QCommandLineOption diagnosticsOutputOption("diagnostics-output", "Also write the diagnostics to <file> as JSON.", "file");
+    parser.addOption(diagnosticsOutputOption);
+    QCommandLineOption energyOption("energy", "Measure the energy used by the GPUs between the job markers until interrupted: SIGUSR1 starts a job, SIGUSR2 stops it and prints its energy, average and peak power as CSV.");
+    parser.addOption(energyOption);
+    QCommandLineOption energyRunOption("energy-run", "Run the shell <command>, print the energy, average and peak power of the GPUs while it ran as CSV and exit with its exit code.", "command");
+    parser.addOption(energyRunOption);
+    QCommandLineOption energyIntervalOption("energy-interval", "Time between two power samples of --energy and --energy-run, in milliseconds (default 1000).", "msecs", "1000");
+    parser.addOption(energyIntervalOption);
+    QCommandLineOption applyProfileOption("apply-profile", "Apply the saved profile <name>, verify it, print the time taken and exit.", "name");
+    parser.addOption(applyProfileOption);
+    QCommandLineOption powerLimitOption("power-limit", "Set the power limit of the GPUs to <watts> in one batch, read it back, print the time taken and exit. Usually needs root.", "watts");
+    parser.addOption(powerLimitOption);
+    QCommandLineOption profileOption("profile", "Apply the saved profile <name> when the window opens, including fan curves.", "name");
+    parser.addOption(profileOption);
+    QCommandLineOption traceOutputOption("trace-output", "Write the trace spans of the last moments to <file> as Chrome trace-event JSON on exit. Needs a build with tracing (qmake CONFIG+=tracing).", "file");
+    parser.addOption(traceOutputOption);
+    QCommandLineOption agentOption("agent", "Stream the metrics of the GPUs to the collector at <host:port> without any window, every second or every --agent-interval. Streams the metrics given by --metrics, or temp,fan,clocks,use,perf,pcie,power.", "host:port");
+    parser.addOption(agentOption);
+    QCommandLineOption agentNameOption("agent-name", "Name of the host given to the collector (default: the host name).", "name");
+    parser.addOption(agentNameOption);
+    QCommandLineOption agentIntervalOption("agent-interval", "Time between two samples of the agent, in milliseconds (default 1000).", "msecs", "1000");
+    parser.addOption(agentIntervalOption);
+    QCommandLineOption collectorOption("collector", "Receive the metrics of the agents on TCP <port> and serve them to the viewers, without any window.", "port");
+    parser.addOption(collectorOption);
+    QCommandLineOption remoteOption("remote", "Show the GPUs of the agents connected to the collector at <host:port> instead of the local ones.", "host:port");
+    parser.addOption(remoteOption);
+
+    parser.process(*a);
+
+    if(parser.isSet(collectorOption)) {
+        GPUCollector collector;
+
+        if(!collector.listen(parser.value(collectorOption).toUShort())) {
+            QTextStream(stderr) << "Cannot listen on port " << parser.value(collectorOption) << endl;
+            return 1;
+        }
+
+        return a->exec();
+    }
+
+    if(parser.isSet(traceOutputOption)) {
+        if(GPUTrace::isEnabled()) {
+            traceOutput = parser.value(traceOutputOption);
+            qAddPostRoutine(writeTraceOutput);
+        } else {
+            QTextStream(stderr) << "GPUTweak was built without tracing, use qmake CONFIG+=tracing" << endl;
+        }
+    }
+
+    QList<GPU*> gpus;
+
+    if(parser.isSet(remoteOption)) {
+        // Added as the collector tells about them
+    } else if(parser.isSet(simulateOption)) {
+        gpus = GPUSimulated::getGPUs(parser.value(simulateOption).toInt());
+    } else if(parser.isSet(benchmarkOption)) {
+        // Benchmarks should not depend on the hardware of the machine
+        gpus = GPUSimulated::getGPUs(32);
+    } else {
+        gpus = GPUBackends::discover(parser.value(backendOption));
+    }
+
+    if(parser.isSet(benchmarkOption)) {
+        return Benchmarks::run(parser.value(benchmarkOption), gpus);
+    }
+
+    if(parser.isSet(agentOption)) {
+        QString host;
+        quint16 port;
+        GPU::Metrics metrics = Cli::parseMetrics(parser.isSet(metricsOption) ? parser.value(metricsOption) : AGENT_DEFAULT_METRICS);
+
+        if(!parseAddress(parser.value(agentOption), host, port) || !metrics) {
+            QTextStream(stderr) << "Invalid collector address or metrics" << endl;
+            return 1;
+        }
+
+        if(gpus.isEmpty()) {
+            QTextStream(stderr) << "No GPU found" << endl;
+            return 1;
+        }
+
+        GPUAgent agent(gpus, parser.isSet(agentNameOption) ? parser.value(agentNameOption) : QHostInfo::localHostName(),
+                       metrics, parser.value(agentIntervalOption).toInt());
+        agent.connectTo(host, port);
+
+        return a->exec();
+    }
+
+    if(parser.isSet(burstOption)) {
+        QList<GPU*> selected;
+        GPU::Metrics metrics = Cli::parseMetrics(parser.value(metricsOption));
+
+        if(!Cli::parseGPUs(parser.isSet(gpuOption) ? parser.value(gpuOption) : "0", gpus, selected) || !metrics) {
+            QTextStream(stderr) << "Invalid GPU or metrics" << endl;
+            return 1;
+        }
+
+        return Cli::burst(selected.first(), metrics, parser.value(burstOption).toInt() * 1000, parser.value(burstOutputOption));
+    }
+
+    if(parser.isSet(quantilesOption)) {
+        QList<GPU*> selected;
+        GPU::Metrics metrics = Cli::parseMetrics(parser.value(metricsOption));
+
+        if(!Cli::parseGPUs(parser.isSet(gpuOption) ? parser.value(gpuOption) : "all", gpus, selected) || !metrics) {
+            QTextStream(stderr) << "Invalid GPU or metrics" << endl;
+            return 1;
+        }
+
+        return Cli::quantiles(selected, metrics, parser.value(quantilesOption).toInt() * 1000, parser.value(quantilesOutputOption));
+    }
+
+    if(parser.isSet(diagnosticsOption)) {
+        QList<GPU*> selected;
+        GPU::Metrics metrics = Cli::parseMetrics(parser.value(metricsOption));
+
+        if(!Cli::parseGPUs(parser.isSet(gpuOption) ? parser.value(gpuOption) : "all", gpus, selected) || !metrics) {
+            QTextStream(stderr) << "Invalid GPU or metrics" << endl;
+            return 1;
+        }
+
+        return Cli::diagnostics(selected, metrics, parser.value(diagnosticsOption).toInt() * 1000, parser.value(diagnosticsOutputOption));
+    }
+
+    if(parser.isSet(energyOption) || parser.isSet(energyRunOption)) {
+        QList<GPU*> selected;
+        int intervalMsecs = parser.value(energyIntervalOption).toInt();
+
+        if(!Cli::parseGPUs(parser.isSet(gpuOption) ? parser.value(gpuOption) : "all", gpus, selected) || intervalMsecs <= 0) {
+            QTextStream(stderr) << "Invalid GPU or interval" << endl;
+            return 1;
+        }
+
+        if(parser.isSet(energyRunOption)) {
+            return Cli::energyRun(selected, parser.value(energyRunOption), intervalMsecs);
+        }
+
+        return Cli::energy(selected, intervalMsecs);
+    }
+
+    QList<GPU*> profileGPUs;
+    if((parser.isSet(applyProfileOption) || parser.isSet(profileOption) || parser.isSet(powerLimitOption))
+            && !Cli::parseGPUs(parser.isSet(gpuOption) ? parser.value(gpuOption) : "all", gpus, profileGPUs)) {
+        return 1;
+    }
+
+    if(parser.isSet(applyProfileOption)) {
+        return Cli::applyProfile(profileGPUs, parser.value(applyProfileOption));
+    }
+
+    if(parser.isSet(powerLimitOption)) {
+        if(parser.value(powerLimitOption).toInt() <= 0) {
+            QTextStream(stderr) << "Invalid power limit" << endl;
+            return 1;
+        }
+
+        return Cli::setPowerLimit(profileGPUs, parser.value(powerLimitOption).toInt());
+    }
+
+    MainWindow w(gpus);
     w.show();
 
-    return a.exec();
+    GPURemoteLink link;
+    if(parser.isSet(remoteOption)) {
+        QString host;
+        quint16 port;
+
+        if(!parseAddress(parser.value(remoteOption), host, port)) {
+            QTextStream(stderr) << "Invalid collector address" << endl;
+            return 1;
+        }
+
+        QObject::connect(&link, SIGNAL(gpuAdded(GPU*)), &w, SLOT(addGPU(GPU*)));
+        link.connectTo(host, port);
+    }
+
+    if(parser.isSet(profileOption)) {
+        foreach(QString failure, w.applyProfile(parser.value(profileOption), profileGPUs)) {
+            QTextStream(stderr) << failure << endl;
+        }
+    }
+
+    return a->exec();
 }
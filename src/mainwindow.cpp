@@ -18,75 +18,223 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
 
-#include <QTimer>
+#include <QMessageBox>
 #include <QToolButton>
 
 #include "gpuinfowindow.h"
 #include "gputweakwindow.h"
 #include "gpustatswindow.h"
-#include "nvidiasettingsadapter.h"
+#include "gpudashboardwindow.h"
+#include "gpudiagnosticswindow.h"
+#include "gpuprofile.h"
 
-MainWindow::MainWindow(QWidget *parent) :
+/**
+ * Time between two fetches of the values watched for throttling
+ */
+const int THROTTLE_POLL_INTERVAL_MSECS = 2000;
+/**
+ * Time between two fetches of the PCI-E link, it only changes with the power state
+ */
+const int PCIE_POLL_INTERVAL_MSECS = 10000;
+/**
+ * Time between two enumerations of the backends looking for plugged and unplugged GPUs
+ */
+const int RESCAN_INTERVAL_MSECS = 10000;
+
+MainWindow::MainWindow(QList<GPU*> gpus, QWidget *parent) :
     QMainWindow(parent),
     ui(new Ui::MainWindow)
 {
     ui->setupUi(this);
 
-    this->gpus.append(NvidiaSettingsAdapter::getGPUs());
-
-    for(int i=0; i < this->gpus.size(); i++) {
-        GPU *gpu = this->gpus.at(i);
+    this->monitoringUsers = 0;
 
-        QHBoxLayout *hBox = new QHBoxLayout();
+    this->poller = new GPUPoller(this);
+    this->eventLog = new GPUEventLog(this);
+    connect(this->eventLog, SIGNAL(changed()), this, SLOT(updateAlerts()));
 
-        hBox->addWidget(new QLabel(QString("[%1] %2").arg(gpu->getIdentifier()).arg(gpu->getName())));
+    // Only shown while something goes wrong
+    this->ui->alertsLabel->hide();
 
-        QToolButton *infoBtn = new QToolButton();
-        hBox->addWidget(infoBtn);
-        QAction * infoAction = new QAction("Informations", infoBtn);
-        QVariant infoActionData;
-        infoActionData.setValue(i);
-        infoAction->setData(infoActionData);
-        infoBtn->setDefaultAction(infoAction);
-        connect(infoAction, SIGNAL(triggered()), this, SLOT(openInfoWindow()));
+    foreach(GPU *gpu, gpus) {
+        this->addGPU(gpu);
+    }
 
-        QToolButton *statsBtn = new QToolButton();
-        hBox->addWidget(statsBtn);
-        QAction * statsAction = new QAction("Stats", statsBtn);
-        QVariant statsActionData;
-        statsActionData.setValue(i);
-        statsAction->setData(statsActionData);
-        statsBtn->setDefaultAction(statsAction);
-        connect(statsAction, SIGNAL(triggered()), this, SLOT(openStatsWindow()));
+    this->registry = new GPURegistry(gpus, this);
+    connect(this->registry, SIGNAL(gpuAdded(GPU*)), this, SLOT(addGPU(GPU*)));
+    connect(this->registry, SIGNAL(gpuRemoved(GPU*)), this, SLOT(removeGPU(GPU*)));
+    this->registry->start(RESCAN_INTERVAL_MSECS);
 
-        QToolButton *tweakBtn = new QToolButton();
-        hBox->addWidget(tweakBtn);
-        QAction * tweakAction = new QAction("Tweak", tweakBtn);
-        QVariant tweakActionData;
-        tweakActionData.setValue(i);
-        tweakAction->setData(tweakActionData);
-        tweakBtn->setDefaultAction(tweakAction);
-        connect(tweakAction, SIGNAL(triggered()), this, SLOT(openTweakWindow()));
+    this->watcher = new GPUWorkloadWatcher(this);
+    connect(this->watcher, SIGNAL(profileRequested(QString)), this, SLOT(applyWatchedProfile(QString)));
+    connect(this->watcher, SIGNAL(profileSwitched()), this, SLOT(updateWatcherStatus()));
 
-        this->ui->gpusLayout->addLayout(hBox);
-    }
-    this->tick();
+    this->reloadProfiles();
 }
 
 MainWindow::~MainWindow()
 {
+    // Fans driven by a curve or a target temperature are given back to the driver on exit
+    foreach(GPUFanController *controller, this->fanControllers) {
+        controller->setEnabled(false);
+    }
+
     delete ui;
 }
 
 /**
- * Tick that refreshes the variable data from the GPUs
+ * Starts tracking a GPU and adds its row of buttons
+ * The history of a GPU that was unplugged earlier is continued
+ * @param gpu
  */
-void MainWindow::tick()
+void MainWindow::addGPU(GPU *gpu)
 {
-    QTimer::singleShot(2000, this, SLOT(tick()));
+    GPUHistory *history = this->unpluggedHistories.take(gpu->getBusId());
+    if(history) {
+        history->setGPU(gpu);
+    } else {
+        history = new GPUHistory(gpu, this);
+    }
+
+    this->gpus.append(gpu);
+    this->histories.append(history);
+
+    this->fanControllers.append(new GPUFanController(gpu, this->poller, this));
+
+    this->createMonitors(gpu);
+
+    // The actions carry the GPU rather than an index, which changes when another GPU is unplugged
+    QVariant actionData;
+    actionData.setValue(static_cast<QObject*>(gpu));
+
+    QWidget *row = new QWidget();
+    QHBoxLayout *hBox = new QHBoxLayout(row);
+    hBox->setContentsMargins(0, 0, 0, 0);
+
+    hBox->addWidget(new QLabel(QString("[%1] %2").arg(gpu->getIdentifier()).arg(gpu->getName())));
+
+    QToolButton *infoBtn = new QToolButton();
+    hBox->addWidget(infoBtn);
+    QAction * infoAction = new QAction("Informations", infoBtn);
+    infoAction->setData(actionData);
+    infoBtn->setDefaultAction(infoAction);
+    connect(infoAction, SIGNAL(triggered()), this, SLOT(openInfoWindow()));
+
+    QToolButton *statsBtn = new QToolButton();
+    hBox->addWidget(statsBtn);
+    QAction * statsAction = new QAction("Stats", statsBtn);
+    statsAction->setData(actionData);
+    statsBtn->setDefaultAction(statsAction);
+    connect(statsAction, SIGNAL(triggered()), this, SLOT(openStatsWindow()));
+
+    QToolButton *tweakBtn = new QToolButton();
+    hBox->addWidget(tweakBtn);
+    QAction * tweakAction = new QAction("Tweak", tweakBtn);
+    tweakAction->setData(actionData);
+    tweakBtn->setDefaultAction(tweakAction);
+    connect(tweakAction, SIGNAL(triggered()), this, SLOT(openTweakWindow()));
+
+    this->ui->gpusLayout->addWidget(row);
+    this->gpuRows.insert(gpu, row);
+
+    emit historyAdded(history);
+}
+
+/**
+ * Stops tracking an unplugged GPU, it is deleted right after
+ * Its history is kept by bus id, the windows of the GPU close themselves
+ * @param gpu
+ */
+void MainWindow::removeGPU(GPU *gpu)
+{
+    int index = this->gpus.indexOf(gpu);
+    if(index < 0) {
+        return;
+    }
+
+    GPUHistory *history = this->histories.takeAt(index);
+    this->gpus.removeAt(index);
+
+    emit historyRemoved(history);
+
+    history->setGPU(0);
+    this->unpluggedHistories.insert(gpu->getBusId(), history);
+
+    this->eventLog->endAll(gpu, QDateTime::currentDateTime());
+
+    // A card that was only renumbered is still there, its fan must not stay at a fixed speed
+    GPUFanController *controller = this->fanControllers.takeAt(index);
+    controller->setEnabled(false);
+    controller->deleteLater();
+    delete this->throttleDetectors.take(gpu);
+    delete this->pcieMonitors.take(gpu);
+    delete this->gpuRows.take(gpu);
+}
+
+/**
+ * Creates the throttle detector and the PCI-E monitor of a GPU, they only fetch values while monitoring
+ * @param gpu
+ */
+void MainWindow::createMonitors(GPU *gpu)
+{
+    this->throttleDetectors.insert(gpu, new GPUThrottleDetector(gpu, this->eventLog, this));
+
+    if(gpu->getPcieMaxLinkWidth() > 0) {
+        this->pcieMonitors.insert(gpu, new GPUPcieMonitor(gpu, this->eventLog, this));
+    }
+
+    if(this->monitoringUsers > 0) {
+        this->subscribeMonitors(gpu);
+    }
+}
+
+/**
+ * Lets the monitors of a GPU fetch the values they watch
+ * @param gpu
+ */
+void MainWindow::subscribeMonitors(GPU *gpu)
+{
+    this->poller->subscribe(this->throttleDetectors.value(gpu), gpu, GPU::CoreTemp | GPU::Utilization | GPU::Clocks, THROTTLE_POLL_INTERVAL_MSECS);
+
+    if(this->pcieMonitors.contains(gpu)) {
+        this->poller->subscribe(this->pcieMonitors.value(gpu), gpu, GPU::PcieLink | GPU::Utilization, PCIE_POLL_INTERVAL_MSECS);
+    }
+}
+
+/**
+ * Starts watching the GPUs for throttling and PCI-E link downgrades if it is the first user of the events
+ * The users are the alerts of the main window and the open stats and dashboard windows
+ */
+void MainWindow::acquireMonitoring()
+{
+    if(this->monitoringUsers++ > 0) {
+        return;
+    }
+
+    foreach(GPU *gpu, this->gpus) {
+        this->subscribeMonitors(gpu);
+    }
+}
+
+/**
+ * Stops watching the GPUs once the last user of the events is gone
+ * Events still going on are ended, nothing would see them end otherwise
+ */
+void MainWindow::releaseMonitoring()
+{
+    if(--this->monitoringUsers > 0) {
+        return;
+    }
+
+    QDateTime now = QDateTime::currentDateTime();
 
     foreach(GPU *gpu, this->gpus) {
-        gpu->fetchVariables();
+        this->eventLog->endAll(gpu, now);
+
+        // Unsubscribed by their deletion, the new ones start without the state of the previous period
+        delete this->throttleDetectors.take(gpu);
+        delete this->pcieMonitors.take(gpu);
+        this->createMonitors(gpu);
     }
 }
 
@@ -94,9 +242,9 @@ void MainWindow::openInfoWindow()
 {
     QAction* action = qobject_cast<QAction*>(sender());
     Q_ASSERT(action);
-    int gpuInd = action->data().value<int>();
+    GPU *gpu = static_cast<GPU*>(action->data().value<QObject*>());
 
-    GPUInfoWindow *window = new GPUInfoWindow(this->gpus.at(gpuInd), this, Qt::Window);
+    GPUInfoWindow *window = new GPUInfoWindow(gpu, this->poller, this, Qt::Window);
     window->setAttribute(Qt::WA_DeleteOnClose);
     window->show();
 }
@@ -105,10 +253,11 @@ void MainWindow::openTweakWindow()
 {
     QAction* action = qobject_cast<QAction*>(sender());
     Q_ASSERT(action);
-    int gpuInd = action->data().value<int>();
+    int gpuInd = this->gpus.indexOf(static_cast<GPU*>(action->data().value<QObject*>()));
 
-    GPUTweakWindow *window = new GPUTweakWindow(this->gpus.at(gpuInd), this, Qt::Window);
+    GPUTweakWindow *window = new GPUTweakWindow(this->fanControllers.at(gpuInd), this, Qt::Window);
     window->setAttribute(Qt::WA_DeleteOnClose);
+    connect(window, SIGNAL(profilesChanged()), this, SLOT(reloadProfiles()));
     window->show();
 }
 
@@ -116,9 +265,184 @@ void MainWindow::openStatsWindow()
 {
     QAction* action = qobject_cast<QAction*>(sender());
     Q_ASSERT(action);
-    int gpuInd = action->data().value<int>();
+    int gpuInd = this->gpus.indexOf(static_cast<GPU*>(action->data().value<QObject*>()));
 
-    GPUStatsWindow *window = new GPUStatsWindow(this->gpus.at(gpuInd), this, Qt::Window);
+    GPUStatsWindow *window = new GPUStatsWindow(this->histories.at(gpuInd), this->eventLog, this->poller, this, Qt::Window);
+    window->setAttribute(Qt::WA_DeleteOnClose);
+    // Queued, the windows closed along with the main window must not call it back while it is destroyed
+    this->acquireMonitoring();
+    connect(window, SIGNAL(destroyed()), this, SLOT(releaseMonitoring()), Qt::QueuedConnection);
+    window->show();
+}
+
+void MainWindow::on_dashboardBtn_clicked()
+{
+    GPUDashboardWindow *window = new GPUDashboardWindow(this->histories, this->poller, this, Qt::Window);
     window->setAttribute(Qt::WA_DeleteOnClose);
+    connect(this, SIGNAL(historyAdded(GPUHistory*)), window, SLOT(addHistory(GPUHistory*)));
+    connect(this, SIGNAL(historyRemoved(GPUHistory*)), window, SLOT(removeHistory(GPUHistory*)));
+    this->acquireMonitoring();
+    connect(window, SIGNAL(destroyed()), this, SLOT(releaseMonitoring()), Qt::QueuedConnection);
     window->show();
 }
+
+void MainWindow::on_diagnosticsBtn_clicked()
+{
+    GPUDiagnosticsWindow *window = new GPUDiagnosticsWindow(this->histories, this, Qt::Window);
+    window->setAttribute(Qt::WA_DeleteOnClose);
+    connect(this, SIGNAL(historyAdded(GPUHistory*)), window, SLOT(addHistory(GPUHistory*)));
+    connect(this, SIGNAL(historyRemoved(GPUHistory*)), window, SLOT(removeHistory(GPUHistory*)));
+    window->show();
+}
+
+/**
+ * Applies a saved profile to some GPUs, with their fan controllers
+ * @param name Name of the profile
+ * @param gpus GPUs to tweak
+ * @return Description of each problem, empty if the profile is applied
+ */
+QStringList MainWindow::applyProfile(QString name, QList<GPU*> gpus)
+{
+    GPUProfile profile;
+    if(!GPUProfile::load(name, profile)) {
+        return QStringList() << QString("Unknown profile: %1").arg(name);
+    }
+
+    QList<GPUFanController*> controllers;
+    foreach(GPU *gpu, gpus) {
+        controllers.append(this->fanControllers.at(this->gpus.indexOf(gpu)));
+    }
+
+    QStringList failures;
+
+    if(!profile.apply(controllers)) {
+        failures.append("The driver reported an error");
+    }
+
+    failures.append(profile.verify(controllers));
+
+    return failures;
+}
+
+/**
+ * Applies the selected profile to all GPUs
+ */
+void MainWindow::on_applyProfileBtn_clicked()
+{
+    QStringList failures = this->applyProfile(this->ui->profileInput->currentText(), this->gpus);
+
+    if(!failures.isEmpty()) {
+        QMessageBox::warning(this, "Profile", failures.join("\n"));
+    }
+}
+
+/**
+ * Fills the profile list from the saved profiles
+ */
+void MainWindow::reloadProfiles()
+{
+    QString current = this->ui->profileInput->currentText();
+
+    this->ui->profileInput->clear();
+    foreach(const GPUProfile &profile, GPUProfile::loadAll()) {
+        this->ui->profileInput->addItem(profile.name);
+    }
+
+    this->ui->profileInput->setCurrentText(current);
+    this->ui->applyProfileBtn->setDisabled(this->ui->profileInput->count() == 0);
+}
+
+/**
+ * Starts or stops the automatic profile switching, with the rules read from the rules file
+ * @param checked
+ */
+void MainWindow::on_watcherInput_toggled(bool checked)
+{
+    if(!checked) {
+        this->watcher->stop();
+        this->ui->watcherLabel->clear();
+        this->ui->watcherLabel->setToolTip(QString());
+        return;
+    }
+
+    QString defaultProfile;
+    QList<GPUWorkloadWatcher::Rule> rules = GPUWorkloadWatcher::loadRules(defaultProfile);
+
+    if(rules.isEmpty()) {
+        QMessageBox::warning(this, "Profile", QString("No rule found in %1").arg(GPUWorkloadWatcher::rulesPath()));
+        this->ui->watcherInput->setChecked(false);
+        return;
+    }
+
+    this->watcher->setRules(rules, defaultProfile);
+    this->watcher->start();
+    this->ui->watcherLabel->setText("Watching");
+}
+
+/**
+ * Applies the profile asked by the watcher to all GPUs
+ * @param name
+ */
+void MainWindow::applyWatchedProfile(QString name)
+{
+    QStringList failures = this->applyProfile(name, this->gpus);
+
+    this->ui->watcherLabel->setText(failures.isEmpty()
+        ? QString("Active: %1").arg(name)
+        : QString("Failed: %1").arg(name));
+
+    this->ui->watcherLabel->setToolTip(failures.join("\n"));
+}
+
+/**
+ * Shows the overhead of the watcher and the latency of the last switch
+ */
+void MainWindow::updateWatcherStatus()
+{
+    QString tooltip = QString("%1 processes, last scan %2 µs, scans used %3% of the CPU time\nSwitched %4 ms after the workload change")
+        .arg(this->watcher->getProcessCount())
+        .arg(this->watcher->getLastScanNsecs() / 1000)
+        .arg(100.0 * this->watcher->getScanCpuNsecs() / qMax(this->watcher->getRunningNsecs(), qint64(1)), 0, 'f', 3)
+        .arg(this->watcher->getLastSwitchLatencyNsecs() / 1000000);
+
+    QString failures = this->ui->watcherLabel->toolTip();
+    if(!failures.isEmpty()) {
+        tooltip += "\n" + failures;
+    }
+
+    this->ui->watcherLabel->setToolTip(tooltip);
+}
+
+/**
+ * Watches the GPUs and shows the events going on, even without any window open
+ * @param checked
+ */
+void MainWindow::on_alertsInput_toggled(bool checked)
+{
+    if(checked) {
+        this->acquireMonitoring();
+    } else {
+        this->releaseMonitoring();
+    }
+}
+
+/**
+ * Lists the events that are still going on
+ */
+void MainWindow::updateAlerts()
+{
+    QStringList alerts;
+
+    foreach(const GPUEventLog::Event &event, this->eventLog->getEvents()) {
+        if(!event.end.isValid()) {
+            alerts.append(QString("[%1] %2 since %3: %4")
+                          .arg(event.gpuIdentifier)
+                          .arg(GPUEventLog::getTypeName(event.type))
+                          .arg(event.start.time().toString())
+                          .arg(event.details));
+        }
+    }
+
+    this->ui->alertsLabel->setText(alerts.join("\n"));
+    this->ui->alertsLabel->setVisible(!alerts.isEmpty());
+}
@@ -19,8 +19,18 @@
 #define MAINWINDOW_H
 
 #include <QMainWindow>
+#include <QHash>
+#include <QStringList>
 
 #include "gpu.h"
+#include "gpuhistory.h"
+#include "gpueventlog.h"
+#include "gputhrottledetector.h"
+#include "gpupciemonitor.h"
+#include "gpupoller.h"
+#include "gpuregistry.h"
+#include "gpufancontroller.h"
+#include "gpuworkloadwatcher.h"
 
 namespace Ui {
 class MainWindow;
@@ -35,20 +45,66 @@ class MainWindow : public QMainWindow
     Q_OBJECT
 
 public:
-    explicit MainWindow(QWidget *parent = 0);
+    explicit MainWindow(QList<GPU*> gpus, QWidget *parent = 0);
     ~MainWindow();
 
+    QStringList applyProfile(QString name, QList<GPU*> gpus);
+
+signals:
+    /**
+     * Emitted when a GPU is plugged or unplugged, for the windows showing all the GPUs
+     */
+    void historyAdded(GPUHistory *history);
+    void historyRemoved(GPUHistory *history);
+
 private:
     Ui::MainWindow *ui;
 
     QList<GPU*> gpus;
+    QList<GPUHistory*> histories;           // same order as the GPUs
+    QList<GPUFanController*> fanControllers; // same order as the GPUs
+    QHash<GPU*, GPUThrottleDetector*> throttleDetectors;
+    QHash<GPU*, GPUPcieMonitor*> pcieMonitors;
+    QHash<GPU*, QWidget*> gpuRows;
+
+    // Histories of the unplugged GPUs by bus id, continued if they come back
+    QHash<QString, GPUHistory*> unpluggedHistories;
+
+    GPURegistry *registry;
+
+    GPUEventLog *eventLog;
+
+    GPUPoller *poller;
+    GPUWorkloadWatcher *watcher;
+
+    int monitoringUsers; // alerts and open windows showing the events
+
+    void createMonitors(GPU *gpu);
+    void subscribeMonitors(GPU *gpu);
+    void acquireMonitoring();
+
+public slots:
+    void addGPU(GPU *gpu);
+    void removeGPU(GPU *gpu);
 
 private slots:
-    void tick();
     void openInfoWindow();
     void openTweakWindow();
     void openStatsWindow();
 
+    void on_dashboardBtn_clicked();
+    void on_diagnosticsBtn_clicked();
+    void on_applyProfileBtn_clicked();
+
+    void reloadProfiles();
+    void releaseMonitoring();
+    void on_alertsInput_toggled(bool checked);
+    void updateAlerts();
+
+    void on_watcherInput_toggled(bool checked);
+    void applyWatchedProfile(QString name);
+    void updateWatcherStatus();
+
 };
 
 #endif // MAINWINDOW_H
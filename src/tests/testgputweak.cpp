@@ -0,0 +1,1084 @@
+/*
+ * This file is part of the GPUTweak project, see README
+ * Copyright (C) 2015 Clark Winkelmann
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <QtTest>
+#include <QTemporaryDir>
+
+#include "gpudiagnostics.h"
+#include "gputrace.h"
+#include "gpunvidia.h"
+#include "nvidiasettingsadapter.h"
+#include "gpunvidiasmi.h"
+#include "nvidiasmiadapter.h"
+#include "gpuburstcapture.h"
+#include "gpuamd.h"
+#include "gpusimulated.h"
+#include "gpufancontroller.h"
+#include "gpuhistory.h"
+#include "gpuworkloadwatcher.h"
+
+/**
+ * Refreshes counted once an attribute was refused
+ */
+const int REFRESHES = 5;
+/**
+ * Spans kept per thread by the trace, see gputrace.cpp
+ */
+const int TRACE_BUFFER_SPANS = 16384;
+/**
+ * Exports made while the trace buffer is overwritten
+ */
+const int TRACE_EXPORTS = 20;
+/**
+ * Rows of the nvidia-smi stream, the second card has no power sensor and reports no fan speed on the first
+ * The last line is not a row, like the messages nvidia-smi prints on errors
+ */
+const QByteArray STREAM_OUTPUT = "0, 45, [N/A], 1530, 877, 20, 5, 3, 16, 45.50, 250.00\n"
+                                 "1, 52, 60, 1380, 810, 30, 6, 1, 8, [N/A], [N/A]\n"
+                                 "7, 30, 40, 1000, 810, 0, 0, 1, 16, 20.00, 100.00\n"
+                                 "Unable to determine the device handle for GPU 0000:03:00.0: Unknown Error\n";
+/**
+ * Duration of the burst captured from the stream, enough for a few rows of each card
+ */
+const int STREAM_BURST_MSECS = 1600;
+/**
+ * Duration of the burst captured through the query cache, a few of its TTLs
+ */
+const int CACHED_BURST_MSECS = 1000;
+/**
+ * Duration of the burst captured from the simulated card
+ */
+const int SILENT_BURST_MSECS = 100;
+/**
+ * Interval of the subscription whose first fetch is checked, longer than the check
+ */
+const int FIRST_FETCH_INTERVAL_MSECS = 10000;
+/**
+ * Time the simulated card spends in its performance level between two samples
+ */
+const int RESIDENCY_MSECS = 50;
+/**
+ * Fan duty cycle written to pwm1 by the fake amdgpu card, 50 %
+ */
+const QByteArray AMD_PWM = "128";
+/**
+ * Simulated seconds given to the card to stabilize before the step of the target, then to settle after it
+ */
+const int PID_STABILIZE_SECS = 300;
+const int PID_SETTLE_SECS    = 120;
+/**
+ * Distance to the target (°C) under which the temperature is considered settled, like the pid benchmark
+ */
+const int PID_SETTLED_BAND = 2;
+/**
+ * Steps the PID is held against one of its limits
+ */
+const int PID_SATURATED_STEPS = 300;
+/**
+ * Fan speed the PID starts from, away from both limits
+ */
+const double PID_START_OUTPUT = 50.0;
+
+/**
+ * Records spans of exactly 1 µs until stopped, wrapping its ring buffer many times
+ * A span read while half overwritten would mix the start of one with the end of another
+ */
+class TraceWriter : public QThread
+{
+public:
+    TraceWriter()
+    {
+        this->setObjectName("trace writer");
+    }
+
+    QAtomicInt stop;
+    QAtomicInt wrapped; // set once the buffer was filled twice
+
+protected:
+    void run()
+    {
+        for(qint64 i=0; !this->stop.load(); i++) {
+            GPUTrace::record("test span", i * 1000, i * 1000 + 1000);
+
+            if(i == TRACE_BUFFER_SPANS * 2) {
+                this->wrapped.store(1);
+            }
+        }
+    }
+};
+
+/**
+ * Records the metrics of each update of a GPU, like the histories and monitors
+ */
+class UpdateRecorder : public QObject
+{
+    Q_OBJECT
+
+public:
+    UpdateRecorder(GPU *gpu) : gpu(gpu)
+    {
+        connect(gpu, SIGNAL(updated()), this, SLOT(record()));
+    }
+
+    QList<int> metrics;
+
+private:
+    GPU *gpu;
+
+private slots:
+    void record()
+    {
+        this->metrics.append(static_cast<int>(this->gpu->getUpdatedMetrics()));
+    }
+};
+
+/**
+ * Behaviour of the backends, the fan controller and the trace, run by "make check"
+ * nvidia-settings and nvidia-smi are replaced by the fake ones of src/tools, and amdgpu
+ * by a fake sysfs tree, so no card is needed
+ */
+class TestGPUTweak : public QObject
+{
+    Q_OBJECT
+
+private:
+    QStringList makeSmiConstants(int index, QString powerDraw);
+    QString makeAmdDevice(const QTemporaryDir &sysfs);
+    void writeFile(QString path, QByteArray value);
+    QByteArray readFile(QString path);
+
+    QTemporaryDir dir;
+    int cacheTtl; // default TTL of the query cache, ms
+
+private slots:
+    void initTestCase();
+
+    void adapterQueryRangeFailure_data();
+    void adapterQueryRangeFailure();
+    void adapterAssign_data();
+    void adapterAssign();
+
+    void fetchRefusedAttribute();
+    void fetchRefusedFan();
+
+    void clockOffset_data();
+    void clockOffset();
+    void fanControlAvailable_data();
+    void fanControlAvailable();
+    void cachedBurstCapture();
+
+    void streamParse_data();
+    void streamParse();
+    void streamBurstCapture();
+    void burstCaptureSilent();
+
+    void amdFetchVariables();
+    void amdFanControl_data();
+    void amdFanControl();
+    void amdFanReadOnly_data();
+    void amdFanReadOnly();
+
+    void pidStepResponse_data();
+    void pidStepResponse();
+    void pidAntiWindup_data();
+    void pidAntiWindup();
+    void pidSetpointChange_data();
+    void pidSetpointChange();
+    void fanControllerUpdate();
+
+    void pollerFirstFetch();
+    void perfLevelResidency();
+
+    void workloadExec();
+
+    void traceExportWhileWrapping();
+};
+
+/**
+ * Puts the fake nvidia-settings first in the PATH
+ */
+void TestGPUTweak::initTestCase()
+{
+    QVERIFY(this->dir.isValid());
+    QVERIFY(QFile::link(QString(GPUTWEAK_TOOLS_DIR) + "/fake-nvidia-settings", this->dir.filePath("nvidia-settings")));
+
+    qputenv("PATH", QFile::encodeName(this->dir.path()) + ":" + qgetenv("PATH"));
+    qputenv("FAKE_NVIDIA_STATE", QFile::encodeName(this->dir.filePath("state")));
+    qunsetenv("GPUTWEAK_NVIDIA_SETTINGS");
+
+    // The cases change the state of the fake tool and read it back right away
+    this->cacheTtl = NvidiaSettingsAdapter::getCacheTtl();
+    NvidiaSettingsAdapter::setCacheTtl(0);
+
+    QCOMPARE(NvidiaSettingsAdapter::command(), QString("nvidia-settings"));
+}
+
+/**
+ * Writes a file of the fake sysfs tree or of the fake nvidia-settings state,
+ * with the new line sysfs puts after each value
+ * @param path
+ * @param value
+ */
+void TestGPUTweak::writeFile(QString path, QByteArray value)
+{
+    QDir().mkpath(QFileInfo(path).path());
+
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    file.write(value + "\n");
+}
+
+/**
+ * Reads a file written by writeFile() or by the code under test
+ * @param path
+ * @return Value without the new line
+ */
+QByteArray TestGPUTweak::readFile(QString path)
+{
+    QFile file(path);
+    file.open(QIODevice::ReadOnly);
+
+    return file.readAll().trimmed();
+}
+
+void TestGPUTweak::adapterQueryRangeFailure_data()
+{
+    QTest::addColumn<QString>("attribute");
+
+    QTest::newRow("read-only")         << "[gpu:0]/GPUCoreTemp";
+    QTest::newRow("unknown attribute") << "[gpu:0]/GPUUnknownAttribute";
+    QTest::newRow("unknown gpu")       << "[gpu:7]/GPUGraphicsClockOffset[2]";
+}
+
+/**
+ * Asking for the range of an attribute that has none fails and leaves the range untouched
+ */
+void TestGPUTweak::adapterQueryRangeFailure()
+{
+    QFETCH(QString, attribute);
+
+    int min = -1, max = -1;
+
+    QVERIFY(!NvidiaSettingsAdapter::queryAttributeRange(attribute, min, max));
+    QCOMPARE(min, -1);
+    QCOMPARE(max, -1);
+    QVERIFY(!NvidiaSettingsAdapter::isAttributeWritable(attribute));
+}
+
+void TestGPUTweak::adapterAssign_data()
+{
+    QTest::addColumn<int>("offset");
+    QTest::addColumn<bool>("batch");
+    QTest::addColumn<bool>("accepted");
+
+    QTest::newRow("accepted")         << 100  << false << true;
+    QTest::newRow("refused")          << 5000 << false << false;
+    QTest::newRow("batch accepted")   << 100  << true  << true;
+    QTest::newRow("batch refused")    << 5000 << true  << false;
+}
+
+/**
+ * An assignment refused by the driver fails, although nvidia-settings exits with 0
+ * and only reports it on the standard error
+ */
+void TestGPUTweak::adapterAssign()
+{
+    QFETCH(int, offset);
+    QFETCH(bool, batch);
+    QFETCH(bool, accepted);
+
+    QString attribute = "[gpu:0]/GPUGraphicsClockOffset[2]";
+    bool ok;
+
+    if(batch) {
+        NvidiaSettingsAdapter::beginBatch();
+        QVERIFY(NvidiaSettingsAdapter::setAttribute(attribute, offset));
+        ok = NvidiaSettingsAdapter::commitBatch();
+    } else {
+        ok = NvidiaSettingsAdapter::setAttribute(attribute, offset);
+    }
+
+    int applied = NvidiaSettingsAdapter::queryAtrribute(attribute).toInt();
+    NvidiaSettingsAdapter::setAttribute(attribute, 0);
+
+    QCOMPARE(ok, accepted);
+    QCOMPARE(applied, accepted ? offset : 0);
+}
+
+/**
+ * An attribute refused by the driver is read one by one the first time, then left out
+ * so a refresh is one process again
+ */
+void TestGPUTweak::fetchRefusedAttribute()
+{
+    QTemporaryDir state;
+    QVERIFY(state.isValid());
+    qputenv("FAKE_NVIDIA_STATE", QFile::encodeName(state.path()));
+
+    this->writeFile(state.filePath("0-GPUUtilization.refused"), QByteArray());
+
+    GPU::Metrics metrics = GPU::Utilization | GPU::CoreTemp;
+    GPUNvidia gpu(0, "GeForce GTX 1080", NvidiaSettingsAdapter::queryTopology().value(0));
+
+    gpu.fetchVariables(metrics);
+    QCOMPARE(gpu.getCurrentCoreTemp(), 45);
+    QVERIFY(!gpu.getFetchArguments(metrics).contains("[gpu:0]/GPUUtilization"));
+
+    GPUDiagnostics::Snapshot before = GPUDiagnostics::snapshot();
+
+    for(int i=0; i < REFRESHES; i++) {
+        gpu.fetchVariables(metrics);
+    }
+
+    GPUDiagnostics::Snapshot after = GPUDiagnostics::snapshot();
+
+    qputenv("FAKE_NVIDIA_STATE", QFile::encodeName(this->dir.filePath("state")));
+
+    QCOMPARE(after.counters[GPUDiagnostics::ProcessSpawns] - before.counters[GPUDiagnostics::ProcessSpawns], static_cast<qint64>(REFRESHES));
+    QCOMPARE(gpu.getCurrentCoreTemp(), 45);
+}
+
+/**
+ * A fan whose speed is refused is left out of the next refreshes like the GPU attributes,
+ * one process per refresh is enough again
+ */
+void TestGPUTweak::fetchRefusedFan()
+{
+    QTemporaryDir state;
+    QVERIFY(state.isValid());
+    qputenv("FAKE_NVIDIA_STATE", QFile::encodeName(state.path()));
+
+    this->writeFile(state.filePath("fan0-GPUCurrentFanSpeed.refused"), QByteArray());
+
+    GPU::Metrics metrics = GPU::FanSpeed | GPU::CoreTemp;
+    GPUNvidia gpu(0, "GeForce GTX 1080", NvidiaSettingsAdapter::queryTopology().value(0));
+
+    gpu.fetchVariables(metrics);
+    QCOMPARE(gpu.getCurrentCoreTemp(), 45);
+    QCOMPARE(gpu.getThermalSensorTempAt(0), 48);
+    QVERIFY(!gpu.getFetchArguments(metrics).contains("[fan:0]/GPUCurrentFanSpeed"));
+
+    GPUDiagnostics::Snapshot before = GPUDiagnostics::snapshot();
+
+    for(int i=0; i < REFRESHES; i++) {
+        gpu.fetchVariables(metrics);
+    }
+
+    GPUDiagnostics::Snapshot after = GPUDiagnostics::snapshot();
+
+    qputenv("FAKE_NVIDIA_STATE", QFile::encodeName(this->dir.filePath("state")));
+
+    QCOMPARE(after.counters[GPUDiagnostics::ProcessSpawns] - before.counters[GPUDiagnostics::ProcessSpawns], static_cast<qint64>(REFRESHES));
+    QCOMPARE(gpu.getThermalSensorTempAt(0), 48);
+}
+
+void TestGPUTweak::clockOffset_data()
+{
+    QTest::addColumn<int>("offset");
+    QTest::addColumn<QByteArray>("range");   // range given by the driver once the card is detected, empty for the usual one
+    QTest::addColumn<QByteArray>("clamp");   // highest offset the driver applies, empty for no limit
+    QTest::addColumn<bool>("accepted");
+    QTest::addColumn<int>("applied");
+
+    QTest::newRow("accepted")         << 100  << QByteArray()          << QByteArray()     << true  << 100;
+    QTest::newRow("refused")          << 100  << QByteArray("-200 50") << QByteArray()     << false << 0;
+    QTest::newRow("silently clamped") << 100  << QByteArray()          << QByteArray("50") << false << 0;
+    QTest::newRow("out of range")     << 1500 << QByteArray()          << QByteArray()     << false << 0;
+}
+
+/**
+ * A core clock offset is written, read back and restored if the driver did not apply it
+ * An offset outside of the range read at detection is refused without running nvidia-settings
+ */
+void TestGPUTweak::clockOffset()
+{
+    QFETCH(int, offset);
+    QFETCH(QByteArray, range);
+    QFETCH(QByteArray, clamp);
+    QFETCH(bool, accepted);
+    QFETCH(int, applied);
+
+    QTemporaryDir state;
+    QVERIFY(state.isValid());
+    qputenv("FAKE_NVIDIA_STATE", QFile::encodeName(state.path()));
+
+    GPUNvidia gpu(0, "GeForce GTX 1080", NvidiaSettingsAdapter::queryTopology().value(0));
+    QVERIFY(gpu.isCoreClockControlAvailable());
+    QCOMPARE(gpu.getCoreClockOffsetMax(), 1200);
+
+    // The offsets apply to the highest of the 3 performance levels of the fake card
+    QString file = state.filePath("0-GPUGraphicsClockOffset[2]");
+    if(!range.isEmpty()) {
+        this->writeFile(file + ".range", range);
+    }
+    if(!clamp.isEmpty()) {
+        this->writeFile(file + ".clamp", clamp);
+    }
+
+    GPUDiagnostics::Snapshot before = GPUDiagnostics::snapshot();
+
+    bool ok = gpu.setCoreClockOffset(offset);
+
+    GPUDiagnostics::Snapshot after = GPUDiagnostics::snapshot();
+
+    qputenv("FAKE_NVIDIA_STATE", QFile::encodeName(this->dir.filePath("state")));
+
+    QCOMPARE(ok, accepted);
+    QCOMPARE(gpu.getCoreClockOffset(), applied);
+    QCOMPARE(this->readFile(file).toInt(), applied);
+    if(offset > 1200) {
+        QCOMPARE(after.counters[GPUDiagnostics::ProcessSpawns], before.counters[GPUDiagnostics::ProcessSpawns]);
+    }
+}
+
+void TestGPUTweak::fanControlAvailable_data()
+{
+    QTest::addColumn<bool>("writable");
+
+    QTest::newRow("with Coolbits 4")    << true;
+    QTest::newRow("without Coolbits 4") << false;
+}
+
+/**
+ * The fans of a card are only controlled when the driver lets GPUFanControlState be written
+ */
+void TestGPUTweak::fanControlAvailable()
+{
+    QFETCH(bool, writable);
+
+    QTemporaryDir state;
+    QVERIFY(state.isValid());
+    qputenv("FAKE_NVIDIA_STATE", QFile::encodeName(state.path()));
+
+    if(!writable) {
+        this->writeFile(state.filePath("0-GPUFanControlState.range"), QByteArray());
+    }
+
+    NvidiaTopology topology = NvidiaSettingsAdapter::queryTopology().value(0);
+
+    GPUNvidia gpu(0, "GeForce GTX 1080", topology);
+
+    qputenv("FAKE_NVIDIA_STATE", QFile::encodeName(this->dir.filePath("state")));
+
+    QCOMPARE(gpu.isFanControlAvailable(), writable);
+}
+
+/**
+ * With the default query cache, each sample of a burst capture waits for the values of the
+ * previous one to expire, so every sample is read from the driver and the rate is the real one
+ */
+void TestGPUTweak::cachedBurstCapture()
+{
+    NvidiaSettingsAdapter::setCacheTtl(this->cacheTtl);
+    NvidiaSettingsAdapter::clearCache();
+
+    GPUNvidia gpu(0, "GeForce GTX 1080", NvidiaSettingsAdapter::queryTopology().value(0));
+    GPUBurstCapture capture(&gpu, GPU::CoreTemp | GPU::Utilization, CACHED_BURST_MSECS);
+
+    GPUDiagnostics::Snapshot before = GPUDiagnostics::snapshot();
+    capture.run();
+    GPUDiagnostics::Snapshot after = GPUDiagnostics::snapshot();
+
+    NvidiaSettingsAdapter::setCacheTtl(0);
+
+    int samples = capture.getSamples().size();
+
+    QCOMPARE(gpu.getRefreshPeriod(), this->cacheTtl);
+    QVERIFY(samples >= 2);
+    QVERIFY(samples <= CACHED_BURST_MSECS / this->cacheTtl + 1);
+    QVERIFY(capture.getMeanInterval() >= this->cacheTtl - 1);
+    QCOMPARE(after.counters[GPUDiagnostics::DriverQueryCacheHits], before.counters[GPUDiagnostics::DriverQueryCacheHits]);
+    QCOMPARE(after.counters[GPUDiagnostics::ProcessSpawns] - before.counters[GPUDiagnostics::ProcessSpawns], static_cast<qint64>(samples));
+    QVERIFY(capture.getSummary().contains("Rate limited"));
+}
+
+/**
+ * Detection row of a card of the nvidia-smi backend
+ * @param index     nvidia-smi index
+ * @param powerDraw Power draw, "[N/A]" for a card without power sensor
+ * @return Values in the order of the detection query
+ */
+QStringList TestGPUTweak::makeSmiConstants(int index, QString powerDraw)
+{
+    return NvidiaSmiAdapter::parseRow(QString("%1, Tesla V100-SXM2-16GB, 418.67, 00000000:%2:00.0, 16160, 3, 16, 16, %3, 250.00, 150.00, 300.00, 250.00")
+                                      .arg(index).arg(index + 1, 2, 10, QChar('0')).arg(powerDraw));
+}
+
+void TestGPUTweak::streamParse_data()
+{
+    QTest::addColumn<int>("chunkSize");
+
+    QTest::newRow("whole output") << STREAM_OUTPUT.size();
+    QTest::newRow("split lines")  << 7;
+    QTest::newRow("single bytes") << 1;
+}
+
+/**
+ * The output of the nvidia-smi stream is parsed as the pipe gives it, in chunks that can
+ * end anywhere in a line, and each row goes to its card
+ */
+void TestGPUTweak::streamParse()
+{
+    QFETCH(int, chunkSize);
+
+    NvidiaSmiStream *stream = NvidiaSmiStream::instance();
+
+    GPUNvidiaSmi first(this->makeSmiConstants(0, "45.50"));
+    GPUNvidiaSmi second(this->makeSmiConstants(1, "[N/A]"));
+
+    QList<QByteArray> chunks;
+    for(int i=0; i < STREAM_OUTPUT.size(); i += chunkSize) {
+        chunks.append(STREAM_OUTPUT.mid(i, chunkSize));
+    }
+
+    foreach(const QByteArray &chunk, chunks) {
+        stream->parseOutput(chunk);
+    }
+
+    QCOMPARE(first.getCurrentCoreTemp(), 45);
+    QCOMPARE(first.getCurrentFanSpeed(), 0);
+    QCOMPARE(first.getCurrentCoreClock(), 1530);
+    QCOMPARE(first.getCurrentMemoryClock(), 877);
+    QCOMPARE(first.getCurrentPowerDraw(), 45.5);
+
+    QCOMPARE(second.getCurrentCoreTemp(), 52);
+    QCOMPARE(second.getCurrentFanSpeed(), 60);
+    QCOMPARE(second.getCurrentCoreUse(), 30);
+    QCOMPARE(second.getPcieLinkGen(), 1);
+    QCOMPARE(second.getPcieLinkWidth(), 8);
+    QVERIFY(!second.isPowerDrawAvailable());
+
+    // A row is only dispatched once its line is complete, and only to its own card
+    qint64 firstRows  = stream->getRowCount(0);
+    qint64 secondRows = stream->getRowCount(1);
+
+    stream->parseOutput("0, 46, [N/A], 15");
+    QCOMPARE(stream->getRowCount(0), firstRows);
+    QCOMPARE(first.getCurrentCoreTemp(), 45);
+
+    stream->parseOutput("30, 877, 20, 5, 3, 16, 45.50, 250.00\n");
+    QCOMPARE(stream->getRowCount(0), firstRows + 1);
+    QCOMPARE(stream->getRowCount(1), secondRows);
+    QCOMPARE(first.getCurrentCoreTemp(), 46);
+    QCOMPARE(first.getCurrentCoreClock(), 1530);
+}
+
+/**
+ * Burst capture of the second card of the fake nvidia-smi, each sample waits for a new row of
+ * that card instead of reporting the same one again or returning on a row of the first card
+ */
+void TestGPUTweak::streamBurstCapture()
+{
+    qputenv("GPUTWEAK_NVIDIA_SMI", QFile::encodeName(QString(GPUTWEAK_TOOLS_DIR) + "/fake-nvidia-smi"));
+    qputenv("FAKE_NVIDIA_STATE", QFile::encodeName(this->dir.filePath("smi-state")));
+
+    QList<GPU*> gpus = NvidiaSmiAdapter::getGPUs();
+    QCOMPARE(gpus.size(), 2);
+
+    GPU *gpu = gpus.at(1);
+    GPUBurstCapture capture(gpu, GPU::CoreTemp | GPU::Utilization, STREAM_BURST_MSECS);
+
+    capture.run();
+
+    NvidiaSmiStream::instance()->stop();
+    qputenv("FAKE_NVIDIA_STATE", QFile::encodeName(this->dir.filePath("state")));
+    qunsetenv("GPUTWEAK_NVIDIA_SMI");
+
+    int period = gpu->getRefreshPeriod();
+    int rows   = STREAM_BURST_MSECS / period + 1;
+
+    QVERIFY(period > 0);
+    QVERIFY(capture.getSamples().size() >= 2);
+    QVERIFY(capture.getSamples().size() <= rows);
+    QVERIFY(capture.getMeanInterval() >= period / 2);
+    foreach(const GPUBurstCapture::Sample &sample, capture.getSamples()) {
+        // Default values of the fake tool for the second card
+        QCOMPARE(sample.values[GPUHistory::CoreTemp], 41);
+        QCOMPARE(sample.values[GPUHistory::CoreUse], 30);
+    }
+    QVERIFY(capture.getSummary().contains("Rate limited"));
+
+    qDeleteAll(gpus);
+}
+
+/**
+ * The samples of a burst capture are not emitted, the subscribers of the GPU do not record them
+ */
+void TestGPUTweak::burstCaptureSilent()
+{
+    GPUSimulated gpu(0);
+    UpdateRecorder recorder(&gpu);
+    GPUBurstCapture capture(&gpu, GPU::CoreTemp | GPU::Utilization, SILENT_BURST_MSECS);
+
+    capture.run();
+
+    QVERIFY(capture.getSamples().size() >= 2);
+    QVERIFY(recorder.metrics.isEmpty());
+
+    gpu.fetchVariables(GPU::CoreTemp);
+    QCOMPARE(recorder.metrics, QList<int>() << static_cast<int>(GPU::CoreTemp));
+}
+
+/**
+ * Device directory of a fake amdgpu card, with its hwmon directory
+ * @param sysfs Directory holding the tree
+ * @return Device path given to GPUAmd
+ */
+QString TestGPUTweak::makeAmdDevice(const QTemporaryDir &sysfs)
+{
+    QString device = sysfs.filePath("class/drm/card0/device");
+    QString hwmon  = device + "/hwmon/hwmon3";
+
+    this->writeFile(device + "/vendor", "0x1002");
+    this->writeFile(device + "/device", "0x67df");
+    this->writeFile(device + "/max_link_width", "16");
+    this->writeFile(device + "/max_link_speed", "8.0 GT/s PCIe");
+    this->writeFile(device + "/current_link_width", "8");
+    this->writeFile(device + "/current_link_speed", "2.5 GT/s PCIe");
+    // 8 GB, more than readIntFd() can give
+    this->writeFile(device + "/mem_info_vram_total", "8589934592");
+    this->writeFile(device + "/mem_info_vram_used", "2147483648");
+    this->writeFile(device + "/pp_dpm_sclk", "0: 300Mhz\n1: 1000Mhz *\n2: 1340Mhz");
+    this->writeFile(device + "/pp_dpm_mclk", "0: 300Mhz\n1: 2000Mhz *");
+    this->writeFile(device + "/gpu_busy_percent", "42");
+
+    this->writeFile(hwmon + "/temp1_input", "65000");
+    this->writeFile(hwmon + "/pwm1", AMD_PWM);
+    this->writeFile(hwmon + "/pwm1_enable", "2");
+    this->writeFile(hwmon + "/power1_average", "95000000");
+    this->writeFile(hwmon + "/power1_cap", "150000000");
+    this->writeFile(hwmon + "/power1_cap_min", "100000000");
+    this->writeFile(hwmon + "/power1_cap_max", "200000000");
+
+    return device;
+}
+
+/**
+ * A refresh of an amdgpu card reads each file kept open again from the start,
+ * so a new value is seen without reopening them
+ */
+void TestGPUTweak::amdFetchVariables()
+{
+    QTemporaryDir sysfs;
+    QVERIFY(sysfs.isValid());
+
+    QString device = this->makeAmdDevice(sysfs);
+    GPUAmd gpu(0, device);
+
+    gpu.fetchVariables(GPU::AllMetrics);
+
+    QCOMPARE(gpu.getTotalMemory(), 8192);
+    QCOMPARE(gpu.getCurrentCoreTemp(), 65);
+    QCOMPARE(gpu.getCurrentCoreClock(), 1000);
+    QCOMPARE(gpu.getCurrentMemoryClock(), 2000);
+    QCOMPARE(gpu.getCurrentCoreUse(), 42);
+    QCOMPARE(gpu.getCurrentMemoryUse(), 25);
+    QCOMPARE(gpu.getCurrentFanSpeed(), 50);
+    QVERIFY(!gpu.isFanControlEnabled());
+    QCOMPARE(gpu.getCurrentPowerDraw(), 95.0);
+    QCOMPARE(gpu.getPowerLimit(), 150.0);
+    QCOMPARE(gpu.getPcieMaxLinkGen(), 3);
+    QCOMPARE(gpu.getPcieLinkWidth(), 8);
+    QCOMPARE(gpu.getPcieLinkGen(), 1);
+
+    this->writeFile(device + "/hwmon/hwmon3/temp1_input", "71500");
+    this->writeFile(device + "/pp_dpm_sclk", "0: 300Mhz\n1: 1000Mhz\n2: 1340Mhz *");
+    gpu.fetchVariables(GPU::CoreTemp | GPU::Clocks);
+
+    QCOMPARE(gpu.getCurrentCoreTemp(), 71);
+    QCOMPARE(gpu.getCurrentCoreClock(), 1340);
+}
+
+void TestGPUTweak::amdFanControl_data()
+{
+    QTest::addColumn<int>("speed");
+    QTest::addColumn<QByteArray>("pwm");
+
+    // Values of the same length as AMD_PWM, the fake files are not truncated by the writes
+    QTest::newRow("50 %")  << 50  << QByteArray("127");
+    QTest::newRow("75 %")  << 75  << QByteArray("191");
+    QTest::newRow("100 %") << 100 << QByteArray("255");
+}
+
+/**
+ * Setting the fan speed writes pwm1, with pwm1_enable switched to manual before
+ * and back to automatic after
+ */
+void TestGPUTweak::amdFanControl()
+{
+    QFETCH(int, speed);
+    QFETCH(QByteArray, pwm);
+
+    QTemporaryDir sysfs;
+    QVERIFY(sysfs.isValid());
+
+    QString device = this->makeAmdDevice(sysfs);
+    QString hwmon  = device + "/hwmon/hwmon3";
+    GPUAmd gpu(0, device);
+
+    QVERIFY(gpu.isFanControlAvailable());
+
+    gpu.setFanControlEnabled(true);
+    QCOMPARE(this->readFile(hwmon + "/pwm1_enable"), QByteArray("1"));
+    QVERIFY(gpu.isFanControlEnabled());
+
+    gpu.setFanSpeed(speed);
+
+    QCOMPARE(this->readFile(hwmon + "/pwm1"), pwm);
+    QCOMPARE(gpu.getCurrentFanSpeed(), speed);
+
+    gpu.setFanControlEnabled(false);
+    QCOMPARE(this->readFile(hwmon + "/pwm1_enable"), QByteArray("2"));
+    QVERIFY(!gpu.isFanControlEnabled());
+
+    // The driver drives the fan again, a speed is not written
+    this->writeFile(hwmon + "/pwm1", AMD_PWM);
+    gpu.setFanSpeed(speed);
+    QCOMPARE(this->readFile(hwmon + "/pwm1"), AMD_PWM);
+}
+
+void TestGPUTweak::amdFanReadOnly_data()
+{
+    QTest::addColumn<bool>("missingEnable");
+
+    QTest::newRow("read-only files")     << false;
+    QTest::newRow("without pwm1_enable") << true;
+}
+
+/**
+ * Without write access to the fan files, the speed is still read but nothing is written
+ */
+void TestGPUTweak::amdFanReadOnly()
+{
+    QFETCH(bool, missingEnable);
+
+    QTemporaryDir sysfs;
+    QVERIFY(sysfs.isValid());
+
+    QString device = this->makeAmdDevice(sysfs);
+    QString hwmon  = device + "/hwmon/hwmon3";
+
+    if(missingEnable) {
+        QVERIFY(QFile::remove(hwmon + "/pwm1_enable"));
+    } else {
+        QFile::setPermissions(hwmon + "/pwm1", QFile::ReadOwner | QFile::ReadGroup | QFile::ReadOther);
+        QFile::setPermissions(hwmon + "/pwm1_enable", QFile::ReadOwner | QFile::ReadGroup | QFile::ReadOther);
+
+        if(QFileInfo(hwmon + "/pwm1").isWritable()) {
+            QSKIP("Read-only files are still writable by root");
+        }
+    }
+
+    GPUAmd gpu(0, device);
+
+    QVERIFY(!gpu.isFanControlAvailable());
+
+    gpu.fetchVariables(GPU::FanSpeed | GPU::FanControlState);
+
+    QCOMPARE(gpu.getCurrentFanSpeed(), 50);
+
+    gpu.setFanControlEnabled(true);
+    gpu.setFanSpeed(100);
+
+    QVERIFY(!gpu.isFanControlEnabled());
+    QCOMPARE(this->readFile(hwmon + "/pwm1"), AMD_PWM);
+    if(!missingEnable) {
+        QCOMPARE(this->readFile(hwmon + "/pwm1_enable"), QByteArray("2"));
+    }
+}
+
+void TestGPUTweak::pidStepResponse_data()
+{
+    QTest::addColumn<int>("load");
+    QTest::addColumn<int>("target");
+
+    // The simulated card stays below 62°C at full speed and 100 % load
+    QTest::newRow("100 %, 70 -> 65°C") << 100 << 65;
+    QTest::newRow("100 %, 70 -> 75°C") << 100 << 75;
+    QTest::newRow("50 %, 70 -> 60°C")  << 50  << 60;
+}
+
+/**
+ * The fan controller of the simulated card, in target temperature mode, settles on a
+ * new target after it steps away from the temperature it held
+ */
+void TestGPUTweak::pidStepResponse()
+{
+    QFETCH(int, load);
+    QFETCH(int, target);
+
+    GPUPoller poller;
+    GPUSimulated gpu(0);
+    gpu.setLoad(load);
+    gpu.setFanControlEnabled(true);
+
+    // Driven on simulated time, like the pid benchmark
+    GPUFanController controller(&gpu, &poller);
+    controller.setMode(GPUFanController::TargetTempMode);
+    controller.setTargetTemp(70);
+
+    for(int t=0; t < PID_STABILIZE_SECS; t++) {
+        gpu.fetchVariables(GPU::CoreTemp);
+        controller.process(gpu.getCurrentCoreTemp(), 1.0);
+    }
+
+    QVERIFY(qAbs(gpu.getCurrentCoreTemp() - 70) <= PID_SETTLED_BAND);
+
+    controller.setTargetTemp(target);
+
+    int settlingSecs = 0;
+    for(int t=1; t <= PID_SETTLE_SECS; t++) {
+        gpu.fetchVariables(GPU::CoreTemp);
+        controller.process(gpu.getCurrentCoreTemp(), 1.0);
+
+        if(qAbs(gpu.getCurrentCoreTemp() - target) > PID_SETTLED_BAND) {
+            settlingSecs = t;
+        }
+    }
+
+    QVERIFY2(settlingSecs < PID_SETTLE_SECS / 2, qPrintable(QString("Settled after %1 s").arg(settlingSecs)));
+}
+
+void TestGPUTweak::pidAntiWindup_data()
+{
+    QTest::addColumn<int>("temp");
+    QTest::addColumn<double>("limit");
+
+    QTest::newRow("hot, 100 %") << 90 << 100.0;
+    QTest::newRow("cold, 20 %") << 50 << 20.0;
+}
+
+/**
+ * The integral of the PID does not grow while its output is held against one of the limits
+ * of the fan speed, so back on the target it gives the speed it held before
+ */
+void TestGPUTweak::pidAntiWindup()
+{
+    QFETCH(int, temp);
+    QFETCH(double, limit);
+
+    GPUFanPid pid;
+    pid.setTarget(70);
+    pid.reset(PID_START_OUTPUT);
+
+    QCOMPARE(pid.step(70, 1.0), PID_START_OUTPUT);
+
+    for(int i=0; i < PID_SATURATED_STEPS; i++) {
+        QCOMPARE(pid.step(temp, 1.0), limit);
+    }
+
+    // The first sample back on the target still has the derivative of the drop
+    pid.step(70, 1.0);
+    QCOMPARE(pid.step(70, 1.0), PID_START_OUTPUT);
+}
+
+void TestGPUTweak::pidSetpointChange_data()
+{
+    QTest::addColumn<int>("target");
+
+    QTest::newRow("lowered") << 67;
+    QTest::newRow("raised")  << 73;
+}
+
+/**
+ * The derivative of the PID is taken on the temperature, so after a change of the target
+ * it gives the speed of a PID which always had that target, without a kick
+ */
+void TestGPUTweak::pidSetpointChange()
+{
+    QFETCH(int, target);
+
+    GPUFanPid pid;
+    pid.setTarget(70);
+    pid.reset(PID_START_OUTPUT);
+
+    for(int i=0; i < 10; i++) {
+        QCOMPARE(pid.step(70, 1.0), PID_START_OUTPUT);
+    }
+
+    // The first sample of a fresh PID has no derivative either
+    GPUFanPid fresh;
+    fresh.setTarget(target);
+    fresh.reset(PID_START_OUTPUT);
+
+    pid.setTarget(target);
+    double output = pid.step(70, 1.0);
+
+    QCOMPARE(output, fresh.step(70, 1.0));
+    QVERIFY(output > 20.0 && output < 100.0);
+}
+
+/**
+ * The fan speed written by the controller is refreshed and emitted once the update of the
+ * temperature is over, a handler connected after the controller still sees that update
+ */
+void TestGPUTweak::fanControllerUpdate()
+{
+    GPUPoller poller;
+    GPUSimulated gpu(0);
+
+    GPUFanController controller(&gpu, &poller);
+    controller.setEnabled(true);
+    QCoreApplication::processEvents();
+
+    // A new mode writes its first speed whatever the previous one
+    controller.setMode(GPUFanController::TargetTempMode);
+    int writes = controller.getWriteCount();
+
+    UpdateRecorder recorder(&gpu);
+    gpu.fetchVariables(GPU::CoreTemp);
+
+    QCOMPARE(recorder.metrics, QList<int>() << static_cast<int>(GPU::CoreTemp));
+
+    QTRY_COMPARE(controller.getWriteCount(), writes + 1);
+    QCOMPARE(recorder.metrics.last(), static_cast<int>(GPU::FanSpeed));
+}
+
+/**
+ * A new subscription is first fetched from the event loop, not from within subscribe()
+ */
+void TestGPUTweak::pollerFirstFetch()
+{
+    GPUPoller poller;
+    GPUSimulated gpu(0);
+    UpdateRecorder recorder(&gpu);
+
+    poller.subscribe(&recorder, &gpu, GPU::CoreTemp, FIRST_FETCH_INTERVAL_MSECS);
+    QVERIFY(recorder.metrics.isEmpty());
+
+    QTRY_COMPARE(recorder.metrics, QList<int>() << static_cast<int>(GPU::CoreTemp));
+}
+
+/**
+ * Only the time between two samples of the level is credited, not the time before the first one
+ */
+void TestGPUTweak::perfLevelResidency()
+{
+    GPUSimulated gpu(0);
+    GPUHistory history(&gpu);
+
+    QElapsedTimer timer;
+    timer.start();
+    gpu.fetchVariables(GPU::PerfLevel);
+    QVERIFY(history.getPerfLevelResidency().isEmpty());
+
+    QThread::msleep(RESIDENCY_MSECS);
+    gpu.fetchVariables(GPU::PerfLevel);
+
+    qint64 total = 0;
+    foreach(qint64 msecs, history.getPerfLevelResidency()) {
+        total += msecs;
+    }
+
+    QVERIFY(total >= RESIDENCY_MSECS);
+    QVERIFY(total <= timer.elapsed());
+}
+
+/**
+ * A known process that runs another executable is matched again, the pid alone does not tell
+ */
+void TestGPUTweak::workloadExec()
+{
+    QTemporaryDir proc;
+    QVERIFY(proc.isValid());
+
+    QString exe = proc.filePath("100/exe");
+    this->writeFile(proc.filePath("100/cmdline"), QByteArray("bash"));
+    QVERIFY(QFile::link("/usr/bin/bash", exe));
+
+    qputenv("GPUTWEAK_PROC_ROOT", QFile::encodeName(proc.path()));
+    GPUWorkloadWatcher watcher;
+    qunsetenv("GPUTWEAK_PROC_ROOT");
+
+    GPUWorkloadWatcher::Rule rule;
+    rule.type    = GPUWorkloadWatcher::Rule::Executable;
+    rule.pattern = "*blender";
+    rule.profile = "render";
+
+    watcher.setRules(QList<GPUWorkloadWatcher::Rule>() << rule, "idle");
+    watcher.setDebounceMsecs(0);
+
+    watcher.scan();
+    QCOMPARE(watcher.getActiveProfile(), QString("idle"));
+
+    // exec keeps the pid and the command line may stay the one of the launcher
+    QVERIFY(QFile::remove(exe));
+    QVERIFY(QFile::link("/usr/bin/blender", exe));
+
+    watcher.scan();
+    QCOMPARE(watcher.getActiveProfile(), QString("render"));
+}
+
+/**
+ * None of the spans exported while another thread keeps overwriting its buffer may be torn
+ */
+void TestGPUTweak::traceExportWhileWrapping()
+{
+    QString path = this->dir.filePath("trace.json");
+
+    TraceWriter writer;
+    writer.start();
+
+    while(!writer.wrapped.load()) {
+        QThread::yieldCurrentThread();
+    }
+
+    // Checked once the writer stopped, a failed check returns from the test
+    QList<QByteArray> exports;
+    for(int i=0; i < TRACE_EXPORTS; i++) {
+        QFile file(path);
+        if(GPUTrace::writeChromeJson(path) && file.open(QIODevice::ReadOnly)) {
+            exports.append(file.readAll());
+        }
+    }
+
+    writer.stop.store(1);
+    writer.wait();
+
+    QCOMPARE(exports.size(), TRACE_EXPORTS);
+
+    foreach(const QByteArray &json, exports) {
+        QJsonArray events = QJsonDocument::fromJson(json).object().value("traceEvents").toArray();
+
+        int tid = -1;
+        foreach(QJsonValue value, events) {
+            QJsonObject event = value.toObject();
+            if(event.value("ph").toString() == "M" && event.value("args").toObject().value("name").toString() == "trace writer") {
+                tid = event.value("tid").toInt();
+            }
+        }
+        QVERIFY(tid > 0);
+
+        int spans = 0;
+        foreach(QJsonValue value, events) {
+            QJsonObject event = value.toObject();
+            if(event.value("ph").toString() != "X" || event.value("tid").toInt() != tid) {
+                continue;
+            }
+
+            spans++;
+            QCOMPARE(event.value("dur").toDouble(), 1.0);
+        }
+
+        QVERIFY(spans > 0);
+        QVERIFY(spans <= TRACE_BUFFER_SPANS);
+    }
+}
+
+QTEST_MAIN(TestGPUTweak)
+
+#include "testgputweak.moc"
@@ -0,0 +1,67 @@
+#-------------------------------------------------
+#
+# Tests of GPUTweak, built separately from the application
+# Run with "make check", see README
+#
+#-------------------------------------------------
+
+QT       += core concurrent testlib
+
+TARGET = gputweak-tests
+TEMPLATE = app
+CONFIG += console testcase
+CONFIG -= app_bundle
+
+# The fake nvidia-settings put on the PATH by the tests, and the fake nvidia-smi
+DEFINES += GPUTWEAK_TOOLS_DIR=\\\"$$PWD/../tools\\\"
+
+# Trace spans, like the executable
+tracing: DEFINES += GPUTWEAK_TRACING
+
+INCLUDEPATH += .. \
+    ../backends/nvidiasettings \
+    ../backends/nvidiasmi \
+    ../backends/amdgpu
+
+SOURCES += testgputweak.cpp \
+    ../gpu.cpp \
+    ../gpuhistory.cpp \
+    ../gpuquantiles.cpp \
+    ../gpusketch.cpp \
+    ../gpudiagnostics.cpp \
+    ../gputrace.cpp \
+    ../gpusimulated.cpp \
+    ../gpupoller.cpp \
+    ../gpuburstcapture.cpp \
+    ../gpufancontroller.cpp \
+    ../gpuworkloadwatcher.cpp \
+    ../gpuprofile.cpp \
+    ../gpubackends.cpp \
+    ../backends/nvidiasettings/gpunvidia.cpp \
+    ../backends/nvidiasettings/nvidiasettingsadapter.cpp \
+    ../backends/nvidiasmi/gpunvidiasmi.cpp \
+    ../backends/nvidiasmi/nvidiasmiadapter.cpp \
+    ../backends/amdgpu/gpuamd.cpp \
+    ../backends/amdgpu/amdgpuadapter.cpp
+
+HEADERS += ../gpu.h \
+    ../gpuhistory.h \
+    ../gpuquantiles.h \
+    ../gpusketch.h \
+    ../gpudiagnostics.h \
+    ../gputrace.h \
+    ../gpusimulated.h \
+    ../gpupoller.h \
+    ../gpuburstcapture.h \
+    ../gpufancontroller.h \
+    ../gpuworkloadwatcher.h \
+    ../gpuprofile.h \
+    ../gpubackends.h \
+    ../gpubackend.h \
+    ../backends/nvidiasettings/gpunvidia.h \
+    ../backends/nvidiasettings/nvidiaattributes.h \
+    ../backends/nvidiasettings/nvidiasettingsadapter.h \
+    ../backends/nvidiasmi/gpunvidiasmi.h \
+    ../backends/nvidiasmi/nvidiasmiadapter.h \
+    ../backends/amdgpu/gpuamd.h \
+    ../backends/amdgpu/amdgpuadapter.h